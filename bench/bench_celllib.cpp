@@ -0,0 +1,59 @@
+// Pin resolution for named connections of library cells: per-pin lookups
+// (table lookup of the master, linear search of its port list) against the
+// bulk annotate_pins pass. Both produce the same pin and direction arrays.
+#include "bench_util.hpp"
+#include "veriloglib.hpp"
+#include "verilog_celllib.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+
+int main(int argc, char** argv) {
+  const size_t cells = argc > 1 ? size_t(std::atol(argv[1])) : 200000;
+  const size_t blocks = 64;
+  std::string text;
+  for (size_t b = 0; b < blocks; ++b) {
+    text += "module blk" + std::to_string(b) + "(ck);\n  input ck;\n";
+    for (size_t i = b; i < cells; i += blocks) {
+      const std::string n = std::to_string(i);
+      text += "  SDFFRX1 r" + n + " (.CK(ck), .D(d" + n + "), .SI(s" + n + "), .SE(e), .RN(rn), .Q(q" + n + "), .QN(qn" + n + "));\n";
+    }
+    text += "endmodule\n";
+  }
+  const verilog::Netlist nl = verilog::parse_string(text);
+
+  verilog::InterfaceTable lib(nl);
+  verilog::add_pin_list(lib, "SDFFRX1 D:in SI:in SE:in CK:in RN:in Q:out QN:out\n");
+  const double pins = double(cells) * 7;
+  std::printf("pin resolution, %zu SDFFRX1 instances x 7 named pins in %zu modules\n", cells, blocks);
+
+  bench::Timer naive_tm;
+  std::vector<std::vector<uint32_t>> pin(blocks);
+  std::vector<std::vector<verilog::PortDir>> dir(blocks);
+  for (size_t b = 0; b < blocks; ++b) {
+    for (const auto& inst : nl.modules[b].module_instances) {
+      const verilog::ModuleInterface* m = lib.find(inst.module_name);
+      for (const auto& [name, e] : inst.ports_named) {
+        const size_t k = size_t(std::find(m->ports.begin(), m->ports.end(), name) - m->ports.begin());
+        pin[b].push_back(k < m->ports.size() ? uint32_t(k) : verilog::ModuleInterface::npos);
+        dir[b].push_back(k < m->ports.size() ? m->dirs[k] : verilog::PortDir::Unknown);
+      }
+    }
+  }
+  bench::row("per-pin lookup", pins / naive_tm.seconds() / 1e6, "Mpins/s");
+
+  bench::Timer one_tm;
+  const verilog::PinAnnotation one = verilog::annotate_pins(nl, lib, 1);
+  bench::row("annotate_pins, 1 thread", pins / one_tm.seconds() / 1e6, "Mpins/s");
+
+  const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+  bench::Timer all_tm;
+  const verilog::PinAnnotation all = verilog::annotate_pins(nl, lib, hw);
+  char label[64];
+  std::snprintf(label, sizeof label, "annotate_pins, %u threads", hw);
+  bench::row(label, pins / all_tm.seconds() / 1e6, "Mpins/s");
+
+  for (size_t b = 0; b < blocks; ++b)
+    if (pin[b] != one.modules[b].pin || dir[b] != all.modules[b].dir) return 1;
+  return 0;
+}
@@ -0,0 +1,85 @@
+// Cone queries on one flat module of random two-input logic (200k cells by
+// default, every 32nd a flop): fan-in cones of many random nets, one wide
+// fan-out cone serial and frontier-parallel, and the export of a cone as
+// Verilog.
+#include "bench_util.hpp"
+#include "veriloglib.hpp"
+#include "verilog_celllib.hpp"
+#include "verilog_cone.hpp"
+#include "verilog_parallel.hpp"
+#include "verilog_writer.hpp"
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+std::string random_logic(size_t cells, size_t inputs) {
+  std::mt19937 rng(7);
+  std::string s = "module logic(clk, in);\n  input clk;\n  input [" + std::to_string(inputs - 1) + ":0] in;\n";
+  s += "  wire [" + std::to_string(cells - 1) + ":0] n;\n";
+  auto source = [&](size_t c) {
+    // Mostly recent nets, so cones are deep rather than all inputs.
+    const size_t span = std::min<size_t>(c, 4096);
+    if (span == 0 || rng() % 16 == 0) return "in[" + std::to_string(rng() % inputs) + "]";
+    return "n[" + std::to_string(c - 1 - rng() % span) + "]";
+  };
+  for (size_t c = 0; c < cells; ++c) {
+    const std::string y = "n[" + std::to_string(c) + "]";
+    if (c % 32 == 31) s += "  DFFX1 R" + std::to_string(c) + " (.D(" + source(c) + "), .CK(clk), .Q(" + y + "));\n";
+    else s += "  NAND2X1 U" + std::to_string(c) + " (.A(" + source(c) + "), .B(" + source(c) + "), .Y(" + y + "));\n";
+  }
+  return s + "endmodule\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const size_t cells = argc > 1 ? size_t(std::atoll(argv[1])) : 200000;
+  const size_t queries = argc > 2 ? size_t(std::atoll(argv[2])) : 200;
+  const verilog::Netlist nl = verilog::parse_string(random_logic(cells, 256));
+  verilog::InterfaceTable lib;
+  verilog::add_cell_stubs(lib, verilog::parse_string(
+    "module NAND2X1(A, B, Y); input A, B; output Y; endmodule\n"
+    "module DFFX1(D, CK, Q); input D, CK; output Q; endmodule\n"));
+  const verilog::ModuleGraph g(nl.modules[0], lib);
+  std::printf("module of %zu cells, %zu nets\n", cells, g.num_nets());
+
+  verilog::ConeOptions serial_opts;
+  serial_opts.stop_at = { "DFF*" };
+  const verilog::ConeExtractor serial(g, serial_opts);
+
+  std::mt19937 rng(1);
+  size_t total = 0;
+  bench::Timer in_tm;
+  for (size_t q = 0; q < queries; ++q) {
+    const verilog::NetId n = verilog::NetId(rng() % g.num_nets());
+    total += serial.fan_in(std::span<const verilog::NetId>(&n, 1)).nodes.size();
+  }
+  const double in_s = in_tm.seconds();
+  bench::row("fan-in cones", double(queries) / in_s, "cones/s");
+  std::printf("  %zu cones, %.0f nodes each on average\n", queries, double(total) / double(queries));
+
+  const auto start = serial.net("in");
+  bench::Timer out_tm;
+  const verilog::Cone wide = serial.fan_out(start);
+  const double out_s = out_tm.seconds();
+  bench::row("fan-out of every input, serial", out_s * 1e3, "ms");
+  std::printf("  %zu nodes, %zu nets\n", wide.nodes.size(), wide.nets.size());
+
+  verilog::ConeOptions par_opts = serial_opts;
+  par_opts.threads = verilog::parallel::default_threads();
+  bench::Timer par_tm;
+  const verilog::Cone wide_par = verilog::ConeExtractor(g, par_opts).fan_out(start);
+  const double par_s = par_tm.seconds();
+  bench::row("fan-out of every input, frontier-parallel", par_s * 1e3, "ms");
+  std::printf("  %u threads, %s\n", par_opts.threads, wide_par.nodes == wide.nodes ? "same cone" : "DIFFERENT CONE");
+
+  bench::Timer module_tm;
+  const verilog::Module sub = serial.to_module(wide, "wide_cone");
+  bench::row("cone as a module", module_tm.seconds() * 1e3, "ms");
+  bench::Timer write_tm;
+  const std::string text = verilog::write_verilog(sub);
+  bench::row("written as Verilog", write_tm.seconds() * 1e3, "ms");
+  std::printf("  %.1f MB of Verilog\n", double(text.size()) / 1e6);
+  return wide_par.nodes == wide.nodes ? 0 : 1;
+}
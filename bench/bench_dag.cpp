@@ -0,0 +1,94 @@
+// Bottom-up passes over a wide, uneven hierarchy: `levels` layers of 256
+// modules (5 by default), each holding a random number of buffer cells
+// (up to 400) and instances of four modules of the layer below. Every visit
+// builds the module's connectivity graph and rolls up the cell count. Times
+// building the DAG, then the pass with the work-stealing run_bottom_up()
+// against one parallel_for per hierarchy level, for 1, 2, 4 ... threads up to
+// the hardware's.
+#include "bench_util.hpp"
+#include "veriloglib.hpp"
+#include "verilog_celllib.hpp"
+#include "verilog_connectivity.hpp"
+#include "verilog_dag.hpp"
+#include "verilog_parallel.hpp"
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+constexpr int kWidth = 256;
+
+std::string layered(int levels) {
+  std::mt19937 rng(5);
+  std::string s;
+  for (int l = 0; l < levels; ++l)
+    for (int w = 0; w < kWidth; ++w) {
+      const size_t cells = rng() % 400 + 1;
+      s += "module m" + std::to_string(l) + "_" + std::to_string(w) + "(i, o);\n  input i; output o;\n";
+      s += "  wire [" + std::to_string(cells) + ":0] n;\n  assign n[0] = i;\n";
+      for (size_t c = 0; c < cells; ++c)
+        s += "  BUFX1 U" + std::to_string(c) + " (.A(n[" + std::to_string(c) + "]), .Y(n[" + std::to_string(c + 1) + "]));\n";
+      if (l)
+        for (int k = 0; k < 4; ++k)
+          s += "  m" + std::to_string(l - 1) + "_" + std::to_string(rng() % kWidth) + " S" + std::to_string(k) +
+               " (.i(n[0]), .o());\n";
+      s += "  assign o = n[" + std::to_string(cells) + "];\nendmodule\n";
+    }
+  return s;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const int levels = argc > 1 ? std::atoi(argv[1]) : 5;
+  const verilog::Netlist nl = verilog::parse_string(layered(levels));
+  verilog::InterfaceTable lib;
+  verilog::add_cell_stubs(lib, verilog::parse_string("module BUFX1(A, Y); input A; output Y; endmodule\n"));
+
+  bench::Timer build_tm;
+  const verilog::ModuleDag dag(nl, 1);
+  bench::row("module DAG build, one thread", build_tm.seconds() * 1e3, "ms");
+  std::printf("  %zu modules, %zu roots, height %u\n", dag.size(), dag.roots().size(), dag.height(dag.bottom_up().back()));
+
+  std::vector<uint64_t> cells(dag.size());
+  auto visit = [&](uint32_t m) {
+    const verilog::ModuleGraph g(dag.module(m), lib);
+    uint64_t n = 0;
+    for (const auto& inst : dag.module(m).module_instances) {
+      const uint32_t c = dag.find(inst.module_name);
+      n += c == verilog::ModuleDag::kNone ? 1 : cells[c];
+    }
+    cells[m] = n;
+  };
+
+  // Modules by height, for the level-by-level baseline.
+  std::vector<std::vector<uint32_t>> by_height;
+  for (uint32_t m : dag.bottom_up()) {
+    if (dag.height(m) >= by_height.size()) by_height.resize(dag.height(m) + 1);
+    by_height[dag.height(m)].push_back(m);
+  }
+
+  uint64_t expect = 0;
+  const unsigned hw = verilog::parallel::default_threads();
+  for (unsigned t = 1;; t = std::min(t * 2, hw)) {
+    std::printf("%u thread%s\n", t, t == 1 ? "" : "s");
+    bench::Timer ws_tm;
+    verilog::run_bottom_up(dag, visit, t);
+    bench::row("run_bottom_up", ws_tm.seconds() * 1e3, "ms");
+    const uint64_t total = cells[dag.bottom_up().back()];
+    if (!expect) expect = total;
+
+    std::fill(cells.begin(), cells.end(), 0);
+    bench::Timer lvl_tm;
+    for (const auto& level : by_height)
+      verilog::parallel::parallel_for(level.size(), [&](size_t i) { visit(level[i]); }, t);
+    bench::row("parallel_for per level", lvl_tm.seconds() * 1e3, "ms");
+    if (total != expect || cells[dag.bottom_up().back()] != expect) {
+      std::printf("  DIFFERENT ROLLUPS\n");
+      return 1;
+    }
+    if (t == hw) break;
+  }
+  std::printf("  %llu cells below the last module\n", (unsigned long long)expect);
+  return 0;
+}
@@ -0,0 +1,63 @@
+// Structural diff of two flat netlists of `cells` buffer instances each
+// (default 1M), the second with 1% of the instances rewired, 0.1% removed
+// and as many added: measures diff_netlists with one thread and with every
+// core, and the resident memory the comparison adds.
+#include "bench_util.hpp"
+#include "veriloglib.hpp"
+#include "verilog_diff.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+std::string netlist(size_t cells, bool eco) {
+  std::string s = "module top(i, o);\n  input i; output o;\n";
+  for (size_t c = 0; c < cells; ++c) {
+    if (eco && c % 1000 == 999) continue;
+    const std::string k = std::to_string(c);
+    const std::string in = eco && c % 100 == 3 ? "i" : "n" + k;
+    s += "  BUFX1 U" + k + " (.A(" + in + "), .Y(n" + std::to_string(c + 1) + "));\n";
+  }
+  if (eco)
+    for (size_t c = 0; c < cells / 1000; ++c) s += "  BUFX1 E" + std::to_string(c) + " (.A(i), .Y());\n";
+  return s + "endmodule\n";
+}
+
+size_t rss() {
+  std::ifstream f("/proc/self/statm");
+  size_t pages = 0, resident = 0;
+  if (!(f >> pages >> resident)) return 0;
+  return resident * size_t(sysconf(_SC_PAGESIZE));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const size_t cells = argc > 1 ? size_t(std::atoll(argv[1])) : 1000000;
+  const verilog::Netlist a = verilog::parse_string(netlist(cells, false));
+  const verilog::Netlist b = verilog::parse_string(netlist(cells, true));
+  std::printf("two netlists of %zu instances\n", cells);
+
+  const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<unsigned> runs{ 1 };
+  if (hw > 1) runs.push_back(hw);
+  for (unsigned threads : runs) {
+    verilog::DiffOptions opts;
+    opts.threads = threads;
+    size_t entries = 0;
+    const size_t before = rss();
+    bench::Timer tm;
+    verilog::diff_netlists(a, b, opts, [&](const verilog::DiffEntry&) { ++entries; });
+    const double secs = tm.seconds();
+    const size_t after = rss();
+    char label[64];
+    std::snprintf(label, sizeof label, "diff, %u thread%s", threads, threads == 1 ? "" : "s");
+    bench::row(label, double(cells) / secs / 1e6, "Minstances/s");
+    if (before && after > before) bench::row("  resident growth per instance", double(after - before) / double(cells), "bytes");
+    std::printf("  %zu entries in %.1f ms\n", entries, secs * 1e3);
+    if (entries < cells / 1000 * 2) return 1;   // at least the removed and added instances
+  }
+  return 0;
+}
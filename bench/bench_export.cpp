@@ -0,0 +1,75 @@
+// Export of a parsed netlist (bench::flat_netlist, 256 modules of `cells`
+// buffer instances, 2048 by default) to JSON and to the binary form, against
+// the parse that produced it. Output goes to a stream that only counts bytes,
+// so the times are encoding, not disk. Also times the one-pass export of a
+// LazyNetlist (each body parsed, written, dropped) and a walk over every
+// connection of the binary form read in place.
+#include "bench_util.hpp"
+#include "veriloglib.hpp"
+#include "verilog_export.hpp"
+#include "verilog_lazy.hpp"
+#include <cstdlib>
+#include <sstream>
+#include <streambuf>
+
+namespace {
+
+class CountingBuf : public std::streambuf {
+public:
+  size_t bytes = 0;
+
+protected:
+  std::streamsize xsputn(const char*, std::streamsize n) override { bytes += size_t(n); return n; }
+  int_type overflow(int_type c) override { ++bytes; return c; }
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const size_t cells = argc > 1 ? size_t(std::atol(argv[1])) : 2048;
+  const std::string text = bench::flat_netlist(256, cells);
+  const double mb = double(text.size()) / 1e6;
+  std::printf("netlist export, 256 modules x %zu instances (%.1f MB of Verilog)\n", cells, mb);
+
+  bench::Timer parse_tm;
+  const verilog::Netlist nl = verilog::parse_string(text);
+  const double parse_s = parse_tm.seconds();
+  bench::row("parse_string", parse_s * 1e3, "ms");
+
+  CountingBuf json_buf;
+  std::ostream json(&json_buf);
+  bench::Timer json_tm;
+  verilog::write_json(nl, json);
+  const double json_s = json_tm.seconds();
+  bench::row("write_json", json_s * 1e3, "ms");
+  std::printf("  %.1f MB of JSON, %.1fx faster than the parse\n", double(json_buf.bytes) / 1e6, parse_s / json_s);
+
+  std::ostringstream bin;
+  bench::Timer bin_tm;
+  verilog::write_binary(nl, bin);
+  const double bin_s = bin_tm.seconds();
+  bench::row("write_binary", bin_s * 1e3, "ms");
+  const std::string bytes = bin.str();
+  std::printf("  %.1f MB binary, %.1fx faster than the parse\n", double(bytes.size()) / 1e6, parse_s / bin_s);
+
+  const verilog::LazyNetlist lazy = verilog::LazyNetlist::from_string(text);
+  CountingBuf lazy_buf;
+  std::ostream lazy_out(&lazy_buf);
+  bench::Timer lazy_tm;
+  verilog::write_json(lazy, lazy_out);
+  bench::row("write_json from a LazyNetlist (parse + export)", lazy_tm.seconds() * 1e3, "ms");
+
+  bench::Timer read_tm;
+  const verilog::binary::NetlistView view(bytes);
+  size_t pins = 0;
+  for (size_t m = 0; m < view.size(); ++m) {
+    const verilog::binary::ModuleView mod = view.module(m);
+    for (uint32_t i = 0; i < mod.num_instances(); ++i) {
+      const verilog::binary::InstanceView inst = mod.instance(i);
+      for (uint32_t k = 0; k < inst.num_named(); ++k) pins += inst.pin(k).size() + inst.named(k).name().size();
+    }
+  }
+  bench::row("binary walk over every connection, in place", read_tm.seconds() * 1e3, "ms");
+  std::printf("  %zu name bytes seen\n", pins);
+  return 0;
+}
@@ -0,0 +1,104 @@
+// Hierarchy passes on a synthetic tree: `levels` levels of 16 instances each
+// over 16 buffer cells, so levels = 5 gives 16^5 = 1M leaves from a netlist of
+// 85 instances. Compares the streamed leaf walk against one that concatenates
+// a name per level, then measures flatten (time and resident memory per leaf)
+// and uniquify.
+#include "bench_util.hpp"
+#include "veriloglib.hpp"
+#include "verilog_flatten.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+#include <unistd.h>
+
+namespace {
+
+std::string tree_netlist(int levels) {
+  std::string s;
+  for (int l = 0; l <= levels; ++l) {
+    const std::string child = l == 0 ? "BUFX1" : "lvl" + std::to_string(l - 1);
+    s += "module lvl" + std::to_string(l) + "(i, o);\n  input i; output o;\n  wire [16:0] n;\n  assign n[0] = i;\n";
+    for (int k = 0; k < 16; ++k) {
+      const std::string a = std::to_string(k), y = std::to_string(k + 1);
+      s += "  " + child + " u" + a + (l == 0 ? " (.A(n[" + a + "]), .Y(n[" + y + "]));\n"
+                                             : " (.i(n[" + a + "]), .o(n[" + y + "]));\n");
+    }
+    s += "  assign o = n[16];\nendmodule\n";
+  }
+  return s;
+}
+
+// Resident set size in bytes (0 where /proc is not available).
+size_t rss() {
+  std::ifstream f("/proc/self/statm");
+  size_t pages = 0, resident = 0;
+  if (!(f >> pages >> resident)) return 0;
+  return resident * size_t(sysconf(_SC_PAGESIZE));
+}
+
+using Defs = std::unordered_map<std::string_view, const verilog::Module*>;
+
+void naive_walk(const Defs& defs, const verilog::Module& m, const std::string& prefix, size_t& leaves, size_t& bytes) {
+  for (const auto& inst : m.module_instances) {
+    const std::string name = prefix.empty() ? inst.instance_name : prefix + "/" + inst.instance_name;
+    auto it = defs.find(inst.module_name);
+    if (it != defs.end()) naive_walk(defs, *it->second, name, leaves, bytes);
+    else { ++leaves; bytes += name.size(); }
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const int levels = argc > 1 ? std::atoi(argv[1]) - 1 : 4;   // argument: depth including the cell level
+  const verilog::Netlist nl = verilog::parse_string(tree_netlist(levels));
+  const std::string top = "lvl" + std::to_string(levels);
+  size_t expect = 16;
+  for (int l = 0; l < levels; ++l) expect *= 16;
+  std::printf("hierarchy of %d levels, %zu leaf cells\n", levels + 1, expect);
+
+  Defs defs;
+  for (const auto& m : nl.modules) defs.emplace(m.module_name, &m);
+  size_t leaves = 0, bytes = 0;
+  bench::Timer naive_tm;
+  naive_walk(defs, nl.modules.back(), "", leaves, bytes);
+  bench::row("leaf walk, name concatenated per level", double(leaves) / naive_tm.seconds() / 1e6, "Mleaves/s");
+
+  verilog::FlattenOptions opts;
+  opts.top = top;
+  size_t walked = 0, walked_bytes = 0;
+  bench::Timer walk_tm;
+  verilog::for_each_leaf(nl, opts, [&](std::string_view path, const verilog::ModuleInstance&) {
+    ++walked;
+    walked_bytes += path.size();
+  });
+  bench::row("for_each_leaf, streamed path", double(walked) / walk_tm.seconds() / 1e6, "Mleaves/s");
+  if (walked != expect || leaves != expect || walked_bytes != bytes) return 1;
+
+  const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<unsigned> runs{ 1 };
+  if (hw > 1) runs.push_back(hw);
+  for (unsigned threads : runs) {
+    opts.threads = threads;
+    const size_t before = rss();
+    bench::Timer tm;
+    verilog::Netlist flat = verilog::flatten(nl, opts);
+    const double secs = tm.seconds();
+    const size_t after = rss();
+    char label[64];
+    std::snprintf(label, sizeof label, "flatten, %u thread%s", threads, threads == 1 ? "" : "s");
+    bench::row(label, double(flat.modules[0].module_instances.size()) / secs / 1e6, "Mleaves/s");
+    if (before && after > before) bench::row("  resident growth per leaf", double(after - before) / double(expect), "bytes");
+    if (flat.modules[0].module_instances.size() != expect) return 1;
+  }
+
+  bench::Timer uq_tm;
+  verilog::UniqueNetlist u = verilog::uniquify(nl, top);
+  const double uq = uq_tm.seconds();
+  bench::Timer mat_tm;
+  const verilog::Netlist un = u.to_netlist();
+  std::printf("  uniquify: %zu modules in %.1f ms (shared bodies), materialised in %.1f ms\n",
+              u.modules.size(), uq * 1e3, mat_tm.seconds() * 1e3);
+  return un.modules.size() == u.modules.size() ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+// Hierarchical name lookups on the bench_flatten tree (16 instances per level
+// over 16 buffer cells): resolves 100k random pin paths one at a time, as one
+// batch, and as a batch grouped by cell (both pins of each cell in a row), and
+// expands a wildcard. The index is built over the netlist's
+// definitions, so its size does not grow with the 1M-leaf flattened design.
+#include "bench_util.hpp"
+#include "veriloglib.hpp"
+#include "verilog_hierarchy.hpp"
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+std::string tree_netlist(int levels) {
+  std::string s;
+  for (int l = 0; l <= levels; ++l) {
+    const std::string child = l == 0 ? "BUFX1" : "lvl" + std::to_string(l - 1);
+    s += "module lvl" + std::to_string(l) + "(i, o);\n  input i; output o;\n  wire [16:0] n;\n  assign n[0] = i;\n";
+    for (int k = 0; k < 16; ++k) {
+      const std::string a = std::to_string(k), y = std::to_string(k + 1);
+      s += "  " + child + " u" + a + (l == 0 ? " (.A(n[" + a + "]), .Y(n[" + y + "]));\n"
+                                             : " (.i(n[" + a + "]), .o(n[" + y + "]));\n");
+    }
+    s += "  assign o = n[16];\nendmodule\n";
+  }
+  return s;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const int levels = argc > 1 ? std::atoi(argv[1]) - 1 : 4;
+  const size_t n = argc > 2 ? size_t(std::atoll(argv[2])) : 100000;
+  const verilog::Netlist nl = verilog::parse_string(tree_netlist(levels));
+
+  bench::Timer build_tm;
+  const verilog::HierarchyIndex h(nl);
+  std::printf("hierarchy of %d levels, index built in %.2f ms\n", levels + 1, build_tm.seconds() * 1e3);
+
+  std::mt19937 rng(1);
+  std::vector<std::string> paths(n);
+  for (auto& p : paths) {
+    p = "lvl" + std::to_string(levels);
+    for (int l = 0; l <= levels; ++l) p += "/u" + std::to_string(rng() % 16);
+    p += rng() % 2 ? "/A" : "/Y";
+  }
+
+  size_t hits = 0;
+  bench::Timer one_tm;
+  for (const auto& p : paths) hits += bool(h.resolve(p));
+  const double one = one_tm.seconds();
+  bench::row("resolve, one at a time", double(n) / one / 1e6, "Mpaths/s");
+  std::printf("  %zu paths in %.1f ms\n", n, one * 1e3);
+
+  bench::Timer batch_tm;
+  const auto batch = h.resolve(std::span<const std::string>(paths));
+  const double bt = batch_tm.seconds();
+  bench::row("resolve, batch", double(n) / bt / 1e6, "Mpaths/s");
+  std::printf("  %zu paths in %.1f ms\n", n, bt * 1e3);
+  size_t batch_hits = 0;
+  for (const auto& r : batch) batch_hits += bool(r);
+
+  std::vector<std::string> grouped;
+  grouped.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    const std::string& p = paths[i / 2 * 2];
+    grouped.push_back(p.substr(0, p.size() - 1) + (i % 2 ? "Y" : "A"));
+  }
+  bench::Timer grouped_tm;
+  const auto pins = h.resolve(std::span<const std::string>(grouped));
+  const double gt = grouped_tm.seconds();
+  bench::row("resolve, batch grouped by cell", double(n) / gt / 1e6, "Mpaths/s");
+  for (const auto& r : pins) batch_hits += bool(r);
+
+  bench::Timer glob_tm;
+  const auto leaves = h.glob("u3/*/u1*/*/u7");
+  std::printf("  glob u3/*/u1*/*/u7: %zu matches in %.2f ms\n", leaves.size(), glob_tm.seconds() * 1e3);
+  return hits == n && batch_hits == 2 * n ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+// module_item dispatch on instantiation-dominated input: the keyword
+// classifier against the previous ordered alternation, which tried five
+// declarations and a seven-keyword not_at before every instantiation.
+#include "bench_util.hpp"
+#include "veriloglib.hpp"
+#include "verilog_grammar.hpp"
+#include <cstdlib>
+
+namespace legacy {
+using namespace verilog::grammar;
+struct not_keyword : not_at< sor< TAO_PEGTL_STRING("wire"), TAO_PEGTL_STRING("input"), TAO_PEGTL_STRING("output"),
+                                  TAO_PEGTL_STRING("inout"), TAO_PEGTL_STRING("assign"), TAO_PEGTL_STRING("module"),
+                                  TAO_PEGTL_STRING("endmodule") > > {};
+struct module_instantiation : if_must< not_keyword, module_inst_head, seps, module_instance_list, sep, semi > {};
+struct module_item : sor< input_declaration, output_declaration, inout_declaration, net_declaration, continuous_assign, module_instantiation > {};
+struct module : seq< module_header, star< seq< sep, module_item > >, sep, kw_endmodule > {};
+struct start : star< seq< sep, module, sep > > {};
+} // namespace legacy
+
+template<typename Rule>
+static double recognise(const std::string& text, int reps) {
+  bench::Timer t;
+  for (int r = 0; r < reps; ++r) {
+    tao::pegtl::memory_input in(text.data(), text.size(), "bench");
+    if (!tao::pegtl::parse< Rule >(in) || !in.empty()) { std::fprintf(stderr, "recognition failed\n"); std::exit(1); }
+  }
+  return t.seconds() / reps;
+}
+
+int main(int argc, char** argv) {
+  const size_t cells = argc > 1 ? size_t(std::atol(argv[1])) : 4096;
+  const int reps = 3;
+  const std::string text = bench::flat_netlist(16, cells);
+  const double mb = double(text.size()) / 1e6;
+
+  std::printf("module_item dispatch, 16 modules x %zu instances (%.1f MB), recognition only\n", cells, mb);
+  const double old_s = recognise< legacy::start >(text, reps);
+  const double new_s = recognise< verilog::grammar::start >(text, reps);
+  bench::row("ordered sor + not_at keywords", mb / old_s, "MB/s");
+  bench::row("keyword classifier dispatch", mb / new_s, "MB/s");
+  bench::row("speedup", old_s / new_s, "x");
+
+  bench::Timer t;
+  verilog::parse_string(text);
+  bench::row("parse_string (with actions)", mb / t.seconds(), "MB/s");
+  return 0;
+}
@@ -0,0 +1,30 @@
+// Module outline of a large netlist: LazyNetlist's skip-scan (headers only)
+// against a full parse_string, and the cost of touching one body afterwards.
+#include "bench_util.hpp"
+#include "veriloglib.hpp"
+#include "verilog_lazy.hpp"
+#include <cstdlib>
+
+int main(int argc, char** argv) {
+  const size_t cells = argc > 1 ? size_t(std::atol(argv[1])) : 8192;
+  const std::string text = bench::flat_netlist(64, cells);
+  const double mb = double(text.size()) / 1e6;
+  std::printf("module outline, 64 modules x %zu instances (%.1f MB)\n", cells, mb);
+
+  bench::Timer scan_tm;
+  verilog::LazyNetlist lazy = verilog::LazyNetlist::from_string(text);
+  const double scan_s = scan_tm.seconds();
+  bench::row("LazyNetlist skip-scan", mb / scan_s, "MB/s");
+
+  bench::Timer touch_tm;
+  lazy.module("blk7");
+  bench::row("first touch of one body", touch_tm.seconds() * 1e3, "ms");
+
+  bench::Timer parse_tm;
+  verilog::parse_string(text);
+  const double parse_s = parse_tm.seconds();
+  bench::row("parse_string", mb / parse_s, "MB/s");
+  bench::row("outline speedup", parse_s / scan_s, "x");
+  bench::row("projected outline time for 5 GB", 5000.0 / (mb / scan_s), "s");
+  return 0;
+}
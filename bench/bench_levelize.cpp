@@ -0,0 +1,57 @@
+// Levelization of one flat module of random logic: nand primitives reading
+// recent nets, with every 64th cell a flop (1M cells by default; pass 10000000
+// for the 10M-gate case). Reports the time per node, which should stay flat
+// as the module grows, and times one parallel pass over the levels.
+#include "bench_util.hpp"
+#include "veriloglib.hpp"
+#include "verilog_celllib.hpp"
+#include "verilog_levelize.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+std::string random_logic(size_t cells) {
+  std::mt19937 rng(5);
+  std::string s = "module logic(clk, in);\n  input clk;\n  input [63:0] in;\n";
+  s += "  wire [" + std::to_string(cells - 1) + ":0] n;\n";
+  auto source = [&](size_t c) {
+    if (c == 0 || rng() % 32 == 0) return "in[" + std::to_string(rng() % 64) + "]";
+    return "n[" + std::to_string(c - 1 - rng() % std::min<size_t>(c, 1024)) + "]";
+  };
+  for (size_t c = 0; c < cells; ++c) {
+    const std::string y = "n[" + std::to_string(c) + "]";
+    if (c % 64 == 63) s += "  DFFX1 R" + std::to_string(c) + " (.D(" + source(c) + "), .CK(clk), .Q(" + y + "));\n";
+    else s += "  nand (" + y + ", " + source(c) + ", " + source(c) + ");\n";
+  }
+  return s + "endmodule\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const size_t cells = argc > 1 ? size_t(std::atoll(argv[1])) : 1000000;
+  bench::Timer parse_tm;
+  const verilog::Netlist nl = verilog::parse_string(random_logic(cells));
+  verilog::InterfaceTable lib;
+  verilog::add_cell_stubs(lib, verilog::parse_string("module DFFX1(D, CK, Q); input D, CK; output Q; endmodule\n"));
+  const verilog::ModuleGraph g(nl.modules[0], lib);
+  std::printf("module of %zu cells, %zu pins, built in %.1f s\n", cells, g.num_pins(), parse_tm.seconds());
+
+  verilog::LevelizeOptions opts;
+  opts.sequential = { "DFF*" };
+  bench::Timer tm;
+  const verilog::Schedule s = verilog::levelize(g, opts);
+  const double t = tm.seconds();
+  bench::row("levelize", t * 1e3, "ms");
+  bench::row("per node", t * 1e9 / double(g.num_nodes()), "ns");
+  std::printf("  %zu levels, %zu combinational nodes, %zu flops, %zu loops\n",
+              s.num_levels(), s.nodes.size(), s.sequential.size(), s.num_loops());
+
+  std::atomic<size_t> seen{0};
+  bench::Timer walk_tm;
+  verilog::for_each_level(s, [&](uint32_t v) { seen.fetch_add(v & 1, std::memory_order_relaxed); });
+  bench::row("one parallel pass over the levels", walk_tm.seconds() * 1e3, "ms");
+  return seen.load() > s.nodes.size();
+}
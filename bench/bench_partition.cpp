@@ -0,0 +1,79 @@
+// Partitioning of one flat module of random NAND2 logic with local
+// structure (200k cells by default): cells read nets from a window of
+// recent cells, as placed logic mostly does, with some global nets mixed in.
+// Reports time and cut for 2, 8 and 32 parts against a random balanced
+// assignment, serial and with all hardware threads.
+#include "bench_util.hpp"
+#include "veriloglib.hpp"
+#include "verilog_celllib.hpp"
+#include "verilog_parallel.hpp"
+#include "verilog_partition.hpp"
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+std::string random_logic(size_t cells) {
+  std::mt19937 rng(13);
+  std::string s = "module logic(clk, in);\n  input clk;\n  input [63:0] in;\n";
+  s += "  wire [" + std::to_string(cells - 1) + ":0] n;\n";
+  auto source = [&](size_t c) {
+    if (c == 0 || rng() % 64 == 0) return "in[" + std::to_string(rng() % 64) + "]";
+    if (rng() % 50 == 0) return "n[" + std::to_string(rng() % c) + "]";
+    return "n[" + std::to_string(c - 1 - rng() % std::min<size_t>(c, 256)) + "]";
+  };
+  for (size_t c = 0; c < cells; ++c)
+    s += "  NAND2X1 U" + std::to_string(c) + " (.A(" + source(c) + "), .B(" + source(c) + "), .Y(n[" + std::to_string(c) + "]));\n";
+  return s + "endmodule\n";
+}
+
+size_t random_cut(const verilog::ModuleGraph& g, uint32_t parts) {
+  std::mt19937 rng(1);
+  std::vector<uint32_t> part(g.num_nodes());
+  for (auto& p : part) p = rng() % parts;
+  size_t cut = 0;
+  for (verilog::NetId n = 0; n < g.num_nets(); ++n) {
+    uint32_t seen = verilog::Partition::kNoPart;
+    for (uint32_t pi : g.net_pins(n)) {
+      const auto& pin = g.pins()[pi];
+      if (g.node_kind(pin.node) == verilog::ModuleGraph::NodeKind::Port) continue;
+      if (seen == verilog::Partition::kNoPart) seen = part[pin.node];
+      else if (part[pin.node] != seen) { ++cut; break; }
+    }
+  }
+  return cut;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const size_t cells = argc > 1 ? size_t(std::atoll(argv[1])) : 200000;
+  const verilog::Netlist nl = verilog::parse_string(random_logic(cells));
+  verilog::InterfaceTable lib;
+  verilog::add_cell_stubs(lib, verilog::parse_string("module NAND2X1(A, B, Y); input A, B; output Y; endmodule\n"));
+  const verilog::ModuleGraph g(nl.modules[0], lib);
+  std::printf("module of %zu cells, %zu nets\n", cells, g.num_nets());
+
+  bool same = true;
+  for (uint32_t parts : { 2u, 8u, 32u }) {
+    verilog::PartitionOptions opts;
+    opts.parts = parts;
+    bench::Timer tm;
+    const verilog::Partition p = verilog::partition(g, opts);
+    const double serial_s = tm.seconds();
+    opts.threads = verilog::parallel::default_threads();
+    bench::Timer par_tm;
+    const verilog::Partition q = verilog::partition(g, opts);
+    const double par_s = par_tm.seconds();
+    same = same && q.part == p.part;
+    const uint32_t largest = *std::max_element(p.sizes.begin(), p.sizes.end());
+    std::printf("  %u parts:\n", parts);
+    bench::row("partition, serial", serial_s * 1e3, "ms");
+    bench::row("partition, all threads", par_s * 1e3, "ms");
+    bench::row("cut nets", double(p.cut.size()), "nets");
+    bench::row("cut nets, random assignment", double(random_cut(g, parts)), "nets");
+    bench::row("largest part over average", 100.0 * (double(largest) * parts / double(cells) - 1), "%");
+  }
+  std::printf("  %s\n", same ? "same parts at every thread count" : "DIFFERENT PARTS ACROSS THREAD COUNTS");
+  return same ? 0 : 1;
+}
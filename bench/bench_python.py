@@ -0,0 +1,133 @@
+"""The veriloglib Python extension against a pure-Python structural netlist parser.
+
+Same netlist as bench::flat_netlist (`modules` modules of `cells` buffer
+instances chained through a bus, and a top over them; 64 x 2048 by default).
+Times parsing, the master histogram and net loads of every module, and what
+it costs to turn the views into Python objects, which the columns avoid.
+
+    PYTHONPATH=build python3 bench/bench_python.py [modules] [cells]
+"""
+import collections
+import re
+import sys
+import time
+
+import veriloglib
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+
+def flat_netlist(modules, cells):
+    out = ["module BUF(A, Y);\n  input A; output Y;\nendmodule\n"]
+    for m in range(modules):
+        out.append("module blk%d(i, o);\n  input i; output o;\n  wire [%d:0] n;\n  assign n[0] = i;\n" % (m, cells))
+        out.extend("  BUF U%d (.A(n[%d]), .Y(n[%d]));\n" % (c, c, c + 1) for c in range(cells))
+        out.append("  assign o = n[%d];\nendmodule\n" % cells)
+    out.append("module top(i, o);\n  input i; output o;\n")
+    out.extend("  blk%d u%d (.i(i), .o(o));\n" % (m, m) for m in range(modules))
+    out.append("endmodule\n")
+    return "".join(out)
+
+
+# ---------------------------------------------------------------- pure Python
+# Enough of Verilog for the netlist above: no comments, escaped names,
+# concatenations or positional connections.
+
+MODULE = re.compile(r"module\s+(\w+)\s*\(([^)]*)\)\s*;(.*?)endmodule", re.S)
+STATEMENT = re.compile(r"\s*([^;]+);")
+DECL = re.compile(r"(input|output|inout|wire)\s*(\[\s*(-?\d+)\s*:\s*(-?\d+)\s*\])?\s*(.*)", re.S)
+INSTANCE = re.compile(r"(\w+)\s+(\w+)\s*\((.*)\)", re.S)
+PIN = re.compile(r"\.(\w+)\s*\(\s*([^)]*?)\s*\)")
+
+
+def parse_python(text):
+    """Modules as dicts: ports, directions and instances as (master, name, {pin: net})."""
+    modules = {}
+    for name, ports, body in MODULE.findall(text):
+        mod = {"ports": [p.strip() for p in ports.split(",") if p.strip()], "dirs": {}, "instances": [], "assigns": []}
+        for stmt in STATEMENT.findall(body):
+            decl = DECL.match(stmt)
+            if decl:
+                for n in decl.group(5).split(","):
+                    mod["dirs"][n.strip()] = decl.group(1)
+            elif stmt.startswith("assign"):
+                lhs, rhs = stmt[6:].split("=")
+                mod["assigns"].append((lhs.strip(), rhs.strip()))
+            else:
+                inst = INSTANCE.match(stmt)
+                if inst:
+                    mod["instances"].append((inst.group(1), inst.group(2), dict(PIN.findall(inst.group(3)))))
+        modules[name] = mod
+    return modules
+
+
+def python_loads(modules, mod):
+    """Loads per net: instance pins that are inputs of their master, and assign right-hand sides."""
+    loads = collections.Counter()
+    for master, _, pins in mod["instances"]:
+        dirs = modules.get(master, {}).get("dirs", {})
+        for pin, net in pins.items():
+            if dirs.get(pin) != "output":
+                loads[net] += 1
+    for _, rhs in mod["assigns"]:
+        loads[rhs] += 1
+    return loads
+
+
+# ---------------------------------------------------------------- bench
+
+
+def row(what, seconds):
+    print("  %-52s %10.1f ms" % (what, seconds * 1e3))
+
+
+def timed(f):
+    t0 = time.perf_counter()
+    r = f()
+    return r, time.perf_counter() - t0
+
+
+def main():
+    modules = int(sys.argv[1]) if len(sys.argv) > 1 else 64
+    cells = int(sys.argv[2]) if len(sys.argv) > 2 else 2048
+    text = flat_netlist(modules, cells)
+    print("%d modules x %d instances (%.1f MB of Verilog)" % (modules, cells, len(text) / 1e6))
+
+    py, py_parse = timed(lambda: parse_python(text))
+    row("pure Python: parse into dicts and tuples", py_parse)
+    hist, py_hist = timed(lambda: [collections.Counter(m for m, _, _ in mod["instances"]) for mod in py.values()])
+    row("pure Python: master histogram of every module", py_hist)
+    _, py_loads = timed(lambda: [python_loads(py, mod) for mod in py.values()])
+    row("pure Python: net loads of every module", py_loads)
+
+    nl, vl_parse = timed(lambda: veriloglib.parse_string(text))
+    row("veriloglib: parse_string (GIL released)", vl_parse)
+
+    def histograms():
+        out = []
+        for mod in nl:
+            codes, names = mod.instance_masters()
+            counts = numpy.bincount(numpy.asarray(codes), minlength=len(names)) if numpy else collections.Counter(memoryview(codes))
+            out.append((names, counts))
+        return out
+
+    vl_hist_r, vl_hist = timed(histograms)
+    row("veriloglib: instance_masters() columns" + (" + numpy.bincount" if numpy else " + Counter"), vl_hist)
+    _, vl_loads = timed(lambda: [mod.net_fanouts() for mod in nl])
+    row("veriloglib: net_fanouts() columns", vl_loads)
+    _, vl_objects = timed(lambda: [[(i.master, i.name, i.pins) for i in mod.instances] for mod in nl])
+    row("veriloglib: every instance as Python objects", vl_objects)
+
+    if sum(len(names) for names, _ in vl_hist_r) != sum(len(h) for h in hist):
+        print("  DIFFERENT HISTOGRAMS")
+        return 1
+    print("  parse speedup %.1fx; parse + histograms + loads %.1fx" %
+          (py_parse / vl_parse, (py_parse + py_hist + py_loads) / (vl_parse + vl_hist + vl_loads)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
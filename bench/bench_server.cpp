@@ -0,0 +1,79 @@
+// vparsed query latency and throughput over a Unix socket, against the cost
+// of re-parsing the netlist that a query would otherwise need.
+#include "bench_util.hpp"
+#include "veriloglib.hpp"
+#include "verilog_server.hpp"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace verilog;
+using namespace verilog::server;
+
+static constexpr size_t kModules = 64, kCells = 1024;
+
+int main(int argc, char** argv) {
+  const size_t queries = argc > 1 ? size_t(std::atol(argv[1])) : 20000;
+  const std::string text = bench::flat_netlist(kModules, kCells);
+
+  bench::Timer parse_tm;
+  Netlist nl = parse_string(text);
+  const double parse_s = parse_tm.seconds();
+
+  const std::string sock = (std::filesystem::temp_directory_path() / ("vparsed_bench_" + std::to_string(::getpid()) + ".sock")).string();
+  NetlistServer srv(sock);
+  srv.add_design("d", std::move(nl), "top");
+  srv.start();
+
+  std::vector<std::string> cells, paths;
+  for (size_t i = 0; i < queries; ++i) {
+    cells.push_back("U" + std::to_string((i * 7919) % kCells));
+    paths.push_back("u" + std::to_string(i % kModules) + "/" + cells.back() + "/Y");
+  }
+
+  std::printf("vparsed, %zu modules x %zu cells, %zu queries\n", kModules, kCells, queries);
+  bench::row("re-parse the netlist", parse_s * 1e3, "ms");
+
+  {
+    NetlistClient c(sock);
+    std::vector<double> us(queries);
+    for (size_t i = 0; i < queries; ++i) {
+      bench::Timer t;
+      c.find_instance("d", "blk0", cells[i]);
+      us[i] = t.seconds() * 1e6;
+    }
+    std::sort(us.begin(), us.end());
+    bench::row("find_instance round trip, p50", us[queries / 2], "us");
+    bench::row("find_instance round trip, p99", us[queries * 99 / 100], "us");
+  }
+
+  for (size_t window : { size_t(1), size_t(16), size_t(256) }) {
+    NetlistClient c(sock);
+    bench::Timer t;
+    c.find_instance_batch("d", "blk0", cells, window);
+    const std::string what = "find_instance_batch, window " + std::to_string(window);
+    bench::row(what.c_str(), double(queries) / t.seconds(), "q/s");
+  }
+  {
+    NetlistClient c(sock);
+    bench::Timer t;
+    c.resolve_path_batch("d", paths);
+    bench::row("resolve_path_batch, window 256", double(queries) / t.seconds(), "q/s");
+  }
+
+  for (unsigned threads : { 2u, 4u, 8u }) {
+    std::vector<std::thread> pool;
+    bench::Timer t;
+    for (unsigned k = 0; k < threads; ++k) {
+      pool.emplace_back([&] { NetlistClient c(sock); c.resolve_path_batch("d", paths); });
+    }
+    for (auto& th : pool) th.join();
+    const std::string what = "resolve_path_batch, " + std::to_string(threads) + " clients";
+    bench::row(what.c_str(), double(queries) * threads / t.seconds(), "q/s");
+  }
+  srv.stop();
+  return 0;
+}
@@ -0,0 +1,76 @@
+// Concurrent-reader throughput: SnapshotPublisher (epoch slot + raw pointer)
+// against the usual atomic<shared_ptr> snapshot, where every read copies the pointer
+// and bumps a shared reference count.
+#include "bench_util.hpp"
+#include "veriloglib.hpp"
+#include "verilog_snapshot.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace verilog;
+
+static constexpr size_t kModules = 64, kCells = 256;
+
+static std::vector<std::string> g_modules, g_cells;
+
+// One "query": resolve a module and an instance by name.
+static bool query(const FrozenNetlist& s, size_t k) {
+  const Module* m = s.find_module(g_modules[k % kModules]);
+  return m && s.find_instance(*m, g_cells[(k / kModules) % kCells]);
+}
+
+template<typename ReadOnce>
+static double run(unsigned threads, double seconds, ReadOnce read_once) {
+  std::atomic<bool> go{false}, stop{false};
+  std::atomic<uint64_t> total{0};
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; ++t) {
+    pool.emplace_back([&, t] {
+      auto ctx = read_once.make_context();
+      uint64_t n = 0;
+      while (!go.load()) std::this_thread::yield();
+      while (!stop.load(std::memory_order_relaxed)) { read_once(ctx, n * 7919 + t); ++n; }
+      total += n;
+    });
+  }
+  bench::Timer tm;
+  go = true;
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  stop = true;
+  for (auto& t : pool) t.join();
+  return double(total.load()) / tm.seconds();
+}
+
+int main(int argc, char** argv) {
+  const double seconds = argc > 1 ? std::atof(argv[1]) : 0.5;
+  const std::string text = bench::flat_netlist(kModules, kCells);
+  for (size_t i = 0; i < kModules; ++i) g_modules.push_back("blk" + std::to_string(i));
+  for (size_t i = 0; i < kCells; ++i) g_cells.push_back("U" + std::to_string(i));
+
+  SnapshotPublisher pub(64);
+  pub.publish(parse_string(text));
+  std::atomic<std::shared_ptr<const FrozenNetlist>> shared{ std::make_shared<const FrozenNetlist>(parse_string(text)) };
+
+  struct Rcu {
+    SnapshotPublisher* pub;
+    SnapshotPublisher::Reader make_context() const { return pub->register_reader(); }
+    void operator()(SnapshotPublisher::Reader& r, size_t k) const { auto g = r.read(); query(*g, k); }
+  };
+  struct Shared {
+    std::atomic<std::shared_ptr<const FrozenNetlist>>* p;
+    int make_context() const { return 0; }
+    void operator()(int, size_t k) const { auto s = p->load(); query(*s, k); }
+  };
+
+  std::printf("concurrent snapshot reads (%zu modules x %zu instances), queries/s\n", kModules, kCells);
+  for (unsigned t : { 1u, 2u, 4u, 8u }) {
+    const double rcu = run(t, seconds, Rcu{ &pub });
+    const double sp = run(t, seconds, Shared{ &shared });
+    std::printf("  threads %u\n", t);
+    bench::row("SnapshotPublisher::Reader::read()", rcu, "q/s");
+    bench::row("atomic<shared_ptr>::load() copy", sp, "q/s");
+  }
+  return 0;
+}
@@ -0,0 +1,51 @@
+// Cost of source locations on a flat netlist: line-table build speed and
+// size against a plain vector of 32-bit line starts, lookup time for random
+// offsets, and the bytes spans and table add per instance, projected to 10M
+// instances. Build once with -DVERILOGLIB_SOURCE_LOCATIONS=OFF to compare
+// parse speed without them.
+#include "bench_util.hpp"
+#include "veriloglib.hpp"
+#include "verilog_source.hpp"
+#include <cstdlib>
+#include <random>
+
+int main(int argc, char** argv) {
+  const size_t cells = argc > 1 ? size_t(std::atol(argv[1])) : 16384;
+  const std::string text = bench::flat_netlist(64, cells);
+  const double mb = double(text.size()) / 1e6;
+  std::printf("source locations (%s), 64 modules x %zu instances (%.1f MB)\n",
+              VERILOGLIB_SOURCE_LOCATIONS ? "on" : "off", cells, mb);
+
+  bench::Timer parse_tm;
+  const verilog::Netlist nl = verilog::parse_string(text);
+  bench::row("parse_string", mb / parse_tm.seconds(), "MB/s");
+
+  bench::Timer build_tm;
+  const verilog::LineTable lines(text);
+  bench::row("line table build", mb / build_tm.seconds(), "MB/s");
+  bench::row("  bytes per line", double(lines.memory_bytes()) / lines.num_lines(), "bytes");
+  bench::row("  flat uint32 line starts, bytes per line", double(sizeof(uint32_t)), "bytes");
+
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<uint32_t> pick(0, uint32_t(text.size() - 1));
+  std::vector<uint32_t> offsets(1 << 20);
+  for (auto& o : offsets) o = pick(rng);
+  uint64_t sum = 0;
+  bench::Timer locate_tm;
+  for (uint32_t o : offsets) sum += lines.locate(o).line;
+  bench::row("locate(), random offsets", locate_tm.seconds() * 1e9 / double(offsets.size()), "ns");
+
+  size_t insts = 0, items = 0;
+  for (const auto& m : nl.modules) {
+    insts += m.module_instances.size();
+    items += 1 + m.module_instances.size() + m.assignments.size() + m.net_declarations.size() +
+             m.input_declarations.size() + m.output_declarations.size() + m.inout_declarations.size();
+  }
+  const double span_bytes = double(items) * (VERILOGLIB_SOURCE_LOCATIONS ? sizeof(verilog::SourceSpan) : 0);
+  const double table_bytes = nl.lines ? double(nl.lines->memory_bytes()) : 0.0;
+  const double per_inst = (span_bytes + table_bytes) / double(insts);
+  bench::row("sizeof(ModuleInstance)", double(sizeof(verilog::ModuleInstance)), "bytes");
+  bench::row("spans + line table per instance", per_inst, "bytes");
+  bench::row("  projected for 10M instances", per_inst * 10e6 / 1e6, "MB");
+  return sum ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace bench {
+
+struct Timer {
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  double seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  }
+};
+
+// `modules` flat modules of `cells` buffer instances each, chained through
+// wires, plus a leaf BUF definition and a top that instantiates every module.
+inline std::string flat_netlist(size_t modules, size_t cells) {
+  std::string s = "module BUF(A, Y);\n  input A; output Y;\nendmodule\n";
+  for (size_t m = 0; m < modules; ++m) {
+    const std::string name = "blk" + std::to_string(m);
+    s += "module " + name + "(i, o);\n  input i; output o;\n";
+    s += "  wire [" + std::to_string(cells) + ":0] n;\n";
+    s += "  assign n[0] = i;\n";
+    for (size_t c = 0; c < cells; ++c) {
+      s += "  BUF U" + std::to_string(c) + " (.A(n[" + std::to_string(c) + "]), .Y(n[" + std::to_string(c + 1) + "]));\n";
+    }
+    s += "  assign o = n[" + std::to_string(cells) + "];\nendmodule\n";
+  }
+  s += "module top(i, o);\n  input i; output o;\n";
+  for (size_t m = 0; m < modules; ++m) {
+    s += "  blk" + std::to_string(m) + " u" + std::to_string(m) + " (.i(i), .o(o));\n";
+  }
+  s += "endmodule\n";
+  return s;
+}
+
+inline void row(const char* what, double value, const char* unit) {
+  std::printf("  %-44s %14.1f %s\n", what, value, unit);
+}
+
+} // namespace bench
@@ -2,7 +2,11 @@
 #include "veriloglib.hpp"
 #include "verilog_grammar.hpp"
 #include <tao/pegtl.hpp>
+#include <algorithm>
+#include <array>
 #include <cctype>
+#include <cstring>
+#include <iterator>
 #include <utility>
 #include <memory>
 
@@ -11,8 +15,8 @@ namespace verilog { namespace actions {
 // ---------- small helpers for expression text → AST ----------
 namespace detail {
 
-inline std::string strip_backslash(std::string s) {
-  if (!s.empty() && s[0] == '\\') return s.substr(1);
+inline std::string_view strip_backslash(std::string_view s) {
+  if (!s.empty() && s[0] == '\\') s.remove_prefix(1);
   return s;
 }
 
@@ -209,99 +213,110 @@ inline std::string strip_backslash(std::string s) {
 //   }
 //   return Identifier{ strip_backslash(s) };
 // }
-inline Expr make_expr_from_text( const std::string& s_in )
-{
-  auto ltrim = [](std::string& x){
-    size_t i = 0; while (i < x.size() && std::isspace((unsigned char)x[i])) ++i;
-    x.erase(0, i);
-  };
-  auto rtrim = [](std::string& x){
-    size_t i = x.size(); while (i > 0 && std::isspace((unsigned char)x[i-1])) --i;
-    x.erase(i);
-  };
-  auto trim = [&](std::string& x){ ltrim(x); rtrim(x); };
-
-  auto peel_match = [&](std::string& x, char open='(', char close=')'){
-    for (;;) {
-      if (x.size() >= 2 && x.front()==open && x.back()==close) {
-        int d = 0; bool ok = false;
-        for (size_t i=0;i<x.size();++i){
-          if (x[i]==open) ++d;
-          else if (x[i]==close) { --d; if (d==0 && i==x.size()-1) ok = true; if (d<0){ ok=false; break; } }
-        }
-        if (ok) { x.erase(x.begin()); x.pop_back(); trim(x); continue; }
-      }
-      break;
+inline Constant make_constant(std::string_view text) {
+  Number n = Number::parse(text);
+  return Constant{ std::move(n.value), n.base.has_value() };
+}
+
+inline std::string_view trim(std::string_view x) {
+  while (!x.empty() && std::isspace((unsigned char)x.front())) x.remove_prefix(1);
+  while (!x.empty() && std::isspace((unsigned char)x.back())) x.remove_suffix(1);
+  return x;
+}
+
+// Peels matching outer (...) repeatedly: "((a))" -> "a".
+inline std::string_view peel_parens(std::string_view x) {
+  for (;;) {
+    if (x.size() < 2 || x.front() != '(' || x.back() != ')') return x;
+    int d = 0; bool ok = false;
+    for (size_t i=0;i<x.size();++i){
+      if (x[i]=='(') ++d;
+      else if (x[i]==')') { --d; if (d==0 && i==x.size()-1) ok = true; if (d<0){ ok=false; break; } }
     }
-  };
+    if (!ok) return x;
+    x = trim(x.substr(1, x.size() - 2));
+  }
+}
 
-  auto strip_comments = [&](std::string& x){
-    // // ...
-    {
-      std::string out; out.reserve(x.size());
-      for (size_t i=0;i<x.size();){
-        if (i+1<x.size() && x[i]=='/' && x[i+1]=='/') {
-          i+=2; while (i<x.size() && x[i]!='\n') ++i;
-        } else {
-          out.push_back(x[i++]);
-        }
-      }
-      x.swap(out);
+// Copies x without its // ..., /* ... */ and (* ... *) comments.
+inline std::string strip_comments(std::string_view x) {
+  std::string out; out.reserve(x.size());
+  for (size_t i=0;i<x.size();){
+    if (i+1<x.size() && x[i]=='/' && x[i+1]=='/') {
+      i+=2; while (i<x.size() && x[i]!='\n') ++i;
+    } else {
+      out.push_back(x[i++]);
     }
-    // /*...*/ and (*...*)
-    auto erase_block = [&](const std::string& open, const std::string& close){
-      std::string out; out.reserve(x.size());
-      for (size_t i=0;i<x.size();){
-        if (i+open.size()<=x.size() && x.compare(i, open.size(), open)==0) {
-          i += open.size();
-          while (i+close.size()<=x.size() && x.compare(i, close.size(), close)!=0) ++i;
-          if (i+close.size()<=x.size()) i += close.size();
-        } else {
-          out.push_back(x[i++]);
-        }
+  }
+  auto erase_block = [&](std::string_view open, std::string_view close){
+    const std::string in = std::move(out);
+    out.clear(); out.reserve(in.size());
+    for (size_t i=0;i<in.size();){
+      if (in.compare(i, open.size(), open)==0) {
+        i += open.size();
+        while (i+close.size()<=in.size() && in.compare(i, close.size(), close)!=0) ++i;
+        if (i+close.size()<=in.size()) i += close.size();
+      } else {
+        out.push_back(in[i++]);
       }
-      x.swap(out);
-    };
-    erase_block("/*","*/");
-    erase_block("(*","*)");
+    }
   };
+  erase_block("/*","*/");
+  erase_block("(*","*)");
+  return out;
+}
 
-  std::string s = s_in;
-  strip_comments(s);
-  trim(s);
-  peel_match(s); // peel outer (...) repeatedly
+// Builds the AST of an expression from its source text. Works on views of
+// the text: the only strings allocated are the names the AST keeps.
+inline Expr make_expr_from_text( std::string_view s_in )
+{
+  // Fast paths for what dominates netlists: a bare name or a literal, with no
+  // whitespace, comments or selects to strip.
+  if (!s_in.empty()) {
+    const char c0 = s_in[0];
+    const bool word = std::all_of(s_in.begin(), s_in.end(), [](char c) { return grammar::detail::is_ident_char(c) || c == '\'' || c == '?'; });
+    if (word && (std::isalpha((unsigned char)c0) || c0 == '_') && s_in.find_first_of("'?") == std::string_view::npos)
+      return Identifier{ std::string(s_in) };
+    if (word && (std::isdigit((unsigned char)c0) || c0 == '\'')) return make_constant(s_in);
+  }
+
+  std::string uncommented;   // only when there are comments to strip
+  std::string_view s = s_in;
+  if (s.find("//") != std::string_view::npos || s.find("/*") != std::string_view::npos || s.find("(*") != std::string_view::npos) {
+    uncommented = strip_comments(s);
+    s = uncommented;
+  }
+  s = peel_parens(trim(s));
 
   // ---- concatenation { e1 , e2 , ... } with top-level scanning ----
   if (!s.empty() && s.front()=='{' && s.back()=='}') {
-    std::string inner = s.substr(1, s.size()-2);
-    std::vector<Expr> elems;
+    const std::string_view inner = s.substr(1, s.size()-2);
+    auto cc = std::make_shared<Concatenation>();
     int b=0,p=0,br=0;  // {} () []
-    std::string tok;
-    auto flush = [&](){
-      std::string t = tok; trim(t);
-      if (!t.empty()) elems.emplace_back(make_expr_from_text(t));
-      tok.clear();
+    size_t tok = 0;
+    auto flush = [&](size_t end){
+      const std::string_view t = trim(inner.substr(tok, end - tok));
+      if (!t.empty()) cc->elements.emplace_back(make_expr_from_text(t));
+      tok = end + 1;
     };
-    for (char c : inner) {
+    for (size_t i = 0; i < inner.size(); ++i) {
+      const char c = inner[i];
       if      (c=='{') ++b;
       else if (c=='}') --b;
       else if (c=='(') ++p;
       else if (c==')') --p;
       else if (c=='[') ++br;
       else if (c==']') --br;
-
-      if (c==',' && b==0 && p==0 && br==0) flush();
-      else tok.push_back(c);
+      else if (c==',' && b==0 && p==0 && br==0) flush(i);
     }
-    flush();
-
-    auto cc = std::make_shared<Concatenation>();
-    cc->elements = std::move(elems);
+    flush(inner.size());
     return cc;
   }
 
+  if (!s.empty() && (std::isdigit((unsigned char)s.front()) || s.front() == '\'')) return make_constant(s);
+
   // ---- identifier / select: find the FIRST '[' at top level ----
-  size_t lb = std::string::npos;
+  size_t lb = std::string_view::npos;
   {
     int b=0,p=0,br=0;
     for (size_t i=0;i<s.size();++i){
@@ -315,23 +330,20 @@ inline Expr make_expr_from_text( const std::string& s_in )
     }
   }
 
-  if (lb != std::string::npos) {
+  if (lb != std::string_view::npos) {
     // find matching ']' for that '['
-    size_t rb = std::string::npos;
+    size_t rb = std::string_view::npos;
     int depth = 0;
     for (size_t i = lb+1; i < s.size(); ++i) {
       if      (s[i]=='[') ++depth;
       else if (s[i]==']') { if (depth==0) { rb=i; break; } --depth; }
     }
-    if (rb != std::string::npos && rb > lb+1) {
-      std::string name   = s.substr(0, lb);
-      std::string inside = s.substr(lb+1, rb-lb-1);
-      trim(name); trim(inside);
-      peel_match(name);    // e.g. "(bus)" -> "bus"
-      peel_match(inside);  // e.g. "(7:0)" -> "7:0"
+    if (rb != std::string_view::npos && rb > lb+1) {
+      const std::string_view name   = peel_parens(trim(s.substr(0, lb)));        // e.g. "(bus)" -> "bus"
+      const std::string_view inside = peel_parens(trim(s.substr(lb+1, rb-lb-1)));  // e.g. "(7:0)" -> "7:0"
 
       // find ':' at top level (in case of nested parens inside [])
-      size_t colon = std::string::npos;
+      size_t colon = std::string_view::npos;
       {
         int p=0;
         for (size_t i=0;i<inside.size();++i){
@@ -342,27 +354,17 @@ inline Expr make_expr_from_text( const std::string& s_in )
         }
       }
 
-      auto toNumber = [&](std::string t)->Number{
-        trim(t);
-        Number n; n.mantissa = t;   // simple subset: mantissa only
-        return n;
-      };
-
-      name = strip_backslash(name);
-
-      if (colon != std::string::npos) {
-        std::string msb = inside.substr(0, colon);
-        std::string lsb = inside.substr(colon+1);
-        Range r{ toNumber(msb), toNumber(lsb) };
-        return IdentifierSliced{ std::move(name), std::move(r) };
+      if (colon != std::string_view::npos) {
+        Range r{ Number::parse(inside.substr(0, colon)), Number::parse(inside.substr(colon+1)) };
+        return IdentifierSliced{ std::string(strip_backslash(name)), std::move(r) };
       } else {
-        return IdentifierIndexed{ std::move(name), toNumber(inside) };
+        return IdentifierIndexed{ std::string(strip_backslash(name)), Number::parse(inside) };
       }
     }
   }
 
   // bare identifier
-  return Identifier{ strip_backslash(s) };
+  return Identifier{ std::string(strip_backslash(s)) };
 }
 
 } // namespace detail
@@ -374,15 +376,36 @@ inline Expr make_expr_from_text( const std::string& s_in )
     using namespace tao::pegtl;
 
 struct State {
+  const char* source_begin = nullptr;   // start of the whole text; spans are offsets from here (none when null)
+  const char* item_end = nullptr;       // just past the last item_semi / item_rparen
+  uint32_t source_offset = 0;           // added to every span: where source_begin sits in a longer stream
+
+  SourceSpan span_of(const char* begin, const char* end) const {
+#if VERILOGLIB_SOURCE_LOCATIONS
+    if (!source_begin || source_offset + uint64_t(end - source_begin) > UINT32_MAX) return {};
+    return SourceSpan{ source_offset + uint32_t(begin - source_begin), source_offset + uint32_t(end - source_begin) };
+#else
+    (void)begin; (void)end;
+    return {};
+#endif
+  }
+  // An item from the start of its match to its closing ';' or ')'.
+  template<typename Input>
+  SourceSpan item_span(const Input& in) const { return span_of(in.begin(), item_end); }
+
   std::optional<int> number_len;
   std::optional<char> number_base;
   std::string number_mantissa;
 
   std::string last_identifier;
-  std::vector<std::string> id_history;
+  // The last identifiers matched, as a ring whose strings keep their buffers:
+  // identifier k (counting from 0) sits at id_ring[k % size].
+  std::array<std::string, 16> id_ring;
+  size_t id_count = 0;
 
   size_t eq_ident_mark = 0;
   std::string last_expr_text; // raw test of the most recently matched <expression>
+  std::string assign_lhs_text; // last_expr_text as it stood when '=' matched
   
   std::vector<Expr> expr_stack;
   std::vector<std::vector<Expr>> concat_items_stack;
@@ -390,7 +413,8 @@ struct State {
   enum class DeclMode { None, Net, In, Out, Inout };
   DeclMode decl_mode = DeclMode::None;
   std::optional<Range> current_range;
-  std::vector<std::string> decl_names;
+  std::vector<std::string_view> decl_names;   // into the input, which outlives the parse
+  std::vector<std::string> decl_vars;   // names matched by variable_name, in order
 
   std::vector<NetDeclaration>  net_decl_accum;
   std::vector<InputDeclaration>  in_decl_accum;
@@ -408,12 +432,52 @@ struct State {
     std::string instance_name;
     std::vector<Expr> ports_pos;
     std::map<std::string, Expr> ports_named;
+    SourceSpan span;
   };
   std::vector<PendingInstance> pending_instances;
 
+  std::shared_ptr<const ParamRange> range_expr;   // current_range as written, when it uses parameters
+
+  bool param_local = false;      // localparam rather than parameter
+  std::string param_name;
+  std::string param_text;        // value of the parameter or named override being parsed
+  std::shared_ptr<ParamOverrides> inst_params;   // #(...) of the instantiation being parsed
+
+  NetType net_type = NetType::Wire;   // of the net declaration being parsed
+  GateType gate_type = GateType::And;
+  std::string gate_name;
+  std::vector<Expr> gate_terminals;   // of all pending gates, one after the other
+  struct PendingGate {
+    GateType type;
+    std::string name;
+    uint32_t terminals_end;   // into gate_terminals
+    SourceSpan span;
+  };
+  std::vector<PendingGate> pending_gates;
+
   Module current_module;
   std::vector<Module> modules_accum;
   bool in_module = false;
+
+  // Drops whatever the item being parsed has built so far, as a fresh State
+  // would have it, but keeps the module and the capacity of the scratch
+  // buffers for the items after it.
+  void reset_item() {
+    item_end = nullptr;
+    number_len.reset(); number_base.reset(); number_mantissa.clear();
+    last_identifier.clear(); id_count = 0; eq_ident_mark = 0;
+    last_expr_text.clear(); assign_lhs_text.clear();
+    expr_stack.clear(); concat_items_stack.clear();
+    decl_mode = DeclMode::None; current_range.reset(); range_expr.reset();
+    decl_names.clear(); decl_vars.clear();
+    net_decl_accum.clear(); in_decl_accum.clear(); out_decl_accum.clear(); inout_decl_accum.clear();
+    current_assign_list.clear(); assign_accum.clear();
+    current_inst_module_name.clear(); temp_named_port.clear(); pending_instances.clear();
+    param_local = false; param_name.clear(); param_text.clear(); inst_params.reset();
+    net_type = NetType::Wire; gate_type = GateType::And; gate_name.clear();
+    gate_terminals.clear(); pending_gates.clear();
+    in_module = false;
+  }
 };
 
 template<typename Rule>
@@ -426,31 +490,11 @@ template<>
 struct action<verilog::grammar::opt_range_decl> {
   template<typename Input>
   static void apply( const Input& in, State& st ) {
-    // Empty: no width
-    if (in.string().find('[') == std::string::npos) {
-      st.current_range.reset();
-      return;
-    }
-    // The inner part of opt_range_decl includes spaces & separators; extract the [..] span.
-    const std::string s = in.string();
-    auto lb = s.find('[');
-    auto rb = s.rfind(']');
-    if (lb == std::string::npos || rb == std::string::npos || rb <= lb) {
+    // Empty: no width. Otherwise range_decl has already decoded [msb:lsb].
+    if (std::string_view(in.begin(), in.size()).find('[') == std::string_view::npos) {
       st.current_range.reset();
-      return;
+      st.range_expr.reset();
     }
-    std::string body = s.substr(lb + 1, rb - lb - 1); // "msb : lsb"
-    auto colon = body.find(':');
-    if (colon == std::string::npos) { st.current_range.reset(); return; }
-    auto trim = [](std::string t){
-      auto a = t.find_first_not_of(" \t\r\n");
-      auto b = t.find_last_not_of(" \t\r\n");
-      return (a==std::string::npos) ? std::string() : t.substr(a, b - a + 1);
-    };
-    Number msb, lsb;
-    msb.mantissa = trim(body.substr(0, colon));
-    lsb.mantissa = trim(body.substr(colon + 1));
-    st.current_range = Range{ msb, lsb };
   }
 };
 
@@ -462,22 +506,20 @@ struct action<verilog::grammar::list_of_variables> {
   static void apply( const Input& in, State& st ) {
     if (st.decl_mode == State::DeclMode::None) return; // only inside a decl
 
-    const std::string s = in.string();
+    const std::string_view s(in.begin(), in.size());
     // Tokenize very conservatively: identifiers are [A-Za-z0-9_$] and backslash-escaped id’s.
-    std::string tok;
+    size_t tok = 0, i = 0;
     auto flush = [&](){
-      if (tok.empty()) return;
       // strip leading backslash for escaped ID’s
-      if (tok[0] == '\\') tok.erase(0, 1);
-      st.decl_names.push_back(tok);
-      tok.clear();
+      if (i > tok) st.decl_names.emplace_back(strip_backslash(s.substr(tok, i - tok)));
     };
 
     bool in_esc = false;
-    for (char c : s) {
+    for (; i < s.size(); ++i) {
+      const char c = s[i];
       if (!in_esc && c == '\\') { // start escaped identifier
         flush();
-        tok.push_back(c);
+        tok = i;
         in_esc = true;
         continue;
       }
@@ -485,35 +527,42 @@ struct action<verilog::grammar::list_of_variables> {
         // Escaped id continues until whitespace/comma/semicolon or bracket
         if (c==' ' || c=='\t' || c=='\r' || c=='\n' || c==',' || c==';' || c=='[' || c==']' || c=='{' || c=='}' || c=='(' || c==')') {
           flush();
+          tok = i;
           in_esc = false;
           // re-process this char as delimiter below
         } else {
-          tok.push_back(c);
           continue;
         }
       }
       // Regular identifier chars
-      if (std::isalnum((unsigned char)c) || c=='_' || c=='$') {
-        tok.push_back(c);
-      } else {
+      if (!(std::isalnum((unsigned char)c) || c=='_' || c=='$')) {
         flush();
+        tok = i + 1;
       }
     }
     flush();
   }
 };
 
+// Declared names proper. decl_names above also collects range bounds and other
+// tokens, so the declaration entries are built from these instead.
+template<> struct action<verilog::grammar::variable_name> {
+  template<typename Input>
+  static void apply( const Input& in, State& st ) {
+    if (st.decl_mode != State::DeclMode::None) st.decl_vars.emplace_back(strip_backslash(std::string_view(in.begin(), in.size())));
+  }
+};
+
 // Capture bare names in declarations (variable_name uses identifier_raw)
 template<> struct action<verilog::grammar::identifier_raw> {
   template<typename Input>
   static void apply( const Input& in, State& st ) {
-    std::string id = in.string();
-    if (!id.empty() && id[0] == '\\') id.erase(0, 1);   // strip Verilog backslash escape
-    st.last_identifier = id;
+    const std::string_view id = strip_backslash(std::string_view(in.begin(), in.size()));   // strip Verilog backslash escape
+    st.last_identifier.assign(id);
 
     // Only collect when inside a declaration; your DeclMode guard prevents noise from expressions
     if (st.decl_mode != State::DeclMode::None) {
-      st.decl_names.push_back(id);
+      st.decl_names.emplace_back(id);
     }
   }
 };
@@ -522,23 +571,41 @@ template<> struct action<verilog::grammar::identifier_raw> {
 template<> struct action<verilog::grammar::range_decl> {
   template<typename Input>
   static void apply( const Input& in, State& st ) {
-    std::string s = in.string();  // "[msb:lsb]"
-    if (!s.empty() && s.front()=='[') s.erase(0,1);
-    if (!s.empty() && s.back()==']')  s.pop_back();
+    std::string_view s(in.begin(), in.size());  // "[msb:lsb]" plus the separators sym<> swallows
+    auto lb = s.find('[');
+    auto rb = s.rfind(']');
+    if (lb == std::string_view::npos || rb == std::string_view::npos || rb <= lb) { st.current_range.reset(); return; }
+    s = s.substr(lb + 1, rb - lb - 1);
 
     auto pos = s.find(':');
-    if (pos == std::string::npos) { st.current_range.reset(); return; }
-
-    auto trim = [](std::string t){
-      auto a = t.find_first_not_of(" \t\r\n");
-      auto b = t.find_last_not_of(" \t\r\n");
-      return (a==std::string::npos) ? std::string() : t.substr(a, b - a + 1);
+    if (pos == std::string_view::npos) { st.current_range.reset(); return; }
+
+    // A bound that is a number as before, and not also a parameter's name
+    // (`[A:0]`), keeps its plain decoding; anything else is an expression
+    // over the module's parameters, valued here for their defaults.
+    const auto& params = st.current_module.parameters;
+    auto is_param = [&](std::string_view t) {
+      return std::any_of(params.begin(), params.end(), [&](const Parameter& p) { return p.name == t; });
     };
-
-    Number msb, lsb;
-    msb.mantissa = trim(s.substr(0, pos));
-    lsb.mantissa = trim(s.substr(pos + 1));
-    st.current_range = Range{ msb, lsb };
+    auto plain = [&](std::string_view t) {
+      if (is_param(t)) return false;
+      tao::pegtl::memory_input<> bound(t.data(), t.size(), "");
+      return tao::pegtl::parse< tao::pegtl::seq< grammar::number_1, tao::pegtl::eof > >(bound);
+    };
+    const std::string_view msb = detail::trim(s.substr(0, pos)), lsb = detail::trim(s.substr(pos + 1));
+    if (plain(msb) && plain(lsb)) {
+      st.current_range = Range{ Number::parse(msb), Number::parse(lsb) };
+      st.range_expr.reset();
+      return;
+    }
+    try {
+      auto r = std::make_shared<ParamRange>(ParamRange{ ParamExpr::parse(msb), ParamExpr::parse(lsb) });
+      st.current_range = Range{ Number::parse(std::to_string(r->msb.eval(params))),
+                                Number::parse(std::to_string(r->lsb.eval(params))) };
+      st.range_expr = std::move(r);
+    } catch (const std::runtime_error& e) {
+      throw tao::pegtl::parse_error(e.what(), in);
+    }
   }
 };
     
@@ -547,7 +614,7 @@ template<> struct action<verilog::grammar::range_decl> {
 template<> struct action<verilog::grammar::expression> {
   template<typename Input>
   static void apply(const Input& in, State& st) {
-    st.last_expr_text = in.string();   // keep only the raw span
+    st.last_expr_text.assign(in.begin(), in.size());   // keep only the raw span, in the buffer of the last one
     // (no pushing to st.expr_stack)
   }
 };
@@ -557,7 +624,8 @@ template<> struct action<verilog::grammar::equal> {
   template<typename Input>
   static void apply(const Input&, State& st) {
     // Remember how many identifiers we had *before* parsing RHS.
-    st.eq_ident_mark = st.id_history.size();
+    st.eq_ident_mark = st.id_count;
+    st.assign_lhs_text = st.last_expr_text;
   }
 };
 
@@ -565,14 +633,11 @@ template<> struct action<verilog::grammar::equal> {
 template<> struct action<verilog::grammar::identifier> {
   template<typename Input>
   static void apply(const Input& in, State& st) {
-    std::string id = in.string();
-    if (!id.empty() && id[0]=='\\') id = id.substr(1);
-    st.last_identifier = id;
-    st.id_history.push_back(id);
-    if (st.id_history.size() > 16)
-      st.id_history.erase(st.id_history.begin(), st.id_history.begin() + (st.id_history.size()-16));
+    const std::string_view id = strip_backslash(std::string_view(in.begin(), in.size()));
+    st.last_identifier.assign(id);
+    st.id_ring[st.id_count++ % st.id_ring.size()].assign(id);
     if (st.decl_mode != State::DeclMode::None)
-      st.decl_names.push_back(id);
+      st.decl_names.emplace_back(id);
   }
 };
 
@@ -580,56 +645,75 @@ template<> struct action<verilog::grammar::identifier> {
 template<> struct action<verilog::grammar::base> {
   template<typename Input>
   static void apply(const Input& in, State& st) {
-    char b = in.string().back();
+    char b = in.end()[-1];
     if (b >= 'A' && b <= 'Z') b = char(b - 'A' + 'a');
     st.number_base = b;
   }
 };
 template<> struct action<verilog::grammar::unsigned_hex_str> {
   template<typename Input>
-  static void apply(const Input& in, State& st) { st.number_mantissa = in.string(); }
+  static void apply(const Input& in, State& st) { st.number_mantissa.assign(in.begin(), in.size()); }
 };
 template<> struct action<verilog::grammar::signed_hex_str> {
   template<typename Input>
-  static void apply(const Input& in, State& st) { st.number_mantissa = in.string(); st.number_base.reset(); }
+  static void apply(const Input& in, State& st) { st.number_mantissa.assign(in.begin(), in.size()); st.number_base.reset(); }
 };
 
 // ---------- declarations — one entry per statement (matches your tests) ----------
-template<> struct action<verilog::grammar::kw_wire>   { template<typename I> static void apply(const I&, State& st){ st.decl_mode=State::DeclMode::Net;   st.decl_names.clear(); } };
-template<> struct action<verilog::grammar::kw_input>  { template<typename I> static void apply(const I&, State& st){ st.decl_mode=State::DeclMode::In;    st.decl_names.clear(); } };
-template<> struct action<verilog::grammar::kw_output> { template<typename I> static void apply(const I&, State& st){ st.decl_mode=State::DeclMode::Out;   st.decl_names.clear(); } };
-template<> struct action<verilog::grammar::kw_inout>  { template<typename I> static void apply(const I&, State& st){ st.decl_mode=State::DeclMode::Inout; st.decl_names.clear(); } };
+template<> struct action<verilog::grammar::kw_net_type> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) {
+    st.decl_mode = State::DeclMode::Net; st.decl_names.clear(); st.decl_vars.clear();
+    switch (grammar::classify_keyword(std::string_view(in.begin(), in.size()))) {
+      case grammar::Keyword::Tri:     st.net_type = NetType::Tri; break;
+      case grammar::Keyword::Supply0: st.net_type = NetType::Supply0; break;
+      case grammar::Keyword::Supply1: st.net_type = NetType::Supply1; break;
+      default:                        st.net_type = NetType::Wire; break;
+    }
+  }
+};
+template<> struct action<verilog::grammar::kw_input>  { template<typename I> static void apply(const I&, State& st){ st.decl_mode=State::DeclMode::In;    st.decl_names.clear(); st.decl_vars.clear(); } };
+template<> struct action<verilog::grammar::kw_output> { template<typename I> static void apply(const I&, State& st){ st.decl_mode=State::DeclMode::Out;   st.decl_names.clear(); st.decl_vars.clear(); } };
+template<> struct action<verilog::grammar::kw_inout>  { template<typename I> static void apply(const I&, State& st){ st.decl_mode=State::DeclMode::Inout; st.decl_names.clear(); st.decl_vars.clear(); } };
 
 template<> struct action<verilog::grammar::net_declaration> {
   template<typename Input>
-  static void apply(const Input&, State& st) {
-    if (!st.decl_names.empty())
-      st.net_decl_accum.push_back( NetDeclaration{ st.decl_names.front(), st.current_range } );
-    st.decl_names.clear(); st.decl_mode = State::DeclMode::None; st.current_range.reset();
+  static void apply(const Input& in, State& st) {
+    if (!st.decl_vars.empty())
+      st.net_decl_accum.push_back( NetDeclaration{ st.decl_vars.front(), st.current_range, std::move(st.decl_vars), st.net_type, st.range_expr, st.item_span(in) } );
+    else if (!st.decl_names.empty())
+      st.net_decl_accum.push_back( NetDeclaration{ std::string(st.decl_names.front()), st.current_range, { std::string(st.decl_names.front()) }, st.net_type, st.range_expr, st.item_span(in) } );
+    st.decl_names.clear(); st.decl_vars.clear(); st.decl_mode = State::DeclMode::None; st.current_range.reset(); st.range_expr.reset();
   }
 };
 template<> struct action<verilog::grammar::input_declaration> {
   template<typename Input>
-  static void apply(const Input&, State& st) {
-    if (!st.decl_names.empty())
-      st.in_decl_accum.push_back( InputDeclaration{ st.decl_names.front(), st.current_range } );
-    st.decl_names.clear(); st.decl_mode = State::DeclMode::None; st.current_range.reset();
+  static void apply(const Input& in, State& st) {
+    if (!st.decl_vars.empty())
+      st.in_decl_accum.push_back( InputDeclaration{ st.decl_vars.front(), st.current_range, std::move(st.decl_vars), NetType::Wire, st.range_expr, st.item_span(in) } );
+    else if (!st.decl_names.empty())
+      st.in_decl_accum.push_back( InputDeclaration{ std::string(st.decl_names.front()), st.current_range, { std::string(st.decl_names.front()) }, NetType::Wire, st.range_expr, st.item_span(in) } );
+    st.decl_names.clear(); st.decl_vars.clear(); st.decl_mode = State::DeclMode::None; st.current_range.reset(); st.range_expr.reset();
   }
 };
 template<> struct action<verilog::grammar::output_declaration> {
   template<typename Input>
-  static void apply(const Input&, State& st) {
-    if (!st.decl_names.empty())
-      st.out_decl_accum.push_back( OutputDeclaration{ st.decl_names.front(), st.current_range } );
-    st.decl_names.clear(); st.decl_mode = State::DeclMode::None; st.current_range.reset();
+  static void apply(const Input& in, State& st) {
+    if (!st.decl_vars.empty())
+      st.out_decl_accum.push_back( OutputDeclaration{ st.decl_vars.front(), st.current_range, std::move(st.decl_vars), NetType::Wire, st.range_expr, st.item_span(in) } );
+    else if (!st.decl_names.empty())
+      st.out_decl_accum.push_back( OutputDeclaration{ std::string(st.decl_names.front()), st.current_range, { std::string(st.decl_names.front()) }, NetType::Wire, st.range_expr, st.item_span(in) } );
+    st.decl_names.clear(); st.decl_vars.clear(); st.decl_mode = State::DeclMode::None; st.current_range.reset(); st.range_expr.reset();
   }
 };
 template<> struct action<verilog::grammar::inout_declaration> {
   template<typename Input>
-  static void apply(const Input&, State& st) {
-    if (!st.decl_names.empty())
-      st.inout_decl_accum.push_back( InoutDeclaration{ st.decl_names.front(), st.current_range } );
-    st.decl_names.clear(); st.decl_mode = State::DeclMode::None; st.current_range.reset();
+  static void apply(const Input& in, State& st) {
+    if (!st.decl_vars.empty())
+      st.inout_decl_accum.push_back( InoutDeclaration{ st.decl_vars.front(), st.current_range, std::move(st.decl_vars), NetType::Wire, st.range_expr, st.item_span(in) } );
+    else if (!st.decl_names.empty())
+      st.inout_decl_accum.push_back( InoutDeclaration{ std::string(st.decl_names.front()), st.current_range, { std::string(st.decl_names.front()) }, NetType::Wire, st.range_expr, st.item_span(in) } );
+    st.decl_names.clear(); st.decl_vars.clear(); st.decl_mode = State::DeclMode::None; st.current_range.reset(); st.range_expr.reset();
   }
 };
 
@@ -645,20 +729,29 @@ template<> struct action<verilog::grammar::assignment> {
       return;
     }
 
-    // Fallback: use identifiers around '=' mark.
+    // Outermost expression spans on either side of '=' (nested concat elements
+    // fire first, so the last expression seen is always the whole side).
+    if (!st.assign_lhs_text.empty() && !st.last_expr_text.empty()) {
+      st.current_assign_list.emplace_back( make_expr_from_text(st.assign_lhs_text),
+                                           make_expr_from_text(st.last_expr_text) );
+      st.assign_lhs_text.clear();
+      return;
+    }
+
+    // Fallback: use identifiers around '=' mark, while the ring still holds both.
     // LHS is the identifier *just before* '=', RHS is the last identifier parsed in the RHS.
-    if (st.eq_ident_mark >= 1 && st.id_history.size() >= st.eq_ident_mark + 1) {
-      const auto& lhs_id = st.id_history[st.eq_ident_mark - 1];
-      const auto& rhs_id = st.id_history.back();
+    if (st.eq_ident_mark >= 1 && st.id_count >= st.eq_ident_mark + 1 && st.id_count - st.eq_ident_mark < st.id_ring.size()) {
+      const auto& lhs_id = st.id_ring[(st.eq_ident_mark - 1) % st.id_ring.size()];
+      const auto& rhs_id = st.id_ring[(st.id_count - 1) % st.id_ring.size()];
       st.current_assign_list.emplace_back( Identifier{ lhs_id }, Identifier{ rhs_id } );
     }
   }
 };
 template<> struct action<verilog::grammar::continuous_assign> {
   template<typename Input>
-  static void apply(const Input&, State& st) {
+  static void apply(const Input& in, State& st) {
     if (!st.current_assign_list.empty()) {
-      st.assign_accum.push_back( ContinuousAssign{ st.current_assign_list } );
+      st.assign_accum.push_back( ContinuousAssign{ std::move(st.current_assign_list), st.item_span(in) } );
       st.current_assign_list.clear();
     }
   }
@@ -668,9 +761,8 @@ template<> struct action<verilog::grammar::continuous_assign> {
 template<> struct action<verilog::grammar::module_inst_head> {
   template<typename Input>
   static void apply(const Input& in, State& st) {
-    std::string id = in.string();
-    if (!id.empty() && id[0]=='\\') id = id.substr(1);
-    st.current_inst_module_name = std::move(id);
+    st.current_inst_module_name.assign(strip_backslash(std::string_view(in.begin(), in.size())));
+    st.inst_params.reset();
   }
 };
 // capture instance name before port list parsing
@@ -678,9 +770,7 @@ template<> struct action<verilog::grammar::instance_name_tok> {
   template<typename Input>
   static void apply(const Input& in, State& st) {
     State::PendingInstance pi;
-    std::string id = in.string();
-    if (!id.empty() && id[0] == '\\') id = id.substr(1);
-    pi.instance_name = std::move(id);
+    pi.instance_name = strip_backslash(std::string_view(in.begin(), in.size()));
     st.pending_instances.emplace_back(std::move(pi));
   }
 };
@@ -690,18 +780,57 @@ template<> struct action<verilog::grammar::module_port_connection> {
   static void apply(const Input& in, State& st) {
     if (st.pending_instances.empty()) return;
     st.pending_instances.back().ports_pos.emplace_back(
-      make_expr_from_text(in.string())
+      make_expr_from_text(std::string_view(in.begin(), in.size()))
     );
   }
 };
 
+// closing ';' / ')' of a declaration, assign or instance: where its span ends
+template<> struct action<verilog::grammar::item_semi> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) { st.item_end = in.end(); }
+};
+template<> struct action<verilog::grammar::item_rparen> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) { st.item_end = in.end(); }
+};
+template<> struct action<verilog::grammar::module_instance> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) {
+    if (!st.pending_instances.empty()) st.pending_instances.back().span = st.item_span(in);
+  }
+};
+
+// ---------------- gate primitives ----------------
+template<> struct action<verilog::grammar::gate_type_tok> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) {
+    const auto kw = grammar::classify_keyword(std::string_view(in.begin(), in.size()));
+    st.gate_type = GateType(uint8_t(kw) - uint8_t(grammar::Keyword::And));
+  }
+};
+template<> struct action<verilog::grammar::gate_instance_name> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) { st.gate_name.assign(strip_backslash(std::string_view(in.begin(), in.size()))); }
+};
+template<> struct action<verilog::grammar::gate_terminal> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) { st.gate_terminals.push_back(make_expr_from_text(std::string_view(in.begin(), in.size()))); }
+};
+template<> struct action<verilog::grammar::gate_instance> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) {
+    st.pending_gates.push_back(State::PendingGate{ st.gate_type, std::move(st.gate_name), uint32_t(st.gate_terminals.size()), st.item_span(in) });
+    st.gate_name.clear();
+  }
+};
+
 // named connection: remember ".name" then store expr afterwards
 template<> struct action<verilog::grammar::named_port_name> {
   template<typename Input>
   static void apply(const Input& in, State& st) {
-    st.temp_named_port = in.string();
-    if (!st.temp_named_port.empty() && st.temp_named_port[0]=='\\')
-      st.temp_named_port = st.temp_named_port.substr(1);
+    st.temp_named_port.assign(strip_backslash(std::string_view(in.begin(), in.size())));
+    st.last_expr_text.clear();   // stays empty for an unconnected ".name()"
   }
 };
 // named connection: remember ".name" then store expr afterwards
@@ -709,7 +838,7 @@ template<> struct action<verilog::grammar::named_port_connection> {
   template<typename Input>
   static void apply(const Input&, State& st) {
     if (st.pending_instances.empty()) return;
-    if (!st.temp_named_port.empty()) {
+    if (!st.temp_named_port.empty() && !st.last_expr_text.empty()) {
       st.pending_instances.back().ports_named.emplace(
         st.temp_named_port, make_expr_from_text(st.last_expr_text)
       );
@@ -718,52 +847,137 @@ template<> struct action<verilog::grammar::named_port_connection> {
   }
 };
 
+// ---------- parameters ----------
+template<> struct action<verilog::grammar::kw_param_kind> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) { st.param_local = in.size() == std::strlen("localparam"); }
+};
+template<> struct action<verilog::grammar::param_name> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) { st.param_name.assign(strip_backslash(std::string_view(in.begin(), in.size()))); }
+};
+template<> struct action<verilog::grammar::param_value> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) { st.param_text.assign(in.begin(), in.size()); }
+};
+// Valued right away, so later defaults and ranges can use it.
+template<> struct action<verilog::grammar::param_assignment> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) {
+    Parameter p;
+    p.name = std::move(st.param_name);
+    p.local = st.param_local;
+    p.span = st.span_of(in.begin(), in.end());
+    try {
+      p.expr = ParamExpr::parse(st.param_text);
+      p.value = p.expr.eval(st.current_module.parameters);
+    } catch (const std::runtime_error& e) {
+      throw tao::pegtl::parse_error(e.what(), in);
+    }
+    st.current_module.parameters.push_back(std::move(p));
+  }
+};
+template<> struct action<verilog::grammar::parameter_declaration> {
+  template<typename Input>
+  static void apply(const Input&, State& st) { st.current_range.reset(); st.range_expr.reset(); }
+};
+
+template<> struct action<verilog::grammar::param_hash> {
+  template<typename Input>
+  static void apply(const Input&, State& st) { st.inst_params = std::make_shared<ParamOverrides>(); }
+};
+template<> struct action<verilog::grammar::positional_param_value> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) {
+    try {
+      st.inst_params->positional.push_back(ParamExpr::parse(std::string_view(in.begin(), in.size())));
+    } catch (const std::runtime_error& e) {
+      throw tao::pegtl::parse_error(e.what(), in);
+    }
+  }
+};
+template<> struct action<verilog::grammar::named_param_name> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) { st.param_name.assign(strip_backslash(std::string_view(in.begin(), in.size()))); st.param_text.clear(); }
+};
+template<> struct action<verilog::grammar::named_param_value> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) { st.param_text.assign(in.begin(), in.size()); }
+};
+// `.W()` keeps the default: nothing is recorded.
+template<> struct action<verilog::grammar::named_param_override> {
+  template<typename Input>
+  static void apply(const Input& in, State& st) {
+    if (st.param_text.empty()) return;
+    try {
+      st.inst_params->named.emplace_back(std::move(st.param_name), ParamExpr::parse(st.param_text));
+    } catch (const std::runtime_error& e) {
+      throw tao::pegtl::parse_error(e.what(), in);
+    }
+    st.param_text.clear();
+  }
+};
+
 // ---------- module assembly ----------
 template<> struct action<verilog::grammar::kw_module> {
   template<typename Input>
-  static void apply(const Input&, State& st) { st.in_module = true; st.current_module = Module{}; }
+  static void apply(const Input&, State& st) {
+    st.in_module = true;
+    st.current_module = Module{};
+    st.param_local = false;
+  }
 };
 template<> struct action<verilog::grammar::module_name_tok> {
   template<typename Input>
   static void apply(const Input& in, State& st) {
-    std::string id = in.string();
-    if (!id.empty() && id[0]=='\\') id = id.substr(1);
-    st.current_module.module_name = id;
+    st.current_module.module_name = strip_backslash(std::string_view(in.begin(), in.size()));
   }
 };
 // push each header port ident directly; no manual scanning
 template<> struct action<verilog::grammar::header_port_ident> {
   template<typename Input>
   static void apply(const Input& in, State& st) {
-    std::string id = in.string();
-    if (!id.empty() && id[0]=='\\') id = id.substr(1);
-    st.current_module.port_list.push_back(std::move(id));
+    st.current_module.port_list.emplace_back(strip_backslash(std::string_view(in.begin(), in.size())));
   }
 };
 template<> struct action<verilog::grammar::module_item> {
   template<typename Input>
   static void apply(const Input&, State& st) {
-    if (!st.net_decl_accum.empty()) { st.current_module.net_declarations.insert(st.current_module.net_declarations.end(), st.net_decl_accum.begin(), st.net_decl_accum.end()); st.net_decl_accum.clear(); }
-    if (!st.in_decl_accum.empty())  { st.current_module.input_declarations.insert(st.current_module.input_declarations.end(), st.in_decl_accum.begin(), st.in_decl_accum.end()); st.in_decl_accum.clear(); }
-    if (!st.out_decl_accum.empty()) { st.current_module.output_declarations.insert(st.current_module.output_declarations.end(), st.out_decl_accum.begin(), st.out_decl_accum.end()); st.out_decl_accum.clear(); }
-    if (!st.inout_decl_accum.empty()){ st.current_module.inout_declarations.insert(st.current_module.inout_declarations.end(), st.inout_decl_accum.begin(), st.inout_decl_accum.end()); st.inout_decl_accum.clear(); }
-    if (!st.assign_accum.empty())   { st.current_module.assignments.insert(st.current_module.assignments.end(), st.assign_accum.begin(), st.assign_accum.end()); st.assign_accum.clear(); }
+    if (!st.net_decl_accum.empty()) { st.current_module.net_declarations.insert(st.current_module.net_declarations.end(), std::make_move_iterator(st.net_decl_accum.begin()), std::make_move_iterator(st.net_decl_accum.end())); st.net_decl_accum.clear(); }
+    if (!st.in_decl_accum.empty())  { st.current_module.input_declarations.insert(st.current_module.input_declarations.end(), std::make_move_iterator(st.in_decl_accum.begin()), std::make_move_iterator(st.in_decl_accum.end())); st.in_decl_accum.clear(); }
+    if (!st.out_decl_accum.empty()) { st.current_module.output_declarations.insert(st.current_module.output_declarations.end(), std::make_move_iterator(st.out_decl_accum.begin()), std::make_move_iterator(st.out_decl_accum.end())); st.out_decl_accum.clear(); }
+    if (!st.inout_decl_accum.empty()){ st.current_module.inout_declarations.insert(st.current_module.inout_declarations.end(), std::make_move_iterator(st.inout_decl_accum.begin()), std::make_move_iterator(st.inout_decl_accum.end())); st.inout_decl_accum.clear(); }
+    if (!st.assign_accum.empty())   { st.current_module.assignments.insert(st.current_module.assignments.end(), std::make_move_iterator(st.assign_accum.begin()), std::make_move_iterator(st.assign_accum.end())); st.assign_accum.clear(); }
     if (!st.pending_instances.empty()) {
       for (auto& pi : st.pending_instances) {
         ModuleInstance mi;
         mi.module_name  = st.current_inst_module_name;
-        mi.instance_name= pi.instance_name;
+        mi.instance_name= std::move(pi.instance_name);
         mi.ports_pos    = std::move(pi.ports_pos);
         mi.ports_named  = std::move(pi.ports_named);
+        mi.params       = st.inst_params;
+        mi.span         = pi.span;
         st.current_module.module_instances.emplace_back(std::move(mi));
       }
       st.pending_instances.clear();
+      st.inst_params.reset();
+    }
+    uint32_t k = 0;
+    for (auto& pg : st.pending_gates) {
+      GateTable& t = st.current_module.gates[size_t(pg.type)];
+      t.names.push_back(std::move(pg.name));
+      for (; k < pg.terminals_end; ++k) t.terminals.push_back(std::move(st.gate_terminals[k]));
+      t.ends.push_back(uint32_t(t.terminals.size()));
+      t.spans.push_back(pg.span);
     }
+    st.pending_gates.clear();
+    st.gate_terminals.clear();
   }
 };
 template<> struct action<verilog::grammar::module> {
   template<typename Input>
-  static void apply(const Input&, State& st) {
+  static void apply(const Input& in, State& st) {
+    st.current_module.span = st.span_of(in.begin(), in.end());
     st.modules_accum.emplace_back(std::move(st.current_module));
     st.current_module = Module{}; st.in_module = false;
   }
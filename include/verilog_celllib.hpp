@@ -0,0 +1,36 @@
+#pragma once
+#include "verilog_connectivity.hpp"
+#include "verilog_stats.hpp"
+
+namespace verilog {
+
+// Leaf-cell interfaces for an InterfaceTable. Cells loaded here replace
+// same-named entries.
+//
+// From Verilog stub modules parsed by this library (port order, directions
+// and widths as in interface_of):
+void add_cell_stubs(InterfaceTable& lib, const Netlist& stubs);
+
+// From a pin-list file, one cell per line, '#' to end of line is a comment:
+//
+//   DFFRX1  D:in CK:in RN:in Q:out QN:out
+//   RAM16   A[3:0]:in D[7:0]:in WE:in Q[7:0]:out
+//
+// Pins are listed in port order; a direction is in/input, out/output or
+// inout. Throws parse_error with the line number on malformed input.
+void add_pin_list(InterfaceTable& lib, std::string_view text, const std::string& source = "pin_list");
+void add_pin_list_file(InterfaceTable& lib, const std::string& path);
+
+// Pin maps of a whole design, parallel to Netlist::modules, plus what could
+// not be resolved. Modules are mapped in parallel; the result does not depend
+// on the thread count. `lib` normally holds the netlist's own modules too:
+// start from InterfaceTable(nl) and add the cell library to it.
+struct PinAnnotation {
+  std::vector<ModulePinMap> modules;
+  std::vector<std::string> unknown_cells;   // masters with no interface, sorted, once each
+  std::vector<PinIssue> unknown_pins;       // named pins the master lacks, "#k" past its last port
+};
+
+PinAnnotation annotate_pins(const Netlist& nl, const InterfaceTable& lib, unsigned threads = 0);
+
+} // namespace verilog
@@ -0,0 +1,59 @@
+#pragma once
+#include "veriloglib.hpp"
+
+namespace verilog {
+
+class InterfaceTable;
+
+enum class Severity : uint8_t { Warning, Error };
+
+enum class CheckId : uint8_t {
+  DuplicateModule,        // a module name defined twice (the first definition is used)
+  DuplicateName,          // an instance name, or a net declared twice, within one module
+  PortWithoutDirection,   // in the header's port list, no input/output/inout declaration
+  DirectionWithoutPort,   // input/output/inout declaration of a name not in the port list
+  UndeclaredNet,          // used in a continuous assign but never declared
+  ImplicitNet,            // used only in instance connections, never declared (legal, but often a typo)
+  BadSelect,              // bit/part select outside the declared range, or on a scalar
+  UndefinedModule,        // master neither defined in the netlist nor in the cell library
+  UnknownPin,             // named pin the master lacks, or more positional connections than ports
+  WidthMismatch,          // connection width differs from the port width; assign sides differ
+  MultipleDrivers,        // net bit driven by more than one output (or input port / assign); not tri or supply nets
+};
+
+const char* to_string(CheckId id);
+
+struct Diagnostic {
+  Severity severity;
+  CheckId check;
+  std::string module;
+  std::string object;    // net, instance, port or module the finding is about
+  std::string message;
+  std::string file;      // CheckOptions::file; for preprocessed netlists, the file the item is in
+  uint32_t line = 0;     // start of the offending item (declaration, assign, instance,
+  uint32_t column = 0;   // or the module header); 0 when the netlist has no line table
+
+  std::string to_string() const;   // "file:line:column: error: [multiple-drivers] module 'm': ..."
+};
+
+struct CheckOptions {
+  unsigned threads = 0;                    // 0: hardware concurrency
+  const InterfaceTable* cells = nullptr;   // leaf-cell interfaces for masters the netlist does not define
+  std::string file;                        // copied into every Diagnostic (preprocessed netlists name their own files)
+  bool implicit_nets = true;               // report ImplicitNet warnings
+};
+
+struct CheckResult {
+  std::vector<Diagnostic> diagnostics;   // module order, then check order within a module
+  size_t errors = 0, warnings = 0;
+
+  std::string report(size_t max_items = 200) const;
+};
+
+// Lint of the parse result. Each module is checked on its own, in parallel;
+// results are merged in module order, so the output does not depend on the
+// thread count. Checks that need a master's ports (pins, widths, drivers)
+// use the netlist's own modules plus `opts.cells`.
+CheckResult check_netlist(const Netlist& nl, const CheckOptions& opts = {});
+
+} // namespace verilog
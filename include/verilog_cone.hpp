@@ -0,0 +1,72 @@
+#pragma once
+#include "veriloglib.hpp"
+#include "verilog_connectivity.hpp"
+#include <functional>
+#include <span>
+
+namespace verilog {
+
+struct ConeOptions {
+  // Instances whose master matches one of these patterns end the cone:
+  // `*` and `?` wildcards, as in "DFF*" or "*LATCH*".
+  std::vector<std::string> stop_at;
+  std::function<bool(const ModuleInstance&)> stop_if;   // further stop condition; may be empty
+  uint32_t max_depth = 0;   // cells, assigns and gates crossed from the start; 0: unlimited
+  unsigned threads = 1;     // >1: each BFS level is expanded in parallel; 0: hardware concurrency
+};
+
+// The nets and nodes (ModuleGraph node ids) of one cone, each ascending.
+// `boundary` holds the nodes where the walk stopped: module ports, stop
+// cells, and nodes reached at max_depth. They are part of `nodes`, but the
+// walk did not continue through them.
+struct Cone {
+  std::vector<NetId> nets;
+  std::vector<uint32_t> nodes;
+  std::vector<uint32_t> boundary;
+};
+
+// Transitive fan-in and fan-out cones of one module. Nets and nodes visited
+// are tracked in bitsets, so a query costs a few bits per net and node of
+// the module plus the cone itself. An instance is crossed from any of its
+// input pins to all of its outputs (and back for fan-in), so cells of
+// defined modules are treated as opaque; a continuous assign of equal-width
+// sides is crossed bit by bit. Inout pins, and pins of unknown direction,
+// are taken as both driving and loading their net. The walk never crosses a
+// module port. The graph must outlive the extractor.
+class ConeExtractor {
+public:
+  explicit ConeExtractor(const ModuleGraph& g, ConeOptions opts = {});
+
+  const ModuleGraph& graph() const { return *g_; }
+
+  // Everything that drives the start nets, back to ports and stop cells.
+  Cone fan_in(std::span<const NetId> start) const;
+  // Everything the start nets drive, forward to ports and stop cells.
+  Cone fan_out(std::span<const NetId> start) const;
+
+  // Bits of a net ("a", "bus[3]", or "bus" for every bit), MSB first, and of
+  // the connection to pin `pin` of instance `instance`. Throw
+  // std::runtime_error when the net, instance or pin is not in the module.
+  std::vector<NetId> net(std::string_view name) const;
+  std::vector<NetId> pin(std::string_view instance, std::string_view pin) const;
+
+  // The cone as a module of its own (stop cells included); extract_module().
+  Module to_module(const Cone& c, std::string name) const;
+
+private:
+  Cone walk(std::span<const NetId> start, bool forward) const;
+
+  const ModuleGraph* g_;
+  ConeOptions opts_;
+  std::vector<uint8_t> stop_;   // per node
+};
+
+// Some nodes of a module as a module of their own, for write_verilog(): the
+// instances, assign pairs and gates among them, with declarations for every
+// net they touch. A net becomes an input when the nodes read it but none of
+// them drives it, an output when they drive it and something outside reads
+// or also drives it (inout then), and a wire otherwise; nets of module ports
+// among the nodes keep the port's direction.
+Module extract_module(const ModuleGraph& g, std::span<const uint32_t> nodes, std::string name);
+
+} // namespace verilog
@@ -0,0 +1,173 @@
+#pragma once
+#include "veriloglib.hpp"
+#include <deque>
+#include <span>
+#include <unordered_map>
+
+namespace verilog {
+
+enum class PortDir : uint8_t { Unknown, Input, Output, Inout };
+
+// Port interface of a module or leaf cell: ports in header order with their
+// direction and width in bits.
+struct ModuleInterface {
+  static constexpr uint32_t npos = ~uint32_t(0);
+  static constexpr size_t kLinearPorts = 16;   // resolve() scans lists this short instead of merging
+
+  std::string name;
+  std::vector<std::string> ports;
+  std::vector<PortDir>     dirs;
+  std::vector<uint32_t>    widths;
+  std::vector<uint32_t>    by_name;   // port indices sorted by name; filled by index()
+
+  void index();                                 // (re)builds by_name after editing ports
+  uint32_t find(std::string_view port) const;   // index into ports, or npos
+  // Port index of every named connection, in map order (npos for pins the
+  // cell lacks). For wide cells the map and by_name are both sorted, so this
+  // is a single merge pass with no hashing.
+  void resolve(const std::map<std::string, Expr>& named, uint32_t* out) const;
+};
+
+// Interface of a parsed module: header order, directions and widths taken
+// from its input/output/inout declarations.
+ModuleInterface interface_of(const Module& m);
+
+struct string_hash {
+  using is_transparent = void;
+  size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+// Interfaces by module name. Built from the modules of a Netlist; leaf cells
+// that the netlist only instantiates can be added by hand.
+class InterfaceTable {
+public:
+  InterfaceTable() = default;
+  explicit InterfaceTable(const Netlist& nl);
+
+  void add(ModuleInterface mi);                        // replaces a same-named entry
+  const ModuleInterface* find(std::string_view name) const;
+  size_t size() const { return items_.size(); }
+  auto begin() const { return items_.begin(); }
+  auto end() const   { return items_.end(); }
+
+private:
+  std::deque<ModuleInterface> items_;
+  std::unordered_map<std::string, size_t, string_hash, std::equal_to<>> index_;
+};
+
+// Master and canonical pin of every instance connection of one module, as
+// parallel arrays. Connections of instance i are [conn_begin[i],
+// conn_begin[i+1]): its ports_pos in order, then its ports_named in map order.
+struct ModulePinMap {
+  std::vector<const ModuleInterface*> master;   // per instance; nullptr for unknown cells
+  std::vector<uint32_t> conn_begin{0};          // instances + 1 entries
+  std::vector<uint32_t> pin;                    // index into master->ports, or ModuleInterface::npos
+  std::vector<PortDir>  dir;                    // Unknown where pin is npos
+};
+
+ModulePinMap map_pins(const Module& m, const InterfaceTable& ifaces);
+
+using NetId = uint32_t;
+constexpr NetId kNoNet = ~NetId(0);
+
+// Bit-level connectivity of one Module. Every net bit gets a NetId; every
+// module port, instance, continuous-assign pair and gate primitive is a node
+// (in that order), and pins tie
+// node bits to nets. Directions are as seen from the node, so an Output pin
+// drives its net: an input *port* of the module is an Output pin here.
+class ModuleGraph {
+public:
+  enum class NodeKind : uint8_t { Port, Instance, Assign, Gate };
+
+  struct Pin {
+    uint32_t node;
+    NetId    net;
+    PortDir  dir;
+    uint32_t port;   // index into the master's ModuleInterface, or ModuleInterface::npos
+    uint32_t bit;    // bit within that port, LSB = 0
+    uint32_t conn;   // instance: positional index, or ports_pos.size() + rank in ports_named;
+                     // assign: 0 = lhs, 1 = rhs; gate: terminal index; port: 0
+  };
+
+  ModuleGraph(const Module& m, const InterfaceTable& ifaces);
+  // From a pin map built beforehand (map_pins, annotate_pins): no name lookups at all.
+  ModuleGraph(const Module& m, const ModulePinMap& pins);
+
+  const Module& module() const { return *module_; }
+
+  size_t num_nets() const  { return net_bus_.size(); }
+  size_t num_nodes() const { return node_kind_.size(); }
+  size_t num_pins() const  { return pins_.size(); }
+
+  std::string net_name(NetId n) const;               // "a" or "bus[3]"
+  NetId find_net(std::string_view name) const;       // kNoNet if unknown
+  bool is_declared(NetId n) const;                   // false for implicit nets
+
+  NodeKind node_kind(uint32_t node) const { return node_kind_[node]; }
+  // Index into port_list, module_instances, or the flattened assign pairs;
+  // for gates, the row in its type's GateTable (see gate_ref()).
+  uint32_t node_ref(uint32_t node) const  { return node_ref_[node]; }
+  // Type and row in Module::gates of a Gate node.
+  std::pair<GateType, uint32_t> gate_ref(uint32_t node) const {
+    return { node_gate_[node], node_ref_[node] };
+  }
+  // Master interface of an Instance node (nullptr for unknown cells).
+  const ModuleInterface* node_master(uint32_t node) const { return node_master_[node]; }
+
+  std::span<const Pin> node_pins(uint32_t node) const {
+    return { pins_.data() + node_pin_begin_[node], pins_.data() + node_pin_begin_[node + 1] };
+  }
+  std::span<const uint32_t> net_pins(NetId n) const {   // indices into pins()
+    return { net_pins_.data() + net_pin_begin_[n], net_pins_.data() + net_pin_begin_[n + 1] };
+  }
+  const std::vector<Pin>& pins() const { return pins_; }
+
+  // Formal name of a pin: the master's port name when known, else the named
+  // connection's key, "#k" for the k-th positional connection or gate
+  // terminal, or "lhs"/"rhs" for assigns. Module port pins give the port name.
+  std::string pin_name(const Pin& p) const;
+
+  // Expand an expression to its net bits, MSB first (declared order).
+  void expr_bits(const Expr& e, std::vector<NetId>& out) const;
+
+  // A declared or implicit net and its bits first .. first + width - 1, in
+  // declared order ([start:end]).
+  struct Bus {
+    std::string name;
+    NetId   first = 0;
+    int64_t start = 0, end = 0;   // declared [start:end]
+    bool    vector = false;
+    bool    declared = true;
+  };
+  size_t num_buses() const { return buses_.size(); }
+  const Bus& bus(uint32_t b) const { return buses_[b]; }
+  uint32_t net_bus(NetId n) const { return net_bus_[n]; }
+  uint32_t find_bus(std::string_view name) const;   // ModuleInterface::npos if unknown
+
+private:
+  uint32_t declare(const std::string& name, const std::optional<Range>& r, bool declared);
+  NetId bit_of(const std::string& name, std::optional<int64_t> index, bool create);
+  void bits(const Expr& e, std::vector<NetId>& out, bool create);
+  void add_node(NodeKind k, uint32_t ref, const ModuleInterface* master, GateType gate = GateType::And);
+  void add_pin(NetId net, PortDir dir, uint32_t port, uint32_t bit, uint32_t conn);
+  void connect(const std::vector<NetId>& bits, PortDir dir, uint32_t port, uint32_t conn);
+  void build(const ModulePinMap& pins);
+
+  const Module* module_;
+  std::deque<Bus> buses_;
+  std::unordered_map<std::string, uint32_t, string_hash, std::equal_to<>> bus_index_;
+  std::unordered_map<std::string, NetId, string_hash, std::equal_to<>> implicit_bits_;
+  std::vector<uint32_t> net_bus_;
+
+  std::vector<NodeKind> node_kind_;
+  std::vector<uint32_t> node_ref_;
+  std::vector<GateType> node_gate_;   // meaningful for Gate nodes only
+  std::vector<const ModuleInterface*> node_master_;
+  std::vector<uint32_t> node_pin_begin_{0};
+  std::vector<Pin> pins_;
+
+  std::vector<uint32_t> net_pin_begin_;
+  std::vector<uint32_t> net_pins_;
+};
+
+} // namespace verilog
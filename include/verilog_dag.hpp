@@ -0,0 +1,61 @@
+#pragma once
+#include "veriloglib.hpp"
+#include <functional>
+#include <span>
+#include <unordered_map>
+
+namespace verilog {
+
+// Which module definitions instantiate which, over every module of a netlist
+// (node i is nl.modules[i]; the netlist must outlive the DAG). An instance
+// names the first definition of its master; masters the netlist does not
+// define are leaf cells and add no edge. Edges are deduplicated, so a module
+// with a thousand instances of one master has one child. Built from hashed
+// name lookups, one per run of instances of the same master, in parallel
+// over modules. Throws std::runtime_error naming the modules of an
+// instantiation cycle ("a -> b -> a").
+class ModuleDag {
+public:
+  static constexpr uint32_t kNone = ~uint32_t(0);
+
+  explicit ModuleDag(const Netlist& nl, unsigned threads = 0);
+
+  size_t size() const { return mods_.size(); }
+  const Module& module(uint32_t m) const { return *mods_[m]; }
+  uint32_t find(std::string_view name) const;   // first definition; kNone when undefined
+
+  std::span<const uint32_t> children(uint32_t m) const { return span(child_, child_begin_, m); }   // ascending
+  std::span<const uint32_t> parents(uint32_t m) const { return span(parent_, parent_begin_, m); }  // ascending
+  // Modules nothing instantiates, ascending.
+  std::span<const uint32_t> roots() const { return roots_; }
+  // Every module after all of its children; the order of run_bottom_up with one thread.
+  std::span<const uint32_t> bottom_up() const { return order_; }
+  // 0 for a module with no defined children, else one above its highest child.
+  uint32_t height(uint32_t m) const { return height_[m]; }
+  // Masters instantiated somewhere but defined nowhere, sorted and distinct.
+  std::span<const std::string_view> undefined() const { return undefined_; }
+
+private:
+  static std::span<const uint32_t> span(const std::vector<uint32_t>& v, const std::vector<uint32_t>& begin, uint32_t m) {
+    return { v.data() + begin[m], v.data() + begin[m + 1] };
+  }
+
+  std::vector<const Module*> mods_;
+  std::unordered_map<std::string_view, uint32_t> index_;
+  std::vector<uint32_t> child_, child_begin_, parent_, parent_begin_;
+  std::vector<uint32_t> roots_, order_, height_;
+  std::vector<std::string_view> undefined_;
+};
+
+// Calls visit(m) once for every module of the DAG, each only after visit has
+// returned for all of its children, on up to `threads` workers (0: hardware
+// concurrency). A module starts as soon as its last child finishes, not when
+// a whole level of the hierarchy is done, so one deep subtree does not hold
+// up the rest. Each worker keeps the modules it made ready in a deque of its
+// own and runs the newest first, close in the hierarchy to what it just did;
+// an idle worker steals the oldest from another's deque. Everything a child's
+// visit wrote is visible to its parents' visits. The first exception thrown
+// by visit stops the run (modules already started finish) and is rethrown.
+void run_bottom_up(const ModuleDag& dag, const std::function<void(uint32_t m)>& visit, unsigned threads = 0);
+
+} // namespace verilog
@@ -0,0 +1,69 @@
+#pragma once
+#include "veriloglib.hpp"
+#include <functional>
+
+namespace verilog {
+
+enum class DiffKind : uint8_t { Added, Removed, Changed };
+
+enum class DiffObject : uint8_t {
+  Module,
+  Port,         // name in the header's port list
+  Parameter,    // value
+  Net,          // input/output/inout/net declaration: kind and range
+  Instance,     // master
+  Connection,   // "inst.pin", or "inst.#k" for positional connections: the connected expression
+  Assign,       // one "lhs = rhs" of a continuous assign, matched by text
+  Gate,         // gate label ("g0", "and#3"): its terminals
+};
+
+const char* to_string(DiffKind k);
+const char* to_string(DiffObject o);
+
+struct DiffEntry {
+  DiffKind kind;
+  DiffObject object;
+  std::string module;   // module the object is in; the module itself for DiffObject::Module
+  std::string name;     // empty for modules
+  std::string before;   // value in the first netlist (empty when added)
+  std::string after;    // value in the second netlist (empty when removed)
+
+  std::string to_string() const;   // "~ top: instance u1: INVX1 -> INVX2"
+  std::string to_json() const;     // one object, no trailing newline
+};
+
+struct DiffOptions {
+  unsigned threads = 0;         // 0: hardware concurrency
+  size_t modules_per_batch = 64;   // modules compared, and their entries held, at once when streaming
+};
+
+struct NetlistDiff {
+  std::vector<DiffEntry> entries;
+  size_t added = 0, removed = 0, changed = 0;
+
+  bool empty() const { return entries.empty(); }
+  std::string report(size_t max_items = 200) const;
+  std::string to_json() const;   // {"added":..,"removed":..,"changed":..,"entries":[...]}
+};
+
+// Structural diff of two netlists. Modules, instances, nets and parameters
+// are matched by name (the first definition of a module name is used);
+// instance names are matched through sorted 64-bit name hashes, which costs
+// 20 bytes per instance of the module being compared rather than a node-based
+// hash map. Matched instances have their masters and connections compared in
+// parallel.
+//
+// Entries come per module of `a` in order (ports, parameters, nets,
+// instances and their connections in `a`'s order followed by instances only
+// in `b`, assigns, gates), then the modules only in `b`. A module only in one
+// netlist is one Module entry, not a list of its contents. The order does not
+// depend on the thread count.
+NetlistDiff diff_netlists(const Netlist& a, const Netlist& b, const DiffOptions& opts = {});
+
+// The same entries, streamed: modules are compared a batch at a time and each
+// batch's entries are passed to `sink` in order and then dropped, so memory
+// holds one batch rather than the whole diff.
+void diff_netlists(const Netlist& a, const Netlist& b, const DiffOptions& opts,
+                   const std::function<void(const DiffEntry&)>& sink);
+
+} // namespace verilog
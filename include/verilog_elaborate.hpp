@@ -0,0 +1,41 @@
+#pragma once
+#include "veriloglib.hpp"
+
+namespace verilog {
+
+struct ElaborateOptions {
+  std::string top;          // empty: every module nothing instantiates, at its defaults
+  unsigned threads = 0;     // 0: hardware concurrency
+  unsigned max_depth = 256; // instantiation levels before giving up on a recursion
+};
+
+struct ElaboratedNetlist {
+  Netlist netlist;
+  size_t specializations = 0;   // (module, parameter values) pairs elaborated, = netlist.modules.size()
+  size_t instances = 0;         // instances of defined modules resolved to a specialization
+};
+
+// Resolves parameters. Every module reachable from the top(s) is elaborated
+// once per distinct tuple of parameter values its instances give it. An
+// instance's #(...) values are looked up in a hash map keyed by (module,
+// overrides), and new tuples in one keyed by (module, values), so thousands of
+// instances with the same overrides cost one lookup each and one elaboration
+// in all.
+//
+// A specialization with the module's default values keeps its name; another
+// is named "<module>_<param><value>..." after the non-local parameters whose
+// values their default expressions do not give ("ram_W16", not "ram_W16_D32"
+// when D = W * 2), with "_<k>" added if that name is taken. In the result
+// every declaration range is a constant Range, parameters are literals of
+// their chosen values, and instances name their specialization and carry no
+// overrides; instances of undefined masters keep theirs, reduced to literals.
+// Modules come out in discovery order: the tops, then level by level.
+// Levels are elaborated in parallel and merged in order, so the result does
+// not depend on the thread count.
+//
+// Throws std::runtime_error for an unknown top, an unknown or local
+// parameter named in an override, too many positional values, a division by
+// zero, or an instantiation recursion deeper than opts.max_depth.
+ElaboratedNetlist elaborate(const Netlist& nl, const ElaborateOptions& opts = {});
+
+} // namespace verilog
@@ -0,0 +1,224 @@
+#pragma once
+#include "veriloglib.hpp"
+#include <iosfwd>
+
+namespace verilog {
+
+class LazyNetlist;
+
+struct ExportOptions {
+  unsigned threads = 0;             // 0: hardware concurrency
+  size_t modules_per_batch = 64;    // modules encoded, and their output held, at once
+};
+
+// Streaming export of a netlist, module by module. Each batch of modules is
+// encoded in parallel into one buffer per module and the buffers are written
+// in module order, so the output does not depend on the thread count and no
+// more than one batch of encoded modules is held at a time. The LazyNetlist
+// overloads parse each body not parsed yet, write it and drop it again, so a
+// netlist too large to hold parsed is exported in one pass with memory for a
+// batch of modules. Write errors on `out` throw std::runtime_error.
+//
+// JSON: {"modules":[ one object per module, one per line ]}. Names are the
+// names themselves; expressions are Verilog text as write_expr() gives it.
+//   {"name":"top","ports":["a","y"],
+//    "parameters":[{"name":"W","expr":"8","value":8,"local":false}],
+//    "declarations":[{"kind":"input","names":["a"],"range":[7,0],"range_expr":["W-1","0"]}],
+//    "assigns":[["y","a"]],
+//    "instances":[{"master":"INVX1","name":"u1","params":{"positional":["W"],"named":{"N":"2"}},
+//                  "ports":["a"],"pins":{"Y":"y"}}],
+//    "gates":[{"type":"nand","name":"g1","terminals":["y","a","b"]}]}
+// "kind" is input, output, inout, wire, tri, supply0 or supply1. "range",
+// "range_expr", "params", "ports" and "pins" are left out when absent;
+// "assigns" lists the lhs = rhs pairs of every assign statement in order.
+void write_json(const Netlist& nl, std::ostream& out, const ExportOptions& opts = {});
+void write_json(const LazyNetlist& nl, std::ostream& out, const ExportOptions& opts = {});
+std::string to_json(const Module& m);   // one module object, no trailing newline
+
+// Binary export, read back in place by binary::NetlistView (below) without
+// parsing or copying, in the manner of FlatBuffers or Cap'n Proto:
+//
+//   file    "VNB1", u32 reserved, the records (each padded to 8 bytes), index, trailer
+//   index   u64 offset of each record from the start of the file
+//   trailer u64 offset of the index, u32 number of records, "VNB1"
+//
+// A record holds one module. It starts with a fixed table and the tables,
+// lists and strings it refers to follow it; every offset is a u32 from the
+// start of the record, so a record can be read on its own. A name used more
+// than once in a record is stored once and shared. Integers are
+// little-endian and read with memcpy, so the buffer needs no alignment.
+//
+//   Str   u32 offset, u32 length                  (bytes, not terminated)
+//   List  u32 offset, u32 count                   (of fixed-size elements)
+//   Expr  u32 kind, u32 a, u32 b, u32 c           16 bytes
+//         0 identifier  a,b: name Str
+//         1 indexed     a,b: name Str; c: offset of the i64 index
+//         2 sliced      a,b: name Str; c: offset of the i64 msb, i64 lsb
+//         3 concat      a,b: List of Expr
+//         4 constant    a: width; b: offset of the value and then the x/z
+//                       plane, ceil(width / 64) u64 words each; c: 1 if sized
+//   Record    +0 u32 size of the record in bytes  +4 u32 reserved
+//             +8 Str name  +16 List<Str> ports  +24 List<Param>  +32 List<Decl>
+//             +40 List<Assign>  +48 List<Instance>  +56 List<Gate>       64 bytes
+//   Param     +0 Str name  +8 Str expr  +16 i64 value  +24 u32 local  +28 u32 reserved   32
+//   Decl      +0 u32 kind (0 input, 1 output, 2 inout, 3 net) | NetType << 8 | has range << 16
+//             +4 u32 reserved  +8 i64 msb  +16 i64 lsb  +24 Str msb expr  +32 Str lsb expr
+//             +40 List<Str> names                                                48
+//   Assign    +0 List<Expr pair> (lhs, rhs: 32 bytes each), one assign statement  8
+//   Instance  +0 Str master  +8 Str name  +16 List<Expr> positional ports
+//             +24 List<Pin> named ports (Pin: Str pin, Expr: 24 bytes)
+//             +32 u32 has #(...)  +36 u32 reserved  +40 List<Str> positional overrides
+//             +48 List<Str pair> named overrides (name, expr: 16 bytes)            56
+//   Gate      +0 u32 GateType  +4 u32 reserved  +8 Str name  +16 List<Expr> terminals   24
+//
+// Parameter and range expressions are Str in ParamExpr::to_string() form.
+// Declarations come inputs, outputs, inouts, then nets; gates by GateType,
+// then in order. Source spans are not exported.
+void write_binary(const Netlist& nl, std::ostream& out, const ExportOptions& opts = {});
+void write_binary(const LazyNetlist& nl, std::ostream& out, const ExportOptions& opts = {});
+
+namespace binary {
+
+// A position in one record. Every read is checked against the record's size
+// and throws std::runtime_error when it falls outside, so a damaged buffer
+// cannot be read past its end.
+class Cursor {
+public:
+  Cursor() = default;
+  Cursor(const char* record, uint32_t size, uint32_t at) : rec_(record), size_(size), at_(at) {}
+
+  uint32_t u32(uint32_t field) const;
+  int64_t i64(uint32_t field) const;
+  std::string_view str(uint32_t field) const;   // the Str at `field`, as a view into the buffer
+  uint32_t count(uint32_t field) const;         // elements of the List at `field`
+  Cursor item(uint32_t field, uint32_t k, uint32_t elem_size) const;   // element k of that List
+  Cursor at(uint32_t offset) const { return { rec_, size_, offset }; }   // from the record's start
+  Cursor skip(uint32_t bytes) const { return { rec_, size_, at_ + bytes }; }
+
+private:
+  const char* check(uint64_t offset, uint64_t bytes) const;
+
+  const char* rec_ = nullptr;
+  uint32_t size_ = 0;
+  uint32_t at_ = 0;
+};
+
+enum class ExprKind : uint32_t { Identifier, Indexed, Sliced, Concat, Constant };
+enum class DeclKind : uint8_t { Input, Output, Inout, Net };
+
+class ExprView {
+public:
+  explicit ExprView(Cursor c) : c_(c) {}
+  ExprKind kind() const { return ExprKind(c_.u32(0)); }
+  std::string_view name() const { return c_.str(4); }          // Identifier, Indexed, Sliced
+  int64_t index() const { return c_.at(c_.u32(12)).i64(0); }   // Indexed
+  int64_t msb() const { return c_.at(c_.u32(12)).i64(0); }     // Sliced
+  int64_t lsb() const { return c_.at(c_.u32(12)).i64(8); }     // Sliced
+  uint32_t size() const { return c_.count(4); }                // Concat
+  ExprView element(uint32_t k) const { return ExprView(c_.item(4, k, 16)); }
+  LogicVector constant() const;                                // Constant
+  bool sized() const { return c_.u32(12) != 0; }               // Constant
+  Expr to_expr() const;
+
+private:
+  Cursor c_;
+};
+
+struct ParamView {
+  Cursor c;
+  std::string_view name() const { return c.str(0); }
+  std::string_view expr() const { return c.str(8); }
+  int64_t value() const { return c.i64(16); }
+  bool local() const { return c.u32(24) != 0; }
+};
+
+struct DeclView {
+  Cursor c;
+  DeclKind kind() const { return DeclKind(c.u32(0) & 0xff); }
+  NetType type() const { return NetType((c.u32(0) >> 8) & 0xff); }
+  bool has_range() const { return (c.u32(0) >> 16) & 1; }
+  int64_t msb() const { return c.i64(8); }
+  int64_t lsb() const { return c.i64(16); }
+  std::string_view msb_expr() const { return c.str(24); }   // empty unless the range uses parameters
+  std::string_view lsb_expr() const { return c.str(32); }
+  uint32_t num_names() const { return c.count(40); }
+  std::string_view name(uint32_t k) const { return c.item(40, k, 8).str(0); }
+};
+
+struct AssignView {
+  Cursor c;
+  uint32_t size() const { return c.count(0); }
+  ExprView lhs(uint32_t k) const { return ExprView(c.item(0, k, 32)); }
+  ExprView rhs(uint32_t k) const { return ExprView(c.item(0, k, 32).skip(16)); }
+};
+
+struct InstanceView {
+  Cursor c;
+  std::string_view master() const { return c.str(0); }
+  std::string_view name() const { return c.str(8); }
+  uint32_t num_positional() const { return c.count(16); }
+  ExprView positional(uint32_t k) const { return ExprView(c.item(16, k, 16)); }
+  uint32_t num_named() const { return c.count(24); }
+  std::string_view pin(uint32_t k) const { return c.item(24, k, 24).str(0); }
+  ExprView named(uint32_t k) const { return ExprView(c.item(24, k, 24).skip(8)); }
+  bool has_params() const { return c.u32(32) != 0; }
+  uint32_t num_positional_params() const { return c.count(40); }
+  std::string_view positional_param(uint32_t k) const { return c.item(40, k, 8).str(0); }
+  uint32_t num_named_params() const { return c.count(48); }
+  std::string_view param_name(uint32_t k) const { return c.item(48, k, 16).str(0); }
+  std::string_view param_expr(uint32_t k) const { return c.item(48, k, 16).str(8); }
+};
+
+struct GateView {
+  Cursor c;
+  GateType type() const { return GateType(c.u32(0)); }
+  std::string_view name() const { return c.str(8); }   // empty when unnamed
+  uint32_t num_terminals() const { return c.count(16); }
+  ExprView terminal(uint32_t k) const { return ExprView(c.item(16, k, 16)); }
+};
+
+class ModuleView {
+public:
+  explicit ModuleView(Cursor record) : c_(record) {}
+  std::string_view name() const { return c_.str(8); }
+  uint32_t num_ports() const { return c_.count(16); }
+  std::string_view port(uint32_t k) const { return c_.item(16, k, 8).str(0); }
+  uint32_t num_parameters() const { return c_.count(24); }
+  ParamView parameter(uint32_t k) const { return { c_.item(24, k, 32) }; }
+  uint32_t num_declarations() const { return c_.count(32); }
+  DeclView declaration(uint32_t k) const { return { c_.item(32, k, 48) }; }
+  uint32_t num_assigns() const { return c_.count(40); }
+  AssignView assign(uint32_t k) const { return { c_.item(40, k, 8) }; }
+  uint32_t num_instances() const { return c_.count(48); }
+  InstanceView instance(uint32_t k) const { return { c_.item(48, k, 56) }; }
+  uint32_t num_gates() const { return c_.count(56); }
+  GateView gate(uint32_t k) const { return { c_.item(56, k, 24) }; }
+
+  Module to_module() const;   // a parsed Module equal to the one exported, without spans
+
+private:
+  Cursor c_;
+};
+
+// Reads a buffer written by write_binary(), for instance a memory-mapped
+// file, in place; the buffer must outlive the view and everything read from
+// it. The constructor checks the header and the index, module(i) the size
+// of record i, and both throw std::runtime_error when they do not fit the
+// buffer.
+class NetlistView {
+public:
+  explicit NetlistView(std::string_view bytes);
+
+  size_t size() const { return count_; }
+  ModuleView module(size_t i) const;
+  Netlist to_netlist() const;
+
+private:
+  std::string_view bytes_;
+  const char* index_ = nullptr;
+  size_t count_ = 0;
+};
+
+} // namespace binary
+
+} // namespace verilog
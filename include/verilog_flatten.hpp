@@ -0,0 +1,73 @@
+#pragma once
+#include "veriloglib.hpp"
+#include <functional>
+#include <memory>
+
+namespace verilog {
+
+// Hierarchy passes. A module the netlist does not define, or defines with an
+// empty body (a stub: ports only, no instances, assigns or gates), is a leaf
+// cell.
+// Every other module is expanded. The top defaults to the last module nothing
+// instantiates. An instantiation cycle throws std::runtime_error.
+
+struct FlattenOptions {
+  std::string top;          // empty: last module nothing instantiates
+  char separator = '/';     // between hierarchy levels in flat names
+  unsigned threads = 0;     // 0: hardware concurrency
+};
+
+// Visits every leaf instance below the top in flatten order, with its
+// hierarchical name ("u_core/u_alu/U12"). The name is a view of one path
+// buffer that grows and shrinks with the walk: nothing is allocated per
+// instance, and the view is only valid during the call. Gate primitives are
+// not leaf instances and are not visited. Serial.
+void for_each_leaf(const Netlist& nl, const FlattenOptions& opts,
+                   const std::function<void(std::string_view path, const ModuleInstance& leaf)>& visit);
+
+// One-module netlist: the top's ports and declarations, then for each expanded
+// instance path P its internal nets as "P/net" wires, its assigns, its gates
+// and its leaf instances renamed "P/inst", connected to flat nets at bit
+// level. A module's own leaves come before its sub-instances, in instance
+// order. Leaves, gates and assigns keep the spans of the text they were
+// copied from. Constants stay constants; an expanded instance's port tied to
+// a constant becomes "assign P/port = <constant>" (a constant inside a
+// concatenation on such a port is left open).
+//
+// Each module definition is analysed once and shared by all of its instance
+// paths, so memory is the output plus one connectivity graph per definition.
+// Subtrees are flattened in parallel and concatenated in order, so the result
+// does not depend on the thread count.
+Netlist flatten(const Netlist& nl, const FlattenOptions& opts = {});
+
+// A module of a uniquified netlist. The body is shared with every other copy
+// of the same definition until edit() gives this one a private copy.
+struct UniqueModule {
+  static constexpr uint32_t npos = ~uint32_t(0);
+
+  std::string name;
+  std::shared_ptr<const Module> body;   // body->module_name is the original definition name
+  std::vector<uint32_t> children;       // per body->module_instances: module index, or npos for leaf cells
+};
+
+// Every expanded module instantiated at several places below the top gets one
+// copy per instantiation: the first keeps its name, later ones are named
+// "<name>_1", "<name>_2", ... (skipping names already taken). modules[0] is the
+// top, the rest follow in depth-first order; leaf stubs the netlist defines
+// are listed once and never copied. Copies share their bodies, so this costs
+// O(instantiations), not O(netlist size x instantiations). Each definition is
+// walked once; repeated subtrees and names are filled in parallel, with the
+// same result for any thread count.
+class UniqueNetlist {
+public:
+  std::vector<UniqueModule> modules;
+  std::shared_ptr<const LineTable> lines;          // of the source netlist; spans in the bodies point into it
+
+  Module& edit(size_t i);                          // copy-on-write: unshares the body first
+  Netlist to_netlist(unsigned threads = 0) const;  // materialises names and masters, in parallel
+};
+
+// Takes the netlist by value: bodies are moved into shared storage, not copied.
+UniqueNetlist uniquify(Netlist nl, const std::string& top = "", unsigned threads = 0);
+
+} // namespace verilog
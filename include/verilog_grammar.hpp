@@ -1,5 +1,9 @@
 #pragma once
 #include <tao/pegtl.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
 
 namespace verilog { namespace grammar {
 using namespace tao::pegtl;
@@ -25,16 +29,20 @@ struct header_port_ident : identifier {};
 
 // Numbers
 struct HEXDIG : ranges<'0','9','a','f','A','F'> {};
-struct unsigned_hex_str : plus< HEXDIG > {};
+struct unsigned_hex_str : seq< HEXDIG, star< sor< HEXDIG, one<'_'> > > > {};
 struct sign : one<'+','-'> {};
 struct signed_hex_str : seq< sign, unsigned_hex_str > {};
 struct base_char : one<'b','B','h','H','o','O','d','D'> {};
-struct base : seq< one<'\''>, base_char > {};
+struct base : seq< one<'\''>, opt< one<'s','S'> >, base_char > {};
+// digits after a base may carry x/z/? bits and '_' separators
+struct based_digit : sor< HEXDIG, one<'x','X','z','Z','?'> > {};
+struct based_digits : seq< based_digit, star< sor< based_digit, one<'_'> > > > {};
+// sized/based forms first: an ordered sor would otherwise stop at the size
 struct number_1 : sor<
-  unsigned_hex_str,
+  seq< unsigned_hex_str, base, based_digits >,
+  seq< base, based_digits >,
   signed_hex_str,
-  seq< unsigned_hex_str, base, unsigned_hex_str >,
-  seq< base, unsigned_hex_str >
+  unsigned_hex_str
 > {};
 
 // Ranges
@@ -59,11 +67,18 @@ struct lbrace : sym<'{'> {}; struct rbrace : sym<'}'> {};
 struct lparen : sym<'('> {}; struct rparen : sym<')'> {};
 struct dot    : sym<'.'> {}; struct comma  : sym<','> {};
 struct semi   : sym<';'> {}; struct equal  : sym<'='> {};
+// Bare ';' and ')' that close a declaration, assign or instance: their actions
+// mark where the item's source span ends, before the whitespace sym<> takes.
+struct item_semi : one<';'> {}; struct item_rparen : one<')'> {};
 struct expression;
 struct concat_list;
 struct concat : seq< lbrace, sep, concat_list, sep, rbrace > {};
+// Literal: sized/based (`1'b0`, `'hff`) or plain decimal (`0`). Unlike
+// number_1 it cannot start with a letter, so it never takes an identifier.
+struct decimal_digits : seq< digit, star< sor< digit, one<'_'> > > > {};
+struct constant : sor< seq< opt< decimal_digits >, base, based_digits >, decimal_digits > {};
 // identifier already supports zero-or-more selects: foo[3], foo[7:0], foo[i][j]
-struct primary_expr : sor< concat, identifier > {};
+struct primary_expr : sor< concat, constant, identifier > {};
 struct expression : primary_expr {};
 struct concat_list : list_must< expression, seq< sep, comma, sep > > {};
 
@@ -71,10 +86,20 @@ struct concat_list : list_must< expression, seq< sep, comma, sep > > {};
 // struct port_list : list< identifier, seq< sep, comma, sep > > {};
 struct port_list : tao::pegtl::list< header_port_ident, tao::pegtl::seq< sep, comma, sep > > {};
 
+// Integer constant expressions over parameters: `WIDTH-1`, `(D<<1)+1`.
+// Recognition only; ParamExpr::parse builds the value from the text.
+struct param_expr;
+struct param_primary : sor< seq< one<'('>, sep, param_expr, sep, one<')'> >, constant, identifier_raw > {};
+struct param_unary : seq< star< one<'+','-'>, sep >, param_primary > {};
+struct param_binop : sor< string<'<','<'>, string<'>','>'>, one<'+','-','*','/','%'> > {};
+struct param_expr : list< param_unary, seq< sep, param_binop, sep > > {};
+
 // Keywords
-struct kw_wire   : TAO_PEGTL_STRING("wire") {};
+struct kw_wire   : TAO_PEGTL_KEYWORD("wire") {};
 // ===== Declarations: width BEFORE name (e.g. "output [7:0] bus, a;") =====
-struct range_decl     : tao::pegtl::seq< lbrack, number_1, sep, colon, sep, number_1, rbrack > {};
+// A bound is a plain number as before, or else a parameter expression.
+struct range_bound    : sor< seq< number_1, at< sep, one<':',']'> > >, param_expr > {};
+struct range_decl     : tao::pegtl::seq< lbrack, range_bound, sep, colon, sep, range_bound, rbrack > {};
 struct opt_range_decl : tao::pegtl::opt< tao::pegtl::seq< sep, range_decl, sep > > {};
 struct variable_name  : identifier_raw {};  // NOTE: raw, no post-selects
 struct list_of_variables
@@ -82,43 +107,176 @@ struct list_of_variables
       opt_range_decl,
       tao::pegtl::list_must< variable_name, tao::pegtl::seq< sep, comma, sep > >
     > {};
-struct kw_input  : TAO_PEGTL_STRING("input") {};
-struct kw_output : TAO_PEGTL_STRING("output") {};
-struct kw_inout  : TAO_PEGTL_STRING("inout") {};
-struct kw_assign : TAO_PEGTL_STRING("assign") {};
-struct kw_module : TAO_PEGTL_STRING("module") {};
-struct kw_endmodule : TAO_PEGTL_STRING("endmodule") {};
-struct not_keyword : not_at< sor< kw_wire, kw_input, kw_output, kw_inout, kw_assign, kw_module, kw_endmodule > > {};
+struct kw_input  : TAO_PEGTL_KEYWORD("input") {};
+struct kw_output : TAO_PEGTL_KEYWORD("output") {};
+struct kw_inout  : TAO_PEGTL_KEYWORD("inout") {};
+struct kw_assign : TAO_PEGTL_KEYWORD("assign") {};
+struct kw_module : TAO_PEGTL_KEYWORD("module") {};
+struct kw_endmodule : TAO_PEGTL_KEYWORD("endmodule") {};
+struct kw_tri     : TAO_PEGTL_KEYWORD("tri") {};
+struct kw_supply0 : TAO_PEGTL_KEYWORD("supply0") {};
+struct kw_supply1 : TAO_PEGTL_KEYWORD("supply1") {};
+struct kw_net_type : sor< kw_wire, kw_tri, kw_supply0, kw_supply1 > {};
+struct kw_parameter  : TAO_PEGTL_KEYWORD("parameter") {};
+struct kw_localparam : TAO_PEGTL_KEYWORD("localparam") {};
+struct kw_param_kind : sor< kw_parameter, kw_localparam > {};
+
+// Keyword classifier. (len + 4 * first + 5 * middle + last char) & 63 indexes
+// a 64-slot table without collisions over the twenty keywords (checked
+// below); one compare against the slot's keyword confirms the match.
+enum class Keyword : uint8_t {
+  None, Wire, Input, Output, Inout, Assign, Module, Endmodule, Tri, Supply0, Supply1, Parameter, Localparam,
+  And, Nand, Or, Nor, Xor, Xnor, Buf, Not,   // gate primitives, in GateType order
+};
+constexpr bool is_gate(Keyword k) { return k >= Keyword::And; }
+
+namespace detail {
+struct KeywordEntry { std::string_view text; Keyword kw; };
+inline constexpr KeywordEntry kKeywords[] = {
+  { "wire", Keyword::Wire },     { "input", Keyword::Input },   { "output", Keyword::Output },
+  { "inout", Keyword::Inout },   { "assign", Keyword::Assign }, { "module", Keyword::Module },
+  { "endmodule", Keyword::Endmodule }, { "tri", Keyword::Tri }, { "supply0", Keyword::Supply0 },
+  { "supply1", Keyword::Supply1 }, { "parameter", Keyword::Parameter }, { "localparam", Keyword::Localparam },
+  { "and", Keyword::And }, { "nand", Keyword::Nand }, { "or", Keyword::Or },   { "nor", Keyword::Nor },
+  { "xor", Keyword::Xor }, { "xnor", Keyword::Xnor }, { "buf", Keyword::Buf }, { "not", Keyword::Not },
+};
+constexpr size_t kKeywordMinLen = 2, kKeywordMaxLen = 10;
+constexpr unsigned keyword_slot(std::string_view w) {
+  return (unsigned(w.size()) + 4u * uint8_t(w[0]) + 5u * uint8_t(w[w.size() / 2]) + uint8_t(w.back())) & 63u;
+}
+constexpr std::array<uint8_t, 64> make_keyword_table() {
+  std::array<uint8_t, 64> t{};   // 0: empty, else index + 1 into kKeywords
+  for (uint8_t i = 0; i < std::size(kKeywords); ++i) t[keyword_slot(kKeywords[i].text)] = uint8_t(i + 1);
+  return t;
+}
+inline constexpr auto kKeywordTable = make_keyword_table();
+constexpr bool keyword_hash_is_perfect() {
+  for (uint8_t i = 0; i < std::size(kKeywords); ++i)
+    if (kKeywordTable[keyword_slot(kKeywords[i].text)] != i + 1) return false;
+  return true;
+}
+static_assert(keyword_hash_is_perfect(), "keyword_slot collides; pick another hash");
+
+constexpr bool is_ident_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$';
+}
+} // namespace detail
+
+// Keyword spelled by a whole word, or None.
+constexpr Keyword classify_keyword(std::string_view word) {
+  if (word.size() < detail::kKeywordMinLen || word.size() > detail::kKeywordMaxLen) return Keyword::None;
+  const uint8_t e = detail::kKeywordTable[detail::keyword_slot(word)];
+  return (e && detail::kKeywords[e - 1].text == word) ? detail::kKeywords[e - 1].kw : Keyword::None;
+}
+
+// Classifies the word at the input position without consuming it. Only the
+// first kKeywordMaxLen + 1 bytes are looked at: anything longer is no keyword.
+template<typename ParseInput>
+Keyword peek_keyword(ParseInput& in) {
+  const size_t avail = std::min(in.size(detail::kKeywordMaxLen + 1), detail::kKeywordMaxLen + 1);
+  const char* p = in.current();
+  size_t n = 0;
+  while (n < avail && detail::is_ident_char(p[n])) ++n;
+  return n > detail::kKeywordMaxLen ? Keyword::None : classify_keyword(std::string_view(p, n));
+}
+
+struct not_keyword {
+  using rule_t = not_keyword;
+  using subs_t = type_list<>;
+  template<typename ParseInput>
+  static bool match(ParseInput& in) { return peek_keyword(in) == Keyword::None; }
+};
 
 // One or more names, separated by commas.
-struct net_declaration    : if_must< kw_wire,   seps, list_of_variables, sep, semi > {};
-struct input_declaration  : if_must< kw_input,  seps, list_of_variables, sep, semi > {};
-struct output_declaration : if_must< kw_output, seps, list_of_variables, sep, semi > {};
-struct inout_declaration  : if_must< kw_inout,  seps, list_of_variables, sep, semi > {};
+struct net_declaration    : if_must< kw_net_type, seps, list_of_variables, sep, item_semi, sep > {};
+struct input_declaration  : if_must< kw_input,  seps, list_of_variables, sep, item_semi, sep > {};
+struct output_declaration : if_must< kw_output, seps, list_of_variables, sep, item_semi, sep > {};
+struct inout_declaration  : if_must< kw_inout,  seps, list_of_variables, sep, item_semi, sep > {};
+
+// parameter W = 8, D = W * 2;   localparam N = 1 << W;
+// The optional range is recognised and ignored: values are plain integers.
+struct param_name : identifier_raw {};
+struct param_value : param_expr {};
+struct param_assignment : if_must< param_name, sep, equal, sep, param_value > {};
+struct parameter_declaration : if_must< kw_param_kind, sep, opt< range_decl, sep >,
+                                        list_must< param_assignment, seq< sep, comma, sep > >, sep, item_semi, sep > {};
 
 // assign
 struct assignment : if_must< expression, sep, equal, sep, expression > {};
 struct assignment_list : list_must< assignment, seq< sep, comma, sep > > {};
-struct continuous_assign : if_must< kw_assign, seps, assignment_list, sep, semi > {};
+struct continuous_assign : if_must< kw_assign, seps, assignment_list, sep, item_semi, sep > {};
 
 // instantiation
 struct module_port_connection : expression {};
 // capture the named port name BEFORE parsing the expression
 struct named_port_name : identifier {};
-struct named_port_connection : if_must< dot, named_port_name, sep, lparen, sep, expression, sep, rparen > {};
+// ".Q()" leaves the pin unconnected
+struct named_port_connection : if_must< dot, named_port_name, sep, lparen, sep, opt< expression >, sep, rparen > {};
 struct list_of_module_connections : list_must< sor< named_port_connection, module_port_connection >, seq< sep, comma, sep > > {};
 // split instance name out so actions can grab it before ports overwrite last_identifier
 struct instance_name_tok : identifier {};
-struct module_instance : if_must< instance_name_tok, sep, lparen, sep, opt< list_of_module_connections >, sep, rparen > {};
+struct module_instance : if_must< instance_name_tok, sep, lparen, sep, opt< list_of_module_connections >, sep, item_rparen, sep > {};
 struct module_instance_list : list_must< module_instance, seq< sep, comma, sep > > {};
 struct module_inst_head : identifier {};
-struct module_instantiation : if_must< not_keyword, module_inst_head, seps, module_instance_list, sep, semi > {};
+// Parameter values: `#(8, 4)`, `#(.W(8), .D())` or `#8`.
+struct param_hash : one<'#'> {};
+struct positional_param_value : param_expr {};
+struct named_param_name : identifier_raw {};
+struct named_param_value : param_expr {};
+struct named_param_override : if_must< dot, named_param_name, sep, lparen, sep, opt< named_param_value >, sep, rparen > {};
+struct param_override_list : sor< list_must< named_param_override, seq< sep, comma, sep > >,
+                                  list_must< positional_param_value, seq< sep, comma, sep > > > {};
+struct param_overrides : if_must< param_hash, sep, sor< seq< lparen, sep, opt< param_override_list >, sep, rparen >,
+                                                        positional_param_value > > {};
+struct module_instantiation : if_must< not_keyword, module_inst_head, sor< seq< sep, param_overrides, sep >, seps >,
+                                       module_instance_list, sep, semi > {};
+
+// Gate primitives: `and g1 (y, a, b), (z, c, d);`. The instance name is
+// optional; terminals are expressions, outputs first.
+struct gate_type_tok : ident_norm {};
+struct gate_instance_name : identifier_raw {};
+struct gate_terminal : expression {};
+struct gate_instance : if_must< opt< gate_instance_name, sep >, lparen, sep,
+                                list_must< gate_terminal, seq< sep, comma, sep > >, sep, item_rparen, sep > {};
+struct gate_instantiation : if_must< gate_type_tok, sep, list_must< gate_instance, seq< sep, comma, sep > >, sep, semi > {};
 
 // module
 struct module_header_ports : if_must< lparen, sep, opt< port_list >, sep, rparen > {};
 struct module_name_tok : identifier {};
-struct module_header : if_must< kw_module, seps, module_name_tok, sep, opt< module_header_ports >, sep, semi > {};
-struct module_item : sor< input_declaration, output_declaration, inout_declaration, net_declaration, continuous_assign, module_instantiation > {};
+// #(parameter W = 8, D = 4): the keyword may be left out after the first.
+struct header_param : seq< opt< kw_param_kind, sep >, opt< range_decl, sep >, param_assignment > {};
+struct module_header_params : if_must< one<'#'>, sep, lparen, sep, list_must< header_param, seq< sep, comma, sep > >, sep, rparen > {};
+struct module_header : if_must< kw_module, seps, module_name_tok, sep, opt< module_header_params, sep >,
+                                opt< module_header_ports >, sep, semi > {};
+// Routes on the leading keyword in one step instead of trying each
+// production in turn; a word that is not a keyword starts an instantiation,
+// and module/endmodule end the item list.
+struct module_item {
+  using rule_t = module_item;
+  using subs_t = type_list< input_declaration, output_declaration, inout_declaration, net_declaration, continuous_assign,
+                            parameter_declaration, gate_instantiation, module_instantiation >;
+
+  template< apply_mode A, rewind_mode M, template< typename... > class Action, template< typename... > class Control,
+            typename ParseInput, typename... States >
+  static bool match(ParseInput& in, States&&... st) {
+    switch (peek_keyword(in)) {
+      case Keyword::Input:  return Control< input_declaration >::template match< A, M, Action, Control >(in, st...);
+      case Keyword::Output: return Control< output_declaration >::template match< A, M, Action, Control >(in, st...);
+      case Keyword::Inout:  return Control< inout_declaration >::template match< A, M, Action, Control >(in, st...);
+      case Keyword::Wire: case Keyword::Tri: case Keyword::Supply0: case Keyword::Supply1:
+                            return Control< net_declaration >::template match< A, M, Action, Control >(in, st...);
+      case Keyword::Assign: return Control< continuous_assign >::template match< A, M, Action, Control >(in, st...);
+      case Keyword::Parameter:
+      case Keyword::Localparam:
+                            return Control< parameter_declaration >::template match< A, M, Action, Control >(in, st...);
+      case Keyword::None:   return Control< module_instantiation >::template match< A, M, Action, Control >(in, st...);
+      case Keyword::Module:
+      case Keyword::Endmodule: return false;
+      default: break;
+    }
+    return Control< gate_instantiation >::template match< A, M, Action, Control >(in, st...);
+  }
+};
 struct module : seq< module_header, star< seq< sep, module_item > >, sep, kw_endmodule > {};
 struct start : star< seq< sep, module, sep > > {};
 
@@ -0,0 +1,68 @@
+#pragma once
+#include "veriloglib.hpp"
+#include "verilog_connectivity.hpp"
+#include <memory>
+#include <optional>
+#include <span>
+
+namespace verilog {
+
+struct HierarchyOptions {
+  std::string top;                          // empty: last module nothing instantiates
+  char separator = '/';                     // between path segments
+  const InterfaceTable* cells = nullptr;    // pins of masters the netlist does not define
+  unsigned threads = 0;                     // for batch lookups; 0: hardware concurrency
+};
+
+// What the last segment of a path names: an instance, a pin of the last
+// instance, or a net (port or declared net) inside the last instance's master.
+enum class PathKind : uint8_t { Instance, Pin, Net };
+
+struct HierPath {
+  std::vector<const ModuleInstance*> hops;   // top down; empty for a net of the top
+  PathKind kind = PathKind::Instance;
+  std::string_view name;                     // pin or net name; empty for instances
+};
+
+// Resolves hierarchical names ("u_cpu/u_alu/U123/Z") below a top, on a parsed
+// or elaborated netlist that must outlive the index. Each defined module gets
+// a flat hash table over its instance names and one over its net names, so a
+// path costs one hashed probe per segment and the hierarchy is never
+// expanded: the index is as large as the netlist, not as the flattened design.
+// A first segment naming the top itself is skipped, as are empty segments.
+// Escaped names that contain the separator cannot be addressed.
+class HierarchyIndex {
+public:
+  // Throws std::runtime_error when opts.top is not defined.
+  explicit HierarchyIndex(const Netlist& nl, const HierarchyOptions& opts = {});
+  ~HierarchyIndex();
+  HierarchyIndex(HierarchyIndex&&) noexcept;
+  HierarchyIndex& operator=(HierarchyIndex&&) noexcept;
+
+  const Module& top() const;
+
+  // The one object a path names; instances shadow pins, pins shadow nets.
+  std::optional<HierPath> resolve(std::string_view path) const;
+
+  // resolve() for every path, in parallel over chunks of consecutive paths.
+  // Each path reuses the hops it shares with the one before it, so a list
+  // grouped by prefix (pins of one cell, cells of one block) walks each
+  // shared prefix once per chunk.
+  std::vector<std::optional<HierPath>> resolve(std::span<const std::string> paths) const;
+
+  // Every object a pattern names, in depth-first instance order. `*` and `?`
+  // match within one segment ("u_cpu/*/U1*"); the last segment is matched
+  // against instances, then pins of the last instance, then nets.
+  std::vector<HierPath> glob(std::string_view pattern) const;
+
+  std::string path_string(const HierPath& p) const;   // segments below the top, joined by the separator
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+// `*` matches any run of characters, `?` any one.
+bool wildcard_match(std::string_view pattern, std::string_view s);
+
+} // namespace verilog
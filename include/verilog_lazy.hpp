@@ -0,0 +1,60 @@
+#pragma once
+#include "veriloglib.hpp"
+#include <memory>
+#include <span>
+
+namespace verilog {
+
+// Header of one module found by the skip-scan, and where its text lives.
+struct ModuleOutline {
+  std::string module_name;
+  std::vector<std::string> port_list;
+  size_t begin = 0;        // byte offset of the `module` keyword
+  uint32_t line = 0;       // its line
+  size_t body_begin = 0;   // just past the header's ';'
+  size_t end = 0;          // just past `endmodule`
+};
+
+// Netlist whose module bodies are parsed on first use. Opening one only
+// parses each module header; between headers a scanner jumps to the matching
+// `endmodule`, stepping over comments and escaped identifiers but running no
+// grammar or actions. module(i) parses body i the first time it is asked for
+// and keeps the result; any number of threads may call it at once. Parse
+// errors in a body surface when that body is first touched, with line and
+// column in the whole file.
+class LazyNetlist {
+public:
+  static LazyNetlist from_string(std::string text, std::string source = "verilog_string");
+  static LazyNetlist from_file(const std::string& path);   // memory-maps the file where possible
+
+  LazyNetlist(LazyNetlist&&) noexcept;
+  LazyNetlist& operator=(LazyNetlist&&) noexcept;
+  ~LazyNetlist();
+
+  size_t size() const;
+  std::span<const ModuleOutline> outlines() const;
+  const ModuleOutline* find(std::string_view name) const;   // first definition wins; nullptr if absent
+  std::string_view text(size_t i) const;                    // source of module i, `module` .. `endmodule`
+
+  const Module& module(size_t i) const;                     // throws parse_error
+  const Module* module(std::string_view name) const;        // nullptr if absent
+  bool is_parsed(size_t i) const;
+  // Parses body i into a Module the netlist does not keep, for one pass over
+  // a netlist too large to hold parsed. Each call parses again.
+  Module parse_module(size_t i) const;                      // throws parse_error
+
+  // Line table of the whole text, for the spans of parsed bodies (offsets
+  // are into the whole file). Built on first call.
+  std::shared_ptr<const LineTable> lines() const;
+
+  // Parses every body not parsed yet (in parallel) and returns a copy of the
+  // whole netlist, equal to what parse_string() gives for the same text.
+  Netlist to_netlist(unsigned threads = 0) const;
+
+private:
+  struct Impl;
+  explicit LazyNetlist(std::unique_ptr<Impl> impl);
+  std::unique_ptr<Impl> impl_;
+};
+
+} // namespace verilog
@@ -0,0 +1,63 @@
+#pragma once
+#include "veriloglib.hpp"
+#include "verilog_connectivity.hpp"
+#include "verilog_parallel.hpp"
+#include <functional>
+#include <span>
+
+namespace verilog {
+
+struct LevelizeOptions {
+  // Instances whose master matches one of these patterns are sequential
+  // (`*` and `?` wildcards, as in "DFF*"): they cut the graph like ports do.
+  std::vector<std::string> sequential;
+  std::function<bool(const ModuleInstance&)> is_sequential;   // further test; may be empty
+};
+
+// Combinational nodes of one module (instances that are not sequential,
+// assign pairs and gates; ModuleGraph node ids) in evaluation order, as flat
+// arrays. Level 0 reads only ports, sequential outputs and undriven nets;
+// every other node is one level above the highest node driving it, so the
+// nodes of one level depend only on earlier levels and can be evaluated in
+// parallel. The nodes of a combinational loop share a level and are listed
+// in `loop_nodes` as well: they have to be iterated together.
+struct Schedule {
+  static constexpr uint32_t kNoLevel = ~uint32_t(0);
+
+  std::vector<uint32_t> nodes;            // by level, ascending node id within a level
+  std::vector<uint32_t> level_begin{0};   // levels + 1 offsets into nodes
+  std::vector<uint32_t> level;            // per graph node; kNoLevel for ports and sequential cells
+  std::vector<uint32_t> sequential;       // sequential instance nodes, ascending
+  std::vector<uint32_t> loop_nodes;       // nodes of each loop (strongly connected component), ascending
+  std::vector<uint32_t> loop_begin{0};    // loops + 1 offsets into loop_nodes
+
+  size_t num_levels() const { return level_begin.size() - 1; }
+  std::span<const uint32_t> level_nodes(size_t l) const {
+    return { nodes.data() + level_begin[l], nodes.data() + level_begin[l + 1] };
+  }
+  size_t num_loops() const { return loop_begin.size() - 1; }
+  std::span<const uint32_t> loop(size_t i) const {
+    return { loop_nodes.data() + loop_begin[i], loop_nodes.data() + loop_begin[i + 1] };
+  }
+};
+
+// Levelizes one module in time linear in its pins (for nets with a single
+// driver): Tarjan's strongly connected components over the combinational
+// nodes, iteratively so deep logic cannot overflow the stack, then longest
+// paths over the components in the topological order Tarjan yields. A node
+// drives another when one of its output pins shares a net with an input pin
+// of the other; inout pins, and pins of masters with no known directions,
+// count as both, so pass cell interfaces when building the graph.
+Schedule levelize(const ModuleGraph& g, const LevelizeOptions& opts = {});
+
+// Calls body(node) for every scheduled node, one level after the other, with
+// the nodes of each level spread over up to `threads` workers.
+template<typename Body>
+void for_each_level(const Schedule& s, Body&& body, unsigned threads = 0, size_t grain = 1024) {
+  for (size_t l = 0; l < s.num_levels(); ++l) {
+    const auto nodes = s.level_nodes(l);
+    parallel::parallel_for(nodes.size(), [&](size_t i) { body(nodes[i]); }, threads, grain);
+  }
+}
+
+} // namespace verilog
@@ -0,0 +1,133 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace verilog { namespace parallel {
+
+// Determinism. Every parallel pass of the library returns the same result,
+// element for element, for any thread count, so reports stay bit-identical
+// from run to run. Work is split into indexed slots or fixed chunks, each
+// slot fills its own output, and the outputs are joined in index order
+// (parallel_reduce, ordered_append, parallel_collect below). Nothing is
+// sorted afterwards to restore an order, and no output depends on which
+// worker finished first. New passes follow the same pattern.
+
+// Number of workers to use when the caller passes threads == 0.
+inline unsigned default_threads() {
+  unsigned n = std::thread::hardware_concurrency();
+  return n ? n : 1;
+}
+
+// Runs body(i) for i in [0, n) on up to `threads` workers. Indices are handed
+// out dynamically in blocks of `grain`, so uneven work (one huge module among
+// many small ones) still balances. The first exception thrown by a body is
+// rethrown on the calling thread once all workers have stopped.
+template<typename Body>
+void parallel_for(size_t n, Body&& body, unsigned threads = 0, size_t grain = 1) {
+  if (n == 0) return;
+  if (threads == 0) threads = default_threads();
+  grain = std::max<size_t>(1, grain);
+  const size_t blocks = (n + grain - 1) / grain;
+  threads = unsigned(std::min<size_t>(threads, blocks));
+  if (threads <= 1) { for (size_t i = 0; i < n; ++i) body(i); return; }
+
+  std::atomic<size_t> next{0};
+  std::exception_ptr error;
+  std::mutex error_mu;
+  auto worker = [&]() {
+    for (;;) {
+      const size_t b = next.fetch_add(1, std::memory_order_relaxed);
+      if (b >= blocks) return;
+      try {
+        for (size_t i = b * grain, e = std::min(n, i + grain); i < e; ++i) body(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lk(error_mu);
+        if (!error) error = std::current_exception();
+        next.store(blocks, std::memory_order_relaxed);
+        return;
+      }
+    }
+  };
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+  worker();
+  for (auto& t : pool) t.join();
+  if (error) std::rethrow_exception(error);
+}
+
+// Ordered parallel reduction. [0, n) is cut into fixed chunks; each chunk folds
+// its indices into a fresh copy of `identity` with map(acc, i), and the chunk
+// partials are then combined left to right with combine(into, std::move(from)).
+// Because chunk boundaries and combine order do not depend on the thread count,
+// any associative combine (including list concatenation) gives the same result
+// for 1 or N threads.
+template<typename T, typename Map, typename Combine>
+T parallel_reduce(size_t n, T identity, Map&& map, Combine&& combine,
+                  unsigned threads = 0, size_t chunk = 64) {
+  chunk = std::max<size_t>(1, chunk);
+  const size_t chunks = (n + chunk - 1) / chunk;
+  std::vector<T> partial(chunks, identity);
+  parallel_for(chunks, [&](size_t c) {
+    for (size_t i = c * chunk, e = std::min(n, i + chunk); i < e; ++i) map(partial[c], i);
+  }, threads);
+  T out = std::move(identity);
+  for (auto& p : partial) combine(out, std::move(p));
+  return out;
+}
+
+// Appends part(0), part(1), ... part(n - 1) (each a std::vector<T>&) to
+// `out`, moving their elements: the serial concatenation. Offsets come from
+// a prefix sum over the part sizes and the parts are moved into place in
+// parallel, so joining large outputs is not a serial step; small totals are
+// appended directly. The parts are left empty.
+template<typename T, typename Part>
+void ordered_append(std::vector<T>& out, size_t n, Part&& part, unsigned threads = 0) {
+  constexpr size_t kParallelElements = 16384;
+  std::vector<size_t> at(n + 1);
+  at[0] = out.size();
+  for (size_t i = 0; i < n; ++i) at[i + 1] = at[i] + part(i).size();
+  if (at[n] - at[0] < kParallelElements || n < 2 || threads == 1) {
+    out.reserve(at[n]);
+    for (size_t i = 0; i < n; ++i) {
+      std::vector<T>& p = part(i);
+      if (out.empty() && p.size() == at[n]) { out.swap(p); p.clear(); continue; }   // one part holds everything
+      std::move(p.begin(), p.end(), std::back_inserter(out));
+      p.clear();
+    }
+    return;
+  }
+  out.resize(at[n]);
+  parallel_for(n, [&](size_t i) {
+    std::vector<T>& p = part(i);
+    std::move(p.begin(), p.end(), out.begin() + ptrdiff_t(at[i]));
+    p.clear();
+  }, threads);
+}
+
+// Runs produce(i, out) for every i in [0, n), where out is a std::vector<T>&
+// shared by a fixed chunk of consecutive indices, and returns what the
+// chunks produced joined in chunk order: exactly what one serial loop over i
+// appending to one vector would give, whatever the thread count.
+template<typename T, typename Produce>
+std::vector<T> parallel_collect(size_t n, Produce&& produce, unsigned threads = 0, size_t chunk = 64) {
+  chunk = std::max<size_t>(1, chunk);
+  const size_t chunks = (n + chunk - 1) / chunk;
+  std::vector<std::vector<T>> parts(chunks);
+  parallel_for(chunks, [&](size_t c) {
+    for (size_t i = c * chunk, e = std::min(n, i + chunk); i < e; ++i) produce(i, parts[c]);
+  }, threads);
+  if (chunks == 1) return std::move(parts[0]);
+  std::vector<T> out;
+  ordered_append(out, chunks, [&](size_t c) -> std::vector<T>& { return parts[c]; }, threads);
+  return out;
+}
+
+}} // namespace verilog::parallel
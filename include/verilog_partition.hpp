@@ -0,0 +1,45 @@
+#pragma once
+#include "veriloglib.hpp"
+#include "verilog_connectivity.hpp"
+#include <span>
+
+namespace verilog {
+
+struct PartitionOptions {
+  uint32_t parts = 2;
+  double imbalance = 0.05;     // a part may hold up to (1 + imbalance) * nodes / parts nodes
+  size_t max_net_pins = 1000;  // wider nets (clocks, resets) are left out of the search but still counted as cut
+  uint32_t passes = 8;         // refinement passes per coarsening level, at most
+  uint64_t seed = 1;
+  unsigned threads = 1;        // the halves of each bisection are split in parallel; 0: hardware concurrency
+};
+
+// Assignment of the instances, assign pairs and gates of one module
+// (ModuleGraph nodes other than ports) to parts 0 .. parts - 1.
+struct Partition {
+  static constexpr uint32_t kNoPart = ~uint32_t(0);
+
+  std::vector<uint32_t> part;   // per graph node; kNoPart for module ports
+  std::vector<uint32_t> sizes;  // nodes per part
+  std::vector<NetId> cut;       // nets with pins in more than one part, ascending
+
+  uint32_t num_parts() const { return uint32_t(sizes.size()); }
+  std::vector<uint32_t> nodes(uint32_t p) const;   // ascending
+};
+
+// Splits one module into balanced parts with few nets between them, for
+// analyzing the parts in separate processes. Nodes are vertices of weight 1
+// and nets are hyperedges over the nodes they connect. k parts come from
+// recursive bisection; each bisection is multilevel: heavy-connectivity
+// matching coarsens the hypergraph to about a hundred vertices, greedy
+// growing from random seeds gives initial halves, and Fiduccia-Mattheyses
+// passes refine the cut at every level on the way back. The result depends
+// on the seed but not on the thread count. Throws std::invalid_argument for
+// zero parts, and for more parts than nodes, which would leave parts empty.
+Partition partition(const ModuleGraph& g, const PartitionOptions& opts = {});
+
+// Part p as a standalone module (extract_module()): nets it shares with
+// other parts or with the module's ports become its ports.
+Module part_module(const ModuleGraph& g, const Partition& p, uint32_t part, std::string name);
+
+} // namespace verilog
@@ -0,0 +1,87 @@
+#pragma once
+#include "veriloglib.hpp"
+#include <deque>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+
+namespace verilog {
+
+// A file as loaded for preprocessing. Files whose contents are byte-for-byte
+// equal share one text and one line table, whatever their paths.
+struct SourceFile {
+  std::string path;
+  std::shared_ptr<const std::string> text;
+  uint64_t hash = 0;                        // FNV-1a of the text
+  std::shared_ptr<const LineTable> lines;   // of the text; null when spans are off
+};
+
+// Files loaded by the preprocessor, memoized by path and by content hash, so
+// a cell-stub file `include`d by every netlist file is read and indexed once.
+// Safe to share between threads: concurrent requests for the same path wait
+// for one load.
+class IncludeCache {
+public:
+  // The file at `path`, or null when it cannot be read (also remembered).
+  std::shared_ptr<const SourceFile> load(const std::string& path);
+
+  size_t files() const;    // distinct paths loaded
+  size_t shared() const;   // loads whose contents matched an earlier file's
+  size_t hits() const;     // loads answered from the cache
+
+private:
+  using Entry = std::shared_future<std::shared_ptr<const SourceFile>>;
+  mutable std::mutex mu_;
+  std::unordered_map<std::string, Entry> by_path_;
+  std::unordered_multimap<uint64_t, std::shared_ptr<const SourceFile>> by_hash_;
+  size_t shared_ = 0, hits_ = 0;
+};
+
+struct PreprocessOptions {
+  std::vector<std::string> include_dirs;      // searched after the including file's directory
+  std::map<std::string, std::string> defines; // predefined macros, as with +define+NAME=VALUE
+  unsigned threads = 0;                       // parse_files: 0 means hardware concurrency
+  unsigned max_include_depth = 64;
+};
+
+// Output of the preprocessor: the expanded text as an ordered list of pieces,
+// each a view into a loaded file or into a macro expansion kept here. The
+// expanded text itself is never assembled.
+struct Preprocessed {
+  struct Piece {
+    std::string_view text;
+    uint32_t file;     // index into `files`
+    uint32_t origin;   // offset of text[0] in that file, or of the macro use for expansions
+    bool expansion;
+  };
+  std::vector<Piece> pieces;
+  std::deque<std::string> expansions;
+  std::vector<std::shared_ptr<const SourceFile>> files;   // in order of first inclusion
+
+  size_t size() const;   // bytes of expanded text
+};
+
+// Runs `define / `undef / `ifdef / `ifndef / `elsif / `else / `endif /
+// `include and macro uses (object- and function-like). `timescale,
+// `default_nettype, `celldefine and the other directives that do not affect
+// a netlist are dropped. Macros are scoped to one call, starting from
+// opts.defines. Errors throw parse_error at the directive's file and line.
+Preprocessed preprocess_file(const std::string& path, const PreprocessOptions& opts, IncludeCache& cache);
+Preprocessed preprocess_string(std::string_view text, const std::string& name, const PreprocessOptions& opts,
+                               IncludeCache& cache);
+
+// Parses the pieces module by module. A module that lies within one piece,
+// the usual case, is parsed straight from the file's text; only a module
+// that straddles a directive or a macro use is copied together first. Spans
+// are offsets into the expanded text; the netlist's SourceMap maps them back
+// to file, line and column.
+Netlist parse_preprocessed(const Preprocessed& pp);
+
+// Preprocesses and parses several files in parallel, sharing `cache` (a
+// private one when null) so every include is loaded once. Each file starts
+// from opts.defines: macros do not carry over from one file to the next. The
+// modules come back in file order, as one netlist.
+Netlist parse_files(const std::vector<std::string>& paths, const PreprocessOptions& opts = {},
+                    IncludeCache* cache = nullptr);
+
+} // namespace verilog
@@ -0,0 +1,39 @@
+#pragma once
+#include "veriloglib.hpp"
+
+namespace verilog {
+
+// One syntax error found by a recovering parse.
+struct ParseDiagnostic {
+  std::string source;
+  SourceLocation location;
+  std::string module;    // module whose text it is in; empty before the first module
+  std::string message;
+
+  std::string to_string() const;   // "chip.v:12:7: error: module 'm': expected ';'"
+};
+
+struct RecoverOptions {
+  unsigned threads = 0;                  // 0: hardware concurrency
+  std::string source = "verilog_string"; // name used in diagnostics (the path for parse_file_recovering)
+};
+
+struct RecoveredNetlist {
+  Netlist netlist;                       // every module that parsed cleanly, in text order
+  std::vector<ParseDiagnostic> errors;   // in text order
+  std::vector<std::string> dropped;      // modules left out because their text has errors
+
+  bool ok() const { return errors.empty(); }
+  std::string report(size_t max_items = 200) const;
+};
+
+// Parse that keeps going past syntax errors. The text is cut into modules at
+// each `module` keyword and the pieces are parsed in parallel, so an error in
+// one module never affects another. Within a module, parsing resumes after
+// the next `;` (or at `endmodule`) following an error, so later errors in the
+// same module are reported too; the module itself is dropped. For a text
+// without errors the netlist equals parse_string()'s.
+RecoveredNetlist parse_string_recovering(std::string_view text, const RecoverOptions& opts = {});
+RecoveredNetlist parse_file_recovering(const std::string& path, RecoverOptions opts = {});
+
+} // namespace verilog
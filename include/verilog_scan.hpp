@@ -0,0 +1,87 @@
+#pragma once
+#include "verilog_grammar.hpp"
+#include <array>
+#include <cstring>
+#include <string_view>
+
+// Byte-level scanning of Verilog text without the grammar: stepping over
+// comments and escaped identifiers to find keywords and statement ends.
+// Used to cut a text into modules (LazyNetlist, the recovering parser) and
+// to resynchronise after a syntax error.
+namespace verilog { namespace scan {
+
+using grammar::detail::is_ident_char;
+
+// Bytes that end an escaped identifier, as in grammar::ident_esc.
+constexpr bool ends_escaped(char c) {
+  switch (c) {
+    case ' ': case '\t': case '\r': case '\n': case '[': case ']': case '{': case '}':
+    case '(': case ')': case '.': case ',': case ';': case '=': return true;
+    default: return false;
+  }
+}
+
+// Past the "*<close>" that ends a block comment, or end.
+inline const char* skip_block(const char* p, const char* end, char close) {
+  while (p < end) {
+    const void* star = std::memchr(p, '*', size_t(end - p));
+    if (!star) return end;
+    p = static_cast<const char*>(star) + 1;
+    if (p < end && *p == close) return p + 1;
+  }
+  return end;
+}
+
+// If a comment ("//", "/*", "(*") or an escaped identifier starts at p (or,
+// for "(*", at p - 1), the position just past it; otherwise p.
+inline const char* skip_trivia(const char* begin, const char* p, const char* end) {
+  const char c = *p;
+  const char next = p + 1 < end ? p[1] : '\0';
+  if (c == '/' && next == '/') {
+    const void* nl = std::memchr(p + 2, '\n', size_t(end - p - 2));
+    return nl ? static_cast<const char*>(nl) + 1 : end;
+  }
+  if (c == '/' && next == '*') return skip_block(p + 2, end, '/');
+  if (c == '*' && p > begin && p[-1] == '(') return skip_block(p + 1, end, ')');
+  if (c == '\\') {
+    ++p;
+    while (p < end && !ends_escaped(*p)) ++p;
+  }
+  return p;
+}
+
+// Whether the whole word `kw` starts at p.
+inline bool word_at(const char* begin, const char* p, const char* end, std::string_view kw) {
+  const size_t n = kw.size();
+  return (p == begin || !is_ident_char(p[-1])) && size_t(end - p) >= n &&
+         std::memcmp(p, kw.data(), n) == 0 && (size_t(end - p) == n || !is_ident_char(p[n]));
+}
+
+// Finds whole-word occurrences of one keyword outside comments and escaped
+// identifiers. The inner loop only stops on bytes that can start a comment,
+// an escaped identifier or the keyword, so plain text is skipped at memchr-like speed.
+class KeywordScanner {
+public:
+  explicit KeywordScanner(std::string_view kw) : kw_(kw) {
+    stop_['/'] = stop_['*'] = stop_['\\'] = true;   // "(*" is caught at its '*': '(' is far more common
+    stop_[uint8_t(kw[0])] = true;
+  }
+
+  const char* find(const char* begin, const char* p, const char* end) const {
+    while (p < end) {
+      while (p < end && !stop_[uint8_t(*p)]) ++p;
+      if (p >= end) break;
+      const char* q = skip_trivia(begin, p, end);
+      if (q != p) { p = q; continue; }
+      if (*p == kw_[0] && word_at(begin, p, end, kw_)) return p;
+      ++p;
+    }
+    return end;
+  }
+
+private:
+  std::string_view kw_;
+  std::array<bool, 256> stop_{};
+};
+
+}} // namespace verilog::scan
@@ -0,0 +1,160 @@
+#pragma once
+#include "verilog_connectivity.hpp"
+#include "verilog_snapshot.hpp"
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+namespace verilog { namespace server {
+
+// Wire protocol. Every message is a frame:
+//   u32 body_len | u32 request_id | u8 code | payload   (body_len counts from request_id)
+// In a request `code` is an Op, in a response a Status. Integers are
+// little-endian; a string is u32 length + bytes. The server answers each
+// connection's requests in the order they arrive, so a client may write any
+// number of requests before reading (pipelining) and match responses by id.
+//
+//   Op            request payload                 response payload (Status::Ok)
+//   Ping          -                               -
+//   ListDesigns   -                               u32 n, n x {str name, str top, u64 modules, u64 instances}
+//   ListModules   str design                      u32 n, n x str
+//   FindInstance  str design, str module, str inst str master, u32 n, n x {str pin, str expr}
+//   NetFanout     str design, str module, str net u32 n, n x {str node, str pin, u8 PortDir}
+//   ResolvePath   str design, str path            u32 n, n x {str inst, str master}, u8 PathEnd, str name
+//
+// Any other status carries a str message.
+enum class Op : uint8_t { Ping = 0, ListDesigns = 1, ListModules = 2, FindInstance = 3, NetFanout = 4, ResolvePath = 5 };
+enum class Status : uint8_t { Ok = 0, NotFound = 1, BadRequest = 2, Error = 3 };
+
+constexpr uint32_t kMaxFrame = 64u << 20;
+
+struct protocol_error : std::runtime_error { using std::runtime_error::runtime_error; };
+
+// Appends little-endian fields to a buffer.
+struct WireWriter {
+  std::string& out;
+  void u8(uint8_t v)  { out.push_back(char(v)); }
+  void u32(uint32_t v) { for (int i = 0; i < 4; ++i) out.push_back(char(v >> (8 * i))); }
+  void u64(uint64_t v) { for (int i = 0; i < 8; ++i) out.push_back(char(v >> (8 * i))); }
+  void str(std::string_view s) { u32(uint32_t(s.size())); out.append(s); }
+};
+
+// Reads fields back; throws protocol_error on truncated input.
+struct WireReader {
+  std::string_view in;
+  size_t pos = 0;
+  uint8_t  u8()  { need(1); return uint8_t(in[pos++]); }
+  uint32_t u32() { need(4); uint32_t v = 0; for (int i = 0; i < 4; ++i) v |= uint32_t(uint8_t(in[pos++])) << (8 * i); return v; }
+  uint64_t u64() { need(8); uint64_t v = 0; for (int i = 0; i < 8; ++i) v |= uint64_t(uint8_t(in[pos++])) << (8 * i); return v; }
+  std::string_view str() { const uint32_t n = u32(); need(n); auto s = in.substr(pos, n); pos += n; return s; }
+  bool done() const { return pos == in.size(); }
+private:
+  void need(size_t n) const { if (in.size() - pos < n) throw protocol_error("truncated message"); }
+};
+
+struct DesignInfo   { std::string name; std::string top; uint64_t modules = 0; uint64_t instances = 0; };
+struct InstanceInfo { std::string master; std::vector<std::pair<std::string, std::string>> connections; };  // pin -> expression
+struct PinRef       { std::string node; std::string pin; PortDir dir = PortDir::Unknown; };
+// node: instance name, module port name, or "assign#k"; dir as seen from the node (Output drives).
+struct FanoutInfo   { std::vector<PinRef> pins; };
+
+enum class PathEnd : uint8_t { Instance = 0, Pin = 1, Net = 2 };
+struct PathInfo {
+  std::vector<std::pair<std::string, std::string>> hops;   // (instance, master), top down
+  PathEnd end = PathEnd::Instance;
+  std::string name;   // pin or net name for Pin/Net ends
+};
+
+// ---------- server ----------
+
+// Serves any number of immutable designs over a Unix domain socket. Every
+// connection gets its own thread; designs are FrozenNetlists, so lookups take
+// no locks. A module's ModuleGraph is built on its first fanout query and
+// then kept.
+class NetlistServer {
+public:
+  explicit NetlistServer(std::string socket_path);
+  ~NetlistServer();   // stop()
+  NetlistServer(const NetlistServer&) = delete;
+  NetlistServer& operator=(const NetlistServer&) = delete;
+
+  // Adds a design before start(). An empty top picks the last module that no
+  // other module instantiates. Throws std::runtime_error on a duplicate name.
+  void add_design(std::string name, Netlist nl, std::string top = "");
+
+  void start();   // binds, listens and returns; throws std::runtime_error
+  void stop();    // closes the socket and every connection, joins all threads
+
+  const std::string& socket_path() const { return path_; }
+
+  // Answers one request frame body (id, op, payload); appends the response frame.
+  void handle(std::string_view body, std::string& out) const;
+
+private:
+  struct Design;
+  struct Conn { std::thread th; std::atomic<bool> done{false}; int fd = -1; };
+
+  void accept_loop();
+  void reap();
+  void serve(Conn* c);
+  const Design* design(std::string_view name) const;
+
+  std::string path_;
+  std::vector<std::unique_ptr<Design>> designs_;
+  int listen_fd_ = -1;
+  int wake_[2] = { -1, -1 };   // written on stop(); every poll() watches wake_[0]
+  std::thread acceptor_;
+  std::mutex conns_mu_;
+  std::list<Conn> conns_;
+};
+
+// ---------- client ----------
+
+// Blocking client for one connection; not thread-safe. The single-query calls
+// do one round trip each. The *_batch calls pipeline: they write up to
+// `window` requests before reading the responses, so N queries cost about
+// one round trip per window instead of N.
+class NetlistClient {
+public:
+  explicit NetlistClient(const std::string& socket_path);   // throws std::runtime_error
+  ~NetlistClient();
+  NetlistClient(const NetlistClient&) = delete;
+  NetlistClient& operator=(const NetlistClient&) = delete;
+
+  struct Response { uint32_t id = 0; Status status = Status::Ok; std::string payload; };
+
+  // Raw access: post() queues a request, flush() writes everything queued,
+  // next() reads the next response (in request order).
+  uint32_t post(Op op, std::string_view payload);
+  void flush();
+  Response next();
+
+  void ping();
+  std::vector<DesignInfo> list_designs();
+  std::vector<std::string> list_modules(std::string_view design);
+  std::optional<InstanceInfo> find_instance(std::string_view design, std::string_view module, std::string_view inst);
+  std::optional<FanoutInfo> net_fanout(std::string_view design, std::string_view module, std::string_view net);
+  std::optional<PathInfo> resolve_path(std::string_view design, std::string_view path);
+
+  std::vector<std::optional<InstanceInfo>> find_instance_batch(std::string_view design, std::string_view module,
+                                                               const std::vector<std::string>& insts, size_t window = 256);
+  std::vector<std::optional<PathInfo>> resolve_path_batch(std::string_view design,
+                                                          const std::vector<std::string>& paths, size_t window = 256);
+
+private:
+  Response call(Op op, std::string_view payload);
+  template<typename T, typename Encode, typename Decode>
+  std::vector<std::optional<T>> batch(size_t n, size_t window, Op op, Encode enc, Decode dec);
+
+  int fd_ = -1;
+  uint32_t next_id_ = 1;
+  std::string out_;
+  std::string in_;
+  size_t in_pos_ = 0;
+};
+
+}} // namespace verilog::server
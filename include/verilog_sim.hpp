@@ -0,0 +1,130 @@
+#pragma once
+#include "veriloglib.hpp"
+#include "verilog_connectivity.hpp"
+#include <span>
+
+namespace verilog {
+
+// Logic function of a leaf cell: one truth table per output over up to six
+// single-bit inputs. Row r of a table holds the output when input j is bit j
+// of r, so a two-input NAND over (A, B) is 0b0111 and a 2:1 mux over
+// (A, B, S) is 0b11001010.
+struct CellFunction {
+  std::vector<std::string> inputs;
+  std::vector<std::string> outputs;
+  std::vector<uint64_t> tables;   // one per output
+};
+
+// Cell functions by master name, supplied by the user.
+class CellFunctions {
+public:
+  static constexpr size_t kMaxInputs = 6;
+
+  // Throws std::invalid_argument for more than kMaxInputs inputs or a table
+  // count that does not match the outputs. Replaces a same-named entry.
+  void add(std::string master, CellFunction f);
+  // Shorthand for single-output cells.
+  void add(std::string master, std::vector<std::string> inputs, std::string output, uint64_t table);
+
+  const CellFunction* find(std::string_view master) const;
+  size_t size() const { return by_name_.size(); }
+
+  // Pin directions of every registered cell (inputs, then outputs, one bit
+  // each), for building the ModuleGraph the simulator runs on.
+  void add_interfaces(InterfaceTable& t) const;
+
+private:
+  std::unordered_map<std::string, CellFunction, string_hash, std::equal_to<>> by_name_;
+};
+
+struct SimOptions {
+  // Masters treated as state elements (`*` and `?` wildcards, "DFF*"): the
+  // nets they drive become inputs of the simulation and the nets they read
+  // become outputs, so one run evaluates one clock cycle's combinational
+  // logic.
+  std::vector<std::string> sequential;
+  unsigned threads = 1;   // vector blocks are split over this many workers; 0: hardware concurrency
+  bool avx2 = true;       // use 256-bit AVX2 operations when the CPU has them
+};
+
+// Two-valued, bit-parallel simulation of one flat module: continuous
+// assigns, gate primitives and cells with a registered function, evaluated
+// in levelized order. Every machine word carries 64 test vectors, and four
+// words go through each operation at a time (256 vectors, one AVX2 register
+// when available). Constants in connections are honoured (x and z read as
+// 0), undriven nets are 0, and a net with several drivers takes the value of
+// the last one evaluated.
+//
+// Inputs are the bits of input and inout ports ("a", "bus[3]") and the
+// outputs of sequential cells ("r0.Q"); outputs are the bits of output and
+// inout ports and the inputs of sequential cells ("r0.D").
+class Simulator {
+public:
+  // Throws std::runtime_error for an instance whose master has no function
+  // and is not sequential (flatten hierarchical designs first), or for a
+  // combinational loop.
+  Simulator(const ModuleGraph& g, const CellFunctions& cells, SimOptions opts = {});
+
+  size_t num_inputs() const { return input_slot_.size(); }
+  size_t num_outputs() const { return output_slot_.size(); }
+  const std::string& input_name(size_t i) const { return input_name_[i]; }
+  const std::string& output_name(size_t i) const { return output_name_[i]; }
+  size_t num_ops() const { return op_.size(); }
+  size_t num_levels() const { return level_begin_.size() - 1; }
+
+  // Simulates 64 * words vectors. Input i's values are in[i * words ..
+  // i * words + words), bit k of word w being vector 64 w + k; outputs are
+  // written to `out` the same way.
+  void run(std::span<const uint64_t> in, std::span<uint64_t> out, size_t words = 1) const;
+
+private:
+  uint32_t slot_of(NetId n) const { return n == kNoNet ? sink_ : net_slot_[n]; }
+  void slots(const Expr& e, std::vector<uint32_t>& out) const;
+  void add_op(uint8_t op, std::span<const uint32_t> outs, std::span<const uint32_t> ins, uint32_t table = 0);
+
+  const ModuleGraph* g_;
+  SimOptions opts_;
+  uint32_t const0_ = 0, const1_ = 0, sink_ = 0, num_slots_ = 0;
+  std::vector<uint32_t> net_slot_;     // the net itself, or const0_ / const1_ for supply0 / supply1 nets
+
+  // The levelized program, as parallel arrays: op k writes args
+  // [arg_begin[k], arg_begin[k] + nout[k]) from the args after them.
+  std::vector<uint8_t> op_;            // gate type, copy or table (verilog_sim.cpp)
+  std::vector<uint32_t> arg_begin_{0};
+  std::vector<uint32_t> args_;
+  std::vector<uint8_t> nout_;
+  std::vector<uint32_t> table_;        // Table ops: index of the first output's table
+  std::vector<uint64_t> tables_;
+  std::vector<uint32_t> level_begin_{0};
+
+  std::vector<uint32_t> input_slot_, output_slot_;
+  std::vector<std::string> input_name_, output_name_;
+};
+
+struct EquivalenceOptions {
+  size_t vectors = 1 << 16;               // rounded up to a multiple of 64
+  uint64_t seed = 1;
+  std::vector<std::string> sequential;    // as in SimOptions; state elements are matched by instance name
+  unsigned threads = 1;
+};
+
+struct EquivalenceResult {
+  size_t vectors = 0;
+  std::vector<std::string> only_in_a, only_in_b;   // inputs and outputs present on one side
+  std::vector<std::string> mismatched;             // outputs that differ on some vector
+  // Inputs of the first failing vector, by name, when there is one.
+  std::vector<std::pair<std::string, bool>> counterexample;
+
+  bool equivalent() const { return mismatched.empty() && only_in_a.empty() && only_in_b.empty(); }
+  std::string report() const;
+};
+
+// Random-pattern equivalence smoke test of two versions of a module, for
+// example before and after an ECO: the same random values go to same-named
+// inputs (unmatched inputs get their own), and same-named outputs are
+// compared. Agreement on every vector is evidence, not proof, of
+// equivalence.
+EquivalenceResult simulate_equivalence(const ModuleGraph& a, const ModuleGraph& b, const CellFunctions& cells,
+                                       const EquivalenceOptions& opts = {});
+
+} // namespace verilog
@@ -0,0 +1,116 @@
+#pragma once
+#include "veriloglib.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <span>
+
+namespace verilog {
+
+// Immutable netlist snapshot. It is built once from a Netlist, with
+// concatenations deep-copied so nothing is shared with the source, and is
+// then only read. Every accessor is const and returns references into the
+// snapshot, so any number of threads may read it at once without locks.
+// Copying an Expr out of a snapshot is the only thing that touches a
+// reference count.
+class FrozenNetlist {
+public:
+  explicit FrozenNetlist(Netlist nl, uint64_t version = 0);
+  FrozenNetlist(const FrozenNetlist&) = delete;
+  FrozenNetlist& operator=(const FrozenNetlist&) = delete;
+
+  uint64_t version() const { return version_; }
+  std::span<const Module> modules() const { return nl_.modules; }
+  const Netlist& netlist() const { return nl_; }
+
+  const Module* find_module(std::string_view name) const;   // first definition wins
+  const ModuleInstance* find_instance(const Module& m, std::string_view instance) const;
+
+  Netlist thaw() const;   // deep, mutable copy, e.g. to apply an ECO and publish again
+
+private:
+  using NameIndex = std::vector<std::pair<std::string_view, uint32_t>>;   // sorted by name
+
+  Netlist nl_;
+  uint64_t version_;
+  NameIndex module_index_;
+  std::vector<NameIndex> instance_index_;
+};
+
+// RCU-style publication of FrozenNetlist versions for long-running readers.
+// Each reading thread owns a cache-line-sized slot. A read stamps the slot
+// with the current epoch and then loads the snapshot through a plain atomic
+// pointer, so readers take no locks and write no shared cache lines.
+// publish() swaps the pointer and retires the old snapshot. A retired
+// snapshot is freed once every active reader entered after the swap.
+class SnapshotPublisher {
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> epoch{0};   // 0: not reading
+    std::atomic<bool> used{false};
+  };
+
+public:
+  // Pins one snapshot for the guard's lifetime. Not reentrant per Reader.
+  class ReadGuard {
+  public:
+    ReadGuard(ReadGuard&& o) noexcept : slot_(o.slot_), snap_(o.snap_) { o.slot_ = nullptr; }
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+    ~ReadGuard() { if (slot_) slot_->epoch.store(0, std::memory_order_release); }
+
+    const FrozenNetlist* get() const { return snap_; }           // nullptr before the first publish
+    const FrozenNetlist& operator*() const { return *snap_; }
+    const FrozenNetlist* operator->() const { return snap_; }
+    explicit operator bool() const { return snap_ != nullptr; }
+
+  private:
+    friend class SnapshotPublisher;
+    ReadGuard(Slot* s, const FrozenNetlist* p) : slot_(s), snap_(p) {}
+    Slot* slot_;
+    const FrozenNetlist* snap_;
+  };
+
+  // Per-thread read handle. It must not outlive its publisher.
+  class Reader {
+  public:
+    Reader(Reader&& o) noexcept : pub_(o.pub_), slot_(o.slot_) { o.slot_ = nullptr; }
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+    ~Reader() { if (slot_) slot_->used.store(false, std::memory_order_release); }
+
+    ReadGuard read() const { return pub_->enter(slot_); }
+
+  private:
+    friend class SnapshotPublisher;
+    Reader(const SnapshotPublisher* p, Slot* s) : pub_(p), slot_(s) {}
+    const SnapshotPublisher* pub_;
+    Slot* slot_;
+  };
+
+  explicit SnapshotPublisher(size_t max_readers = 256);
+  ~SnapshotPublisher();   // no reader may be active
+  SnapshotPublisher(const SnapshotPublisher&) = delete;
+  SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+  Reader register_reader();                 // throws std::runtime_error when all slots are taken
+  uint64_t publish(Netlist nl);             // freezes and swaps in; returns the new version
+  uint64_t version() const;
+
+  size_t reclaim();                         // frees what it can; returns snapshots still retired
+  void synchronize();                       // waits until every retired snapshot is freed
+
+private:
+  ReadGuard enter(Slot* s) const;
+  size_t reclaim_locked();
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t nslots_;
+  std::atomic<const FrozenNetlist*> current_{nullptr};
+  std::atomic<uint64_t> epoch_{1};
+
+  mutable std::mutex writer_mu_;   // serialises writers only
+  std::vector<std::pair<uint64_t, const FrozenNetlist*>> retired_;
+  uint64_t version_ = 0;
+};
+
+} // namespace verilog
@@ -0,0 +1,79 @@
+#pragma once
+#include "veriloglib.hpp"
+
+namespace verilog {
+
+// Line starts of one source text, kept compact so it can sit next to a
+// multi-gigabyte netlist: lines are grouped in blocks of kBlockLines, each
+// block stores its first line's offset, and every line stores a 16-bit
+// distance from that (blocks spanning 64 KiB or more keep full offsets
+// instead). About 2.1 bytes per line. Offsets past 4 GiB are not covered.
+class LineTable {
+public:
+  static constexpr uint32_t kBlockLines = 64;
+
+  LineTable() = default;
+  explicit LineTable(std::string_view text, std::string name = {});
+
+  const std::string& name() const { return name_; }
+  uint32_t num_lines() const { return num_lines_; }
+  uint32_t line_start(uint32_t line) const;          // offset of a 1-based line
+  SourceLocation locate(uint32_t offset) const;      // binary search; offsets past the end clamp to it
+  size_t memory_bytes() const;
+
+private:
+  struct Block {
+    uint32_t start;   // offset of the block's first line
+    uint32_t wide;    // index into wide_ of the block's offsets, or kNarrow
+  };
+  static constexpr uint32_t kNarrow = UINT32_MAX;
+
+  std::string name_;
+  uint32_t size_ = 0;
+  uint32_t num_lines_ = 0;
+  std::vector<Block> blocks_;
+  std::vector<uint16_t> delta_;   // line start - block start; one per line, unused in wide blocks
+  std::vector<uint32_t> wide_;
+};
+
+// Offsets of a preprocessed stream mapped back to the files it was pieced
+// together from. The stream is a sequence of segments, each either a run of
+// one file's text (offsets map one to one) or a macro expansion (every
+// offset maps to the macro's use). One entry per segment, not per byte.
+class SourceMap {
+public:
+  // Registers a file and returns its index; `lines` is of the file's text.
+  uint32_t add_file(std::string name, std::shared_ptr<const LineTable> lines);
+  // Starts a segment at stream offset `at`, which must not precede the last one's.
+  void add_segment(uint32_t at, uint32_t file, uint32_t origin, bool expansion);
+
+  struct Origin {
+    uint32_t file = 0;
+    uint32_t offset = 0;   // in that file
+  };
+  Origin origin(uint32_t offset) const;
+  SourceLocation locate(uint32_t offset) const;   // with `file` set; {} for an empty map
+  size_t num_files() const { return files_.size(); }
+  const std::string& file_name(uint32_t file) const { return files_[file].name; }
+  size_t num_segments() const { return segments_.size(); }
+
+private:
+  struct File {
+    std::string name;
+    std::shared_ptr<const LineTable> lines;
+  };
+  struct Segment {
+    uint32_t at;
+    uint32_t file;
+    uint32_t origin;   // file offset of the segment's first byte, or of the macro use
+    bool expansion;
+  };
+  std::vector<File> files_;
+  std::vector<Segment> segments_;
+};
+
+// Location of the start of `span`, or {} when the netlist has no line table
+// or the span is empty. Preprocessed netlists are looked up in their SourceMap.
+SourceLocation locate(const Netlist& nl, const SourceSpan& span);
+
+} // namespace verilog
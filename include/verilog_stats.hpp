@@ -0,0 +1,46 @@
+#pragma once
+#include "veriloglib.hpp"
+#include <map>
+
+namespace verilog {
+
+class InterfaceTable;
+
+struct StatsOptions {
+  std::string top;        // empty: every module nobody instantiates is a top
+  unsigned threads = 0;   // 0: hardware concurrency
+  const InterfaceTable* cells = nullptr;   // leaf-cell interfaces for masters the netlist does not define
+};
+
+struct NetIssue { std::string module; std::string net; };
+struct PinIssue { std::string module; std::string instance; std::string pin; };
+
+// Whole-design statistics. Instance counts and histograms are for the
+// flattened design: every module's contribution is multiplied by how many
+// times it is instantiated below the top(s). Issue lists name each module
+// definition once.
+struct DesignStats {
+  std::vector<std::string> tops;
+  std::map<std::string, uint64_t> module_instantiations;   // module -> times instantiated (tops: 1)
+  std::map<std::string, uint64_t> instance_counts;         // master -> flattened instance count
+  uint64_t leaf_instances = 0;                             // flattened instances of undefined masters
+  std::map<std::string, uint64_t> gate_counts;             // gate type ("and", ...) -> flattened gate count
+
+  std::map<uint64_t, uint64_t> fanout_histogram;   // loads per net -> nets
+  std::map<uint64_t, uint64_t> fanin_histogram;    // drivers per net -> nets
+  uint64_t unresolved_nets = 0;                    // touch pins of unknown cells; not in the histograms
+
+  std::vector<NetIssue> floating_nets;    // declared, connected to nothing
+  std::vector<NetIssue> undriven_nets;    // loads but no driver (supply0/supply1 nets count as driven)
+  std::vector<NetIssue> unused_nets;      // driven but no loads
+  std::vector<PinIssue> unconnected_pins; // master ports an instance leaves open
+
+  std::string report(size_t max_items = 20) const;   // human-readable dump
+};
+
+// Per-module work (connectivity, local counts, net checks) runs in parallel;
+// the results are merged in module order, so the output does not depend on
+// the thread count.
+DesignStats compute_stats(const Netlist& nl, const StatsOptions& opts = {});
+
+} // namespace verilog
@@ -0,0 +1,25 @@
+#pragma once
+#include "veriloglib.hpp"
+
+namespace verilog {
+
+// A name as Verilog source: unchanged when it is a simple identifier that is
+// not a keyword, else escaped ("\a.b " with the terminating space).
+std::string verilog_identifier(std::string_view name);
+
+// Verilog text of an expression, with escaped names where needed; unlike
+// expr_to_string() the result always parses back to the same expression.
+std::string write_expr(const Expr& e);
+void append_expr(std::string& out, const Expr& e);   // write_expr(), appended to `out`
+
+// Structural Verilog for a module or a whole netlist, in the subset the
+// parser reads: the port list, parameters and localparams (all in the body,
+// with their expressions as written), port and net declarations, continuous
+// assigns, instances with their parameter overrides, and gate primitives.
+// Parsing the text gives back an equal module: same summary(), same
+// connections. Comments, source spans and left-open named connections
+// (`.Q()`, which the parser does not record) are not reproduced.
+std::string write_verilog(const Module& m);
+std::string write_verilog(const Netlist& nl);
+
+} // namespace verilog
@@ -9,14 +9,100 @@
 #include <cstdint>
 #include <sstream>
 #include <memory>
+#include <array>
+#include <span>
+
+#ifndef VERILOGLIB_SOURCE_LOCATIONS
+#define VERILOGLIB_SOURCE_LOCATIONS 1
+#endif
 
 namespace verilog {
 
+// Where a parsed item came from: byte offsets into the parsed text, end
+// exclusive. Line and column are looked up on demand in the netlist's
+// LineTable (verilog_source.hpp). Texts of 4 GiB and more leave spans past
+// that point empty. Building with VERILOGLIB_SOURCE_LOCATIONS=0 turns spans
+// into empty members that take no space and always read as empty.
+#if VERILOGLIB_SOURCE_LOCATIONS
+struct SourceSpan {
+  uint32_t begin = 0;
+  uint32_t end = 0;
+  constexpr bool empty() const { return end <= begin; }
+};
+#else
+struct SourceSpan {
+  static constexpr uint32_t begin = 0;
+  static constexpr uint32_t end = 0;
+  constexpr SourceSpan() = default;
+  constexpr SourceSpan(uint32_t, uint32_t) {}
+  constexpr bool empty() const { return true; }
+};
+#endif
+
+struct SourceLocation {
+  uint32_t line = 0;     // 1-based; 0 when unknown
+  uint32_t column = 0;   // 1-based, in bytes
+  std::string_view file; // set for preprocessed netlists (SourceMap), whose text comes from several files
+};
+
+class LineTable;
+class SourceMap;
+
+// Four-state bit vector. Every bit costs two bits of storage, split over two
+// planes as in the VPI: 0=(a0,b0) 1=(a1,b0) z=(a0,b1) x=(a1,b1). Vectors of up
+// to 64 bits live inline; wider ones spill to a single heap block.
+class LogicVector {
+public:
+  LogicVector() = default;
+  explicit LogicVector(uint32_t width);
+  LogicVector(const LogicVector& o);
+  LogicVector(LogicVector&& o) noexcept;
+  LogicVector& operator=(const LogicVector& o);
+  LogicVector& operator=(LogicVector&& o) noexcept;
+
+  uint32_t width() const { return width_; }
+  size_t num_words() const { return (size_t(width_) + 63) / 64; }
+  const uint64_t* aval() const { return heap_ ? heap_.get() : &inline_[0]; }
+  const uint64_t* bval() const { return heap_ ? heap_.get() + num_words() : &inline_[1]; }
+
+  char bit(uint32_t i) const;            // '0', '1', 'x' or 'z'
+  void set_bit(uint32_t i, char v);
+  void resize(uint32_t width, char fill = '0');
+  bool is_fully_known() const;           // no x/z bits
+  bool fits_uint64() const;              // known, and nothing set above bit 63
+  uint64_t to_uint64() const;            // low 64 bits, x/z read as 0
+  void negate();                         // two's complement within width (known values only)
+  std::string to_string() const;         // sized literal, e.g. 8'hff or 4'b10xz
+
+  bool operator==(const LogicVector& o) const;
+  bool operator!=(const LogicVector& o) const { return !(*this == o); }
+
+private:
+  uint64_t* aval_mut() { return heap_ ? heap_.get() : &inline_[0]; }
+  uint64_t* bval_mut() { return heap_ ? heap_.get() + num_words() : &inline_[1]; }
+
+  uint32_t width_ = 0;
+  uint64_t inline_[2] = {0, 0};
+  std::unique_ptr<uint64_t[]> heap_;
+};
+
 struct Number {
   std::optional<int> length;
   std::optional<char> base;
   std::string mantissa;
-  int64_t as_integer() const;
+
+  // Decoded value, filled once by Number::parse() at parse time. Numbers built
+  // by hand (fields set directly) are decoded on demand instead.
+  LogicVector value;
+  int64_t int_value = 0;
+  bool negative = false;
+  bool decoded = false;
+
+  static Number parse(std::string_view text);   // "8'hFF", "4'b10_xz", "-3", ...
+  int64_t as_integer() const;                   // low 64 bits; x/z bits read as 0
+  bool fits_int64() const;
+  uint32_t width() const;
+  std::string to_string() const;                // decimal when it fits, else sized literal
 };
 
 struct Range {
@@ -28,13 +114,73 @@ struct Range {
 struct Identifier { std::string name; };
 struct IdentifierIndexed { std::string name; Number index; };
 struct IdentifierSliced { std::string name; Range range; };
+// A literal in an expression or connection (`1'b0`, `4'bx01z`, `0`). The
+// bits sit in the variant itself, inline up to 64 bits, so a tie-off costs
+// no allocation and no text.
+struct Constant {
+  LogicVector value;
+  bool sized = true;   // false for a plain decimal such as `0` (32 bits wide)
+};
 struct Concatenation;
-using Expr = std::variant<Identifier, IdentifierIndexed, IdentifierSliced, std::shared_ptr<Concatenation>>;
+using Expr = std::variant<Identifier, IdentifierIndexed, IdentifierSliced, std::shared_ptr<Concatenation>, Constant>;
 struct Concatenation { std::vector<Expr> elements; };
 
+struct Parameter;
+
+// Integer constant expression over parameters, as in `WIDTH-1` or
+// `(DEPTH<<1)+1`: literals, parameter names, unary minus, + - * / % << >>
+// and parentheses. Terms are kept in postfix order, so evaluation is one
+// pass with a small stack.
+struct ParamExpr {
+  enum class Op : uint8_t { Value, Param, Neg, Add, Sub, Mul, Div, Mod, Shl, Shr };
+  struct Term {
+    Op op = Op::Value;
+    int64_t value = 0;   // Value
+    std::string name;    // Param
+  };
+  std::vector<Term> terms;
+
+  static ParamExpr parse(std::string_view text);   // throws parse_error
+  static ParamExpr literal(int64_t v);
+  bool is_literal() const { return terms.size() == 1 && terms[0].op == Op::Value; }
+  // Names resolve to the last parameter of that name in `env`. Throws
+  // std::runtime_error for an unknown name or a division by zero.
+  int64_t eval(std::span<const Parameter> env) const;
+  std::string to_string() const;
+};
+
+// A `parameter` or `localparam`, from the header's #(...) or the body.
+struct Parameter {
+  std::string name;
+  ParamExpr expr;        // the default as written; may use earlier parameters
+  int64_t value = 0;     // expr for the defaults, or the value elaborate() chose
+  bool local = false;    // localparam: not overridable
+  [[no_unique_address]] SourceSpan span;
+};
+
+// The bounds of a declaration range written with parameters (`[WIDTH-1:0]`).
+struct ParamRange {
+  ParamExpr msb, lsb;
+};
+
+// Parameter values of an instantiation, `#(8, 4)` or `#(.W(8))`, in terms
+// of the instantiating module's parameters.
+struct ParamOverrides {
+  std::vector<ParamExpr> positional;
+  std::vector<std::pair<std::string, ParamExpr>> named;
+};
+
+enum class NetType : uint8_t { Wire, Tri, Supply0, Supply1 };
+
 struct NetDeclaration {
-  std::string net_name;
+  std::string net_name;              // first name of the statement
   std::optional<Range> range;
+  std::vector<std::string> names;    // every name declared by the statement, in order
+  NetType type = NetType::Wire;      // wire, tri, supply0 or supply1; always Wire for ports
+  // Set when the range uses parameters; `range` then holds its value for the
+  // parameter defaults until elaborate() resolves it per parameter set.
+  std::shared_ptr<const ParamRange> range_expr;
+  [[no_unique_address]] SourceSpan span;   // the whole statement
 };
 struct OutputDeclaration : NetDeclaration {};
 struct InputDeclaration  : NetDeclaration {};
@@ -42,35 +188,81 @@ struct InoutDeclaration  : NetDeclaration {};
 
 struct ContinuousAssign {
   std::vector<std::pair<Expr, Expr>> assignments;
+  [[no_unique_address]] SourceSpan span;   // `assign` .. `;`
 };
 
 struct ModuleInstance {
   std::string module_name;
   std::string instance_name;
   std::vector<Expr> ports_pos;
-  std::map<std::string, Expr> ports_named;
+  std::map<std::string, Expr> ports_named;   // iterates by port name (byte order), not as written
+  std::shared_ptr<const ParamOverrides> params;   // #(...), shared by the statement's instances; null when absent
+  [[no_unique_address]] SourceSpan span;   // instance name .. closing parenthesis
+};
+
+// Built-in gate primitives. The first terminal of and..xnor is the output;
+// buf and not drive every terminal but the last.
+enum class GateType : uint8_t { And, Nand, Or, Nor, Xor, Xnor, Buf, Not };
+constexpr size_t kNumGateTypes = 8;
+std::string_view gate_type_name(GateType t);   // "and", "nand", ...
+constexpr uint32_t gate_outputs(GateType t, uint32_t terminals) {
+  return (t == GateType::Buf || t == GateType::Not) ? (terminals ? terminals - 1 : 0) : (terminals ? 1 : 0);
+}
+
+// The primitives of one type in a module, as parallel arrays rather than one
+// ModuleInstance each: gate i is names[i] (empty when unnamed), with
+// terminals [ends[i - 1], ends[i]) (from 0 for the first) in the order written.
+struct GateTable {
+  std::vector<std::string> names;
+  std::vector<uint32_t> ends;
+  std::vector<Expr> terminals;
+  std::vector<SourceSpan> spans;   // per gate: name (or type) .. closing parenthesis
+
+  size_t size() const { return names.size(); }
+  bool empty() const { return names.empty(); }
+  std::span<const Expr> terminals_of(size_t i) const {
+    return { terminals.data() + (i ? ends[i - 1] : 0), terminals.data() + ends[i] };
+  }
 };
 
 struct Module {
   std::string module_name;
   std::vector<std::string> port_list;
+  std::vector<Parameter> parameters;   // header #(...) first, then the body's, in order
   std::vector<NetDeclaration> net_declarations;
   std::vector<OutputDeclaration> output_declarations;
   std::vector<InputDeclaration>  input_declarations;
   std::vector<InoutDeclaration>  inout_declarations;
-  std::vector<ModuleInstance>    module_instances;
+  std::vector<ModuleInstance>    module_instances;   // in source order
   std::vector<ContinuousAssign>  assignments;
   std::vector<Module>            sub_modules;
+  std::array<GateTable, kNumGateTypes> gates;   // by GateType
+  [[no_unique_address]] SourceSpan span;   // `module` .. `endmodule`
+  size_t num_gates() const;
+  // Name of gate i of type t, or "<type>#<i>" when it is unnamed.
+  std::string gate_label(GateType t, size_t i) const;
   std::string summary() const;
 };
 
-struct Netlist { std::vector<Module> modules; };
+struct Netlist {
+  std::vector<Module> modules;   // in source order; parse_files(): file by file, in the order given
+  std::shared_ptr<const LineTable> lines;   // of the parsed text; null when built by hand or spans are off
+  std::shared_ptr<const SourceMap> sources; // instead of `lines` for preprocessed input (verilog_preprocess.hpp)
+};
+
+struct parse_error : std::runtime_error {
+  using std::runtime_error::runtime_error;
+  parse_error(const std::string& what, std::string source, SourceLocation where)
+    : std::runtime_error(what), source(std::move(source)), location(where) {}
 
-struct parse_error : std::runtime_error { using std::runtime_error::runtime_error; };
+  std::string source;        // file name, or "verilog_string"; empty when unknown
+  SourceLocation location;   // of the failure; line 0 when unknown
+};
 
 Netlist parse_string(std::string_view text);
 Netlist parse_file(const std::string& path);
 
 std::string expr_to_string(const Expr& e);
+Expr clone_expr(const Expr& e);   // deep copy: concatenations are not shared with `e`
 
 } // namespace verilog
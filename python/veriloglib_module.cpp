@@ -0,0 +1,600 @@
+// The `veriloglib` Python extension: parse_file() / parse_string() with the
+// GIL released, and views over the parsed Netlist. A Module, its instance
+// list and an Instance are small objects pointing into the netlist, which
+// they keep alive; nothing is converted until an attribute is read. Bulk
+// columns are Column objects that export their buffer (uint32), so
+// numpy.asarray() or memoryview() wraps them without a Python object per
+// element. Written against the CPython C API so that it needs nothing but
+// the interpreter's headers.
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "veriloglib.hpp"
+#include "verilog_celllib.hpp"
+#include "verilog_connectivity.hpp"
+#include "verilog_writer.hpp"
+#include <memory>
+#include <unordered_map>
+
+namespace {
+
+using namespace verilog;
+
+PyTypeObject* NetlistType;
+PyTypeObject* ModuleType;
+PyTypeObject* InstanceListType;
+PyTypeObject* InstanceType;
+PyTypeObject* ColumnType;
+PyObject* ParseError;
+
+struct NetlistObject {
+  PyObject_HEAD
+  Netlist* nl;                    // never changed once wrapped, so views may point into it
+  InterfaceTable* ifaces;         // of nl's modules, built on first use
+};
+
+struct ModuleObject {
+  PyObject_HEAD
+  NetlistObject* owner;
+  const Module* m;
+};
+
+struct InstanceListObject {
+  PyObject_HEAD
+  NetlistObject* owner;
+  const Module* m;
+};
+
+struct InstanceObject {
+  PyObject_HEAD
+  NetlistObject* owner;
+  const ModuleInstance* inst;
+};
+
+struct ColumnObject {
+  PyObject_HEAD
+  std::vector<uint32_t>* data;
+};
+
+template<typename T>
+T* alloc(PyTypeObject* type) { return reinterpret_cast<T*>(type->tp_alloc(type, 0)); }
+
+void free_object(PyObject* self) {
+  PyTypeObject* type = Py_TYPE(self);
+  type->tp_free(self);
+  Py_DECREF(type);   // instances of heap types hold their type
+}
+
+// Runs f with the GIL released; exceptions come out after it is taken back.
+template<typename F>
+auto without_gil(F&& f) {
+  PyThreadState* ts = PyEval_SaveThread();
+  try {
+    auto r = f();
+    PyEval_RestoreThread(ts);
+    return r;
+  } catch (...) {
+    PyEval_RestoreThread(ts);
+    throw;
+  }
+}
+
+// C++ exceptions as Python ones: parse_error as veriloglib.ParseError with
+// `source`, `line` and `column`, anything else as RuntimeError.
+template<typename F>
+PyObject* guarded(F&& f) {
+  try {
+    return f();
+  } catch (const parse_error& e) {
+    PyObject* exc = PyObject_CallFunction(ParseError, "s", e.what());
+    if (!exc) return nullptr;
+    PyObject* source = PyUnicode_FromStringAndSize(e.source.data(), Py_ssize_t(e.source.size()));
+    PyObject* line = PyLong_FromUnsignedLong(e.location.line);
+    PyObject* column = PyLong_FromUnsignedLong(e.location.column);
+    if (source && line && column) {
+      PyObject_SetAttrString(exc, "source", source);
+      PyObject_SetAttrString(exc, "line", line);
+      PyObject_SetAttrString(exc, "column", column);
+      PyErr_SetObject(ParseError, exc);
+    }
+    Py_XDECREF(source);
+    Py_XDECREF(line);
+    Py_XDECREF(column);
+    Py_DECREF(exc);
+  } catch (const std::bad_alloc&) {
+    PyErr_NoMemory();
+  } catch (const std::exception& e) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+  }
+  return nullptr;
+}
+
+PyObject* str(std::string_view s) { return PyUnicode_DecodeUTF8(s.data(), Py_ssize_t(s.size()), "surrogateescape"); }
+
+PyObject* str_list(const std::vector<std::string>& v) {
+  PyObject* list = PyList_New(Py_ssize_t(v.size()));
+  if (!list) return nullptr;
+  for (size_t i = 0; i < v.size(); ++i) {
+    PyObject* s = str(v[i]);
+    if (!s) { Py_DECREF(list); return nullptr; }
+    PyList_SET_ITEM(list, Py_ssize_t(i), s);
+  }
+  return list;
+}
+
+PyObject* expr_str(const Expr& e) {
+  std::string s;
+  append_expr(s, e);
+  return str(s);
+}
+
+// ---------------------------------------------------------------- Column
+
+PyObject* make_column(std::vector<uint32_t> v) {
+  ColumnObject* c = alloc<ColumnObject>(ColumnType);
+  if (!c) return nullptr;
+  c->data = new std::vector<uint32_t>(std::move(v));
+  return reinterpret_cast<PyObject*>(c);
+}
+
+void column_dealloc(PyObject* self) {
+  delete reinterpret_cast<ColumnObject*>(self)->data;
+  free_object(self);
+}
+
+Py_ssize_t column_len(PyObject* self) { return Py_ssize_t(reinterpret_cast<ColumnObject*>(self)->data->size()); }
+
+PyObject* column_item(PyObject* self, Py_ssize_t i) {
+  const auto& v = *reinterpret_cast<ColumnObject*>(self)->data;
+  if (i < 0 || size_t(i) >= v.size()) {
+    PyErr_SetString(PyExc_IndexError, "Column index out of range");
+    return nullptr;
+  }
+  return PyLong_FromUnsignedLong(v[size_t(i)]);
+}
+
+// One-dimensional, read-only, uint32; shape and strides live in the view's
+// internal pointer so that any number of exports may be out at once.
+int column_getbuffer(PyObject* self, Py_buffer* view, int flags) {
+  if (flags & PyBUF_WRITABLE) {
+    PyErr_SetString(PyExc_BufferError, "Column is read-only");
+    return -1;
+  }
+  auto& v = *reinterpret_cast<ColumnObject*>(self)->data;
+  auto* dims = new Py_ssize_t[2]{ Py_ssize_t(v.size()), Py_ssize_t(sizeof(uint32_t)) };
+  view->obj = Py_NewRef(self);
+  view->buf = v.data();
+  view->len = Py_ssize_t(v.size() * sizeof(uint32_t));
+  view->readonly = 1;
+  view->itemsize = sizeof(uint32_t);
+  view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>("I") : nullptr;
+  view->ndim = 1;
+  view->shape = (flags & PyBUF_ND) ? &dims[0] : nullptr;
+  view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &dims[1] : nullptr;
+  view->suboffsets = nullptr;
+  view->internal = dims;
+  return 0;
+}
+
+void column_releasebuffer(PyObject*, Py_buffer* view) { delete[] static_cast<Py_ssize_t*>(view->internal); }
+
+PyObject* column_repr(PyObject* self) {
+  return PyUnicode_FromFormat("<veriloglib.Column of %zd uint32>", column_len(self));
+}
+
+PyType_Slot column_slots[] = {
+  { Py_tp_doc, const_cast<char*>("Read-only uint32 column; numpy.asarray() and memoryview() wrap it without copying.") },
+  { Py_tp_dealloc, reinterpret_cast<void*>(column_dealloc) },
+  { Py_tp_repr, reinterpret_cast<void*>(column_repr) },
+  { Py_sq_length, reinterpret_cast<void*>(column_len) },
+  { Py_sq_item, reinterpret_cast<void*>(column_item) },
+  { Py_bf_getbuffer, reinterpret_cast<void*>(column_getbuffer) },
+  { Py_bf_releasebuffer, reinterpret_cast<void*>(column_releasebuffer) },
+  { 0, nullptr },
+};
+
+// ---------------------------------------------------------------- Instance
+
+PyObject* make_instance(NetlistObject* owner, const ModuleInstance* inst) {
+  InstanceObject* o = alloc<InstanceObject>(InstanceType);
+  if (!o) return nullptr;
+  o->owner = owner;
+  Py_INCREF(owner);
+  o->inst = inst;
+  return reinterpret_cast<PyObject*>(o);
+}
+
+template<typename View>
+void view_dealloc(PyObject* self) {
+  Py_DECREF(reinterpret_cast<View*>(self)->owner);
+  free_object(self);
+}
+
+const ModuleInstance& inst_of(PyObject* self) { return *reinterpret_cast<InstanceObject*>(self)->inst; }
+
+PyObject* instance_name(PyObject* self, void*) { return str(inst_of(self).instance_name); }
+PyObject* instance_master(PyObject* self, void*) { return str(inst_of(self).module_name); }
+
+PyObject* instance_ports(PyObject* self, void*) {
+  const auto& pos = inst_of(self).ports_pos;
+  PyObject* list = PyList_New(Py_ssize_t(pos.size()));
+  if (!list) return nullptr;
+  for (size_t i = 0; i < pos.size(); ++i) {
+    PyObject* e = expr_str(pos[i]);
+    if (!e) { Py_DECREF(list); return nullptr; }
+    PyList_SET_ITEM(list, Py_ssize_t(i), e);
+  }
+  return list;
+}
+
+PyObject* instance_pins(PyObject* self, void*) {
+  PyObject* dict = PyDict_New();
+  if (!dict) return nullptr;
+  for (const auto& [pin, e] : inst_of(self).ports_named) {
+    PyObject* k = str(pin);
+    PyObject* v = k ? expr_str(e) : nullptr;
+    const int rc = v ? PyDict_SetItem(dict, k, v) : -1;
+    Py_XDECREF(k);
+    Py_XDECREF(v);
+    if (rc < 0) { Py_DECREF(dict); return nullptr; }
+  }
+  return dict;
+}
+
+PyObject* instance_repr(PyObject* self) {
+  const ModuleInstance& i = inst_of(self);
+  return PyUnicode_FromFormat("<veriloglib.Instance %s %s>", i.module_name.c_str(), i.instance_name.c_str());
+}
+
+PyGetSetDef instance_getset[] = {
+  { "name", instance_name, nullptr, "Instance name.", nullptr },
+  { "master", instance_master, nullptr, "Name of the instantiated module or cell.", nullptr },
+  { "ports", instance_ports, nullptr, "Positional connections, as Verilog text.", nullptr },
+  { "pins", instance_pins, nullptr, "Named connections, pin -> Verilog text, in pin-name order.", nullptr },
+  { nullptr, nullptr, nullptr, nullptr, nullptr },
+};
+
+PyType_Slot instance_slots[] = {
+  { Py_tp_doc, const_cast<char*>("View of one module instance; attributes are read from the netlist on access.") },
+  { Py_tp_dealloc, reinterpret_cast<void*>(view_dealloc<InstanceObject>) },
+  { Py_tp_repr, reinterpret_cast<void*>(instance_repr) },
+  { Py_tp_getset, instance_getset },
+  { 0, nullptr },
+};
+
+// ---------------------------------------------------------------- InstanceList
+
+Py_ssize_t instances_len(PyObject* self) {
+  return Py_ssize_t(reinterpret_cast<InstanceListObject*>(self)->m->module_instances.size());
+}
+
+PyObject* instances_item(PyObject* self, Py_ssize_t i) {
+  auto* l = reinterpret_cast<InstanceListObject*>(self);
+  if (i < 0 || size_t(i) >= l->m->module_instances.size()) {
+    PyErr_SetString(PyExc_IndexError, "instance index out of range");
+    return nullptr;
+  }
+  return make_instance(l->owner, &l->m->module_instances[size_t(i)]);
+}
+
+PyType_Slot instance_list_slots[] = {
+  { Py_tp_doc, const_cast<char*>("The instances of a module, in source order, as a sequence of Instance views.") },
+  { Py_tp_dealloc, reinterpret_cast<void*>(view_dealloc<InstanceListObject>) },
+  { Py_sq_length, reinterpret_cast<void*>(instances_len) },
+  { Py_sq_item, reinterpret_cast<void*>(instances_item) },
+  { 0, nullptr },
+};
+
+// ---------------------------------------------------------------- Module
+
+PyObject* make_module(NetlistObject* owner, const Module* m) {
+  ModuleObject* o = alloc<ModuleObject>(ModuleType);
+  if (!o) return nullptr;
+  o->owner = owner;
+  Py_INCREF(owner);
+  o->m = m;
+  return reinterpret_cast<PyObject*>(o);
+}
+
+const Module& mod_of(PyObject* self) { return *reinterpret_cast<ModuleObject*>(self)->m; }
+
+PyObject* module_name(PyObject* self, void*) { return str(mod_of(self).module_name); }
+PyObject* module_ports(PyObject* self, void*) { return str_list(mod_of(self).port_list); }
+
+PyObject* module_instances(PyObject* self, void*) {
+  auto* mo = reinterpret_cast<ModuleObject*>(self);
+  InstanceListObject* l = alloc<InstanceListObject>(InstanceListType);
+  if (!l) return nullptr;
+  l->owner = mo->owner;
+  Py_INCREF(mo->owner);
+  l->m = mo->m;
+  return reinterpret_cast<PyObject*>(l);
+}
+
+// (codes, names): codes[i] indexes names, the distinct masters in order of
+// first use.
+PyObject* module_instance_masters(PyObject* self, PyObject*) {
+  return guarded([&]() -> PyObject* {
+    const Module& m = mod_of(self);
+    std::vector<std::string_view> names;
+    std::vector<uint32_t> codes = without_gil([&] {
+      std::unordered_map<std::string_view, uint32_t> code;
+      std::vector<uint32_t> c;
+      c.reserve(m.module_instances.size());
+      for (const auto& inst : m.module_instances) {
+        auto [it, fresh] = code.try_emplace(inst.module_name, uint32_t(names.size()));
+        if (fresh) names.push_back(inst.module_name);
+        c.push_back(it->second);
+      }
+      return c;
+    });
+    PyObject* list = PyList_New(Py_ssize_t(names.size()));
+    if (!list) return nullptr;
+    for (size_t i = 0; i < names.size(); ++i) {
+      PyObject* s = str(names[i]);
+      if (!s) { Py_DECREF(list); return nullptr; }
+      PyList_SET_ITEM(list, Py_ssize_t(i), s);
+    }
+    PyObject* col = make_column(std::move(codes));
+    if (!col) { Py_DECREF(list); return nullptr; }
+    return Py_BuildValue("(NN)", col, list);
+  });
+}
+
+// Interfaces for connectivity: the netlist's own modules, cached, or those
+// plus the cells of `cells` (a Netlist of stubs) for one call.
+bool interfaces(ModuleObject* mo, PyObject* cells, const InterfaceTable*& out, std::unique_ptr<InterfaceTable>& tmp) {
+  if (cells && cells != Py_None) {
+    if (!PyObject_TypeCheck(cells, NetlistType)) {
+      PyErr_SetString(PyExc_TypeError, "cells must be a veriloglib.Netlist of cell stubs");
+      return false;
+    }
+    const Netlist& stubs = *reinterpret_cast<NetlistObject*>(cells)->nl;
+    tmp = without_gil([&] {
+      auto t = std::make_unique<InterfaceTable>(*mo->owner->nl);
+      add_cell_stubs(*t, stubs);
+      return t;
+    });
+    out = tmp.get();
+    return true;
+  }
+  if (!mo->owner->ifaces) {
+    // Built without the GIL, so another thread may have stored its table
+    // meanwhile; the first one stored is kept.
+    std::unique_ptr<InterfaceTable> t = without_gil([&] { return std::make_unique<InterfaceTable>(*mo->owner->nl); });
+    if (!mo->owner->ifaces) mo->owner->ifaces = t.release();
+  }
+  out = mo->owner->ifaces;
+  return true;
+}
+
+PyObject* module_net_fanouts(PyObject* self, PyObject* args, PyObject* kwargs) {
+  static const char* kw[] = { "cells", nullptr };
+  PyObject* cells = nullptr;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|O", const_cast<char**>(kw), &cells)) return nullptr;
+  return guarded([&]() -> PyObject* {
+    auto* mo = reinterpret_cast<ModuleObject*>(self);
+    const InterfaceTable* lib;
+    std::unique_ptr<InterfaceTable> tmp;
+    if (!interfaces(mo, cells, lib, tmp)) return nullptr;
+    std::vector<uint32_t> loads = without_gil([&] {
+      const ModuleGraph g(*mo->m, *lib);
+      std::vector<uint32_t> v(g.num_nets(), 0);
+      for (NetId n = 0; n < g.num_nets(); ++n)
+        for (uint32_t p : g.net_pins(n)) v[n] += g.pins()[p].dir != PortDir::Output;
+      return v;
+    });
+    return make_column(std::move(loads));
+  });
+}
+
+PyObject* module_net_names(PyObject* self, PyObject*) {
+  return guarded([&]() -> PyObject* {
+    auto* mo = reinterpret_cast<ModuleObject*>(self);
+    const InterfaceTable* lib;
+    std::unique_ptr<InterfaceTable> tmp;
+    if (!interfaces(mo, nullptr, lib, tmp)) return nullptr;
+    std::vector<std::string> names = without_gil([&] {
+      const ModuleGraph g(*mo->m, *lib);
+      std::vector<std::string> v(g.num_nets());
+      for (NetId n = 0; n < g.num_nets(); ++n) v[n] = g.net_name(n);
+      return v;
+    });
+    return str_list(names);
+  });
+}
+
+PyObject* module_to_verilog(PyObject* self, PyObject*) {
+  return guarded([&] { return str(write_verilog(mod_of(self))); });
+}
+
+PyObject* module_repr(PyObject* self) {
+  const Module& m = mod_of(self);
+  return PyUnicode_FromFormat("<veriloglib.Module %s: %zu instances>", m.module_name.c_str(), m.module_instances.size());
+}
+
+PyGetSetDef module_getset[] = {
+  { "name", module_name, nullptr, "Module name.", nullptr },
+  { "ports", module_ports, nullptr, "Names in the header's port list.", nullptr },
+  { "instances", module_instances, nullptr, "Sequence of Instance views, in source order.", nullptr },
+  { nullptr, nullptr, nullptr, nullptr, nullptr },
+};
+
+PyMethodDef module_methods[] = {
+  { "instance_masters", module_instance_masters, METH_NOARGS,
+    "instance_masters() -> (Column, list[str])\n\n"
+    "Master of every instance, dictionary-encoded: codes[i] indexes the list of distinct masters." },
+  { "net_fanouts", reinterpret_cast<PyCFunction>(reinterpret_cast<void*>(module_net_fanouts)), METH_VARARGS | METH_KEYWORDS,
+    "net_fanouts(cells=None) -> Column\n\n"
+    "Loads on every net bit, in net_names() order: pins that do not only drive the net. Directions\n"
+    "come from the netlist's modules and the cell stubs in `cells` (a Netlist); pins of cells\n"
+    "neither defines count as loads." },
+  { "net_names", module_net_names, METH_NOARGS, "net_names() -> list[str]\n\nName of every net bit (\"a\", \"bus[3]\")." },
+  { "to_verilog", module_to_verilog, METH_NOARGS, "to_verilog() -> str\n\nThe module as structural Verilog." },
+  { nullptr, nullptr, 0, nullptr },
+};
+
+PyType_Slot module_slots[] = {
+  { Py_tp_doc, const_cast<char*>("View of one module of a Netlist.") },
+  { Py_tp_dealloc, reinterpret_cast<void*>(view_dealloc<ModuleObject>) },
+  { Py_tp_repr, reinterpret_cast<void*>(module_repr) },
+  { Py_tp_getset, module_getset },
+  { Py_tp_methods, module_methods },
+  { 0, nullptr },
+};
+
+// ---------------------------------------------------------------- Netlist
+
+PyObject* wrap(Netlist nl) {
+  NetlistObject* o = alloc<NetlistObject>(NetlistType);
+  if (!o) return nullptr;
+  o->nl = new Netlist(std::move(nl));
+  return reinterpret_cast<PyObject*>(o);
+}
+
+void netlist_dealloc(PyObject* self) {
+  auto* o = reinterpret_cast<NetlistObject*>(self);
+  delete o->ifaces;
+  delete o->nl;
+  free_object(self);
+}
+
+Py_ssize_t netlist_len(PyObject* self) { return Py_ssize_t(reinterpret_cast<NetlistObject*>(self)->nl->modules.size()); }
+
+PyObject* netlist_item(PyObject* self, Py_ssize_t i) {
+  auto* o = reinterpret_cast<NetlistObject*>(self);
+  if (i < 0 || size_t(i) >= o->nl->modules.size()) {
+    PyErr_SetString(PyExc_IndexError, "module index out of range");
+    return nullptr;
+  }
+  return make_module(o, &o->nl->modules[size_t(i)]);
+}
+
+// The first module of that name, or nullptr.
+const Module* find_module(NetlistObject* o, PyObject* name) {
+  Py_ssize_t len;
+  const char* s = PyUnicode_AsUTF8AndSize(name, &len);
+  if (!s) return nullptr;
+  for (const auto& m : o->nl->modules)
+    if (m.module_name == std::string_view(s, size_t(len))) return &m;
+  return nullptr;
+}
+
+PyObject* netlist_subscript(PyObject* self, PyObject* key) {
+  auto* o = reinterpret_cast<NetlistObject*>(self);
+  if (!PyUnicode_Check(key)) {
+    const Py_ssize_t i = PyNumber_AsSsize_t(key, PyExc_IndexError);
+    if (i == -1 && PyErr_Occurred()) return nullptr;
+    return netlist_item(self, i < 0 ? i + netlist_len(self) : i);
+  }
+  const Module* m = find_module(o, key);
+  if (!m) {
+    if (!PyErr_Occurred()) PyErr_SetObject(PyExc_KeyError, key);
+    return nullptr;
+  }
+  return make_module(o, m);
+}
+
+PyObject* netlist_find(PyObject* self, PyObject* name) {
+  if (!PyUnicode_Check(name)) {
+    PyErr_SetString(PyExc_TypeError, "find() takes a module name");
+    return nullptr;
+  }
+  const Module* m = find_module(reinterpret_cast<NetlistObject*>(self), name);
+  if (m) return make_module(reinterpret_cast<NetlistObject*>(self), m);
+  if (PyErr_Occurred()) return nullptr;
+  Py_RETURN_NONE;
+}
+
+PyObject* netlist_repr(PyObject* self) {
+  return PyUnicode_FromFormat("<veriloglib.Netlist: %zd modules>", netlist_len(self));
+}
+
+PyMethodDef netlist_methods[] = {
+  { "find", netlist_find, METH_O, "find(name) -> Module | None\n\nThe first module of that name." },
+  { nullptr, nullptr, 0, nullptr },
+};
+
+PyType_Slot netlist_slots[] = {
+  { Py_tp_doc, const_cast<char*>("A parsed netlist: a sequence of Module views, also indexed by module name.") },
+  { Py_tp_dealloc, reinterpret_cast<void*>(netlist_dealloc) },
+  { Py_tp_repr, reinterpret_cast<void*>(netlist_repr) },
+  { Py_tp_methods, netlist_methods },
+  { Py_sq_length, reinterpret_cast<void*>(netlist_len) },
+  { Py_sq_item, reinterpret_cast<void*>(netlist_item) },
+  { Py_mp_length, reinterpret_cast<void*>(netlist_len) },
+  { Py_mp_subscript, reinterpret_cast<void*>(netlist_subscript) },
+  { 0, nullptr },
+};
+
+// ---------------------------------------------------------------- functions
+
+PyObject* py_parse_string(PyObject*, PyObject* arg) {
+  Py_buffer buf;
+  Py_ssize_t len = 0;
+  const char* text = nullptr;
+  const bool is_str = PyUnicode_Check(arg);
+  if (is_str) {
+    text = PyUnicode_AsUTF8AndSize(arg, &len);
+    if (!text) return nullptr;
+  } else {
+    if (PyObject_GetBuffer(arg, &buf, PyBUF_SIMPLE) < 0) return nullptr;
+    text = static_cast<const char*>(buf.buf);
+    len = buf.len;
+  }
+  // `arg` is referenced by the call for its whole duration, so the text stays put without the GIL.
+  PyObject* r = guarded([&] { return wrap(without_gil([&] { return parse_string(std::string_view(text, size_t(len))); })); });
+  if (!is_str) PyBuffer_Release(&buf);
+  return r;
+}
+
+PyObject* py_parse_file(PyObject*, PyObject* arg) {
+  PyObject* bytes = nullptr;
+  if (!PyUnicode_FSConverter(arg, &bytes)) return nullptr;
+  const std::string path(PyBytes_AS_STRING(bytes), size_t(PyBytes_GET_SIZE(bytes)));
+  Py_DECREF(bytes);
+  return guarded([&] { return wrap(without_gil([&] { return parse_file(path); })); });
+}
+
+PyMethodDef functions[] = {
+  { "parse_string", py_parse_string, METH_O,
+    "parse_string(text: str | bytes) -> Netlist\n\nParses Verilog text; the GIL is released while parsing." },
+  { "parse_file", py_parse_file, METH_O,
+    "parse_file(path) -> Netlist\n\nParses a Verilog file; the GIL is released while parsing." },
+  { nullptr, nullptr, 0, nullptr },
+};
+
+PyModuleDef module_def = {
+  PyModuleDef_HEAD_INIT, "veriloglib",
+  "Structural Verilog netlists: parsing with the GIL released and zero-copy views.", -1, functions,
+  nullptr, nullptr, nullptr, nullptr,
+};
+
+PyTypeObject* make_type(PyObject* module, const char* name, const char* qualified, size_t size, PyType_Slot* slots) {
+  PyType_Spec spec = { qualified, int(size), 0, Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DISALLOW_INSTANTIATION, slots };
+  PyObject* type = PyType_FromSpec(&spec);
+  if (!type || PyModule_AddObjectRef(module, name, type) < 0) {
+    Py_XDECREF(type);
+    return nullptr;
+  }
+  return reinterpret_cast<PyTypeObject*>(type);
+}
+
+} // namespace
+
+PyMODINIT_FUNC PyInit_veriloglib() {
+  PyObject* m = PyModule_Create(&module_def);
+  if (!m) return nullptr;
+  ParseError = PyErr_NewExceptionWithDoc("veriloglib.ParseError",
+                                         "A syntax error; `source`, `line` and `column` tell where (line 0 when unknown).",
+                                         PyExc_ValueError, nullptr);
+  if (!ParseError || PyModule_AddObjectRef(m, "ParseError", ParseError) < 0 ||
+      !(NetlistType = make_type(m, "Netlist", "veriloglib.Netlist", sizeof(NetlistObject), netlist_slots)) ||
+      !(ModuleType = make_type(m, "Module", "veriloglib.Module", sizeof(ModuleObject), module_slots)) ||
+      !(InstanceListType = make_type(m, "InstanceList", "veriloglib.InstanceList", sizeof(InstanceListObject), instance_list_slots)) ||
+      !(InstanceType = make_type(m, "Instance", "veriloglib.Instance", sizeof(InstanceObject), instance_slots)) ||
+      !(ColumnType = make_type(m, "Column", "veriloglib.Column", sizeof(ColumnObject), column_slots))) {
+    Py_DECREF(m);
+    return nullptr;
+  }
+  return m;
+}
@@ -1,12 +1,214 @@
 #include "veriloglib.hpp"
+#include "verilog_celllib.hpp"
+#include "verilog_check.hpp"
+#include "verilog_cone.hpp"
+#include "verilog_diff.hpp"
+#include "verilog_elaborate.hpp"
+#include "verilog_export.hpp"
+#include "verilog_lazy.hpp"
+#include "verilog_levelize.hpp"
+#include "verilog_partition.hpp"
+#include "verilog_preprocess.hpp"
+#include "verilog_recover.hpp"
+#include "verilog_stats.hpp"
+#include "verilog_writer.hpp"
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 
 int main(int argc, char** argv) {
-  if (argc < 2) { std::cerr << "Usage: vparse <file.v>\n"; return 1; }
+  bool report = false, outline = false, check = false, keep_going = false, preprocess = false, elaborate = false,
+       diff = false, json = false, fanout = false, levels = false, split = false;
+  std::string path, cells, top, cone, out_dir, binary_out;
+  uint32_t parts = 0;
+  std::vector<std::string> paths, stops;
+  verilog::PreprocessOptions pp;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--report") report = true;
+    else if (a == "--outline") outline = true;
+    else if (a == "--check") check = true;
+    else if (a == "--keep-going") keep_going = true;
+    else if (a == "--cells" && i + 1 < argc) cells = argv[++i];
+    else if (a == "--preprocess") preprocess = true;
+    else if (a == "--elaborate") elaborate = true;
+    else if (a == "--diff") diff = true;
+    else if (a == "--json") json = true;
+    else if (a == "--binary" && i + 1 < argc) binary_out = argv[++i];
+    else if (a == "--cone" && i + 1 < argc) cone = argv[++i];
+    else if (a == "--fanout") fanout = true;
+    else if (a == "--stop" && i + 1 < argc) stops.push_back(argv[++i]);
+    else if (a == "--levels") levels = true;
+    else if (a == "--partition" && i + 1 < argc) { parts = uint32_t(std::strtoul(argv[++i], nullptr, 10)); split = true; }
+    else if (a == "--out" && i + 1 < argc) out_dir = argv[++i];
+    else if (a == "--top" && i + 1 < argc) { top = argv[++i]; elaborate = true; }
+    else if (a.starts_with("-I") && (a.size() > 2 || i + 1 < argc)) { pp.include_dirs.push_back(a.size() > 2 ? a.substr(2) : argv[++i]); preprocess = true; }
+    else if (a.starts_with("-D") && (a.size() > 2 || i + 1 < argc)) {
+      const std::string d = a.size() > 2 ? a.substr(2) : argv[++i];
+      const size_t eq = d.find('=');
+      pp.defines[d.substr(0, eq)] = eq == std::string::npos ? "" : d.substr(eq + 1);
+      preprocess = true;
+    }
+    else paths.push_back(a);
+  }
+  if (paths.size() > 1 && !diff) preprocess = true;
+  if (!paths.empty()) path = paths.front();
+  if (path.empty() || (preprocess && (keep_going || outline)) || (diff && paths.size() != 2) ||
+      (split && parts == 0)) {
+    std::cerr << "Usage: vparse [--report | --check] [--cells <stubs.v|pins.txt>] [--keep-going] <file.v>\n"
+                 "       vparse [--report | --check] [--cells ...] [--preprocess] [-I <dir>] [-D <name>[=<value>]] <file.v>...\n"
+                 "       vparse ... [--elaborate | --top <module>] <file.v>...\n"
+                 "       vparse --diff [--json] [-I <dir>] [-D ...] <before.v> <after.v>\n"
+                 "       vparse --json [--binary <out.vnb>] [-I <dir>] [-D ...] [--elaborate | --top <module>] <file.v>...\n"
+                 "       vparse --cone <net | inst.pin> [--fanout] [--stop <master pattern>]... [--cells ...] [--top <module>] <file.v>...\n"
+                 "       vparse --levels [--stop <sequential master pattern>]... [--cells ...] [--top <module>] <file.v>...\n"
+                 "       vparse --partition <parts> [--out <dir>] [--cells ...] [--top <module>] <file.v>...\n"
+                 "       vparse --outline <file.v>\n";
+    return 1;
+  }
   try {
-    verilog::Netlist nl = verilog::parse_file(argv[1]);
-    std::cout << "Parsed modules: " << nl.modules.size() << "\n";
-    for (const auto& m : nl.modules) { std::cout << m.summary() << "\n"; }
+    if (diff) {   // entries are printed as each batch of modules is compared
+      auto load = [&](const std::string& p) { return preprocess ? verilog::parse_files({ p }, pp) : verilog::parse_file(p); };
+      const verilog::Netlist before = load(paths[0]), after = load(paths[1]);
+      size_t counts[3] = {};
+      bool first = true;
+      if (json) std::cout << "{\"entries\":[";
+      verilog::diff_netlists(before, after, {}, [&](const verilog::DiffEntry& e) {
+        ++counts[size_t(e.kind)];
+        if (json) std::cout << (first ? "\n" : ",\n") << e.to_json();
+        else std::cout << e.to_string() << "\n";
+        first = false;
+      });
+      if (json) std::cout << "],\n\"added\":" << counts[0] << ",\"removed\":" << counts[1] << ",\"changed\":" << counts[2] << "}\n";
+      else std::cout << "diff: " << counts[0] << " added, " << counts[1] << " removed, " << counts[2] << " changed\n";
+      return 0;
+    }
+    if (outline) {   // headers only: module bodies are skipped, not parsed
+      verilog::LazyNetlist lazy = verilog::LazyNetlist::from_file(path);
+      std::cout << "Parsed modules: " << lazy.size() << "\n";
+      for (const auto& o : lazy.outlines()) {
+        std::cout << "module " << o.module_name << "(";
+        for (size_t i = 0; i < o.port_list.size(); ++i) std::cout << (i ? ", " : "") << o.port_list[i];
+        std::cout << ");\n";
+      }
+      return 0;
+    }
+    const bool exporting = (json && !diff) || !binary_out.empty();
+    auto export_netlist = [&](const auto& source) {   // JSON to stdout, binary to --binary's file
+      if (json) verilog::write_json(source, std::cout);
+      if (binary_out.empty()) return;
+      std::ofstream f(binary_out, std::ios::binary);
+      if (!f) throw std::runtime_error("cannot write " + binary_out);
+      verilog::write_binary(source, f);
+    };
+    if (exporting && !preprocess && !keep_going && !elaborate) {   // one pass: each body is parsed, written and dropped
+      export_netlist(verilog::LazyNetlist::from_file(path));
+      return 0;
+    }
+    verilog::Netlist nl;
+    bool syntax_errors = false;
+    if (keep_going) {   // report every syntax error and carry on with the modules that parsed
+      verilog::RecoveredNetlist r = verilog::parse_file_recovering(path);
+      if (!r.ok()) { std::cerr << r.report(); syntax_errors = true; }
+      nl = std::move(r.netlist);
+    } else if (preprocess) {   // `define / `ifdef / `include; several files parse in parallel
+      nl = verilog::parse_files(paths, pp);
+    } else {
+      nl = verilog::parse_file(path);
+    }
+    std::ostream& info = cone.empty() && !json ? std::cout : std::cerr;   // stdout is the cone's Verilog or the JSON
+    info << "Parsed modules: " << nl.modules.size() << "\n";
+    if (elaborate) {   // one module per distinct parameter set, ranges resolved
+      verilog::ElaborateOptions opts;
+      opts.top = top;
+      verilog::ElaboratedNetlist e = verilog::elaborate(nl, opts);
+      info << "Elaborated modules: " << e.specializations << " (" << e.instances << " instances)\n";
+      nl = std::move(e.netlist);
+    }
+    if (exporting) {
+      export_netlist(nl);
+      return syntax_errors ? 2 : 0;
+    }
+    verilog::InterfaceTable lib;
+    if (!cells.empty()) {
+      if (cells.ends_with(".v") || cells.ends_with(".sv")) verilog::add_cell_stubs(lib, verilog::parse_file(cells));
+      else verilog::add_pin_list_file(lib, cells);
+    }
+    const verilog::Module* top_module = nl.modules.empty() ? nullptr : &nl.modules.back();
+    for (const auto& x : nl.modules) if (x.module_name == top) top_module = &x;
+    if (levels) {   // levelize the top's combinational logic between ports and sequential cells
+      if (!top_module) throw std::runtime_error("no modules to levelize");
+      const verilog::ModuleGraph g(*top_module, lib);
+      verilog::LevelizeOptions opts;
+      opts.sequential = stops;
+      const verilog::Schedule s = verilog::levelize(g, opts);
+      std::cout << "Levels: " << s.num_levels() << " (" << s.nodes.size() << " combinational nodes, "
+                << s.sequential.size() << " sequential)\n";
+      for (size_t i = 0; i < s.num_loops(); ++i) {
+        std::cout << "Combinational loop:";
+        for (uint32_t v : s.loop(i)) {
+          if (g.node_kind(v) == verilog::ModuleGraph::NodeKind::Instance)
+            std::cout << " " << top_module->module_instances[g.node_ref(v)].instance_name;
+          else if (g.node_kind(v) == verilog::ModuleGraph::NodeKind::Gate)
+            std::cout << " " << top_module->gate_label(g.gate_ref(v).first, g.gate_ref(v).second);
+          else std::cout << " assign#" << g.node_ref(v);
+        }
+        std::cout << "\n";
+      }
+      return s.num_loops() ? 4 : (syntax_errors ? 2 : 0);
+    }
+    if (split) {   // balanced parts of the top with few nets between them, one module (and file) each
+      if (!top_module) throw std::runtime_error("no modules to partition");
+      const verilog::ModuleGraph g(*top_module, lib);
+      verilog::PartitionOptions opts;
+      opts.parts = parts;
+      opts.threads = 0;
+      const verilog::Partition p = verilog::partition(g, opts);
+      std::cout << "Partition: " << p.num_parts() << " parts, " << p.cut.size() << " cut nets, sizes";
+      for (uint32_t s : p.sizes) std::cout << " " << s;
+      std::cout << "\n";
+      for (uint32_t k = 0; !out_dir.empty() && k < p.num_parts(); ++k) {
+        const std::string name = top_module->module_name + "_part" + std::to_string(k);
+        std::ofstream f(out_dir + "/" + name + ".v");
+        if (!(f << verilog::write_verilog(verilog::part_module(g, p, k, name))))
+          throw std::runtime_error("cannot write " + out_dir + "/" + name + ".v");
+      }
+      return syntax_errors ? 2 : 0;
+    }
+    if (!cone.empty()) {   // fan-in (or fan-out) cone of one net or pin of the top, as a module of its own
+      if (!top_module) throw std::runtime_error("no modules to take a cone of");
+      const verilog::Module* m = top_module;
+      const verilog::ModuleGraph g(*m, lib);
+      verilog::ConeOptions opts;
+      opts.stop_at = stops;
+      opts.threads = 0;
+      const verilog::ConeExtractor cones(g, opts);
+      const size_t dot = cone.rfind('.');
+      const bool is_pin = dot != std::string::npos && g.find_net(cone) == verilog::kNoNet &&
+                          g.find_bus(cone) == verilog::ModuleInterface::npos;
+      const auto start = is_pin ? cones.pin(cone.substr(0, dot), cone.substr(dot + 1)) : cones.net(cone);
+      const verilog::Cone c = fanout ? cones.fan_out(start) : cones.fan_in(start);
+      info << "Cone: " << c.nodes.size() << " nodes, " << c.nets.size() << " nets, " << c.boundary.size() << " on the boundary\n";
+      std::cout << verilog::write_verilog(cones.to_module(c, m->module_name + "_cone"));
+      return syntax_errors ? 2 : 0;
+    }
+    if (check) {
+      verilog::CheckOptions opts;
+      opts.file = path;
+      if (!cells.empty()) opts.cells = &lib;
+      const verilog::CheckResult r = verilog::check_netlist(nl, opts);
+      std::cout << r.report();
+      if (r.errors) return 4;
+    } else if (report) {
+      verilog::StatsOptions opts;
+      if (!cells.empty()) opts.cells = &lib;
+      std::cout << verilog::compute_stats(nl, opts).report();
+    } else {
+      for (const auto& m : nl.modules) { std::cout << m.summary() << "\n"; }
+    }
+    if (syntax_errors) return 2;
   } catch (const verilog::parse_error& e) {
     std::cerr << "Parse error: " << e.what() << "\n"; return 2;
   } catch (const std::exception& e) {
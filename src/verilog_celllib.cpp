@@ -0,0 +1,112 @@
+#include "verilog_celllib.hpp"
+#include "verilog_parallel.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <set>
+
+namespace verilog {
+
+void add_cell_stubs(InterfaceTable& lib, const Netlist& stubs) {
+  for (const auto& m : stubs.modules) lib.add(interface_of(m));
+}
+
+static PortDir parse_dir(std::string_view d) {
+  if (d == "in" || d == "input")   return PortDir::Input;
+  if (d == "out" || d == "output") return PortDir::Output;
+  if (d == "inout")                return PortDir::Inout;
+  return PortDir::Unknown;
+}
+
+void add_pin_list(InterfaceTable& lib, std::string_view text, const std::string& source) {
+  size_t line_no = 0;
+  auto fail = [&](const std::string& msg) -> void {
+    throw parse_error(source + ":" + std::to_string(line_no) + ": " + msg);
+  };
+
+  while (!text.empty()) {
+    ++line_no;
+    const size_t eol = std::min(text.find('\n'), text.size());
+    std::string_view line = text.substr(0, eol);
+    text.remove_prefix(std::min(eol + 1, text.size()));
+    line = line.substr(0, std::min(line.find('#'), line.size()));
+
+    std::vector<std::string_view> words;
+    for (size_t i = 0; i < line.size();) {
+      while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i]))) ++i;
+      const size_t b = i;
+      while (i < line.size() && !std::isspace(static_cast<unsigned char>(line[i]))) ++i;
+      if (i > b) words.push_back(line.substr(b, i - b));
+    }
+    if (words.empty()) continue;
+
+    ModuleInterface mi;
+    mi.name = std::string(words[0]);
+    for (size_t w = 1; w < words.size(); ++w) {
+      std::string_view pin = words[w];
+      const size_t colon = pin.rfind(':');
+      if (colon == std::string_view::npos) fail("pin '" + std::string(pin) + "' has no direction");
+      const PortDir dir = parse_dir(pin.substr(colon + 1));
+      if (dir == PortDir::Unknown) fail("bad direction '" + std::string(pin.substr(colon + 1)) + "'");
+      pin = pin.substr(0, colon);
+
+      uint32_t width = 1;
+      if (const size_t lb = pin.find('['); lb != std::string_view::npos) {
+        const size_t c = pin.find(':', lb);
+        if (c == std::string_view::npos || pin.back() != ']') fail("bad range in '" + std::string(pin) + "'");
+        const int64_t msb = Number::parse(pin.substr(lb + 1, c - lb - 1)).as_integer();
+        const int64_t lsb = Number::parse(pin.substr(c + 1, pin.size() - c - 2)).as_integer();
+        width = uint32_t((msb >= lsb ? msb - lsb : lsb - msb) + 1);
+        pin = pin.substr(0, lb);
+      }
+      if (pin.empty()) fail("empty pin name");
+      mi.ports.emplace_back(pin);
+      mi.dirs.push_back(dir);
+      mi.widths.push_back(width);
+    }
+    lib.add(std::move(mi));
+  }
+}
+
+void add_pin_list_file(InterfaceTable& lib, const std::string& path) {
+  std::ifstream ifs(path);
+  if (!ifs) throw parse_error("could not open file: " + path);
+  std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  add_pin_list(lib, content, path);
+}
+
+PinAnnotation annotate_pins(const Netlist& nl, const InterfaceTable& lib, unsigned threads) {
+  PinAnnotation out;
+  out.modules.resize(nl.modules.size());
+  std::vector<std::vector<PinIssue>> bad(nl.modules.size());
+  parallel::parallel_for(nl.modules.size(), [&](size_t i) {
+    const Module& m = nl.modules[i];
+    ModulePinMap& pm = out.modules[i] = map_pins(m, lib);
+    for (size_t k = 0; k < m.module_instances.size(); ++k) {
+      if (!pm.master[k]) continue;
+      const ModuleInstance& inst = m.module_instances[k];
+      const uint32_t c0 = pm.conn_begin[k];
+      const uint32_t* first = pm.pin.data() + c0;
+      const uint32_t* last = pm.pin.data() + pm.conn_begin[k + 1];
+      if (std::find(first, last, ModuleInterface::npos) == last) continue;   // skip the map walk
+      for (size_t c = 0; c < inst.ports_pos.size(); ++c)
+        if (pm.pin[c0 + c] == ModuleInterface::npos)
+          bad[i].push_back({ m.module_name, inst.instance_name, "#" + std::to_string(c) });
+      uint32_t c = c0 + uint32_t(inst.ports_pos.size());
+      for (const auto& [name, e] : inst.ports_named)
+        if (pm.pin[c++] == ModuleInterface::npos) bad[i].push_back({ m.module_name, inst.instance_name, name });
+    }
+  }, threads);
+
+  std::set<std::string_view> unknown;
+  for (size_t i = 0; i < nl.modules.size(); ++i) {
+    const auto& insts = nl.modules[i].module_instances;
+    for (size_t k = 0; k < insts.size(); ++k)
+      if (!out.modules[i].master[k]) unknown.insert(insts[k].module_name);
+    out.unknown_pins.insert(out.unknown_pins.end(), std::make_move_iterator(bad[i].begin()), std::make_move_iterator(bad[i].end()));
+  }
+  out.unknown_cells.assign(unknown.begin(), unknown.end());
+  return out;
+}
+
+} // namespace verilog
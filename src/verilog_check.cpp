@@ -0,0 +1,344 @@
+#include "verilog_check.hpp"
+#include "verilog_connectivity.hpp"
+#include "verilog_parallel.hpp"
+#include "verilog_source.hpp"
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace verilog {
+
+const char* to_string(CheckId id) {
+  switch (id) {
+    case CheckId::DuplicateModule:      return "duplicate-module";
+    case CheckId::DuplicateName:        return "duplicate-name";
+    case CheckId::PortWithoutDirection: return "port-without-direction";
+    case CheckId::DirectionWithoutPort: return "direction-without-port";
+    case CheckId::UndeclaredNet:        return "undeclared-net";
+    case CheckId::ImplicitNet:          return "implicit-net";
+    case CheckId::BadSelect:            return "bad-select";
+    case CheckId::UndefinedModule:      return "undefined-module";
+    case CheckId::UnknownPin:           return "unknown-pin";
+    case CheckId::WidthMismatch:        return "width-mismatch";
+    case CheckId::MultipleDrivers:      return "multiple-drivers";
+  }
+  return "?";
+}
+
+std::string Diagnostic::to_string() const {
+  std::string s = file.empty() ? "netlist" : file;
+  if (line) s += ":" + std::to_string(line) + ":" + std::to_string(column);
+  s += severity == Severity::Error ? ": error: [" : ": warning: [";
+  s += verilog::to_string(check);
+  s += "] module '" + module + "': " + message;
+  return s;
+}
+
+std::string CheckResult::report(size_t max_items) const {
+  std::ostringstream oss;
+  oss << "check: " << errors << " error(s), " << warnings << " warning(s)\n";
+  for (size_t i = 0; i < diagnostics.size() && i < max_items; ++i) oss << diagnostics[i].to_string() << "\n";
+  if (diagnostics.size() > max_items) oss << "... and " << diagnostics.size() - max_items << " more\n";
+  return oss.str();
+}
+
+namespace {
+
+// Preprocessed netlists know which file each location is in; otherwise the
+// caller's name for the one parsed text is used.
+std::string file_of(const CheckOptions& opts, const SourceLocation& loc) {
+  return loc.file.empty() ? opts.file : std::string(loc.file);
+}
+
+struct Decl {
+  std::optional<Range> range;
+  bool direction = false;   // declared input/output/inout
+  bool net = false;         // declared wire (or other net type)
+  bool resolved = false;    // tri or supply: several drivers are intended
+  SourceSpan span;          // first declaration
+};
+
+int64_t range_lo(const Range& r) { return std::min(r.start.as_integer(), r.end.as_integer()); }
+int64_t range_hi(const Range& r) { return std::max(r.start.as_integer(), r.end.as_integer()); }
+
+class ModuleChecker {
+public:
+  ModuleChecker(const Netlist& nl, const Module& m, const InterfaceTable& ifaces, const CheckOptions& opts,
+                std::vector<Diagnostic>& out)
+    : nl_(nl), m_(m), ifaces_(ifaces), opts_(opts), out_(out) {}
+
+  void run() {
+    declarations();
+    ports();
+    instance_names();
+    assigns();
+    connections();
+    drivers();
+  }
+
+private:
+  // `at` is the item the finding is about; the module's span when empty.
+  void add(const SourceSpan& at, Severity sev, CheckId id, std::string object, std::string message) {
+    const SourceLocation loc = locate(nl_, at.empty() ? m_.span : at);
+    out_.push_back(Diagnostic{ sev, id, m_.module_name, std::move(object), std::move(message), file_of(opts_, loc),
+                               loc.line, loc.column });
+  }
+
+  void declarations() {
+    auto note = [&](const auto& decls, bool direction) {
+      for (const auto& d : decls) {
+        for (const auto& n : d.names) {
+          Decl& x = decls_[n];
+          if (!x.direction && !x.net) x.span = d.span;
+          if (direction ? x.direction : x.net)
+            add(d.span, Severity::Error, CheckId::DuplicateName, n, "'" + n + "' is declared twice");
+          (direction ? x.direction : x.net) = true;
+          if (d.range && (direction || !x.range)) x.range = d.range;
+        }
+      }
+    };
+    note(m_.input_declarations, true);
+    note(m_.output_declarations, true);
+    note(m_.inout_declarations, true);
+    note(m_.net_declarations, false);
+    for (const auto& d : m_.net_declarations)
+      if (d.type != NetType::Wire)
+        for (const auto& n : d.names) decls_[n].resolved = true;
+  }
+
+  void ports() {
+    std::unordered_set<std::string_view> in_header;
+    for (const auto& p : m_.port_list) {
+      if (!in_header.insert(p).second) add(m_.span, Severity::Error, CheckId::DuplicateName, p, "port '" + p + "' is listed twice");
+      auto it = decls_.find(p);
+      if (it == decls_.end() || !it->second.direction)
+        add(m_.span, Severity::Error, CheckId::PortWithoutDirection, p, "port '" + p + "' has no input/output/inout declaration");
+    }
+    auto stray = [&](const auto& decls, const char* kind) {
+      for (const auto& d : decls)
+        for (const auto& n : d.names)
+          if (!in_header.count(n))
+            add(d.span, Severity::Error, CheckId::DirectionWithoutPort, n, std::string(kind) + " '" + n + "' is not in the port list");
+    };
+    stray(m_.input_declarations, "input");
+    stray(m_.output_declarations, "output");
+    stray(m_.inout_declarations, "inout");
+  }
+
+  void instance_names() {
+    std::unordered_set<std::string_view> seen;
+    for (const auto& inst : m_.module_instances)
+      if (!seen.insert(inst.instance_name).second)
+        add(inst.span, Severity::Error, CheckId::DuplicateName, inst.instance_name, "instance name '" + inst.instance_name + "' is used twice");
+    for (const auto& gt : m_.gates)
+      for (size_t i = 0; i < gt.size(); ++i)
+        if (!gt.names[i].empty() && !seen.insert(gt.names[i]).second)
+          add(gt.spans[i], Severity::Error, CheckId::DuplicateName, gt.names[i], "instance name '" + gt.names[i] + "' is used twice");
+  }
+
+  // Width of an expression from the declarations (undeclared names count 1).
+  uint32_t width(const Expr& e) const {
+    struct V {
+      const ModuleChecker& c;
+      uint32_t operator()(const Identifier& x) const {
+        auto it = c.decls_.find(x.name);
+        if (it == c.decls_.end() || !it->second.range) return 1;
+        return uint32_t(range_hi(*it->second.range) - range_lo(*it->second.range) + 1);
+      }
+      uint32_t operator()(const IdentifierIndexed&) const { return 1; }
+      uint32_t operator()(const IdentifierSliced& x) const {
+        return uint32_t(range_hi(x.range) - range_lo(x.range) + 1);
+      }
+      uint32_t operator()(const std::shared_ptr<Concatenation>& x) const {
+        uint32_t w = 0;
+        for (const auto& el : x->elements) w += std::visit(*this, el);
+        return w;
+      }
+      uint32_t operator()(const Constant& x) const { return x.value.width(); }
+    };
+    return std::visit(V{ *this }, e);
+  }
+
+  // Reports undeclared names (as `id`) and bad selects in one expression of
+  // the item at `at`.
+  void references(const Expr& e, CheckId id, const SourceSpan& at) {
+    struct V {
+      ModuleChecker& c; CheckId id; const SourceSpan& at;
+      const Decl* find(const std::string& name) const {
+        auto it = c.decls_.find(name);
+        if (it != c.decls_.end()) return &it->second;
+        if (id == CheckId::ImplicitNet && !c.opts_.implicit_nets) return nullptr;
+        if (c.undeclared_.insert(name).second) {
+          c.add(at, id == CheckId::UndeclaredNet ? Severity::Error : Severity::Warning, id, name,
+                id == CheckId::UndeclaredNet ? "'" + name + "' is assigned or read in an assign but never declared"
+                                             : "'" + name + "' is never declared (implicit net)");
+        }
+        return nullptr;
+      }
+      void bad(const std::string& name, const std::string& text, const std::string& why) const {
+        if (c.bad_selects_.insert(text).second) c.add(at, Severity::Error, CheckId::BadSelect, name, "'" + text + "' " + why);
+      }
+      void operator()(const Identifier& x) const { find(x.name); }
+      void operator()(const IdentifierIndexed& x) const {
+        const Decl* d = find(x.name);
+        if (!d) return;
+        const std::string text = x.name + "[" + x.index.to_string() + "]";
+        if (!d->range) return bad(x.name, text, "selects a bit of a scalar");
+        const int64_t i = x.index.as_integer();
+        if (i < range_lo(*d->range) || i > range_hi(*d->range)) bad(x.name, text, "is outside the declared range");
+      }
+      void operator()(const IdentifierSliced& x) const {
+        const Decl* d = find(x.name);
+        if (!d) return;
+        const std::string text = x.name + "[" + x.range.start.to_string() + ":" + x.range.end.to_string() + "]";
+        if (!d->range) return bad(x.name, text, "selects part of a scalar");
+        if (range_lo(x.range) < range_lo(*d->range) || range_hi(x.range) > range_hi(*d->range))
+          return bad(x.name, text, "is outside the declared range");
+        const bool decl_down = d->range->start.as_integer() >= d->range->end.as_integer();
+        const bool sel_down = x.range.start.as_integer() >= x.range.end.as_integer();
+        if (range_lo(x.range) != range_hi(x.range) && decl_down != sel_down)
+          bad(x.name, text, "runs against the declared direction");
+      }
+      void operator()(const std::shared_ptr<Concatenation>& x) const {
+        for (const auto& el : x->elements) std::visit(*this, el);
+      }
+      void operator()(const Constant&) const {}
+    };
+    std::visit(V{ *this, id, at }, e);
+  }
+
+  void assigns() {
+    for (const auto& ca : m_.assignments) {
+      for (const auto& [lhs, rhs] : ca.assignments) {
+        references(lhs, CheckId::UndeclaredNet, ca.span);
+        references(rhs, CheckId::UndeclaredNet, ca.span);
+        const uint32_t wl = width(lhs), wr = width(rhs);
+        if (wl != wr)
+          add(ca.span, Severity::Warning, CheckId::WidthMismatch, expr_to_string(lhs),
+              "assign " + expr_to_string(lhs) + " (" + std::to_string(wl) + " bits) = " + expr_to_string(rhs) +
+              " (" + std::to_string(wr) + " bits)");
+      }
+    }
+  }
+
+  void connections() {
+    for (const auto& gt : m_.gates)
+      for (size_t i = 0; i < gt.size(); ++i)
+        for (const auto& e : gt.terminals_of(i)) references(e, CheckId::ImplicitNet, gt.spans[i]);
+
+    pins_ = map_pins(m_, ifaces_);
+    std::unordered_set<std::string_view> undefined;
+    for (size_t k = 0; k < m_.module_instances.size(); ++k) {
+      const ModuleInstance& inst = m_.module_instances[k];
+      for (const auto& e : inst.ports_pos) references(e, CheckId::ImplicitNet, inst.span);
+      for (const auto& [pin, e] : inst.ports_named) references(e, CheckId::ImplicitNet, inst.span);
+
+      const ModuleInterface* master = pins_.master[k];
+      if (!master) {
+        if (undefined.insert(inst.module_name).second)
+          add(inst.span, Severity::Error, CheckId::UndefinedModule, inst.module_name,
+              "module '" + inst.module_name + "' (instance '" + inst.instance_name + "') is not defined");
+        continue;
+      }
+      if (inst.ports_pos.size() > master->ports.size())
+        add(inst.span, Severity::Error, CheckId::UnknownPin, inst.instance_name,
+            "instance '" + inst.instance_name + "' has " + std::to_string(inst.ports_pos.size()) +
+            " positional connections; '" + master->name + "' has " + std::to_string(master->ports.size()) + " ports");
+
+      uint32_t c = pins_.conn_begin[k];
+      auto conn = [&](const Expr& e, const std::string& label) {
+        const uint32_t pin = pins_.pin[c++];
+        if (pin == ModuleInterface::npos) return;
+        const uint32_t have = width(e), want = master->widths[pin];
+        if (have != want)
+          add(inst.span, Severity::Warning, CheckId::WidthMismatch, inst.instance_name,
+              inst.instance_name + "." + master->ports[pin] + ": " + expr_to_string(e) + " is " + std::to_string(have) +
+              " bits, port is " + std::to_string(want) + (label.empty() ? "" : " (" + label + ")"));
+      };
+      for (size_t p = 0; p < inst.ports_pos.size(); ++p) conn(inst.ports_pos[p], "#" + std::to_string(p));
+      for (const auto& [pin, e] : inst.ports_named) {
+        if (pins_.pin[c] == ModuleInterface::npos)
+          add(inst.span, Severity::Error, CheckId::UnknownPin, inst.instance_name,
+              "instance '" + inst.instance_name + "': '" + master->name + "' has no pin '" + pin + "'");
+        conn(e, "");
+      }
+    }
+  }
+
+  void drivers() {
+    const ModuleGraph g(m_, pins_);
+    std::string who;
+    for (NetId n = 0; n < g.num_nets(); ++n) {
+      const auto net_pins = g.net_pins(n);
+      size_t count = 0;
+      for (uint32_t p : net_pins) count += g.pins()[p].dir == PortDir::Output;
+      if (count < 2) continue;
+      auto decl = decls_.find(g.bus(g.net_bus(n)).name);
+      if (decl != decls_.end() && decl->second.resolved) continue;
+      who.clear();
+      for (uint32_t p : net_pins) {
+        const auto& pin = g.pins()[p];
+        if (pin.dir != PortDir::Output) continue;
+        if (!who.empty()) who += ", ";
+        switch (g.node_kind(pin.node)) {
+          case ModuleGraph::NodeKind::Port:     who += "input port " + g.pin_name(pin); break;
+          case ModuleGraph::NodeKind::Assign:   who += "assign"; break;
+          case ModuleGraph::NodeKind::Instance:
+            who += m_.module_instances[g.node_ref(pin.node)].instance_name + "." + g.pin_name(pin); break;
+          case ModuleGraph::NodeKind::Gate: {
+            const auto [type, row] = g.gate_ref(pin.node);
+            who += m_.gate_label(type, row) + "." + g.pin_name(pin);
+            break;
+          }
+        }
+      }
+      const std::string name = g.net_name(n);
+      add(decl == decls_.end() ? m_.span : decl->second.span, Severity::Error, CheckId::MultipleDrivers, name,
+          "'" + name + "' has " + std::to_string(count) + " drivers: " + who);
+    }
+  }
+
+  const Netlist& nl_;
+  const Module& m_;
+  const InterfaceTable& ifaces_;
+  const CheckOptions& opts_;
+  std::vector<Diagnostic>& out_;
+
+  std::unordered_map<std::string, Decl> decls_;
+  std::unordered_set<std::string> undeclared_;    // reported once per name
+  std::unordered_set<std::string> bad_selects_;   // reported once per select text
+  ModulePinMap pins_;
+};
+
+} // namespace
+
+CheckResult check_netlist(const Netlist& nl, const CheckOptions& opts) {
+  const size_t n = nl.modules.size();
+  InterfaceTable ifaces(nl);
+  if (opts.cells)
+    for (const auto& cell : *opts.cells) if (!ifaces.find(cell.name)) ifaces.add(cell);
+
+  std::unordered_map<std::string_view, size_t> first;
+  for (size_t i = 0; i < n; ++i) first.emplace(nl.modules[i].module_name, i);
+
+  CheckResult r;
+  r.diagnostics = parallel::parallel_collect<Diagnostic>(n, [&](size_t i, std::vector<Diagnostic>& out) {
+    const Module& m = nl.modules[i];
+    const size_t f = first.at(m.module_name);
+    if (f != i) {
+      const SourceLocation here = locate(nl, m.span), used = locate(nl, nl.modules[f].span);
+      out.push_back(Diagnostic{ Severity::Error, CheckId::DuplicateModule, m.module_name, m.module_name,
+                                     "module '" + m.module_name + "' is defined again; the " +
+                                     (used.line ? "definition at line " + std::to_string(used.line) +
+                                                  (used.file.empty() ? "" : " of " + std::string(used.file))
+                                                : std::string("first definition")) +
+                                     " is used",
+                                     file_of(opts, here), here.line, here.column });
+    }
+    ModuleChecker(nl, m, ifaces, opts, out).run();
+  }, opts.threads, 1);
+  for (const auto& d : r.diagnostics) (d.severity == Severity::Error ? r.errors : r.warnings)++;
+  return r;
+}
+
+} // namespace verilog
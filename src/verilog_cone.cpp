@@ -0,0 +1,244 @@
+#include "verilog_cone.hpp"
+#include "verilog_hierarchy.hpp"
+#include "verilog_parallel.hpp"
+#include <atomic>
+#include <bit>
+#include <stdexcept>
+
+namespace verilog {
+
+namespace {
+
+using Kind = ModuleGraph::NodeKind;
+
+bool drives(PortDir d) { return d != PortDir::Input; }
+bool loads(PortDir d) { return d != PortDir::Output; }
+
+constexpr size_t kFrontierGrain = 256;   // nets of one level expanded per parallel task
+
+// One bit per net or node. claim() is safe to call from several threads.
+class Bitset {
+public:
+  explicit Bitset(size_t n) : words_((n + 63) / 64) {}
+
+  // Sets bit i; true when this call set it.
+  bool claim(size_t i, bool shared) {
+    const uint64_t m = uint64_t(1) << (i & 63);
+    uint64_t& w = words_[i >> 6];
+    if (!shared) {
+      if (w & m) return false;
+      w |= m;
+      return true;
+    }
+    if (std::atomic_ref<uint64_t>(w).load(std::memory_order_relaxed) & m) return false;
+    return !(std::atomic_ref<uint64_t>(w).fetch_or(m, std::memory_order_relaxed) & m);
+  }
+  template<typename T> std::vector<T> members() const {
+    std::vector<T> out;
+    for (size_t k = 0; k < words_.size(); ++k)
+      for (uint64_t w = words_[k]; w; w &= w - 1) out.push_back(T(k * 64 + size_t(std::countr_zero(w))));
+    return out;
+  }
+
+private:
+  std::vector<uint64_t> words_;
+};
+
+} // namespace
+
+ConeExtractor::ConeExtractor(const ModuleGraph& g, ConeOptions opts) : g_(&g), opts_(std::move(opts)) {
+  const Module& m = g.module();
+  stop_.assign(g.num_nodes(), 0);
+  for (uint32_t n = 0; n < g.num_nodes(); ++n) {
+    if (g.node_kind(n) == Kind::Port) { stop_[n] = 1; continue; }
+    if (g.node_kind(n) != Kind::Instance) continue;
+    const ModuleInstance& inst = m.module_instances[g.node_ref(n)];
+    for (const auto& pat : opts_.stop_at)
+      if (wildcard_match(pat, inst.module_name)) { stop_[n] = 1; break; }
+    if (!stop_[n] && opts_.stop_if && opts_.stop_if(inst)) stop_[n] = 1;
+  }
+}
+
+Cone ConeExtractor::fan_in(std::span<const NetId> start) const { return walk(start, false); }
+Cone ConeExtractor::fan_out(std::span<const NetId> start) const { return walk(start, true); }
+
+Cone ConeExtractor::walk(std::span<const NetId> start, bool forward) const {
+  const ModuleGraph& g = *g_;
+  const unsigned threads = opts_.threads ? opts_.threads : parallel::default_threads();
+  const bool shared = threads > 1;
+  Bitset nets(g.num_nets()), nodes(g.num_nodes()), boundary(g.num_nodes());
+  // Forward, a node is entered through the pins that load the net and left
+  // through the ones that drive; backward the other way round.
+  auto enters = [&](PortDir d) { return forward ? loads(d) : drives(d); };
+  auto leaves = [&](PortDir d) { return forward ? drives(d) : loads(d); };
+
+  std::vector<NetId> frontier;
+  for (NetId n : start) {
+    if (n >= g.num_nets()) throw std::runtime_error("cone: net id " + std::to_string(n) + " out of range");
+    if (nets.claim(n, false)) frontier.push_back(n);
+  }
+
+  for (uint32_t depth = 1; !frontier.empty(); ++depth) {
+    const bool last = opts_.max_depth && depth >= opts_.max_depth;
+    frontier = parallel::parallel_collect<NetId>(frontier.size(), [&](size_t i, std::vector<NetId>& out) {
+      auto reach = [&](NetId n) { if (nets.claim(n, shared)) out.push_back(n); };
+      for (uint32_t pi : g.net_pins(frontier[i])) {
+        const ModuleGraph::Pin& p = g.pins()[pi];
+        if (!enters(p.dir)) continue;
+        const bool first = nodes.claim(p.node, shared);
+        if (first && (stop_[p.node] || last)) boundary.claim(p.node, shared);
+        if (stop_[p.node] || last) continue;
+        const auto pins = g.node_pins(p.node);
+        if (g.node_kind(p.node) != Kind::Assign) {
+          if (!first) continue;   // every output (or input) was reached the first time
+          for (const auto& q : pins)
+            if (leaves(q.dir)) reach(q.net);
+          continue;
+        }
+        // Assign sides of equal width are crossed bit for bit.
+        uint32_t width[2] = { 0, 0 };
+        for (const auto& q : pins) width[q.conn] = std::max(width[q.conn], q.bit + 1);
+        const bool bitwise = width[0] == width[1];
+        for (const auto& q : pins)
+          if (q.conn != p.conn && leaves(q.dir) && (!bitwise || q.bit == p.bit)) reach(q.net);
+      }
+    }, threads, kFrontierGrain);
+  }
+
+  Cone c;
+  c.nets = nets.members<NetId>();
+  c.nodes = nodes.members<uint32_t>();
+  c.boundary = boundary.members<uint32_t>();
+  return c;
+}
+
+std::vector<NetId> ConeExtractor::net(std::string_view name) const {
+  const ModuleGraph& g = *g_;
+  if (const NetId n = g.find_net(name); n != kNoNet) return { n };
+  const uint32_t b = g.find_bus(name);
+  if (b == ModuleInterface::npos) throw std::runtime_error("cone: no net '" + std::string(name) + "' in module " + g.module().module_name);
+  const auto& bus = g.bus(b);
+  const uint32_t width = uint32_t((bus.start > bus.end ? bus.start - bus.end : bus.end - bus.start) + 1);
+  std::vector<NetId> out(width);
+  for (uint32_t i = 0; i < width; ++i) out[i] = bus.first + i;
+  return out;
+}
+
+std::vector<NetId> ConeExtractor::pin(std::string_view instance, std::string_view pin) const {
+  const ModuleGraph& g = *g_;
+  const Module& m = g.module();
+  for (uint32_t i = 0; i < m.module_instances.size(); ++i) {
+    if (m.module_instances[i].instance_name != instance) continue;
+    std::vector<NetId> out;
+    for (const auto& p : g.node_pins(uint32_t(m.port_list.size()) + i))
+      if (g.pin_name(p) == pin) out.push_back(p.net);
+    if (out.empty())
+      throw std::runtime_error("cone: instance " + std::string(instance) + " has no connected pin '" + std::string(pin) + "'");
+    return out;
+  }
+  throw std::runtime_error("cone: no instance '" + std::string(instance) + "' in module " + m.module_name);
+}
+
+Module ConeExtractor::to_module(const Cone& c, std::string name) const {
+  return extract_module(*g_, c.nodes, std::move(name));
+}
+
+Module extract_module(const ModuleGraph& g, std::span<const uint32_t> nodes, std::string name) {
+  const Module& m = g.module();
+  Module out;
+  out.module_name = std::move(name);
+  out.parameters = m.parameters;   // overrides may refer to them
+
+  std::vector<uint8_t> inside(g.num_nodes(), 0);
+  std::vector<PortDir> port_dir(g.num_buses(), PortDir::Unknown);   // of module ports in the cone
+  const ModuleInterface self = interface_of(m);
+  std::vector<std::pair<uint32_t, uint32_t>> assign_of;   // flattened pair -> (statement, pair)
+  for (uint32_t s = 0; s < m.assignments.size(); ++s)
+    for (uint32_t k = 0; k < m.assignments[s].assignments.size(); ++k) assign_of.emplace_back(s, k);
+  ContinuousAssign assigns;
+  out.module_instances.reserve(nodes.size());
+  for (uint32_t n : nodes) {
+    const uint32_t ref = g.node_ref(n);
+    switch (g.node_kind(n)) {
+      case Kind::Port: {
+        const uint32_t b = g.find_bus(m.port_list[ref]);
+        if (b != ModuleInterface::npos) port_dir[b] = self.dirs[ref];
+        continue;
+      }
+      case Kind::Instance: {
+        const ModuleInstance& src = m.module_instances[ref];
+        ModuleInstance& inst = out.module_instances.emplace_back();
+        inst.module_name = src.module_name;
+        inst.instance_name = src.instance_name;
+        inst.ports_pos.reserve(src.ports_pos.size());
+        for (const auto& e : src.ports_pos) inst.ports_pos.push_back(clone_expr(e));
+        for (const auto& [key, e] : src.ports_named) inst.ports_named.emplace_hint(inst.ports_named.end(), key, clone_expr(e));
+        inst.params = src.params;
+        inst.span = src.span;
+        break;
+      }
+      case Kind::Assign: {
+        const auto [s, k] = assign_of[ref];
+        const auto& [lhs, rhs] = m.assignments[s].assignments[k];
+        assigns.assignments.emplace_back(clone_expr(lhs), clone_expr(rhs));
+        break;
+      }
+      case Kind::Gate: {
+        const auto [t, row] = g.gate_ref(n);
+        const GateTable& src = m.gates[size_t(t)];
+        GateTable& dst = out.gates[size_t(t)];
+        dst.names.push_back(src.names[row]);
+        for (const auto& e : src.terminals_of(row)) dst.terminals.push_back(clone_expr(e));
+        dst.ends.push_back(uint32_t(dst.terminals.size()));
+        if (row < src.spans.size()) dst.spans.push_back(src.spans[row]);
+        break;
+      }
+    }
+    inside[n] = 1;
+  }
+  if (!assigns.assignments.empty()) out.assignments.push_back(std::move(assigns));
+
+  // Who drives and loads each touched bus, inside the cone and outside it.
+  enum : uint8_t { DriveIn = 1, LoadIn = 2, DriveOut = 4, LoadOut = 8, Touched = 16 };
+  std::vector<uint8_t> use(g.num_buses(), 0);
+  for (uint32_t n : nodes) {
+    if (!inside[n]) continue;
+    for (const auto& p : g.node_pins(n)) {
+      uint8_t& u = use[g.net_bus(p.net)];
+      if (u & Touched) continue;
+      u |= Touched;
+      for (NetId bit = g.bus(g.net_bus(p.net)).first; bit < g.num_nets() && g.net_bus(bit) == g.net_bus(p.net); ++bit)
+        for (uint32_t pi : g.net_pins(bit)) {
+          const auto& q = g.pins()[pi];
+          if (drives(q.dir)) u |= inside[q.node] ? DriveIn : DriveOut;
+          if (loads(q.dir)) u |= inside[q.node] ? LoadIn : LoadOut;
+        }
+    }
+  }
+
+  for (uint32_t b = 0; b < g.num_buses(); ++b) {
+    const uint8_t u = use[b];
+    if (!(u & Touched)) continue;
+    PortDir dir = port_dir[b];
+    if (dir == PortDir::Unknown) {
+      if (u & DriveIn) dir = (u & DriveOut) ? PortDir::Inout : (u & LoadOut) ? PortDir::Output : PortDir::Unknown;
+      else if (u & LoadIn) dir = PortDir::Input;
+    }
+    const auto& bus = g.bus(b);
+    if (dir == PortDir::Unknown && !bus.declared) continue;   // implicit in the original too
+    NetDeclaration d;
+    d.net_name = bus.name;
+    d.names.push_back(bus.name);
+    if (bus.vector) d.range = Range{ Number::parse(std::to_string(bus.start)), Number::parse(std::to_string(bus.end)) };
+    switch (dir) {
+      case PortDir::Input:  out.input_declarations.push_back({ std::move(d) }); break;
+      case PortDir::Output: out.output_declarations.push_back({ std::move(d) }); break;
+      case PortDir::Inout:  out.inout_declarations.push_back({ std::move(d) }); break;
+      case PortDir::Unknown: out.net_declarations.push_back(std::move(d)); continue;
+    }
+    out.port_list.push_back(bus.name);
+  }
+  return out;
+}
+
+} // namespace verilog
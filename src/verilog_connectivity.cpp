@@ -0,0 +1,347 @@
+#include "verilog_connectivity.hpp"
+#include <algorithm>
+
+namespace verilog {
+
+static uint32_t range_width(const std::optional<Range>& r) {
+  if (!r) return 1;
+  const int64_t s = r->start.as_integer(), e = r->end.as_integer();
+  return uint32_t((s >= e ? s - e : e - s) + 1);
+}
+
+void ModuleInterface::index() {
+  by_name.resize(ports.size());
+  for (uint32_t i = 0; i < by_name.size(); ++i) by_name[i] = i;
+  std::stable_sort(by_name.begin(), by_name.end(), [&](uint32_t a, uint32_t b) { return ports[a] < ports[b]; });
+}
+
+uint32_t ModuleInterface::find(std::string_view port) const {
+  if (by_name.size() != ports.size()) {
+    for (size_t i = 0; i < ports.size(); ++i) if (ports[i] == port) return uint32_t(i);
+    return npos;
+  }
+  auto it = std::lower_bound(by_name.begin(), by_name.end(), port,
+                             [&](uint32_t i, std::string_view p) { return ports[i] < p; });
+  return (it != by_name.end() && ports[*it] == port) ? *it : npos;
+}
+
+void ModuleInterface::resolve(const std::map<std::string, Expr>& named, uint32_t* out) const {
+  // Short port lists (most library cells) scan faster than they merge:
+  // equality rejects on length before touching the characters.
+  if (by_name.size() != ports.size() || ports.size() <= kLinearPorts) {
+    for (const auto& [name, e] : named) {
+      uint32_t k = 0;
+      while (k < ports.size() && ports[k] != name) ++k;
+      *out++ = k < ports.size() ? k : npos;
+    }
+    return;
+  }
+  size_t j = 0;
+  for (const auto& [name, e] : named) {
+    int c = 1;
+    while (j < by_name.size() && (c = ports[by_name[j]].compare(name)) < 0) ++j;
+    *out++ = (j < by_name.size() && c == 0) ? by_name[j] : npos;
+  }
+}
+
+ModuleInterface interface_of(const Module& m) {
+  std::unordered_map<std::string_view, std::pair<PortDir, uint32_t>> decl;
+  auto note = [&](const auto& decls, PortDir d) {
+    for (const auto& x : decls)
+      for (const auto& n : x.names) decl.emplace(n, std::make_pair(d, range_width(x.range)));
+  };
+  note(m.input_declarations,  PortDir::Input);
+  note(m.output_declarations, PortDir::Output);
+  note(m.inout_declarations,  PortDir::Inout);
+
+  ModuleInterface mi;
+  mi.name = m.module_name;
+  mi.ports = m.port_list;
+  mi.dirs.reserve(mi.ports.size());
+  mi.widths.reserve(mi.ports.size());
+  for (const auto& p : mi.ports) {
+    auto it = decl.find(p);
+    mi.dirs.push_back(it == decl.end() ? PortDir::Unknown : it->second.first);
+    mi.widths.push_back(it == decl.end() ? 1u : it->second.second);
+  }
+  mi.index();
+  return mi;
+}
+
+InterfaceTable::InterfaceTable(const Netlist& nl) {
+  for (const auto& m : nl.modules) {
+    if (index_.count(m.module_name)) continue;   // first definition wins
+    add(interface_of(m));
+  }
+}
+
+void InterfaceTable::add(ModuleInterface mi) {
+  if (mi.by_name.size() != mi.ports.size()) mi.index();
+  auto it = index_.find(mi.name);
+  if (it != index_.end()) { items_[it->second] = std::move(mi); return; }
+  index_.emplace(mi.name, items_.size());
+  items_.push_back(std::move(mi));
+}
+
+const ModuleInterface* InterfaceTable::find(std::string_view name) const {
+  auto it = index_.find(name);
+  return it == index_.end() ? nullptr : &items_[it->second];
+}
+
+// ---------- ModuleGraph ----------
+
+static PortDir flip(PortDir d) {
+  switch (d) {
+    case PortDir::Input:  return PortDir::Output;
+    case PortDir::Output: return PortDir::Input;
+    default:              return d;
+  }
+}
+
+ModulePinMap map_pins(const Module& m, const InterfaceTable& ifaces) {
+  ModulePinMap pm;
+  pm.master.reserve(m.module_instances.size());
+  pm.conn_begin.reserve(m.module_instances.size() + 1);
+
+  const ModuleInterface* last = nullptr;   // netlists tend to repeat masters back to back
+  uint32_t base = 0;
+  for (const auto& inst : m.module_instances) {
+    const ModuleInterface* master =
+      (last && last->name == inst.module_name) ? last : ifaces.find(inst.module_name);
+    if (master) last = master;
+    pm.master.push_back(master);
+
+    const uint32_t npos_conns = uint32_t(inst.ports_pos.size());
+    const uint32_t end = base + npos_conns + uint32_t(inst.ports_named.size());
+    pm.pin.resize(end, ModuleInterface::npos);
+    pm.dir.resize(end, PortDir::Unknown);
+    if (master) {
+      for (uint32_t k = 0; k < npos_conns && k < master->ports.size(); ++k) pm.pin[base + k] = k;
+      master->resolve(inst.ports_named, pm.pin.data() + base + npos_conns);
+      for (uint32_t c = base; c < end; ++c)
+        if (pm.pin[c] != ModuleInterface::npos) pm.dir[c] = master->dirs[pm.pin[c]];
+    }
+    base = end;
+    pm.conn_begin.push_back(base);
+  }
+  return pm;
+}
+
+ModuleGraph::ModuleGraph(const Module& m, const InterfaceTable& ifaces) : module_(&m) {
+  build(map_pins(m, ifaces));
+}
+
+ModuleGraph::ModuleGraph(const Module& m, const ModulePinMap& pins) : module_(&m) {
+  build(pins);
+}
+
+void ModuleGraph::build(const ModulePinMap& pins) {
+  const Module& m = *module_;
+  // Declared nets first so their bits get contiguous ids in declaration order.
+  auto declare_all = [&](const auto& decls) {
+    for (const auto& d : decls) for (const auto& n : d.names) declare(n, d.range, true);
+  };
+  declare_all(m.input_declarations);
+  declare_all(m.output_declarations);
+  declare_all(m.inout_declarations);
+  declare_all(m.net_declarations);
+
+  const ModuleInterface self = interface_of(m);
+  std::vector<NetId> bits_buf;
+
+  for (uint32_t i = 0; i < m.port_list.size(); ++i) {
+    add_node(NodeKind::Port, i, nullptr);
+    bits_buf.clear();
+    bits(Identifier{ m.port_list[i] }, bits_buf, true);
+    connect(bits_buf, flip(self.dirs[i]), i, 0);
+  }
+
+  for (uint32_t i = 0; i < m.module_instances.size(); ++i) {
+    const auto& inst = m.module_instances[i];
+    add_node(NodeKind::Instance, i, pins.master[i]);
+    const uint32_t c0 = pins.conn_begin[i];
+    for (uint32_t k = 0; k < inst.ports_pos.size(); ++k) {
+      bits_buf.clear();
+      bits(inst.ports_pos[k], bits_buf, true);
+      connect(bits_buf, pins.dir[c0 + k], pins.pin[c0 + k], k);
+    }
+    uint32_t rank = uint32_t(inst.ports_pos.size());
+    for (const auto& [name, e] : inst.ports_named) {
+      bits_buf.clear();
+      bits(e, bits_buf, true);
+      connect(bits_buf, pins.dir[c0 + rank], pins.pin[c0 + rank], rank);
+      ++rank;
+    }
+  }
+
+  uint32_t flat = 0;
+  for (const auto& ca : m.assignments) {
+    for (const auto& [lhs, rhs] : ca.assignments) {
+      add_node(NodeKind::Assign, flat++, nullptr);
+      bits_buf.clear();
+      bits(rhs, bits_buf, true);
+      connect(bits_buf, PortDir::Input, 1, 1);
+      bits_buf.clear();
+      bits(lhs, bits_buf, true);
+      connect(bits_buf, PortDir::Output, 0, 0);
+    }
+  }
+  for (size_t t = 0; t < kNumGateTypes; ++t) {
+    const GateTable& gt = m.gates[t];
+    for (uint32_t i = 0; i < gt.size(); ++i) {
+      add_node(NodeKind::Gate, i, nullptr, GateType(t));
+      const auto terms = gt.terminals_of(i);
+      const uint32_t outs = gate_outputs(GateType(t), uint32_t(terms.size()));
+      for (uint32_t k = 0; k < terms.size(); ++k) {
+        bits_buf.clear();
+        bits(terms[k], bits_buf, true);
+        connect(bits_buf, k < outs ? PortDir::Output : PortDir::Input, k, k);
+      }
+    }
+  }
+  node_pin_begin_.push_back(uint32_t(pins_.size()));
+
+  // net -> pins, counting sort so each net's pins stay in node order
+  net_pin_begin_.assign(num_nets() + 1, 0);
+  for (const auto& p : pins_) ++net_pin_begin_[p.net + 1];
+  for (size_t n = 0; n < num_nets(); ++n) net_pin_begin_[n + 1] += net_pin_begin_[n];
+  net_pins_.resize(pins_.size());
+  std::vector<uint32_t> fill(net_pin_begin_.begin(), net_pin_begin_.end() - 1);
+  for (uint32_t i = 0; i < pins_.size(); ++i) net_pins_[fill[pins_[i].net]++] = i;
+}
+
+uint32_t ModuleGraph::declare(const std::string& name, const std::optional<Range>& r, bool declared) {
+  auto it = bus_index_.find(name);
+  if (it != bus_index_.end()) return it->second;
+  Bus b;
+  b.name = name;
+  b.first = NetId(net_bus_.size());
+  b.vector = r.has_value();
+  b.declared = declared;
+  if (r) { b.start = r->start.as_integer(); b.end = r->end.as_integer(); }
+  const uint32_t idx = uint32_t(buses_.size());
+  net_bus_.resize(net_bus_.size() + range_width(r), idx);
+  buses_.push_back(std::move(b));
+  bus_index_.emplace(name, idx);
+  return idx;
+}
+
+NetId ModuleGraph::bit_of(const std::string& name, std::optional<int64_t> index, bool create) {
+  auto it = bus_index_.find(name);
+  if (index) {
+    if (it != bus_index_.end()) {
+      const Bus& b = buses_[it->second];
+      const int64_t lo = std::min(b.start, b.end), hi = std::max(b.start, b.end);
+      if (b.vector && *index >= lo && *index <= hi)
+        return b.first + NetId(b.start >= b.end ? b.start - *index : *index - b.start);
+    }
+    // Bit of an undeclared (or out-of-range) vector: an implicit scalar net.
+    const std::string bit_name = name + "[" + std::to_string(*index) + "]";
+    auto bit = bus_index_.find(bit_name);
+    if (bit != bus_index_.end()) return buses_[bit->second].first;
+    if (!create) return kNoNet;
+    return buses_[declare(bit_name, std::nullopt, false)].first;
+  }
+  if (it != bus_index_.end()) return buses_[it->second].first;
+  if (!create) return kNoNet;
+  return buses_[declare(name, std::nullopt, false)].first;
+}
+
+void ModuleGraph::bits(const Expr& e, std::vector<NetId>& out, bool create) {
+  struct V {
+    ModuleGraph& g; std::vector<NetId>& out; bool create;
+    void operator()(const Identifier& x) const {
+      auto it = g.bus_index_.find(x.name);
+      if (it != g.bus_index_.end() && g.buses_[it->second].vector) {
+        const Bus& b = g.buses_[it->second];
+        const int64_t n = (b.start >= b.end ? b.start - b.end : b.end - b.start) + 1;
+        for (int64_t k = 0; k < n; ++k) out.push_back(b.first + NetId(k));
+        return;
+      }
+      out.push_back(g.bit_of(x.name, std::nullopt, create));
+    }
+    void operator()(const IdentifierIndexed& x) const {
+      out.push_back(g.bit_of(x.name, x.index.as_integer(), create));
+    }
+    void operator()(const IdentifierSliced& x) const {
+      const int64_t s = x.range.start.as_integer(), e = x.range.end.as_integer();
+      const int64_t step = s >= e ? -1 : 1;
+      for (int64_t i = s;; i += step) { out.push_back(g.bit_of(x.name, i, create)); if (i == e) break; }
+    }
+    void operator()(const std::shared_ptr<Concatenation>& x) const {
+      for (const auto& el : x->elements) std::visit(*this, el);
+    }
+    // Constant bits drive no net; kNoNet keeps the positions of the others.
+    void operator()(const Constant& x) const { out.insert(out.end(), x.value.width(), kNoNet); }
+  };
+  std::visit(V{ *this, out, create }, e);
+}
+
+void ModuleGraph::expr_bits(const Expr& e, std::vector<NetId>& out) const {
+  const_cast<ModuleGraph*>(this)->bits(e, out, false);   // create == false never mutates
+}
+
+void ModuleGraph::add_node(NodeKind k, uint32_t ref, const ModuleInterface* master, GateType gate) {
+  if (!node_kind_.empty()) node_pin_begin_.push_back(uint32_t(pins_.size()));
+  node_kind_.push_back(k);
+  node_ref_.push_back(ref);
+  node_gate_.push_back(gate);
+  node_master_.push_back(master);
+}
+
+void ModuleGraph::add_pin(NetId net, PortDir dir, uint32_t port, uint32_t bit, uint32_t conn) {
+  pins_.push_back(Pin{ uint32_t(node_kind_.size() - 1), net, dir, port, bit, conn });
+}
+
+void ModuleGraph::connect(const std::vector<NetId>& bits, PortDir dir, uint32_t port, uint32_t conn) {
+  const uint32_t n = uint32_t(bits.size());
+  for (uint32_t k = 0; k < n; ++k) {
+    if (bits[k] == kNoNet) continue;
+    add_pin(bits[k], dir, port, n - 1 - k, conn);
+  }
+}
+
+std::string ModuleGraph::pin_name(const Pin& p) const {
+  switch (node_kind_[p.node]) {
+    case NodeKind::Port:   return module_->port_list[node_ref_[p.node]];
+    case NodeKind::Assign: return p.conn == 0 ? "lhs" : "rhs";
+    case NodeKind::Gate:   return "#" + std::to_string(p.conn);
+    case NodeKind::Instance: break;
+  }
+  if (const ModuleInterface* m = node_master_[p.node]; m && p.port != ModuleInterface::npos) return m->ports[p.port];
+  const ModuleInstance& inst = module_->module_instances[node_ref_[p.node]];
+  if (p.conn < inst.ports_pos.size()) return "#" + std::to_string(p.conn);
+  auto it = inst.ports_named.begin();
+  std::advance(it, p.conn - inst.ports_pos.size());
+  return it->first;
+}
+
+std::string ModuleGraph::net_name(NetId n) const {
+  const Bus& b = buses_[net_bus_[n]];
+  if (!b.vector) return b.name;
+  const int64_t off = int64_t(n - b.first);
+  return b.name + "[" + std::to_string(b.start >= b.end ? b.start - off : b.start + off) + "]";
+}
+
+NetId ModuleGraph::find_net(std::string_view name) const {
+  auto it = bus_index_.find(name);
+  if (it != bus_index_.end()) return buses_[it->second].vector ? kNoNet : buses_[it->second].first;
+  const auto lb = name.rfind('[');
+  if (lb == std::string_view::npos || name.back() != ']') return kNoNet;
+  auto base = bus_index_.find(name.substr(0, lb));
+  if (base == bus_index_.end()) return kNoNet;
+  const Number idx = Number::parse(name.substr(lb + 1, name.size() - lb - 2));
+  const Bus& b = buses_[base->second];
+  const int64_t i = idx.as_integer();
+  if (!b.vector || i < std::min(b.start, b.end) || i > std::max(b.start, b.end)) return kNoNet;
+  return b.first + NetId(b.start >= b.end ? b.start - i : i - b.start);
+}
+
+uint32_t ModuleGraph::find_bus(std::string_view name) const {
+  auto it = bus_index_.find(name);
+  return it == bus_index_.end() ? ModuleInterface::npos : it->second;
+}
+
+bool ModuleGraph::is_declared(NetId n) const { return buses_[net_bus_[n]].declared; }
+
+} // namespace verilog
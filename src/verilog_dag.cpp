@@ -0,0 +1,218 @@
+#include "verilog_dag.hpp"
+#include "verilog_parallel.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace verilog {
+
+ModuleDag::ModuleDag(const Netlist& nl, unsigned threads) {
+  const size_t n = nl.modules.size();
+  mods_.reserve(n);
+  for (const auto& m : nl.modules) mods_.push_back(&m);
+  index_.reserve(n);
+  for (uint32_t i = 0; i < n; ++i) index_.emplace(mods_[i]->module_name, i);   // the first definition stays
+
+  // Children of each module, one lookup per run of instances of one master.
+  std::vector<std::vector<uint32_t>> kids(n);
+  std::vector<std::vector<std::string_view>> missing(n);
+  parallel::parallel_for(n, [&](size_t i) {
+    std::string_view last;
+    bool any = false;
+    for (const auto& inst : mods_[i]->module_instances) {
+      if (any && inst.module_name == last) continue;
+      last = inst.module_name;
+      any = true;
+      const uint32_t c = find(last);
+      if (c == kNone) missing[i].push_back(last);
+      else kids[i].push_back(c);
+    }
+    std::sort(kids[i].begin(), kids[i].end());
+    kids[i].erase(std::unique(kids[i].begin(), kids[i].end()), kids[i].end());
+  }, threads, 16);
+
+  child_begin_.assign(1, 0);
+  std::vector<uint32_t> pending(n), parent_count(n + 1, 0);
+  for (size_t i = 0; i < n; ++i) {
+    child_.insert(child_.end(), kids[i].begin(), kids[i].end());
+    child_begin_.push_back(uint32_t(child_.size()));
+    pending[i] = uint32_t(kids[i].size());
+    for (uint32_t c : kids[i]) ++parent_count[c + 1];
+    undefined_.insert(undefined_.end(), missing[i].begin(), missing[i].end());
+  }
+  std::sort(undefined_.begin(), undefined_.end());
+  undefined_.erase(std::unique(undefined_.begin(), undefined_.end()), undefined_.end());
+
+  // Parents by a counting sort over the children; filling in module order
+  // keeps each list ascending.
+  for (size_t i = 0; i < n; ++i) parent_count[i + 1] += parent_count[i];
+  parent_begin_ = parent_count;
+  parent_.resize(child_.size());
+  for (uint32_t i = 0; i < n; ++i)
+    for (uint32_t c : children(i)) parent_[parent_count[c]++] = i;
+  for (uint32_t i = 0; i < n; ++i)
+    if (parents(i).empty()) roots_.push_back(i);
+
+  // Kahn's algorithm from the modules with no defined children.
+  order_.reserve(n);
+  height_.assign(n, 0);
+  for (uint32_t i = 0; i < n; ++i)
+    if (!pending[i]) order_.push_back(i);
+  for (size_t k = 0; k < order_.size(); ++k) {
+    const uint32_t m = order_[k];
+    for (uint32_t p : parents(m)) {
+      height_[p] = std::max(height_[p], height_[m] + 1);
+      if (--pending[p] == 0) order_.push_back(p);
+    }
+  }
+  if (order_.size() == n) return;
+
+  // Every module left over has a child left over: follow the lowest one from
+  // the lowest module until a module comes round again.
+  std::vector<uint32_t> seen_at(n, kNone), path;
+  uint32_t m = 0;
+  while (!pending[m]) ++m;
+  while (seen_at[m] == kNone) {
+    seen_at[m] = uint32_t(path.size());
+    path.push_back(m);
+    for (uint32_t c : children(m))
+      if (pending[c]) { m = c; break; }
+  }
+  std::string cycle;
+  for (size_t k = seen_at[m]; k < path.size(); ++k) cycle += mods_[path[k]]->module_name + " -> ";
+  throw std::runtime_error("instantiation cycle: " + cycle + mods_[m]->module_name);
+}
+
+uint32_t ModuleDag::find(std::string_view name) const {
+  auto it = index_.find(name);
+  return it == index_.end() ? kNone : it->second;
+}
+
+namespace {
+
+// The work-stealing pool behind run_bottom_up().
+class BottomUp {
+public:
+  BottomUp(const ModuleDag& dag, const std::function<void(uint32_t)>& visit, unsigned threads)
+      : dag_(dag), visit_(visit), threads_(threads), workers_(new Worker[threads]),
+        pending_(new std::atomic<uint32_t>[dag.size()]), left_(dag.size()) {
+    unsigned w = 0;
+    for (uint32_t m = 0; m < dag.size(); ++m) {
+      const uint32_t c = uint32_t(dag.children(m).size());
+      pending_[m].store(c, std::memory_order_relaxed);
+      if (c) continue;
+      workers_[w].ready.push_back(m);
+      queued_.fetch_add(1);
+      w = (w + 1) % threads_;
+    }
+  }
+
+  void run() {
+    std::vector<std::thread> pool;
+    pool.reserve(threads_ - 1);
+    for (unsigned w = 1; w < threads_; ++w) pool.emplace_back([this, w] { work(w); });
+    work(0);
+    for (auto& t : pool) t.join();
+    if (error_) std::rethrow_exception(error_);
+  }
+
+private:
+  struct alignas(64) Worker {
+    std::mutex mu;
+    std::deque<uint32_t> ready;
+  };
+
+  bool done() const { return left_.load() == 0 || stop_.load(); }
+
+  // The newest module of w's own deque, else the oldest of another's.
+  bool take(unsigned w, uint32_t& m) {
+    for (unsigned k = 0; k < threads_; ++k) {
+      Worker& v = workers_[(w + k) % threads_];
+      std::lock_guard<std::mutex> lk(v.mu);
+      if (v.ready.empty()) continue;
+      if (k == 0) { m = v.ready.back(); v.ready.pop_back(); }
+      else { m = v.ready.front(); v.ready.pop_front(); }
+      queued_.fetch_sub(1);
+      return true;
+    }
+    return false;
+  }
+
+  // queued_ is raised before the module is visible, so it never reads less
+  // than the deques hold, and a worker about to sleep either sees it or is
+  // seen in sleepers_ and woken.
+  void push(unsigned w, uint32_t m) {
+    queued_.fetch_add(1);
+    {
+      std::lock_guard<std::mutex> lk(workers_[w].mu);
+      workers_[w].ready.push_back(m);
+    }
+    if (sleepers_.load()) wake_one();
+  }
+
+  void wake_one() {
+    { std::lock_guard<std::mutex> lk(sleep_mu_); }
+    wake_.notify_one();
+  }
+  void wake_all() {
+    { std::lock_guard<std::mutex> lk(sleep_mu_); }
+    wake_.notify_all();
+  }
+
+  void work(unsigned w) {
+    while (!done()) {
+      uint32_t m;
+      if (!take(w, m)) {
+        std::unique_lock<std::mutex> lk(sleep_mu_);
+        sleepers_.fetch_add(1);
+        wake_.wait(lk, [&] { return queued_.load() > 0 || done(); });
+        sleepers_.fetch_sub(1);
+        continue;
+      }
+      try {
+        visit_(m);
+      } catch (...) {
+        {
+          std::lock_guard<std::mutex> lk(error_mu_);
+          if (!error_) error_ = std::current_exception();
+        }
+        stop_.store(true);
+        wake_all();
+        return;
+      }
+      for (uint32_t p : dag_.parents(m))
+        if (pending_[p].fetch_sub(1, std::memory_order_acq_rel) == 1) push(w, p);
+      if (left_.fetch_sub(1) == 1) wake_all();
+    }
+  }
+
+  const ModuleDag& dag_;
+  const std::function<void(uint32_t)>& visit_;
+  const unsigned threads_;
+  std::unique_ptr<Worker[]> workers_;
+  std::unique_ptr<std::atomic<uint32_t>[]> pending_;   // children not yet visited
+  std::atomic<size_t> left_;                            // modules not yet visited
+  std::atomic<size_t> queued_{ 0 };                     // modules in the deques, or about to be
+  std::atomic<unsigned> sleepers_{ 0 };
+  std::atomic<bool> stop_{ false };
+  std::mutex sleep_mu_;
+  std::condition_variable wake_;
+  std::mutex error_mu_;
+  std::exception_ptr error_;
+};
+
+} // namespace
+
+void run_bottom_up(const ModuleDag& dag, const std::function<void(uint32_t m)>& visit, unsigned threads) {
+  if (threads == 0) threads = parallel::default_threads();
+  threads = unsigned(std::min<size_t>(threads, dag.size()));
+  if (threads <= 1) {
+    for (uint32_t m : dag.bottom_up()) visit(m);
+    return;
+  }
+  BottomUp(dag, visit, threads).run();
+}
+
+} // namespace verilog
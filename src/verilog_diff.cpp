@@ -0,0 +1,397 @@
+#include "verilog_diff.hpp"
+#include "verilog_parallel.hpp"
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+
+namespace verilog {
+
+const char* to_string(DiffKind k) {
+  switch (k) {
+    case DiffKind::Added:   return "added";
+    case DiffKind::Removed: return "removed";
+    case DiffKind::Changed: return "changed";
+  }
+  return "?";
+}
+
+const char* to_string(DiffObject o) {
+  switch (o) {
+    case DiffObject::Module:     return "module";
+    case DiffObject::Port:       return "port";
+    case DiffObject::Parameter:  return "parameter";
+    case DiffObject::Net:        return "net";
+    case DiffObject::Instance:   return "instance";
+    case DiffObject::Connection: return "connection";
+    case DiffObject::Assign:     return "assign";
+    case DiffObject::Gate:       return "gate";
+  }
+  return "?";
+}
+
+std::string DiffEntry::to_string() const {
+  std::string s = kind == DiffKind::Added ? "+ " : kind == DiffKind::Removed ? "- " : "~ ";
+  if (object == DiffObject::Module) return s + "module " + module;
+  s += module + ": " + verilog::to_string(object) + " " + name;
+  if (kind == DiffKind::Changed) return s + ": " + before + " -> " + after;
+  const std::string& value = kind == DiffKind::Added ? after : before;
+  return value.empty() ? s : s + " (" + value + ")";
+}
+
+namespace {
+
+void json_string(std::string& out, std::string_view s) {
+  out += '"';
+  for (char c : s) {
+    switch (c) {
+      case '"':  out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if ((unsigned char)c < 0x20) {
+          static const char* hex = "0123456789abcdef";
+          out += "\\u00";
+          out += hex[(c >> 4) & 0xf];
+          out += hex[c & 0xf];
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+
+} // namespace
+
+std::string DiffEntry::to_json() const {
+  std::string s = "{\"kind\":\"";
+  s += verilog::to_string(kind);
+  s += "\",\"object\":\"";
+  s += verilog::to_string(object);
+  s += "\",\"module\":";
+  json_string(s, module);
+  if (!name.empty())   { s += ",\"name\":";   json_string(s, name); }
+  if (!before.empty()) { s += ",\"before\":"; json_string(s, before); }
+  if (!after.empty())  { s += ",\"after\":";  json_string(s, after); }
+  s += '}';
+  return s;
+}
+
+std::string NetlistDiff::report(size_t max_items) const {
+  std::ostringstream oss;
+  oss << "diff: " << added << " added, " << removed << " removed, " << changed << " changed\n";
+  for (size_t i = 0; i < entries.size() && i < max_items; ++i) oss << entries[i].to_string() << "\n";
+  if (entries.size() > max_items) oss << "... and " << entries.size() - max_items << " more\n";
+  return oss.str();
+}
+
+std::string NetlistDiff::to_json() const {
+  std::string s = "{\"added\":" + std::to_string(added) + ",\"removed\":" + std::to_string(removed) +
+                  ",\"changed\":" + std::to_string(changed) + ",\"entries\":[";
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (i) s += ',';
+    s += entries[i].to_json();
+  }
+  s += "]}";
+  return s;
+}
+
+namespace {
+
+constexpr uint32_t npos = ~uint32_t(0);
+constexpr size_t kLargeModule = 4096;   // instances; such modules are compared alone, in parallel chunks
+
+bool number_equal(const Number& a, const Number& b) {
+  if (a.decoded && b.decoded) return a.negative == b.negative && a.value == b.value;
+  return a.to_string() == b.to_string();
+}
+
+bool expr_equal(const Expr& a, const Expr& b) {
+  if (a.index() != b.index()) return false;
+  struct V {
+    const Expr& b;
+    bool operator()(const Identifier& x) const { return x.name == std::get<Identifier>(b).name; }
+    bool operator()(const IdentifierIndexed& x) const {
+      const auto& y = std::get<IdentifierIndexed>(b);
+      return x.name == y.name && number_equal(x.index, y.index);
+    }
+    bool operator()(const IdentifierSliced& x) const {
+      const auto& y = std::get<IdentifierSliced>(b);
+      return x.name == y.name && number_equal(x.range.start, y.range.start) && number_equal(x.range.end, y.range.end);
+    }
+    bool operator()(const std::shared_ptr<Concatenation>& x) const {
+      const auto& y = std::get<std::shared_ptr<Concatenation>>(b);
+      if (x == y) return true;
+      if (x->elements.size() != y->elements.size()) return false;
+      for (size_t i = 0; i < x->elements.size(); ++i)
+        if (!expr_equal(x->elements[i], y->elements[i])) return false;
+      return true;
+    }
+    bool operator()(const Constant& x) const {
+      const auto& y = std::get<Constant>(b);
+      return x.sized == y.sized && x.value == y.value;
+    }
+  };
+  return std::visit(V{ b }, a);
+}
+
+uint64_t name_hash(std::string_view s) { return std::hash<std::string_view>{}(s); }
+
+// Pairs instances of `a` with same-named instances of `b` through sorted
+// (hash, index) lists; equal hashes are resolved by comparing names, first
+// to first. partner[i] is the b index for a's instance i, or npos.
+std::vector<uint32_t> match_instances(const Module& a, const Module& b, std::vector<bool>& b_matched) {
+  using Key = std::pair<uint64_t, uint32_t>;
+  auto keys = [](const Module& m) {
+    std::vector<Key> k(m.module_instances.size());
+    for (uint32_t i = 0; i < k.size(); ++i) k[i] = { name_hash(m.module_instances[i].instance_name), i };
+    std::sort(k.begin(), k.end());
+    return k;
+  };
+  const std::vector<Key> ka = keys(a), kb = keys(b);
+  std::vector<uint32_t> partner(ka.size(), npos);
+  b_matched.assign(kb.size(), false);
+  size_t i = 0, j = 0;
+  while (i < ka.size() && j < kb.size()) {
+    if (ka[i].first < kb[j].first) { ++i; continue; }
+    if (kb[j].first < ka[i].first) { ++j; continue; }
+    const uint64_t h = ka[i].first;
+    size_t ie = i, je = j;
+    while (ie < ka.size() && ka[ie].first == h) ++ie;
+    while (je < kb.size() && kb[je].first == h) ++je;
+    for (size_t x = i; x < ie; ++x) {
+      const std::string& name = a.module_instances[ka[x].second].instance_name;
+      for (size_t y = j; y < je; ++y) {
+        if (b_matched[kb[y].second] || b.module_instances[kb[y].second].instance_name != name) continue;
+        partner[ka[x].second] = kb[y].second;
+        b_matched[kb[y].second] = true;
+        break;
+      }
+    }
+    i = ie;
+    j = je;
+  }
+  return partner;
+}
+
+void diff_connections(const std::string& module, const ModuleInstance& x, const ModuleInstance& y, std::vector<DiffEntry>& out) {
+  auto emit = [&](DiffKind k, const std::string& pin, const Expr* before, const Expr* after) {
+    out.push_back(DiffEntry{ k, DiffObject::Connection, module, x.instance_name + "." + pin,
+                             before ? expr_to_string(*before) : std::string(), after ? expr_to_string(*after) : std::string() });
+  };
+  const size_t np = std::max(x.ports_pos.size(), y.ports_pos.size());
+  for (size_t k = 0; k < np; ++k) {
+    const Expr* e = k < x.ports_pos.size() ? &x.ports_pos[k] : nullptr;
+    const Expr* f = k < y.ports_pos.size() ? &y.ports_pos[k] : nullptr;
+    if (e && f && expr_equal(*e, *f)) continue;
+    emit(!e ? DiffKind::Added : !f ? DiffKind::Removed : DiffKind::Changed, "#" + std::to_string(k), e, f);
+  }
+  // Both maps are sorted by pin: one merge pass.
+  auto i = x.ports_named.begin(), j = y.ports_named.begin();
+  while (i != x.ports_named.end() || j != y.ports_named.end()) {
+    if (j == y.ports_named.end() || (i != x.ports_named.end() && i->first < j->first)) {
+      emit(DiffKind::Removed, i->first, &i->second, nullptr);
+      ++i;
+    } else if (i == x.ports_named.end() || j->first < i->first) {
+      emit(DiffKind::Added, j->first, nullptr, &j->second);
+      ++j;
+    } else {
+      if (!expr_equal(i->second, j->second)) emit(DiffKind::Changed, i->first, &i->second, &j->second);
+      ++i;
+      ++j;
+    }
+  }
+}
+
+// Keyed items of a module (ports, parameters, nets, gates): value per name,
+// in declaration order, first of equal names.
+using Items = std::vector<std::pair<std::string, std::string>>;
+
+void diff_items(const std::string& module, DiffObject object, const Items& a, const Items& b, std::vector<DiffEntry>& out) {
+  std::unordered_map<std::string_view, size_t> in_b;
+  in_b.reserve(b.size());
+  for (size_t i = 0; i < b.size(); ++i) in_b.emplace(b[i].first, i);
+  std::vector<bool> seen(b.size());
+  std::unordered_map<std::string_view, size_t> in_a;
+  for (const auto& [name, value] : a) {
+    if (!in_a.emplace(name, 0).second) continue;
+    auto it = in_b.find(name);
+    if (it == in_b.end()) { out.push_back(DiffEntry{ DiffKind::Removed, object, module, name, value, {} }); continue; }
+    seen[it->second] = true;
+    if (b[it->second].second != value) out.push_back(DiffEntry{ DiffKind::Changed, object, module, name, value, b[it->second].second });
+  }
+  for (size_t i = 0; i < b.size(); ++i) {
+    if (seen[i] || in_b.at(b[i].first) != i) continue;
+    out.push_back(DiffEntry{ DiffKind::Added, object, module, b[i].first, {}, b[i].second });
+  }
+}
+
+std::string range_text(const std::optional<Range>& r) {
+  return r ? "[" + r->start.to_string() + ":" + r->end.to_string() + "]" : std::string();
+}
+
+Items nets_of(const Module& m) {
+  Items v;
+  auto add = [&](const auto& decls, const char* kind) {
+    for (const auto& d : decls) {
+      std::string value = kind;
+      if (d.range) value += " " + range_text(d.range);
+      for (const auto& n : d.names) v.emplace_back(n, value);
+    }
+  };
+  add(m.input_declarations, "input");
+  add(m.output_declarations, "output");
+  add(m.inout_declarations, "inout");
+  for (const auto& d : m.net_declarations) {
+    static const char* types[] = { "wire", "tri", "supply0", "supply1" };
+    std::string value = types[size_t(d.type)];
+    if (d.range) value += " " + range_text(d.range);
+    for (const auto& n : d.names) v.emplace_back(n, value);
+  }
+  return v;
+}
+
+Items gates_of(const Module& m) {
+  Items v;
+  for (size_t t = 0; t < kNumGateTypes; ++t) {
+    const GateTable& g = m.gates[t];
+    for (size_t i = 0; i < g.size(); ++i) {
+      std::string value = std::string(gate_type_name(GateType(t))) + " (";
+      bool first = true;
+      for (const auto& e : g.terminals_of(i)) {
+        if (!first) value += ", ";
+        first = false;
+        value += expr_to_string(e);
+      }
+      v.emplace_back(m.gate_label(GateType(t), i), value + ")");
+    }
+  }
+  return v;
+}
+
+std::vector<DiffEntry> diff_module(const Module& a, const Module& b, unsigned threads) {
+  std::vector<DiffEntry> out;
+  const std::string& mod = a.module_name;
+
+  Items pa, pb;
+  for (const auto& p : a.port_list) pa.emplace_back(p, std::string());
+  for (const auto& p : b.port_list) pb.emplace_back(p, std::string());
+  diff_items(mod, DiffObject::Port, pa, pb, out);
+
+  Items ra, rb;
+  for (const auto& p : a.parameters) ra.emplace_back(p.name, std::to_string(p.value));
+  for (const auto& p : b.parameters) rb.emplace_back(p.name, std::to_string(p.value));
+  diff_items(mod, DiffObject::Parameter, ra, rb, out);
+
+  diff_items(mod, DiffObject::Net, nets_of(a), nets_of(b), out);
+
+  std::vector<bool> b_matched;
+  const std::vector<uint32_t> partner = match_instances(a, b, b_matched);
+  constexpr size_t kChunk = 1024;
+  const size_t chunks = (partner.size() + kChunk - 1) / kChunk;
+  std::vector<std::vector<DiffEntry>> parts(chunks);
+  parallel::parallel_for(chunks, [&](size_t c) {
+    for (size_t i = c * kChunk, e = std::min(partner.size(), i + kChunk); i < e; ++i) {
+      const ModuleInstance& x = a.module_instances[i];
+      if (partner[i] == npos) {
+        parts[c].push_back(DiffEntry{ DiffKind::Removed, DiffObject::Instance, mod, x.instance_name, x.module_name, {} });
+        continue;
+      }
+      const ModuleInstance& y = b.module_instances[partner[i]];
+      if (x.module_name != y.module_name)
+        parts[c].push_back(DiffEntry{ DiffKind::Changed, DiffObject::Instance, mod, x.instance_name, x.module_name, y.module_name });
+      diff_connections(mod, x, y, parts[c]);
+    }
+  }, threads);
+  parallel::ordered_append(out, chunks, [&](size_t c) -> std::vector<DiffEntry>& { return parts[c]; }, threads);
+  for (size_t j = 0; j < b_matched.size(); ++j) {
+    if (b_matched[j]) continue;
+    const ModuleInstance& y = b.module_instances[j];
+    out.push_back(DiffEntry{ DiffKind::Added, DiffObject::Instance, mod, y.instance_name, {}, y.module_name });
+  }
+
+  // Assigns have no names: match "lhs = rhs" texts as multisets.
+  auto assigns = [](const Module& m) {
+    std::vector<std::string> v;
+    for (const auto& ca : m.assignments)
+      for (const auto& [l, r] : ca.assignments) v.push_back(expr_to_string(l) + " = " + expr_to_string(r));
+    return v;
+  };
+  std::vector<std::string> aa = assigns(a), ab = assigns(b);
+  std::vector<std::string> sa = aa, sb = ab;
+  std::sort(sa.begin(), sa.end());
+  std::sort(sb.begin(), sb.end());
+  std::vector<std::string> only_a, only_b;
+  std::set_difference(sa.begin(), sa.end(), sb.begin(), sb.end(), std::back_inserter(only_a));
+  std::set_difference(sb.begin(), sb.end(), sa.begin(), sa.end(), std::back_inserter(only_b));
+  auto report = [&](const std::vector<std::string>& texts, std::vector<std::string>& only, DiffKind k) {
+    for (const auto& t : texts) {   // in statement order
+      auto it = std::lower_bound(only.begin(), only.end(), t);
+      if (it == only.end() || *it != t) continue;
+      out.push_back(DiffEntry{ k, DiffObject::Assign, mod, t, {}, {} });
+      only.erase(it);
+    }
+  };
+  report(aa, only_a, DiffKind::Removed);
+  report(ab, only_b, DiffKind::Added);
+
+  diff_items(mod, DiffObject::Gate, gates_of(a), gates_of(b), out);
+  return out;
+}
+
+} // namespace
+
+void diff_netlists(const Netlist& a, const Netlist& b, const DiffOptions& opts,
+                   const std::function<void(const DiffEntry&)>& sink) {
+  std::unordered_map<std::string_view, const Module*> in_a, in_b;   // first definition wins
+  for (const auto& m : a.modules) in_a.emplace(m.module_name, &m);
+  for (const auto& m : b.modules) in_b.emplace(m.module_name, &m);
+
+  // The first definitions of `a`, then modules only in `b`, each with its partner or null.
+  std::vector<std::pair<const Module*, const Module*>> work;
+  for (const auto& m : a.modules) {
+    if (in_a.at(m.module_name) != &m) continue;
+    auto it = in_b.find(m.module_name);
+    work.emplace_back(&m, it == in_b.end() ? nullptr : it->second);
+  }
+  for (const auto& m : b.modules)
+    if (in_b.at(m.module_name) == &m && !in_a.count(m.module_name)) work.emplace_back(nullptr, &m);
+
+  auto one = [&](size_t i, unsigned threads) {
+    const auto [x, y] = work[i];
+    if (!x) return std::vector<DiffEntry>{ DiffEntry{ DiffKind::Added, DiffObject::Module, y->module_name, {}, {}, {} } };
+    if (!y) return std::vector<DiffEntry>{ DiffEntry{ DiffKind::Removed, DiffObject::Module, x->module_name, {}, {}, {} } };
+    return diff_module(*x, *y, threads);
+  };
+  auto large = [&](size_t i) {
+    const auto [x, y] = work[i];
+    return x && y && x->module_instances.size() + y->module_instances.size() >= kLargeModule;
+  };
+
+  const size_t per_batch = std::max<size_t>(1, opts.modules_per_batch);
+  for (size_t begin = 0; begin < work.size(); begin += per_batch) {
+    const size_t end = std::min(work.size(), begin + per_batch);
+    std::vector<std::vector<DiffEntry>> local(end - begin);
+    // Small modules side by side; a large one uses every worker on its own.
+    parallel::parallel_for(end - begin, [&](size_t k) {
+      if (!large(begin + k)) local[k] = one(begin + k, 1);
+    }, opts.threads);
+    for (size_t k = 0; k < local.size(); ++k) {
+      if (large(begin + k)) local[k] = one(begin + k, opts.threads);
+      for (const auto& e : local[k]) sink(e);
+      std::vector<DiffEntry>().swap(local[k]);
+    }
+  }
+}
+
+NetlistDiff diff_netlists(const Netlist& a, const Netlist& b, const DiffOptions& opts) {
+  NetlistDiff d;
+  diff_netlists(a, b, opts, [&](const DiffEntry& e) {
+    (e.kind == DiffKind::Added ? d.added : e.kind == DiffKind::Removed ? d.removed : d.changed)++;
+    d.entries.push_back(e);
+  });
+  return d;
+}
+
+} // namespace verilog
@@ -0,0 +1,296 @@
+#include "verilog_elaborate.hpp"
+#include "verilog_parallel.hpp"
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace verilog {
+
+namespace {
+
+constexpr uint32_t npos = ~uint32_t(0);
+
+// A module and a tuple: parameter values, or per parameter an override.
+template<typename V>
+struct Key {
+  uint32_t module;
+  std::vector<V> values;
+  bool operator==(const Key&) const = default;
+};
+
+struct KeyHash {
+  static uint64_t mix(uint64_t h, uint64_t v) { return (h ^ v) * 0x100000001b3ull; }
+  size_t operator()(const Key<int64_t>& k) const {
+    uint64_t h = mix(0xcbf29ce484222325ull, k.module);
+    for (int64_t v : k.values) h = mix(h, uint64_t(v));
+    return size_t(h);
+  }
+  size_t operator()(const Key<std::optional<int64_t>>& k) const {
+    uint64_t h = mix(0xcbf29ce484222325ull, k.module);
+    for (const auto& v : k.values) h = mix(mix(h, v.has_value()), uint64_t(v.value_or(0)));
+    return size_t(h);
+  }
+};
+
+using Overrides = std::vector<std::optional<int64_t>>;   // empty: every default
+
+struct Spec {
+  uint32_t module;
+  std::vector<int64_t> values;
+  std::string name;
+};
+
+// An instance of a defined module, found while elaborating its parent.
+struct Request {
+  uint32_t inst;
+  uint32_t module;
+  Overrides overrides;
+};
+
+Number number(int64_t v) { return Number::parse(std::to_string(v)); }
+
+class Elaborator {
+public:
+  Elaborator(const Netlist& nl, const ElaborateOptions& opts) : nl_(nl), opts_(opts) {
+    const size_t n = nl.modules.size();
+    for (uint32_t i = 0; i < n; ++i) {
+      by_name_.emplace(nl.modules[i].module_name, i);
+      taken_.insert(nl.modules[i].module_name);
+    }
+    default_spec_.assign(n, npos);
+  }
+
+  ElaboratedNetlist run() {
+    std::vector<uint32_t> level;
+    if (!opts_.top.empty()) {
+      auto it = by_name_.find(opts_.top);
+      if (it == by_name_.end()) throw std::runtime_error("top module not found: " + opts_.top);
+      resolve(it->second, {}, level);
+    } else {
+      std::unordered_set<std::string_view> used;
+      for (const auto& m : nl_.modules)
+        for (const auto& inst : m.module_instances) used.insert(inst.module_name);
+      for (uint32_t i = 0; i < nl_.modules.size(); ++i) {
+        const Module& m = nl_.modules[i];
+        if (by_name_.at(m.module_name) == i && !used.count(m.module_name)) resolve(i, {}, level);
+      }
+    }
+
+    ElaboratedNetlist out;
+    std::vector<Module> mods;
+    for (unsigned depth = 0; !level.empty(); ++depth) {
+      if (depth == opts_.max_depth)
+        throw std::runtime_error("instantiation of '" + specs_[level.front()].name + "' is more than " +
+                                 std::to_string(opts_.max_depth) + " levels deep; recursive parameters?");
+      mods.resize(specs_.size());
+      std::vector<std::vector<Request>> reqs(level.size());
+      parallel::parallel_for(level.size(), [&](size_t i) {
+        mods[level[i]] = specialise(specs_[level[i]], reqs[i]);
+      }, opts_.threads);
+
+      std::vector<uint32_t> next;
+      for (size_t i = 0; i < level.size(); ++i) {
+        Module& m = mods[level[i]];
+        for (auto& r : reqs[i]) {
+          const uint32_t s = resolve(r.module, std::move(r.overrides), next);
+          m.module_instances[r.inst].module_name = specs_[s].name;
+          ++out.instances;
+        }
+      }
+      level = std::move(next);
+    }
+
+    out.specializations = specs_.size();
+    out.netlist.modules = std::move(mods);
+    out.netlist.lines = nl_.lines;
+    out.netlist.sources = nl_.sources;
+    return out;
+  }
+
+private:
+  // The specialization an instance of `m` with `ov` gets; new ones are queued
+  // on `fresh`. Serial.
+  uint32_t resolve(uint32_t m, Overrides ov, std::vector<uint32_t>& fresh) {
+    const Module& mod = nl_.modules[m];
+    if (ov.empty()) {
+      if (default_spec_[m] == npos) {
+        std::vector<int64_t> values;
+        values.reserve(mod.parameters.size());
+        for (const auto& p : mod.parameters) values.push_back(p.value);
+        default_spec_[m] = intern(m, std::move(values), fresh);
+      }
+      return default_spec_[m];
+    }
+    Key<std::optional<int64_t>> key{ m, std::move(ov) };
+    if (auto it = by_overrides_.find(key); it != by_overrides_.end()) return it->second;
+
+    // Defaults that are not overridden may depend on ones that are.
+    std::vector<Parameter> env = mod.parameters;
+    std::vector<int64_t> values(env.size());
+    for (size_t i = 0; i < env.size(); ++i) {
+      env[i].value = key.values[i] ? *key.values[i] : eval(env[i].expr, std::span(env.data(), i), mod.module_name);
+      values[i] = env[i].value;
+    }
+    const uint32_t s = intern(m, std::move(values), fresh);
+    by_overrides_.emplace(std::move(key), s);
+    return s;
+  }
+
+  uint32_t intern(uint32_t m, std::vector<int64_t> values, std::vector<uint32_t>& fresh) {
+    Key<int64_t> key{ m, std::move(values) };
+    if (auto it = by_values_.find(key); it != by_values_.end()) return it->second;
+    const uint32_t s = uint32_t(specs_.size());
+    specs_.push_back(Spec{ m, key.values, name_for(m, key.values) });
+    by_values_.emplace(std::move(key), s);
+    fresh.push_back(s);
+    return s;
+  }
+
+  std::string name_for(uint32_t m, const std::vector<int64_t>& values) {
+    const Module& mod = nl_.modules[m];
+    std::string name = mod.module_name;
+    std::vector<Parameter> env = mod.parameters;
+    for (size_t i = 0; i < values.size(); ++i) env[i].value = values[i];
+    for (size_t i = 0; i < values.size(); ++i) {
+      // A value its default expression gives, like D = W * 2, follows from the others.
+      const Parameter& p = mod.parameters[i];
+      if (p.local || values[i] == derived(p.expr, std::span(env.data(), i))) continue;
+      name += "_" + p.name + (values[i] < 0 ? "m" + std::to_string(0 - uint64_t(values[i])) : std::to_string(values[i]));
+    }
+    if (name == mod.module_name) return name;
+    if (!taken_.insert(name).second) {
+      for (unsigned k = 1;; ++k) {
+        std::string cand = name + "_" + std::to_string(k);
+        if (taken_.insert(cand).second) { name = std::move(cand); break; }
+      }
+    }
+    return name;
+  }
+
+  static std::optional<int64_t> derived(const ParamExpr& e, std::span<const Parameter> env) {
+    try {
+      return e.eval(env);
+    } catch (const std::runtime_error&) {
+      return std::nullopt;
+    }
+  }
+
+  static int64_t eval(const ParamExpr& e, std::span<const Parameter> env, const std::string& module) {
+    try {
+      return e.eval(env);
+    } catch (const std::runtime_error& x) {
+      throw std::runtime_error("module '" + module + "': " + x.what());
+    }
+  }
+
+  // The module with the spec's values substituted; instances of defined
+  // modules come back as requests, named by the caller. Parallel.
+  Module specialise(const Spec& sp, std::vector<Request>& reqs) const {
+    Module m = nl_.modules[sp.module];
+    m.module_name = sp.name;
+    for (size_t i = 0; i < m.parameters.size(); ++i) {
+      m.parameters[i].value = sp.values[i];
+      m.parameters[i].expr = ParamExpr::literal(sp.values[i]);
+    }
+    auto ranges = [&](auto& decls) {
+      for (auto& d : decls) {
+        if (!d.range_expr) continue;
+        d.range = Range{ number(eval(d.range_expr->msb, m.parameters, m.module_name)),
+                         number(eval(d.range_expr->lsb, m.parameters, m.module_name)) };
+        d.range_expr.reset();
+      }
+    };
+    ranges(m.input_declarations);
+    ranges(m.output_declarations);
+    ranges(m.inout_declarations);
+    ranges(m.net_declarations);
+
+    // Instances of one statement share their overrides: evaluate each once.
+    const ParamOverrides* last = nullptr;
+    Overrides last_ov;
+    std::shared_ptr<const ParamOverrides> last_literal;
+    for (uint32_t k = 0; k < m.module_instances.size(); ++k) {
+      ModuleInstance& inst = m.module_instances[k];
+      auto it = by_name_.find(inst.module_name);
+      if (it == by_name_.end()) {
+        if (inst.params && !literal(*inst.params)) {
+          if (inst.params.get() != last) {
+            last = inst.params.get();
+            last_literal = reduce(*inst.params, m);
+          }
+          inst.params = last_literal;
+        }
+        continue;
+      }
+      Request r{ k, it->second, {} };
+      if (inst.params) {
+        if (inst.params.get() != last) {
+          last = inst.params.get();
+          last_ov = overrides(*inst.params, nl_.modules[it->second], m, inst.instance_name);
+        }
+        r.overrides = last_ov;
+        inst.params.reset();
+      }
+      reqs.push_back(std::move(r));
+    }
+    return m;
+  }
+
+  // Override values per parameter of `child`, evaluated in the parent.
+  static Overrides overrides(const ParamOverrides& po, const Module& child, const Module& parent, const std::string& inst) {
+    auto fail = [&](const std::string& why) -> void {
+      throw std::runtime_error("module '" + parent.module_name + "', instance '" + inst + "': " + why);
+    };
+    const auto& cp = child.parameters;
+    Overrides ov(cp.size());
+    size_t slot = 0;
+    for (const auto& e : po.positional) {
+      while (slot < cp.size() && cp[slot].local) ++slot;
+      if (slot == cp.size()) fail("too many parameter values for '" + child.module_name + "'");
+      ov[slot++] = eval(e, parent.parameters, parent.module_name);
+    }
+    for (const auto& [name, e] : po.named) {
+      size_t i = 0;
+      while (i < cp.size() && cp[i].name != name) ++i;
+      if (i == cp.size()) fail("'" + child.module_name + "' has no parameter '" + name + "'");
+      if (cp[i].local) fail("parameter '" + name + "' of '" + child.module_name + "' is local");
+      ov[i] = eval(e, parent.parameters, parent.module_name);
+    }
+    // Overrides that restate every default are the defaults.
+    bool any = false;
+    for (size_t i = 0; i < ov.size() && !any; ++i) any = ov[i] && *ov[i] != cp[i].value;
+    if (!any) ov.clear();
+    return ov;
+  }
+
+  static bool literal(const ParamOverrides& po) {
+    for (const auto& e : po.positional) if (!e.is_literal()) return false;
+    for (const auto& [name, e] : po.named) if (!e.is_literal()) return false;
+    return true;
+  }
+
+  static std::shared_ptr<const ParamOverrides> reduce(const ParamOverrides& po, const Module& parent) {
+    auto out = std::make_shared<ParamOverrides>();
+    for (const auto& e : po.positional) out->positional.push_back(ParamExpr::literal(eval(e, parent.parameters, parent.module_name)));
+    for (const auto& [name, e] : po.named)
+      out->named.emplace_back(name, ParamExpr::literal(eval(e, parent.parameters, parent.module_name)));
+    return out;
+  }
+
+  const Netlist& nl_;
+  const ElaborateOptions& opts_;
+  std::unordered_map<std::string_view, uint32_t> by_name_;   // first definition wins
+  std::unordered_set<std::string> taken_;
+  std::vector<Spec> specs_;
+  std::vector<uint32_t> default_spec_;
+  std::unordered_map<Key<int64_t>, uint32_t, KeyHash> by_values_;
+  std::unordered_map<Key<std::optional<int64_t>>, uint32_t, KeyHash> by_overrides_;
+};
+
+} // namespace
+
+ElaboratedNetlist elaborate(const Netlist& nl, const ElaborateOptions& opts) {
+  return Elaborator(nl, opts).run();
+}
+
+} // namespace verilog
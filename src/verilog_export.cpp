@@ -0,0 +1,614 @@
+#include "verilog_export.hpp"
+#include "verilog_lazy.hpp"
+#include "verilog_parallel.hpp"
+#include "verilog_writer.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <ostream>
+#include <unordered_map>
+
+static_assert(std::endian::native == std::endian::little, "the binary netlist format is read and written in place");
+
+namespace verilog {
+
+namespace {
+
+constexpr char kMagic[4] = { 'V', 'N', 'B', '1' };
+
+// Encodes modules [0, n) a batch at a time, encode(i, buffer) in parallel,
+// and passes the buffers to emit() in module order.
+template<typename Encode, typename Emit>
+void in_batches(size_t n, const ExportOptions& opts, Encode&& encode, Emit&& emit) {
+  const size_t batch = std::max<size_t>(opts.modules_per_batch, 1);
+  std::vector<std::string> bufs(std::min(n, batch));
+  for (size_t b = 0; b < n; b += batch) {
+    const size_t k = std::min(batch, n - b);
+    parallel::parallel_for(k, [&](size_t i) {
+      bufs[i].clear();
+      encode(b + i, bufs[i]);
+    }, opts.threads);
+    for (size_t i = 0; i < k; ++i) emit(bufs[i]);
+  }
+}
+
+// Calls f with module i of a lazy netlist: the kept body when it was parsed
+// already, else one parsed for the call and dropped after it.
+template<typename F>
+void with_module(const LazyNetlist& nl, size_t i, F&& f) {
+  if (nl.is_parsed(i)) {
+    f(nl.module(i));
+  } else {
+    const Module m = nl.parse_module(i);
+    f(m);
+  }
+}
+
+void put(std::ostream& out, std::string_view s) {
+  out.write(s.data(), std::streamsize(s.size()));
+  if (!out) throw std::runtime_error("export: write failed");
+}
+
+// ---------------------------------------------------------------- JSON
+
+void json_string(std::string& out, std::string_view s) {
+  static constexpr char hex[] = "0123456789abcdef";
+  out += '"';
+  size_t run = 0;   // start of the characters not yet copied
+  for (size_t i = 0; i < s.size(); ++i) {
+    const unsigned char c = s[i];
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+    out.append(s, run, i - run);
+    run = i + 1;
+    switch (c) {
+      case '"':  out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        out += "\\u00";
+        out += hex[c >> 4];
+        out += hex[c & 0xf];
+    }
+  }
+  out.append(s, run, s.size() - run);
+  out += '"';
+}
+
+class JsonModule {
+public:
+  explicit JsonModule(std::string& out) : out_(out) {}
+
+  void module(const Module& m) {
+    out_ += "{\"name\":";
+    json_string(out_, m.module_name);
+    out_ += ",\"ports\":[";
+    for (size_t i = 0; i < m.port_list.size(); ++i) {
+      if (i) out_ += ',';
+      json_string(out_, m.port_list[i]);
+    }
+    out_ += "],\"parameters\":[";
+    for (size_t i = 0; i < m.parameters.size(); ++i) {
+      const Parameter& p = m.parameters[i];
+      out_ += i ? ",{\"name\":" : "{\"name\":";
+      json_string(out_, p.name);
+      out_ += ",\"expr\":";
+      json_string(out_, p.expr.to_string());
+      out_ += ",\"value\":" + std::to_string(p.value);
+      out_ += p.local ? ",\"local\":true}" : ",\"local\":false}";
+    }
+    out_ += "],\"declarations\":[";
+    first_ = true;
+    for (const auto& d : m.input_declarations) decl("input", d);
+    for (const auto& d : m.output_declarations) decl("output", d);
+    for (const auto& d : m.inout_declarations) decl("inout", d);
+    static constexpr const char* net_kinds[] = { "wire", "tri", "supply0", "supply1" };
+    for (const auto& d : m.net_declarations) decl(net_kinds[size_t(d.type)], d);
+    out_ += "],\"assigns\":[";
+    first_ = true;
+    for (const auto& ca : m.assignments)
+      for (const auto& [lhs, rhs] : ca.assignments) {
+        out_ += first_ ? "[" : ",[";
+        first_ = false;
+        expr(lhs);
+        out_ += ',';
+        expr(rhs);
+        out_ += ']';
+      }
+    out_ += "],\"instances\":[";
+    for (size_t i = 0; i < m.module_instances.size(); ++i) {
+      if (i) out_ += ',';
+      instance(m.module_instances[i]);
+    }
+    out_ += "],\"gates\":[";
+    first_ = true;
+    for (size_t t = 0; t < kNumGateTypes; ++t) {
+      const GateTable& gt = m.gates[t];
+      for (size_t i = 0; i < gt.size(); ++i) {
+        out_ += first_ ? "{\"type\":\"" : ",{\"type\":\"";
+        first_ = false;
+        out_ += gate_type_name(GateType(t));
+        out_ += "\",\"name\":";
+        json_string(out_, gt.names[i]);
+        out_ += ",\"terminals\":[";
+        const auto terms = gt.terminals_of(i);
+        for (size_t k = 0; k < terms.size(); ++k) {
+          if (k) out_ += ',';
+          expr(terms[k]);
+        }
+        out_ += "]}";
+      }
+    }
+    out_ += "]}";
+  }
+
+private:
+  void expr(const Expr& e) {
+    text_.clear();
+    append_expr(text_, e);
+    json_string(out_, text_);
+  }
+
+  void decl(const char* kind, const NetDeclaration& d) {
+    out_ += first_ ? "{\"kind\":\"" : ",{\"kind\":\"";
+    first_ = false;
+    out_ += kind;
+    out_ += "\",\"names\":[";
+    for (size_t i = 0; i < d.names.size(); ++i) {
+      if (i) out_ += ',';
+      json_string(out_, d.names[i]);
+    }
+    out_ += ']';
+    if (d.range)
+      out_ += ",\"range\":[" + std::to_string(d.range->start.as_integer()) + "," +
+              std::to_string(d.range->end.as_integer()) + "]";
+    if (d.range_expr) {
+      out_ += ",\"range_expr\":[";
+      json_string(out_, d.range_expr->msb.to_string());
+      out_ += ',';
+      json_string(out_, d.range_expr->lsb.to_string());
+      out_ += ']';
+    }
+    out_ += '}';
+  }
+
+  void instance(const ModuleInstance& inst) {
+    out_ += "{\"master\":";
+    json_string(out_, inst.module_name);
+    out_ += ",\"name\":";
+    json_string(out_, inst.instance_name);
+    if (inst.params) {
+      out_ += ",\"params\":{\"positional\":[";
+      for (size_t i = 0; i < inst.params->positional.size(); ++i) {
+        if (i) out_ += ',';
+        json_string(out_, inst.params->positional[i].to_string());
+      }
+      out_ += "],\"named\":{";
+      for (size_t i = 0; i < inst.params->named.size(); ++i) {
+        if (i) out_ += ',';
+        json_string(out_, inst.params->named[i].first);
+        out_ += ':';
+        json_string(out_, inst.params->named[i].second.to_string());
+      }
+      out_ += "}}";
+    }
+    if (!inst.ports_pos.empty()) {
+      out_ += ",\"ports\":[";
+      for (size_t i = 0; i < inst.ports_pos.size(); ++i) {
+        if (i) out_ += ',';
+        expr(inst.ports_pos[i]);
+      }
+      out_ += ']';
+    }
+    if (!inst.ports_named.empty()) {
+      out_ += ",\"pins\":{";
+      bool first = true;
+      for (const auto& [pin, e] : inst.ports_named) {
+        if (!first) out_ += ',';
+        first = false;
+        json_string(out_, pin);
+        out_ += ':';
+        expr(e);
+      }
+      out_ += '}';
+    }
+    out_ += '}';
+  }
+
+  std::string& out_;
+  std::string text_;   // an expression's Verilog text, before escaping
+  bool first_ = true;
+};
+
+template<typename Source>
+void json_stream(size_t n, const Source& get, std::ostream& out, const ExportOptions& opts) {
+  put(out, "{\"modules\":[");
+  in_batches(n, opts, [&](size_t i, std::string& buf) {
+    buf += i ? ",\n" : "\n";
+    get(i, [&](const Module& m) { JsonModule(buf).module(m); });
+  }, [&](const std::string& buf) { put(out, buf); });
+  put(out, "\n]}\n");
+}
+
+// ---------------------------------------------------------------- binary
+
+// Builds one record at the end of `buf`. Tables are placed first and filled
+// in afterwards, so every write goes through an offset: `buf` may move. Names
+// are stored once per record; every later use points at the first copy.
+class Record {
+public:
+  explicit Record(std::string& buf) : buf_(buf) {}
+
+  void module(const Module& m) {
+    const uint32_t r = alloc(64);
+    name(r + 8, m.module_name);
+    uint32_t at = list(r + 16, m.port_list.size(), 8);
+    for (const auto& p : m.port_list) name(at, p), at += 8;
+
+    at = list(r + 24, m.parameters.size(), 32);
+    for (const auto& p : m.parameters) {
+      name(at, p.name);
+      str(at + 8, p.expr.to_string());
+      put64(at + 16, p.value);
+      put32(at + 24, p.local);
+      at += 32;
+    }
+
+    at = list(r + 32, m.input_declarations.size() + m.output_declarations.size() + m.inout_declarations.size() +
+                      m.net_declarations.size(), 48);
+    for (const auto& d : m.input_declarations) decl(at, 0, d), at += 48;
+    for (const auto& d : m.output_declarations) decl(at, 1, d), at += 48;
+    for (const auto& d : m.inout_declarations) decl(at, 2, d), at += 48;
+    for (const auto& d : m.net_declarations) decl(at, 3, d), at += 48;
+
+    at = list(r + 40, m.assignments.size(), 8);
+    for (const auto& ca : m.assignments) {
+      uint32_t pair = list(at, ca.assignments.size(), 32);
+      for (const auto& [lhs, rhs] : ca.assignments) {
+        expr(pair, lhs);
+        expr(pair + 16, rhs);
+        pair += 32;
+      }
+      at += 8;
+    }
+
+    at = list(r + 48, m.module_instances.size(), 56);
+    for (const auto& inst : m.module_instances) instance(at, inst), at += 56;
+
+    at = list(r + 56, m.num_gates(), 24);
+    for (size_t t = 0; t < kNumGateTypes; ++t) {
+      const GateTable& gt = m.gates[t];
+      for (size_t i = 0; i < gt.size(); ++i) {
+        put32(at, uint32_t(t));
+        name(at + 8, gt.names[i]);
+        const auto terms = gt.terminals_of(i);
+        uint32_t e = list(at + 16, terms.size(), 16);
+        for (const auto& x : terms) expr(e, x), e += 16;
+        at += 24;
+      }
+    }
+
+    buf_.resize((buf_.size() + 7) & ~size_t(7), '\0');
+    if (buf_.size() > UINT32_MAX) throw std::runtime_error("export: module '" + m.module_name + "' is over 4 GiB in binary form");
+    put32(r, uint32_t(buf_.size()));
+  }
+
+private:
+  uint32_t alloc(size_t bytes) {
+    const size_t at = (buf_.size() + 3) & ~size_t(3);
+    buf_.resize(at + bytes, '\0');
+    return uint32_t(at);   // checked against 4 GiB once the record is done
+  }
+  void put32(uint32_t at, uint32_t v) { std::memcpy(&buf_[at], &v, 4); }
+  void put64(uint32_t at, int64_t v) { std::memcpy(&buf_[at], &v, 8); }
+  void str(uint32_t at, std::string_view s) {
+    put32(at, uint32_t(buf_.size()));
+    put32(at + 4, uint32_t(s.size()));
+    buf_ += s;
+  }
+  // A string owned by the module, which outlives the record.
+  void name(uint32_t at, std::string_view s) {
+    auto [it, fresh] = names_.try_emplace(s, uint32_t(buf_.size()));
+    if (fresh) buf_ += s;
+    put32(at, it->second);
+    put32(at + 4, uint32_t(s.size()));
+  }
+  uint32_t list(uint32_t at, size_t count, size_t elem) {
+    const uint32_t first = alloc(count * elem);
+    put32(at, first);
+    put32(at + 4, uint32_t(count));
+    return first;
+  }
+
+  void expr(uint32_t at, const Expr& e) {
+    struct V {
+      Record& r;
+      uint32_t at;
+      void operator()(const Identifier& x) const { r.name(at + 4, x.name); }
+      void operator()(const IdentifierIndexed& x) const {
+        r.put32(at, 1);
+        r.name(at + 4, x.name);
+        const uint32_t v = r.alloc(8);
+        r.put64(v, x.index.as_integer());
+        r.put32(at + 12, v);
+      }
+      void operator()(const IdentifierSliced& x) const {
+        r.put32(at, 2);
+        r.name(at + 4, x.name);
+        const uint32_t v = r.alloc(16);
+        r.put64(v, x.range.start.as_integer());
+        r.put64(v + 8, x.range.end.as_integer());
+        r.put32(at + 12, v);
+      }
+      void operator()(const std::shared_ptr<Concatenation>& x) const {
+        r.put32(at, 3);
+        uint32_t e = r.list(at + 4, x->elements.size(), 16);
+        for (const auto& el : x->elements) r.expr(e, el), e += 16;
+      }
+      void operator()(const Constant& x) const {
+        const size_t words = x.value.num_words();
+        r.put32(at, 4);
+        r.put32(at + 4, x.value.width());
+        const uint32_t v = r.alloc(words * 16);
+        std::memcpy(&r.buf_[v], x.value.aval(), words * 8);
+        std::memcpy(&r.buf_[v + words * 8], x.value.bval(), words * 8);
+        r.put32(at + 8, v);
+        r.put32(at + 12, x.sized);
+      }
+    };
+    std::visit(V{ *this, at }, e);
+  }
+
+  void decl(uint32_t at, uint32_t kind, const NetDeclaration& d) {
+    put32(at, kind | uint32_t(d.type) << 8 | uint32_t(d.range.has_value()) << 16);
+    if (d.range) {
+      put64(at + 8, d.range->start.as_integer());
+      put64(at + 16, d.range->end.as_integer());
+    }
+    if (d.range_expr) {
+      str(at + 24, d.range_expr->msb.to_string());
+      str(at + 32, d.range_expr->lsb.to_string());
+    }
+    uint32_t n = list(at + 40, d.names.size(), 8);
+    for (const auto& x : d.names) name(n, x), n += 8;
+  }
+
+  void instance(uint32_t at, const ModuleInstance& inst) {
+    name(at, inst.module_name);
+    name(at + 8, inst.instance_name);
+    uint32_t e = list(at + 16, inst.ports_pos.size(), 16);
+    for (const auto& x : inst.ports_pos) expr(e, x), e += 16;
+    e = list(at + 24, inst.ports_named.size(), 24);
+    for (const auto& [pin, x] : inst.ports_named) {
+      name(e, pin);
+      expr(e + 8, x);
+      e += 24;
+    }
+    if (!inst.params) return;
+    put32(at + 32, 1);
+    e = list(at + 40, inst.params->positional.size(), 8);
+    for (const auto& p : inst.params->positional) str(e, p.to_string()), e += 8;
+    e = list(at + 48, inst.params->named.size(), 16);
+    for (const auto& [param, p] : inst.params->named) {
+      name(e, param);
+      str(e + 8, p.to_string());
+      e += 16;
+    }
+  }
+
+  std::string& buf_;
+  std::unordered_map<std::string_view, uint32_t> names_;
+};
+
+template<typename Source>
+void binary_stream(size_t n, const Source& get, std::ostream& out, const ExportOptions& opts) {
+  char head[8] = {};
+  std::memcpy(head, kMagic, 4);
+  put(out, std::string_view(head, 8));
+  std::vector<uint64_t> index;
+  index.reserve(n);
+  uint64_t pos = 8;
+  in_batches(n, opts, [&](size_t i, std::string& buf) {
+    get(i, [&](const Module& m) { Record(buf).module(m); });
+  }, [&](const std::string& buf) {
+    index.push_back(pos);
+    put(out, buf);
+    pos += buf.size();
+  });
+  put(out, std::string_view(reinterpret_cast<const char*>(index.data()), index.size() * 8));
+  char tail[16];
+  const uint32_t count = uint32_t(n);
+  std::memcpy(tail, &pos, 8);
+  std::memcpy(tail + 8, &count, 4);
+  std::memcpy(tail + 12, kMagic, 4);
+  put(out, std::string_view(tail, 16));
+}
+
+auto netlist_source(const Netlist& nl) {
+  return [&nl](size_t i, auto&& f) { f(nl.modules[i]); };
+}
+
+auto lazy_source(const LazyNetlist& nl) {
+  return [&nl](size_t i, auto&& f) { with_module(nl, i, f); };
+}
+
+Number number(int64_t v) { return Number::parse(std::to_string(v)); }
+
+} // namespace
+
+std::string to_json(const Module& m) {
+  std::string s;
+  JsonModule(s).module(m);
+  return s;
+}
+
+void write_json(const Netlist& nl, std::ostream& out, const ExportOptions& opts) {
+  json_stream(nl.modules.size(), netlist_source(nl), out, opts);
+}
+
+void write_json(const LazyNetlist& nl, std::ostream& out, const ExportOptions& opts) {
+  json_stream(nl.size(), lazy_source(nl), out, opts);
+}
+
+void write_binary(const Netlist& nl, std::ostream& out, const ExportOptions& opts) {
+  binary_stream(nl.modules.size(), netlist_source(nl), out, opts);
+}
+
+void write_binary(const LazyNetlist& nl, std::ostream& out, const ExportOptions& opts) {
+  binary_stream(nl.size(), lazy_source(nl), out, opts);
+}
+
+namespace binary {
+
+const char* Cursor::check(uint64_t offset, uint64_t bytes) const {
+  if (offset + bytes > size_) throw std::runtime_error("binary netlist: offset out of bounds in a record");
+  return rec_ + offset;
+}
+
+uint32_t Cursor::u32(uint32_t field) const {
+  uint32_t v;
+  std::memcpy(&v, check(uint64_t(at_) + field, 4), 4);
+  return v;
+}
+
+int64_t Cursor::i64(uint32_t field) const {
+  int64_t v;
+  std::memcpy(&v, check(uint64_t(at_) + field, 8), 8);
+  return v;
+}
+
+std::string_view Cursor::str(uint32_t field) const {
+  const uint32_t len = u32(field + 4);
+  return { check(u32(field), len), len };
+}
+
+uint32_t Cursor::count(uint32_t field) const { return u32(field + 4); }
+
+Cursor Cursor::item(uint32_t field, uint32_t k, uint32_t elem_size) const {
+  if (k >= count(field)) throw std::out_of_range("binary netlist: list index");
+  const uint64_t at = u32(field) + uint64_t(k) * elem_size;
+  check(at, elem_size);
+  return { rec_, size_, uint32_t(at) };
+}
+
+LogicVector ExprView::constant() const {
+  LogicVector v(c_.u32(4));
+  const Cursor words = c_.at(c_.u32(8));
+  const uint32_t n = uint32_t(v.num_words());
+  for (uint32_t i = 0; i < v.width(); ++i) {
+    const uint64_t a = uint64_t(words.i64((i / 64) * 8)) >> (i % 64) & 1;
+    const uint64_t b = uint64_t(words.i64((n + i / 64) * 8)) >> (i % 64) & 1;
+    v.set_bit(i, b ? (a ? 'x' : 'z') : (a ? '1' : '0'));
+  }
+  return v;
+}
+
+Expr ExprView::to_expr() const {
+  switch (kind()) {
+    case ExprKind::Identifier: return Identifier{ std::string(name()) };
+    case ExprKind::Indexed: return IdentifierIndexed{ std::string(name()), number(index()) };
+    case ExprKind::Sliced: return IdentifierSliced{ std::string(name()), Range{ number(msb()), number(lsb()) } };
+    case ExprKind::Concat: {
+      auto c = std::make_shared<Concatenation>();
+      c->elements.reserve(size());
+      for (uint32_t k = 0; k < size(); ++k) c->elements.push_back(element(k).to_expr());
+      return c;
+    }
+    case ExprKind::Constant: return Constant{ constant(), sized() };
+  }
+  throw std::runtime_error("binary netlist: unknown expression kind " + std::to_string(uint32_t(kind())));
+}
+
+Module ModuleView::to_module() const {
+  Module m;
+  m.module_name = name();
+  for (uint32_t k = 0; k < num_ports(); ++k) m.port_list.emplace_back(port(k));
+  for (uint32_t k = 0; k < num_parameters(); ++k) {
+    const ParamView p = parameter(k);
+    Parameter& q = m.parameters.emplace_back();
+    q.name = p.name();
+    q.expr = ParamExpr::parse(p.expr());
+    q.value = p.value();
+    q.local = p.local();
+  }
+  for (uint32_t k = 0; k < num_declarations(); ++k) {
+    const DeclView d = declaration(k);
+    NetDeclaration n;
+    for (uint32_t i = 0; i < d.num_names(); ++i) n.names.emplace_back(d.name(i));
+    if (!n.names.empty()) n.net_name = n.names.front();
+    if (d.has_range()) n.range = Range{ number(d.msb()), number(d.lsb()) };
+    if (!d.msb_expr().empty())
+      n.range_expr = std::make_shared<const ParamRange>(ParamRange{ ParamExpr::parse(d.msb_expr()), ParamExpr::parse(d.lsb_expr()) });
+    switch (d.kind()) {
+      case DeclKind::Input: static_cast<NetDeclaration&>(m.input_declarations.emplace_back()) = std::move(n); break;
+      case DeclKind::Output: static_cast<NetDeclaration&>(m.output_declarations.emplace_back()) = std::move(n); break;
+      case DeclKind::Inout: static_cast<NetDeclaration&>(m.inout_declarations.emplace_back()) = std::move(n); break;
+      case DeclKind::Net: n.type = d.type(); m.net_declarations.push_back(std::move(n)); break;
+    }
+  }
+  for (uint32_t k = 0; k < num_assigns(); ++k) {
+    const AssignView a = assign(k);
+    ContinuousAssign& ca = m.assignments.emplace_back();
+    for (uint32_t i = 0; i < a.size(); ++i) ca.assignments.emplace_back(a.lhs(i).to_expr(), a.rhs(i).to_expr());
+  }
+  m.module_instances.reserve(num_instances());
+  for (uint32_t k = 0; k < num_instances(); ++k) {
+    const InstanceView v = instance(k);
+    ModuleInstance& inst = m.module_instances.emplace_back();
+    inst.module_name = v.master();
+    inst.instance_name = v.name();
+    for (uint32_t i = 0; i < v.num_positional(); ++i) inst.ports_pos.push_back(v.positional(i).to_expr());
+    for (uint32_t i = 0; i < v.num_named(); ++i) inst.ports_named.emplace(v.pin(i), v.named(i).to_expr());
+    if (!v.has_params()) continue;
+    auto p = std::make_shared<ParamOverrides>();
+    for (uint32_t i = 0; i < v.num_positional_params(); ++i) p->positional.push_back(ParamExpr::parse(v.positional_param(i)));
+    for (uint32_t i = 0; i < v.num_named_params(); ++i)
+      p->named.emplace_back(std::string(v.param_name(i)), ParamExpr::parse(v.param_expr(i)));
+    inst.params = std::move(p);
+  }
+  for (uint32_t k = 0; k < num_gates(); ++k) {
+    const GateView g = gate(k);
+    if (size_t(g.type()) >= kNumGateTypes) throw std::runtime_error("binary netlist: unknown gate type");
+    GateTable& gt = m.gates[size_t(g.type())];
+    gt.names.emplace_back(g.name());
+    for (uint32_t i = 0; i < g.num_terminals(); ++i) gt.terminals.push_back(g.terminal(i).to_expr());
+    gt.ends.push_back(uint32_t(gt.terminals.size()));
+    gt.spans.emplace_back();
+  }
+  return m;
+}
+
+NetlistView::NetlistView(std::string_view bytes) : bytes_(bytes) {
+  if (bytes.size() < 24 || std::memcmp(bytes.data(), kMagic, 4) || std::memcmp(bytes.data() + bytes.size() - 4, kMagic, 4))
+    throw std::runtime_error("binary netlist: bad header or trailer");
+  uint64_t index_at;
+  uint32_t count;
+  std::memcpy(&index_at, bytes.data() + bytes.size() - 16, 8);
+  std::memcpy(&count, bytes.data() + bytes.size() - 8, 4);
+  if (index_at < 8 || index_at + uint64_t(count) * 8 != bytes.size() - 16)
+    throw std::runtime_error("binary netlist: index does not fit the buffer");
+  index_ = bytes.data() + index_at;
+  count_ = count;
+}
+
+ModuleView NetlistView::module(size_t i) const {
+  if (i >= count_) throw std::out_of_range("binary netlist: module index");
+  uint64_t at;
+  std::memcpy(&at, index_ + i * 8, 8);
+  const uint64_t end = uint64_t(index_ - bytes_.data());
+  uint32_t size = 0;
+  if (at + 64 <= end) std::memcpy(&size, bytes_.data() + at, 4);
+  if (size < 64 || at + size > end) throw std::runtime_error("binary netlist: record " + std::to_string(i) + " does not fit the buffer");
+  return ModuleView(Cursor(bytes_.data() + at, size, 0));
+}
+
+Netlist NetlistView::to_netlist() const {
+  Netlist nl;
+  nl.modules.reserve(count_);
+  for (size_t i = 0; i < count_; ++i) nl.modules.push_back(module(i).to_module());
+  return nl;
+}
+
+} // namespace binary
+
+} // namespace verilog
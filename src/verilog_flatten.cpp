@@ -0,0 +1,635 @@
+#include "verilog_flatten.hpp"
+#include "verilog_connectivity.hpp"
+#include "verilog_parallel.hpp"
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace verilog {
+
+namespace {
+
+constexpr uint32_t kLeaf = ~uint32_t(0);
+
+bool is_stub(const Module& m) { return m.module_instances.empty() && m.assignments.empty() && m.num_gates() == 0; }
+
+// Instantiation tree below the top, over definitions (first definition of a
+// name wins).
+struct Hierarchy {
+  std::vector<const Module*> mods;
+  std::unordered_map<std::string_view, uint32_t> by_name;
+  std::vector<std::vector<uint32_t>> child;   // per module, per instance: expanded module, or kLeaf
+  std::vector<uint32_t> reachable;            // expanded modules below (and including) the top
+  uint32_t top = kLeaf;
+};
+
+Hierarchy analyse(std::vector<const Module*> mods, const std::string& top, unsigned threads) {
+  Hierarchy h;
+  h.mods = std::move(mods);
+  const size_t n = h.mods.size();
+  for (uint32_t i = 0; i < n; ++i) h.by_name.emplace(h.mods[i]->module_name, i);
+
+  h.child.resize(n);
+  parallel::parallel_for(n, [&](size_t i) {
+    const auto& insts = h.mods[i]->module_instances;
+    h.child[i].resize(insts.size(), kLeaf);
+    for (size_t k = 0; k < insts.size(); ++k) {
+      auto it = h.by_name.find(insts[k].module_name);
+      if (it != h.by_name.end() && !is_stub(*h.mods[it->second])) h.child[i][k] = it->second;
+    }
+  }, threads, 16);
+
+  if (!top.empty()) {
+    auto it = h.by_name.find(top);
+    if (it == h.by_name.end()) throw std::runtime_error("top module not found: " + top);
+    h.top = it->second;
+  } else {
+    std::unordered_set<std::string_view> used;
+    for (const Module* m : h.mods)
+      for (const auto& inst : m->module_instances) used.insert(inst.module_name);
+    for (size_t i = n; i-- > 0;)
+      if (!used.count(h.mods[i]->module_name)) { h.top = uint32_t(i); break; }
+    if (h.top == kLeaf) {
+      if (n == 0) throw std::runtime_error("netlist has no modules");
+      h.top = uint32_t(n - 1);   // everything is instantiated: the cycle check below reports it
+    }
+  }
+
+  // Depth-first with on-stack marks: finds cycles and the reachable set.
+  std::vector<uint8_t> state(n, 0);   // 0 unseen, 1 on the stack, 2 done
+  std::vector<std::pair<uint32_t, size_t>> stack{ { h.top, 0 } };
+  state[h.top] = 1;
+  while (!stack.empty()) {
+    const uint32_t m = stack.back().first;
+    const size_t k = stack.back().second++;
+    if (k == h.child[m].size()) {
+      state[m] = 2;
+      h.reachable.push_back(m);
+      stack.pop_back();
+      continue;
+    }
+    const uint32_t c = h.child[m][k];
+    if (c == kLeaf || state[c] == 2) continue;
+    if (state[c] == 1) throw std::runtime_error("instantiation cycle through module " + h.mods[c]->module_name);
+    state[c] = 1;
+    stack.emplace_back(c, 0);
+  }
+  return h;
+}
+
+std::vector<const Module*> pointers(const Netlist& nl) {
+  std::vector<const Module*> v;
+  v.reserve(nl.modules.size());
+  for (const auto& m : nl.modules) v.push_back(&m);
+  return v;
+}
+
+// Appends "<sep>name" (just "name" at the top) and returns the old length.
+size_t push_path(std::string& path, char sep, std::string_view name) {
+  const size_t old = path.size();
+  if (old) path += sep;
+  path += name;
+  return old;
+}
+
+void walk_leaves(const Hierarchy& h, uint32_t m, std::string& path, char sep,
+                 const std::function<void(std::string_view, const ModuleInstance&)>& visit) {
+  const auto& insts = h.mods[m]->module_instances;
+  for (size_t k = 0; k < insts.size(); ++k) {
+    if (h.child[m][k] != kLeaf) continue;
+    const size_t old = push_path(path, sep, insts[k].instance_name);
+    visit(path, insts[k]);
+    path.resize(old);
+  }
+  for (size_t k = 0; k < insts.size(); ++k) {
+    if (h.child[m][k] == kLeaf) continue;
+    const size_t old = push_path(path, sep, insts[k].instance_name);
+    walk_leaves(h, h.child[m][k], path, sep, visit);
+    path.resize(old);
+  }
+}
+
+// ---------- flatten ----------
+
+struct FlatBus {
+  std::string name;
+  int64_t start = 0, end = 0;
+  bool vector = false;
+};
+
+// A flat net bit: a bus of some piece (or of the top) and the offset in its
+// declared order. bus == nullptr: not bound yet.
+struct Bit {
+  const FlatBus* bus = nullptr;
+  uint32_t off = 0;
+};
+
+// Per definition, shared by every instance path.
+struct Def {
+  std::unique_ptr<ModuleGraph> g;
+  std::vector<std::vector<NetId>> port_bits;   // per port, MSB first
+};
+
+// Output of one unit of work; pieces are concatenated in order.
+struct Piece {
+  std::deque<FlatBus> buses;   // stable addresses: child bindings point into it
+  std::vector<NetDeclaration> wires;
+  std::vector<ContinuousAssign> assigns;
+  std::vector<ModuleInstance> leaves;
+  std::array<GateTable, kNumGateTypes> gates;
+};
+
+// Bit and part selects reuse a decoded copy for the usual small indices.
+Number number(int64_t v) {
+  static const std::vector<Number> small = [] {
+    std::vector<Number> t;
+    for (int i = 0; i < 1024; ++i) t.push_back(Number::parse(std::to_string(i)));
+    return t;
+  }();
+  return v >= 0 && v < int64_t(small.size()) ? small[size_t(v)] : Number::parse(std::to_string(v));
+}
+
+Expr select(const FlatBus& b, uint32_t first, uint32_t last) {
+  if (!b.vector) return Identifier{ b.name };
+  const uint32_t width = uint32_t((b.start >= b.end ? b.start - b.end : b.end - b.start) + 1);
+  if (first == 0 && last == width - 1) return Identifier{ b.name };
+  auto index = [&](uint32_t off) { return b.start >= b.end ? b.start - int64_t(off) : b.start + int64_t(off); };
+  if (first == last) return IdentifierIndexed{ b.name, number(index(first)) };
+  return IdentifierSliced{ b.name, Range{ number(index(first)), number(index(last)) } };
+}
+
+// Bits (MSB first) back to an expression: runs of ascending offsets on one
+// bus become a name, a bit or a part select; several runs a concatenation.
+Expr pack(const std::vector<Bit>& bits) {
+  std::vector<Expr> parts;
+  for (size_t i = 0; i < bits.size();) {
+    size_t j = i + 1;
+    while (j < bits.size() && bits[j].bus == bits[i].bus && bits[j].off == bits[j - 1].off + 1) ++j;
+    parts.push_back(select(*bits[i].bus, bits[i].off, bits[j - 1].off));
+    i = j;
+  }
+  if (parts.size() == 1) return std::move(parts.front());
+  auto c = std::make_shared<Concatenation>();
+  c->elements = std::move(parts);
+  return c;
+}
+
+bool has_constant(const Expr& e) {
+  if (std::holds_alternative<Constant>(e)) return true;
+  if (auto c = std::get_if<std::shared_ptr<Concatenation>>(&e))
+    for (const auto& el : (*c)->elements) if (has_constant(el)) return true;
+  return false;
+}
+
+class Flattener {
+public:
+  Flattener(const Netlist& nl, const Hierarchy& h, const FlattenOptions& opts)
+    : h_(h), sep_(opts.separator), ifaces_(nl), defs_(nl.modules.size()) {
+    parallel::parallel_for(h.reachable.size(), [&](size_t r) {
+      const uint32_t m = h.reachable[r];
+      Def& d = defs_[m];
+      d.g = std::make_unique<ModuleGraph>(*h.mods[m], ifaces_);
+      const auto& ports = h.mods[m]->port_list;
+      d.port_bits.resize(ports.size());
+      for (size_t p = 0; p < ports.size(); ++p) d.g->expr_bits(Identifier{ ports[p] }, d.port_bits[p]);
+    }, opts.threads);
+  }
+
+  // The module's own part at `path`: fresh buses for every bit the binding
+  // leaves open, then its assigns and leaf instances.
+  void local(uint32_t m, const std::string& path, std::vector<Bit>& bind, Piece& out) const {
+    const Module& mod = *h_.mods[m];
+    const ModuleGraph& g = *defs_[m].g;
+    for (uint32_t b = 0; b < g.num_buses(); ++b) {
+      const ModuleGraph::Bus& bus = g.bus(b);
+      const uint32_t width = uint32_t((bus.start >= bus.end ? bus.start - bus.end : bus.end - bus.start) + 1);
+      bool open = false;
+      for (uint32_t k = 0; k < width && !open; ++k) open = !bind[bus.first + k].bus;
+      if (!open) continue;
+      FlatBus& fb = out.buses.emplace_back();
+      fb.name = path;
+      push_path(fb.name, sep_, bus.name);
+      fb.start = bus.start;
+      fb.end = bus.end;
+      fb.vector = bus.vector;
+      if (!path.empty()) {
+        NetDeclaration d;
+        d.net_name = fb.name;
+        if (fb.vector) d.range = Range{ number(fb.start), number(fb.end) };
+        d.names.push_back(fb.name);
+        out.wires.push_back(std::move(d));
+      }
+      for (uint32_t k = 0; k < width; ++k)
+        if (!bind[bus.first + k].bus) bind[bus.first + k] = Bit{ &fb, k };
+    }
+
+    std::vector<NetId> ids;
+    std::vector<Bit> bits;
+    // Constants are copied; a concatenation holding one is rebuilt element
+    // by element, since bits drop the constant positions.
+    auto rewrite = [&](auto& self, const Expr& e) -> Expr {
+      if (std::holds_alternative<Constant>(e)) return e;
+      if (has_constant(e)) {
+        auto c = std::make_shared<Concatenation>();
+        for (const auto& el : std::get<std::shared_ptr<Concatenation>>(e)->elements) c->elements.push_back(self(self, el));
+        return c;
+      }
+      ids.clear();
+      bits.clear();
+      g.expr_bits(e, ids);
+      for (NetId id : ids) if (id != kNoNet) bits.push_back(bind[id]);
+      return pack(bits);
+    };
+
+    for (const auto& ca : mod.assignments) {
+      ContinuousAssign flat;
+      flat.span = ca.span;
+      flat.assignments.reserve(ca.assignments.size());
+      for (const auto& [lhs, rhs] : ca.assignments) flat.assignments.emplace_back(rewrite(rewrite, lhs), rewrite(rewrite, rhs));
+      out.assigns.push_back(std::move(flat));
+    }
+
+    std::string name = path;
+    for (size_t t = 0; t < kNumGateTypes; ++t) {
+      const GateTable& gt = mod.gates[t];
+      GateTable& flat = out.gates[t];
+      for (size_t i = 0; i < gt.size(); ++i) {
+        if (gt.names[i].empty()) {
+          flat.names.emplace_back();
+        } else {
+          const size_t old = push_path(name, sep_, gt.names[i]);
+          flat.names.push_back(name);
+          name.resize(old);
+        }
+        for (const auto& e : gt.terminals_of(i)) flat.terminals.push_back(rewrite(rewrite, e));
+        flat.ends.push_back(uint32_t(flat.terminals.size()));
+        flat.spans.push_back(gt.spans[i]);
+      }
+    }
+
+    // Leaf connections come straight from the graph: an instance's pins are
+    // grouped by connection in order, each group MSB first. An expanded
+    // instance's ports tied to a constant get an assign to the port's flat
+    // net, which the child's part declares.
+    for (size_t k = 0; k < mod.module_instances.size(); ++k) {
+      if (h_.child[m][k] != kLeaf) {
+        tie_constants(mod.module_instances[k], *h_.mods[h_.child[m][k]], path, out);
+        continue;
+      }
+      const ModuleInstance& inst = mod.module_instances[k];
+      ModuleInstance& leaf = out.leaves.emplace_back();
+      leaf.module_name = inst.module_name;
+      leaf.span = inst.span;
+      const size_t old = push_path(name, sep_, inst.instance_name);
+      leaf.instance_name = name;
+      name.resize(old);
+
+      const auto pins = g.node_pins(uint32_t(mod.port_list.size() + k));
+      size_t p = 0;
+      auto conn = [&](uint32_t c, const Expr& e) {
+        bits.clear();
+        while (p < pins.size() && pins[p].conn == c) bits.push_back(bind[pins[p++].net]);
+        if (has_constant(e)) {
+          while (p < pins.size() && pins[p].conn == c) ++p;
+          return rewrite(rewrite, e);
+        }
+        return bits.empty() ? rewrite(rewrite, e) : pack(bits);
+      };
+      uint32_t c = 0;
+      leaf.ports_pos.reserve(inst.ports_pos.size());
+      for (const auto& e : inst.ports_pos) leaf.ports_pos.push_back(conn(c++, e));
+      for (const auto& [pin, e] : inst.ports_named) leaf.ports_named.emplace_hint(leaf.ports_named.end(), pin, conn(c++, e));
+    }
+  }
+
+  void tie_constants(const ModuleInstance& inst, const Module& child, const std::string& path, Piece& out) const {
+    auto tie = [&](const std::string& port, const Expr& e) {
+      if (!std::holds_alternative<Constant>(e)) return;
+      std::string name = path;
+      push_path(name, sep_, inst.instance_name);
+      push_path(name, sep_, port);
+      ContinuousAssign& ca = out.assigns.emplace_back();
+      ca.span = inst.span;
+      ca.assignments.emplace_back(Identifier{ std::move(name) }, e);
+    };
+    for (size_t p = 0; p < inst.ports_pos.size() && p < child.port_list.size(); ++p) tie(child.port_list[p], inst.ports_pos[p]);
+    for (const auto& [pin, e] : inst.ports_named)
+      if (std::find(child.port_list.begin(), child.port_list.end(), pin) != child.port_list.end()) tie(pin, e);
+  }
+
+  // Binding of instance k's master: its port bits take the parent's flat bits.
+  std::vector<Bit> bind_child(uint32_t m, size_t k, const std::vector<Bit>& bind) const {
+    const ModuleGraph& g = *defs_[m].g;
+    const Def& c = defs_[h_.child[m][k]];
+    std::vector<Bit> cb(c.g->num_nets());
+    const uint32_t node = uint32_t(h_.mods[m]->port_list.size() + k);   // ports come first, then instances
+    for (const auto& pin : g.node_pins(node)) {
+      if (pin.port == ModuleInterface::npos || pin.port >= c.port_bits.size()) continue;
+      const auto& pb = c.port_bits[pin.port];
+      if (pin.bit < pb.size() && pb[pb.size() - 1 - pin.bit] != kNoNet) cb[pb[pb.size() - 1 - pin.bit]] = bind[pin.net];
+    }
+    return cb;
+  }
+
+  void whole(uint32_t m, std::string& path, std::vector<Bit>& bind, Piece& out) const {
+    local(m, path, bind, out);
+    const auto& insts = h_.mods[m]->module_instances;
+    for (size_t k = 0; k < insts.size(); ++k) {
+      if (h_.child[m][k] == kLeaf) continue;
+      std::vector<Bit> cb = bind_child(m, k, bind);
+      const size_t old = push_path(path, sep_, insts[k].instance_name);
+      whole(h_.child[m][k], path, cb, out);
+      path.resize(old);
+    }
+  }
+
+  size_t num_nets(uint32_t m) const { return defs_[m].g->num_nets(); }
+
+private:
+  const Hierarchy& h_;
+  char sep_;
+  InterfaceTable ifaces_;
+  std::vector<Def> defs_;
+};
+
+template<typename T>
+void append(std::vector<T>& into, std::vector<T>&& from) {
+  if (into.empty()) { into = std::move(from); return; }
+  into.insert(into.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+}
+
+void append(GateTable& into, GateTable&& from) {
+  const uint32_t base = uint32_t(into.terminals.size());
+  append(into.names, std::move(from.names));
+  append(into.terminals, std::move(from.terminals));
+  append(into.spans, std::move(from.spans));
+  for (uint32_t e : from.ends) into.ends.push_back(base + e);
+}
+
+void unshare(Module& m) {
+  auto fix = [](Expr& e) { if (std::holds_alternative<std::shared_ptr<Concatenation>>(e)) e = clone_expr(e); };
+  for (auto& gt : m.gates)
+    for (auto& e : gt.terminals) fix(e);
+  for (auto& inst : m.module_instances) {
+    for (auto& e : inst.ports_pos) fix(e);
+    for (auto& [pin, e] : inst.ports_named) fix(e);
+  }
+  for (auto& ca : m.assignments)
+    for (auto& [lhs, rhs] : ca.assignments) { fix(lhs); fix(rhs); }
+}
+
+} // namespace
+
+void for_each_leaf(const Netlist& nl, const FlattenOptions& opts,
+                   const std::function<void(std::string_view, const ModuleInstance&)>& visit) {
+  const Hierarchy h = analyse(pointers(nl), opts.top, opts.threads);
+  std::string path;
+  walk_leaves(h, h.top, path, opts.separator, visit);
+}
+
+Netlist flatten(const Netlist& nl, const FlattenOptions& opts) {
+  const Hierarchy h = analyse(pointers(nl), opts.top, opts.threads);
+  const Flattener f(nl, h, opts);
+  const unsigned threads = opts.threads ? opts.threads : parallel::default_threads();
+
+  // Split the tree into independent subtrees: expand the top (and then the
+  // next level, ...) serially until there are enough to keep every thread
+  // busy. An expanded item keeps its local part; its sub-instances follow it
+  // as new items, so concatenating items in order gives the serial order.
+  struct Item {
+    uint32_t m;
+    std::string path;
+    std::vector<Bit> bind;
+    std::unique_ptr<Piece> piece = std::make_unique<Piece>();
+    bool expanded = false;
+  };
+  std::vector<Item> items;
+  items.push_back(Item{ h.top, std::string(), std::vector<Bit>(f.num_nets(h.top)) });
+  auto has_children = [&](uint32_t m) {
+    for (uint32_t c : h.child[m]) if (c != kLeaf) return true;
+    return false;
+  };
+  while (threads > 1 && items.size() < size_t(threads) * 4) {
+    std::vector<Item> next;
+    bool grew = false;
+    for (auto& it : items) {
+      if (it.expanded || !has_children(it.m)) { next.push_back(std::move(it)); continue; }
+      f.local(it.m, it.path, it.bind, *it.piece);
+      it.expanded = true;
+      const auto& insts = h.mods[it.m]->module_instances;
+      const uint32_t m = it.m;
+      const std::vector<Bit>& bind = it.bind;
+      const std::string& path = it.path;
+      std::vector<Item> kids;
+      for (size_t k = 0; k < insts.size(); ++k) {
+        if (h.child[m][k] == kLeaf) continue;
+        Item kid{ h.child[m][k], path, f.bind_child(m, k, bind) };
+        push_path(kid.path, opts.separator, insts[k].instance_name);
+        kids.push_back(std::move(kid));
+      }
+      next.push_back(std::move(it));
+      append(next, std::move(kids));
+      grew = true;
+    }
+    items = std::move(next);
+    if (!grew) break;
+  }
+
+  parallel::parallel_for(items.size(), [&](size_t i) {
+    Item& it = items[i];
+    if (!it.expanded) f.whole(it.m, it.path, it.bind, *it.piece);
+  }, threads);
+
+  const Module& top = *h.mods[h.top];
+  Module flat;
+  flat.module_name = top.module_name;
+  flat.span = top.span;
+  flat.port_list = top.port_list;
+  flat.input_declarations = top.input_declarations;
+  flat.output_declarations = top.output_declarations;
+  flat.inout_declarations = top.inout_declarations;
+  flat.net_declarations = top.net_declarations;
+  // The pieces in item order, each moved into place in parallel.
+  parallel::ordered_append(flat.net_declarations, items.size(), [&](size_t i) -> auto& { return items[i].piece->wires; }, threads);
+  parallel::ordered_append(flat.assignments, items.size(), [&](size_t i) -> auto& { return items[i].piece->assigns; }, threads);
+  parallel::ordered_append(flat.module_instances, items.size(), [&](size_t i) -> auto& { return items[i].piece->leaves; }, threads);
+  for (auto& it : items)
+    for (size_t t = 0; t < kNumGateTypes; ++t) append(flat.gates[t], std::move(it.piece->gates[t]));
+  // Expressions built above still point at buses of the pieces; only names
+  // were copied out of them, so the pieces can go now.
+  items.clear();
+
+  Netlist out;
+  out.modules.push_back(std::move(flat));
+  out.lines = nl.lines;
+  // Stub definitions of the leaf cells used, so the result keeps their interfaces.
+  std::unordered_set<std::string_view> used;
+  for (const auto& inst : out.modules[0].module_instances) used.insert(inst.module_name);
+  for (uint32_t i = 0; i < h.mods.size(); ++i) {
+    const Module& m = *h.mods[i];
+    auto it = h.by_name.find(m.module_name);
+    if (it->second == i && is_stub(m) && used.count(m.module_name) && i != h.top) out.modules.push_back(m);
+  }
+  return out;
+}
+
+// ---------- uniquify ----------
+
+Module& UniqueNetlist::edit(size_t i) {
+  UniqueModule& um = modules.at(i);
+  if (um.body.use_count() > 1) {
+    auto copy = std::make_shared<Module>(*um.body);
+    unshare(*copy);
+    um.body = std::move(copy);
+  }
+  // Bodies are only ever created non-const (uniquify, above), so this is sound.
+  return const_cast<Module&>(*um.body);
+}
+
+Netlist UniqueNetlist::to_netlist(unsigned threads) const {
+  Netlist nl;
+  nl.lines = lines;
+  nl.modules.resize(modules.size());
+  parallel::parallel_for(modules.size(), [&](size_t i) {
+    const UniqueModule& um = modules[i];
+    Module m = *um.body;
+    m.module_name = um.name;
+    for (size_t k = 0; k < m.module_instances.size() && k < um.children.size(); ++k)
+      if (um.children[k] != UniqueModule::npos) m.module_instances[k].module_name = modules[um.children[k]].name;
+    nl.modules[i] = std::move(m);
+  }, threads, 16);
+  return nl;
+}
+
+UniqueNetlist uniquify(Netlist nl, const std::string& top, unsigned threads) {
+  if (threads == 0) threads = parallel::default_threads();
+  std::vector<std::shared_ptr<const Module>> bodies;
+  std::vector<const Module*> mods;
+  bodies.reserve(nl.modules.size());
+  for (auto& m : nl.modules) {
+    bodies.push_back(std::make_shared<Module>(std::move(m)));
+    mods.push_back(bodies.back().get());
+  }
+  const Hierarchy h = analyse(std::move(mods), top, threads);
+  const size_t n = h.mods.size();
+  constexpr uint32_t npos = UniqueModule::npos;
+
+  // Copies in the subtree of each definition, itself included (children come
+  // first in h.reachable), plus one entry per stub used.
+  std::vector<uint64_t> copies(n, 0);
+  for (uint32_t m : h.reachable) {
+    uint64_t c = 1;
+    for (uint32_t ch : h.child[m]) if (ch != kLeaf) c += copies[ch];
+    copies[m] = c;
+  }
+  uint64_t total = copies[h.top];
+  std::vector<bool> used(n, false);
+  for (uint32_t m : h.reachable)
+    for (size_t k = 0; k < h.child[m].size(); ++k) {
+      if (h.child[m][k] != kLeaf) continue;
+      auto it = h.by_name.find(h.mods[m]->module_instances[k].module_name);
+      if (it != h.by_name.end() && !used[it->second]) { used[it->second] = true; ++total; }
+    }
+  if (total >= npos) throw std::runtime_error("uniquify: more than 2^32-1 module copies");
+
+  UniqueNetlist out;
+  out.lines = std::move(nl.lines);
+  out.modules.resize(size_t(total));
+  std::vector<uint32_t> def(static_cast<size_t>(total));   // definition of each entry
+
+  // Each definition is walked once, in depth-first order: its first copy and
+  // the stubs it is first to use get their entries there. A later copy of a
+  // subtree only reserves its copies[] entries, filled below.
+  std::vector<uint32_t> first(n, npos), stub_slot(n, npos);
+  std::vector<std::pair<uint32_t, uint32_t>> jobs;   // (entry, definition)
+  uint32_t next = 0;
+  auto walk = [&](auto& self, uint32_t m) -> void {
+    const uint32_t idx = first[m] = next++;
+    def[idx] = m;
+    out.modules[idx].body = bodies[m];
+    const auto& insts = h.mods[m]->module_instances;
+    std::vector<uint32_t> children(insts.size(), npos);
+    for (size_t k = 0; k < insts.size(); ++k) {
+      const uint32_t c = h.child[m][k];
+      if (c != kLeaf) {
+        children[k] = next;
+        if (first[c] == npos) { self(self, c); continue; }
+        jobs.emplace_back(next, c);
+        next += uint32_t(copies[c]);
+        continue;
+      }
+      auto it = h.by_name.find(insts[k].module_name);
+      if (it == h.by_name.end()) continue;   // undefined cell
+      uint32_t& slot = stub_slot[it->second];
+      if (slot == npos) {
+        slot = next++;
+        def[slot] = it->second;
+        out.modules[slot].body = bodies[it->second];
+      }
+      children[k] = slot;
+    }
+    out.modules[idx].children = std::move(children);
+  };
+  walk(walk, h.top);
+
+  // A later copy has the first one's shape: stubs where the first copy points,
+  // expanded children at fixed offsets after it. Big copies are split a level
+  // at a time until the jobs balance; the rest expand in parallel.
+  auto place = [&](uint32_t m, uint32_t idx, auto&& child) {
+    def[idx] = m;
+    UniqueModule& um = out.modules[idx];
+    um.body = bodies[m];
+    um.children = out.modules[first[m]].children;
+    uint32_t at = idx + 1;
+    for (size_t k = 0; k < um.children.size(); ++k) {
+      const uint32_t c = h.child[m][k];
+      if (c == kLeaf) continue;
+      um.children[k] = at;
+      child(c, at);
+      at += uint32_t(copies[c]);
+    }
+  };
+  const uint64_t big = std::max<uint64_t>(64, total / (uint64_t(threads) * 8));
+  for (size_t j = 0; j < jobs.size(); ++j) {
+    const auto [idx, m] = jobs[j];
+    if (threads <= 1 || copies[m] <= big) continue;
+    jobs[j].second = npos;
+    place(m, idx, [&](uint32_t c, uint32_t at) { jobs.emplace_back(at, c); });
+  }
+  parallel::parallel_for(jobs.size(), [&](size_t j) {
+    auto expand = [&](auto& self, uint32_t m, uint32_t idx) -> void {
+      place(m, idx, [&](uint32_t c, uint32_t at) { self(self, c, at); });
+    };
+    if (jobs[j].second != npos) expand(expand, jobs[j].second, jobs[j].first);
+  }, threads);
+
+  // Names, per definition in entry order: "<name>", then "<name>_<k>" from
+  // k = copy number on, skipping names taken by a definition. A copy name is
+  // the base name, "_" and digits, so definitions cannot clash with each other.
+  std::vector<uint32_t> start(n + 1, 0), order(static_cast<size_t>(total));
+  for (uint32_t d : def) ++start[d + 1];
+  for (size_t m = 0; m < n; ++m) start[m + 1] += start[m];
+  {
+    std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+    for (uint32_t i = 0; i < total; ++i) order[fill[def[i]]++] = i;
+  }
+  std::unordered_set<std::string_view> taken;
+  for (const Module* m : h.mods) taken.insert(m->module_name);
+  parallel::parallel_for(n, [&](size_t m) {
+    const std::string& name = h.mods[m]->module_name;
+    uint32_t last = 0;
+    for (uint32_t u = 0; start[m] + u < start[m + 1]; ++u) {
+      UniqueModule& um = out.modules[order[start[m] + u]];
+      if (u == 0) { um.name = name; continue; }
+      uint32_t k = std::max(u, last + 1);
+      std::string cand = name + "_" + std::to_string(k);
+      while (taken.count(cand)) cand = name + "_" + std::to_string(++k);
+      um.name = std::move(cand);
+      last = k;
+    }
+  }, threads, 16);
+  return out;
+}
+
+} // namespace verilog
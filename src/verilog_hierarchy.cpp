@@ -0,0 +1,366 @@
+#include "verilog_hierarchy.hpp"
+#include "verilog_parallel.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace verilog {
+
+bool wildcard_match(std::string_view pat, std::string_view s) {
+  size_t p = 0, i = 0, star = std::string_view::npos, mark = 0;
+  while (i < s.size()) {
+    if (p < pat.size() && (pat[p] == '?' || pat[p] == s[i])) { ++p; ++i; }
+    else if (p < pat.size() && pat[p] == '*') { star = p++; mark = i; }
+    else if (star != std::string_view::npos) { p = star + 1; i = ++mark; }
+    else return false;
+  }
+  while (p < pat.size() && pat[p] == '*') ++p;
+  return p == pat.size();
+}
+
+namespace {
+
+constexpr uint32_t npos = ~uint32_t(0);
+
+// Open-addressed table from names to row numbers. A slot packs the upper half
+// of the name's hash with row + 1 (0: empty), so a probe compares strings only
+// when 32 hash bits agree. Rows are inserted in order and the first of equal
+// names wins.
+class NameTable {
+public:
+  void reserve(size_t n) {
+    size_t cap = 8;
+    while (cap < 2 * n) cap *= 2;
+    slots_.assign(cap, 0);
+    mask_ = cap - 1;
+  }
+
+  template<typename NameOf>
+  void build(size_t n, NameOf name_of) {
+    reserve(n);
+    for (uint32_t i = 0; i < n; ++i) insert(i, name_of);
+  }
+
+  // Returns false (and changes nothing) if the name is already present.
+  template<typename NameOf>
+  bool insert(uint32_t row, NameOf name_of) {
+    const std::string_view name = name_of(row);
+    const uint64_t h = hash(name);
+    for (size_t s = h & mask_;; s = (s + 1) & mask_) {
+      if (!slots_[s]) { slots_[s] = (h >> 32 << 32) | (uint64_t(row) + 1); return true; }
+      if ((slots_[s] >> 32) == (h >> 32) && name_of(uint32_t(slots_[s]) - 1) == name) return false;
+    }
+  }
+
+  template<typename NameOf>
+  uint32_t find(std::string_view name, NameOf name_of) const {
+    if (slots_.empty()) return npos;
+    const uint64_t h = hash(name);
+    for (size_t s = h & mask_; slots_[s]; s = (s + 1) & mask_) {
+      if ((slots_[s] >> 32) == (h >> 32) && name_of(uint32_t(slots_[s]) - 1) == name) return uint32_t(slots_[s]) - 1;
+    }
+    return npos;
+  }
+
+private:
+  static uint64_t hash(std::string_view s) {
+    uint64_t h = std::hash<std::string_view>{}(s);
+    return h ^ (h >> 29) * 0x9e3779b97f4a7c15ull;   // spread into the tag half as well
+  }
+
+  std::vector<uint64_t> slots_;
+  size_t mask_ = 0;
+};
+
+// One defined module: its instances' masters and its name tables.
+struct Scope {
+  const Module* mod = nullptr;
+  std::vector<uint32_t> child;            // per instance: scope of the master, or npos for leaf cells
+  NameTable instances;
+  NameTable ports;                        // port_list, for pins of instances of this module
+  std::vector<std::string_view> nets;     // ports and declared names, each once
+  NameTable net_table;
+
+  std::string_view inst_name(uint32_t i) const { return mod->module_instances[i].instance_name; }
+};
+
+bool has_wildcard(std::string_view s) { return s.find_first_of("*?") != std::string_view::npos; }
+
+// Instance hops matched so far for the previous path of a batch.
+struct Walker {
+  struct Frame {
+    size_t end;                  // offset just past the segment in `prev`
+    const ModuleInstance* inst;
+    uint32_t scope;              // the master's scope, or npos
+  };
+  std::string_view prev;
+  std::vector<Frame> frames;
+};
+
+} // namespace
+
+struct HierarchyIndex::Impl {
+  HierarchyOptions opts;
+  std::vector<Scope> scopes;   // one per first definition of a name
+  uint32_t top = 0;
+
+  std::string_view strip_top(std::string_view path) const {
+    const char sep = opts.separator;
+    size_t b = 0;
+    while (b < path.size() && path[b] == sep) ++b;
+    const size_t e = std::min(path.find(sep, b), path.size());
+    const std::string_view first = path.substr(b, e - b);
+    const Scope& t = scopes[top];
+    if (first == t.mod->module_name && t.instances.find(first, [&](uint32_t i) { return t.inst_name(i); }) == npos)
+      return path.substr(e);
+    return path;
+  }
+
+  // Pin `name` of instance `inst` (whose master has scope `master`), as a view
+  // into the netlist or the cell table; empty if there is none.
+  std::string_view pin(const ModuleInstance& inst, uint32_t master, std::string_view name) const {
+    if (master != npos) {
+      const Scope& m = scopes[master];
+      const uint32_t p = m.ports.find(name, [&](uint32_t i) -> std::string_view { return m.mod->port_list[i]; });
+      return p == npos ? std::string_view() : std::string_view(m.mod->port_list[p]);
+    }
+    if (opts.cells) {
+      if (const ModuleInterface* mi = opts.cells->find(inst.module_name)) {
+        const uint32_t p = mi->find(name);
+        if (p != ModuleInterface::npos) return mi->ports[p];
+      }
+    }
+    auto it = inst.ports_named.find(std::string(name));
+    return it == inst.ports_named.end() ? std::string_view() : std::string_view(it->first);
+  }
+
+  std::string_view net(uint32_t scope, std::string_view name) const {
+    if (scope == npos) return {};
+    const Scope& s = scopes[scope];
+    const uint32_t n = s.net_table.find(name, [&](uint32_t i) { return s.nets[i]; });
+    return n == npos ? std::string_view() : s.nets[n];
+  }
+
+  std::optional<HierPath> walk(std::string_view path, Walker& w) const {
+    const char sep = opts.separator;
+    path = strip_top(path);
+
+    // Keep the hops this path shares, whole segments only, with the last one.
+    size_t lcp = 0;
+    const size_t lim = std::min(path.size(), w.prev.size());
+    while (lcp < lim && path[lcp] == w.prev[lcp]) ++lcp;
+    size_t keep = 0;
+    while (keep < w.frames.size() && w.frames[keep].end <= lcp &&
+           (w.frames[keep].end == path.size() || path[w.frames[keep].end] == sep))
+      ++keep;
+    w.frames.resize(keep);
+    w.prev = path;
+
+    size_t pos = keep ? w.frames.back().end : 0;
+    for (;;) {
+      while (pos < path.size() && path[pos] == sep) ++pos;
+      if (pos == path.size()) break;
+      const size_t end = std::min(path.find(sep, pos), path.size());
+      const std::string_view seg = path.substr(pos, end - pos);
+      const uint32_t cur = w.frames.empty() ? top : w.frames.back().scope;
+      if (cur != npos) {
+        const Scope& s = scopes[cur];
+        const uint32_t i = s.instances.find(seg, [&](uint32_t k) { return s.inst_name(k); });
+        if (i != npos) {
+          w.frames.push_back({ end, &s.mod->module_instances[i], s.child[i] });
+          pos = end;
+          continue;
+        }
+      }
+      // Not an instance: only the final segment may be a pin or a net.
+      size_t rest = end;
+      while (rest < path.size() && path[rest] == sep) ++rest;
+      if (rest != path.size()) return std::nullopt;
+      HierPath out = hops(w);
+      if (!w.frames.empty()) {
+        out.name = pin(*w.frames.back().inst, w.frames.back().scope, seg);
+        out.kind = PathKind::Pin;
+      }
+      if (out.name.empty()) {
+        out.name = net(cur, seg);
+        out.kind = PathKind::Net;
+      }
+      if (out.name.empty()) return std::nullopt;
+      return out;
+    }
+    return hops(w);
+  }
+
+  static HierPath hops(const Walker& w) {
+    HierPath out;
+    out.hops.reserve(w.frames.size());
+    for (const auto& f : w.frames) out.hops.push_back(f.inst);
+    return out;
+  }
+
+  // Matches segs[k..] below `scope`, the master of path.back() (or the top).
+  void glob(uint32_t scope, const std::vector<std::string_view>& segs, size_t k,
+            std::vector<const ModuleInstance*>& path, std::vector<HierPath>& out) const {
+    const std::string_view seg = segs[k];
+    const bool last = k + 1 == segs.size();
+    const bool wild = has_wildcard(seg);
+    auto emit = [&](PathKind kind, std::string_view name) {
+      out.push_back(HierPath{ path, kind, name });
+    };
+
+    size_t found = 0;
+    if (scope != npos) {
+      const Scope& s = scopes[scope];
+      auto visit = [&](uint32_t i) {
+        ++found;
+        path.push_back(&s.mod->module_instances[i]);
+        if (last) emit(PathKind::Instance, {});
+        else glob(s.child[i], segs, k + 1, path, out);
+        path.pop_back();
+      };
+      if (!wild) {
+        const uint32_t i = s.instances.find(seg, [&](uint32_t j) { return s.inst_name(j); });
+        if (i != npos) visit(i);
+      } else {
+        for (uint32_t i = 0; i < s.mod->module_instances.size(); ++i)
+          if (wildcard_match(seg, s.inst_name(i))) visit(i);
+      }
+    }
+    if (!last || (!wild && found)) return;
+
+    // Pins of the last instance, then nets of its master (or of the top).
+    if (!path.empty()) {
+      const ModuleInstance& inst = *path.back();
+      if (!wild) {
+        if (const std::string_view p = pin(inst, scope, seg); !p.empty()) { emit(PathKind::Pin, p); return; }
+      } else if (scope != npos) {
+        for (const auto& p : scopes[scope].mod->port_list)
+          if (wildcard_match(seg, p)) emit(PathKind::Pin, p);
+      } else if (const ModuleInterface* mi = opts.cells ? opts.cells->find(inst.module_name) : nullptr) {
+        for (const auto& p : mi->ports)
+          if (wildcard_match(seg, p)) emit(PathKind::Pin, p);
+      } else {
+        for (const auto& [p, e] : inst.ports_named)
+          if (wildcard_match(seg, p)) emit(PathKind::Pin, p);
+      }
+    }
+    if (scope == npos) return;
+    if (!wild) {
+      if (const std::string_view n = net(scope, seg); !n.empty()) emit(PathKind::Net, n);
+      return;
+    }
+    const Scope& s = scopes[scope];
+    for (std::string_view n : s.nets) {
+      const bool port = s.ports.find(n, [&](uint32_t i) -> std::string_view { return s.mod->port_list[i]; }) != npos;
+      if (wildcard_match(seg, n) && !(port && !path.empty())) emit(PathKind::Net, n);   // listed as pins already
+    }
+  }
+};
+
+HierarchyIndex::HierarchyIndex(const Netlist& nl, const HierarchyOptions& opts) : impl_(std::make_unique<Impl>()) {
+  Impl& im = *impl_;
+  im.opts = opts;
+
+  std::unordered_map<std::string_view, uint32_t> by_name;   // first definition wins
+  for (const auto& m : nl.modules) {
+    if (by_name.emplace(m.module_name, uint32_t(im.scopes.size())).second) im.scopes.emplace_back().mod = &m;
+  }
+  if (im.scopes.empty()) throw std::runtime_error("netlist has no modules");
+  if (!opts.top.empty()) {
+    auto it = by_name.find(opts.top);
+    if (it == by_name.end()) throw std::runtime_error("top module not found: " + opts.top);
+    im.top = it->second;
+  } else {
+    std::unordered_set<std::string_view> used;
+    for (const auto& m : nl.modules)
+      for (const auto& inst : m.module_instances) used.insert(inst.module_name);
+    im.top = uint32_t(im.scopes.size() - 1);
+    for (size_t i = im.scopes.size(); i-- > 0;)
+      if (!used.count(im.scopes[i].mod->module_name)) { im.top = uint32_t(i); break; }
+  }
+
+  parallel::parallel_for(im.scopes.size(), [&](size_t k) {
+    Scope& s = im.scopes[k];
+    const Module& m = *s.mod;
+    s.child.resize(m.module_instances.size());
+    for (size_t i = 0; i < m.module_instances.size(); ++i) {
+      auto it = by_name.find(m.module_instances[i].module_name);
+      s.child[i] = it == by_name.end() ? npos : it->second;
+    }
+    s.instances.build(m.module_instances.size(), [&](uint32_t i) { return s.inst_name(i); });
+    s.ports.build(m.port_list.size(), [&](uint32_t i) -> std::string_view { return m.port_list[i]; });
+
+    size_t total = m.port_list.size();
+    auto count = [&](const auto& decls) { for (const auto& d : decls) total += d.names.size(); };
+    count(m.input_declarations);
+    count(m.output_declarations);
+    count(m.inout_declarations);
+    count(m.net_declarations);
+    s.nets.reserve(total);
+    s.net_table.reserve(total);
+    auto add = [&](std::string_view name) {
+      s.nets.push_back(name);
+      if (!s.net_table.insert(uint32_t(s.nets.size() - 1), [&](uint32_t i) { return s.nets[i]; })) s.nets.pop_back();
+    };
+    for (const auto& p : m.port_list) add(p);
+    auto names = [&](const auto& decls) { for (const auto& d : decls) for (const auto& n : d.names) add(n); };
+    names(m.input_declarations);
+    names(m.output_declarations);
+    names(m.inout_declarations);
+    names(m.net_declarations);
+  }, opts.threads);
+}
+
+HierarchyIndex::~HierarchyIndex() = default;
+HierarchyIndex::HierarchyIndex(HierarchyIndex&&) noexcept = default;
+HierarchyIndex& HierarchyIndex::operator=(HierarchyIndex&&) noexcept = default;
+
+const Module& HierarchyIndex::top() const { return *impl_->scopes[impl_->top].mod; }
+
+std::optional<HierPath> HierarchyIndex::resolve(std::string_view path) const {
+  Walker w;
+  return impl_->walk(path, w);
+}
+
+std::vector<std::optional<HierPath>> HierarchyIndex::resolve(std::span<const std::string> paths) const {
+  // Sorting first would find more shared prefixes but costs as much as the
+  // lookups it saves; path lists come grouped by prefix often enough.
+  constexpr size_t kChunk = 1024;   // paths per worker task, each with its own prefix cache
+  std::vector<std::optional<HierPath>> out(paths.size());
+  parallel::parallel_for((paths.size() + kChunk - 1) / kChunk, [&](size_t c) {
+    Walker w;
+    for (size_t k = c * kChunk, e = std::min(paths.size(), k + kChunk); k < e; ++k) out[k] = impl_->walk(paths[k], w);
+  }, impl_->opts.threads);
+  return out;
+}
+
+std::vector<HierPath> HierarchyIndex::glob(std::string_view pattern) const {
+  const Impl& im = *impl_;
+  pattern = im.strip_top(pattern);
+  std::vector<std::string_view> segs;
+  for (size_t b = 0; b <= pattern.size();) {
+    const size_t e = std::min(pattern.find(im.opts.separator, b), pattern.size());
+    if (e > b) segs.push_back(pattern.substr(b, e - b));
+    b = e + 1;
+  }
+  std::vector<HierPath> out;
+  if (segs.empty()) { out.emplace_back(); return out; }
+  std::vector<const ModuleInstance*> path;
+  im.glob(im.top, segs, 0, path, out);
+  return out;
+}
+
+std::string HierarchyIndex::path_string(const HierPath& p) const {
+  std::string s;
+  for (const ModuleInstance* h : p.hops) {
+    if (!s.empty()) s += impl_->opts.separator;
+    s += h->instance_name;
+  }
+  if (p.kind != PathKind::Instance) {
+    if (!s.empty()) s += impl_->opts.separator;
+    s += p.name;
+  }
+  return s;
+}
+
+} // namespace verilog
@@ -0,0 +1,239 @@
+#include "verilog_lazy.hpp"
+#include "verilog_actions.hpp"
+#include "verilog_grammar.hpp"
+#include "verilog_parallel.hpp"
+#include "verilog_scan.hpp"
+#include "verilog_source.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VERILOG_LAZY_MMAP 1
+#endif
+
+namespace verilog {
+
+using scan::KeywordScanner;
+
+struct LazyNetlist::Impl {
+  std::string source;
+  std::string owned;        // from_string, or from_file without mmap
+  const char* map = nullptr;
+  size_t map_len = 0;
+  std::string_view text;
+
+  std::vector<ModuleOutline> outlines;
+  std::unordered_map<std::string_view, size_t> index;   // first definition wins
+  std::unique_ptr<std::mutex[]> parsing;   // not once_flag: a body that throws must stay retryable
+  std::unique_ptr<std::atomic<Module*>[]> bodies;
+  mutable std::once_flag lines_once;
+  mutable std::shared_ptr<const LineTable> lines;
+
+  ~Impl() {
+    if (bodies) for (size_t i = 0; i < outlines.size(); ++i) delete bodies[i].load();
+#ifdef VERILOG_LAZY_MMAP
+    if (map) ::munmap(const_cast<char*>(map), map_len);
+#endif
+  }
+
+  // Rethrows a PEGTL error from a parse that started at `offset`, with the
+  // position translated to the whole text.
+  [[noreturn]] void rethrow(const tao::pegtl::parse_error& e, size_t offset) const {
+    size_t line = 1, col = 1;
+    for (size_t i = 0; i < offset; ++i) {
+      if (text[i] == '\n') { ++line; col = 1; } else { ++col; }
+    }
+    if (!e.positions().empty()) {
+      const auto& pos = e.positions().front();
+      col = pos.line == 1 ? col + pos.column - 1 : pos.column;
+      line += pos.line - 1;
+    }
+    SourceLocation where;
+    where.line = uint32_t(line);
+    where.column = uint32_t(col);
+    throw parse_error(source + ":" + std::to_string(line) + ":" + std::to_string(col) + ": " + std::string(e.message()),
+                      source, where);
+  }
+
+  void scan() {
+    static const KeywordScanner find_module("module"), find_endmodule("endmodule");
+    const char* const begin = text.data();
+    const char* const end = begin + text.size();
+    const char* p = begin;
+    const char* counted = begin;   // newlines before here are in `line`
+    uint32_t line = 1;
+    for (;;) {
+      p = find_module.find(begin, p, end);
+      if (p == end) break;
+
+      ModuleOutline o;
+      o.begin = size_t(p - begin);
+      while (const void* nl = std::memchr(counted, '\n', size_t(p - counted))) {
+        ++line;
+        counted = static_cast<const char*>(nl) + 1;
+      }
+      counted = p;
+      o.line = line;
+      tao::pegtl::memory_input<> in(p, end, source);
+      actions::State st;
+      try {
+        if (!tao::pegtl::parse< grammar::module_header, actions::action >(in, st))
+          throw parse_error(source + ": bad module header at byte " + std::to_string(o.begin));
+      } catch (const tao::pegtl::parse_error& e) {
+        rethrow(e, o.begin);
+      }
+      o.module_name = std::move(st.current_module.module_name);
+      o.port_list = std::move(st.current_module.port_list);
+      o.body_begin = size_t(in.current() - begin);
+
+      const char* q = find_endmodule.find(begin, in.current(), end);
+      if (q == end) throw parse_error(source + ": module '" + o.module_name + "' has no endmodule");
+      o.end = size_t(q - begin) + std::strlen("endmodule");
+      p = begin + o.end;
+      outlines.push_back(std::move(o));
+    }
+
+    for (size_t i = 0; i < outlines.size(); ++i) index.emplace(outlines[i].module_name, i);
+    parsing.reset(new std::mutex[outlines.size()]);
+    bodies.reset(new std::atomic<Module*>[outlines.size()]);
+    for (size_t i = 0; i < outlines.size(); ++i) bodies[i].store(nullptr, std::memory_order_relaxed);
+  }
+
+  Module parse(size_t i) const {
+    const ModuleOutline& o = outlines[i];
+    tao::pegtl::memory_input<> in(text.data() + o.begin, text.data() + o.end, source);
+    actions::State st;
+    st.source_begin = text.data();
+    try {
+      if (!tao::pegtl::parse< grammar::module, actions::action >(in, st) || st.modules_accum.size() != 1)
+        throw parse_error(source + ": could not parse module '" + o.module_name + "'");
+    } catch (const tao::pegtl::parse_error& e) {
+      rethrow(e, o.begin);
+    }
+    return std::move(st.modules_accum.front());
+  }
+
+  const Module& body(size_t i) const {
+    if (const Module* m = bodies[i].load(std::memory_order_acquire)) return *m;
+    std::lock_guard<std::mutex> lock(parsing[i]);
+    if (const Module* m = bodies[i].load(std::memory_order_relaxed)) return *m;
+    Module* m = new Module(parse(i));
+    bodies[i].store(m, std::memory_order_release);
+    return *m;
+  }
+};
+
+LazyNetlist::LazyNetlist(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
+LazyNetlist::LazyNetlist(LazyNetlist&&) noexcept = default;
+LazyNetlist& LazyNetlist::operator=(LazyNetlist&&) noexcept = default;
+LazyNetlist::~LazyNetlist() = default;
+
+LazyNetlist LazyNetlist::from_string(std::string text, std::string source) {
+  auto impl = std::make_unique<Impl>();
+  impl->source = std::move(source);
+  impl->owned = std::move(text);
+  impl->text = impl->owned;
+  impl->scan();
+  return LazyNetlist(std::move(impl));
+}
+
+LazyNetlist LazyNetlist::from_file(const std::string& path) {
+  auto impl = std::make_unique<Impl>();
+  impl->source = path;
+#ifdef VERILOG_LAZY_MMAP
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) throw parse_error("could not open file: " + path);
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw parse_error("could not stat file: " + path);
+  }
+  if (S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* m = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m != MAP_FAILED) {
+      impl->map = static_cast<const char*>(m);
+      impl->map_len = size_t(st.st_size);
+      impl->text = std::string_view(impl->map, impl->map_len);
+    }
+  }
+  if (!impl->map) {   // pipes, FIFOs and procfs report no size: read the open descriptor to EOF
+    char buf[1 << 16];
+    for (ssize_t n; (n = ::read(fd, buf, sizeof buf)) != 0;) {
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0) {
+        ::close(fd);
+        throw parse_error("could not read file: " + path);
+      }
+      impl->owned.append(buf, size_t(n));
+    }
+    impl->text = impl->owned;
+  }
+  ::close(fd);
+#else
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs) throw parse_error("could not open file: " + path);
+  impl->owned.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+  impl->text = impl->owned;
+#endif
+  impl->scan();
+  return LazyNetlist(std::move(impl));
+}
+
+size_t LazyNetlist::size() const { return impl_->outlines.size(); }
+
+std::span<const ModuleOutline> LazyNetlist::outlines() const { return impl_->outlines; }
+
+const ModuleOutline* LazyNetlist::find(std::string_view name) const {
+  auto it = impl_->index.find(name);
+  return it == impl_->index.end() ? nullptr : &impl_->outlines[it->second];
+}
+
+std::string_view LazyNetlist::text(size_t i) const {
+  const ModuleOutline& o = impl_->outlines.at(i);
+  return impl_->text.substr(o.begin, o.end - o.begin);
+}
+
+const Module& LazyNetlist::module(size_t i) const {
+  if (i >= impl_->outlines.size()) throw std::out_of_range("LazyNetlist::module");
+  return impl_->body(i);
+}
+
+const Module* LazyNetlist::module(std::string_view name) const {
+  auto it = impl_->index.find(name);
+  return it == impl_->index.end() ? nullptr : &impl_->body(it->second);
+}
+
+Module LazyNetlist::parse_module(size_t i) const {
+  if (i >= impl_->outlines.size()) throw std::out_of_range("LazyNetlist::parse_module");
+  return impl_->parse(i);
+}
+
+bool LazyNetlist::is_parsed(size_t i) const {
+  if (i >= impl_->outlines.size()) throw std::out_of_range("LazyNetlist::is_parsed");
+  return impl_->bodies[i].load(std::memory_order_acquire) != nullptr;
+}
+
+Netlist LazyNetlist::to_netlist(unsigned threads) const {
+  Netlist nl;
+  nl.modules.resize(size());
+  parallel::parallel_for(size(), [&](size_t i) { nl.modules[i] = impl_->body(i); }, threads);
+#if VERILOGLIB_SOURCE_LOCATIONS
+  nl.lines = lines();
+#endif
+  return nl;
+}
+
+std::shared_ptr<const LineTable> LazyNetlist::lines() const {
+  std::call_once(impl_->lines_once, [&] { impl_->lines = std::make_shared<const LineTable>(impl_->text, impl_->source); });
+  return impl_->lines;
+}
+
+} // namespace verilog
@@ -0,0 +1,170 @@
+#include "verilog_levelize.hpp"
+#include "verilog_hierarchy.hpp"
+#include <algorithm>
+
+namespace verilog {
+
+namespace {
+
+using Kind = ModuleGraph::NodeKind;
+
+constexpr uint32_t kNone = ~uint32_t(0);
+
+bool drives(PortDir d) { return d != PortDir::Input; }
+bool loads(PortDir d) { return d != PortDir::Output; }
+
+// Combinational successors of every combinational node, as CSR arrays: a
+// node drives the nodes with a loading pin on a net one of its driving pins
+// is on. Built in one pass in node order, so the walks below touch each edge
+// as one sequential read instead of two levels of pin indirection.
+struct Successors {
+  std::vector<uint32_t> begin;   // nodes + 1 offsets into succ
+  std::vector<uint32_t> succ;
+  std::vector<uint8_t> self_loop;
+
+  Successors(const ModuleGraph& g, const std::vector<uint8_t>& comb) {
+    const uint32_t n = uint32_t(g.num_nodes());
+    begin.assign(size_t(n) + 1, 0);
+    self_loop.assign(n, 0);
+    succ.reserve(g.num_pins());
+    for (uint32_t u = 0; u < n; ++u) {
+      begin[u] = uint32_t(succ.size());
+      if (!comb[u]) continue;
+      for (const auto& p : g.node_pins(u)) {
+        if (!drives(p.dir)) continue;
+        for (uint32_t qi : g.net_pins(p.net)) {
+          const ModuleGraph::Pin& q = g.pins()[qi];
+          if (!loads(q.dir) || !comb[q.node] || &q == &p) continue;
+          if (q.node == u) self_loop[u] = 1;
+          else succ.push_back(q.node);
+        }
+      }
+    }
+    begin[n] = uint32_t(succ.size());
+  }
+};
+
+// Tarjan's algorithm with an explicit stack. Components come out in reverse
+// topological order: members in `order`, grouped, with offsets in
+// comp_begin; comp[node] is the component of each combinational node.
+struct Components {
+  std::vector<uint32_t> comp;
+  std::vector<uint32_t> order;
+  std::vector<uint32_t> comp_begin{0};
+
+  Components(const Successors& g, const std::vector<uint8_t>& comb) {
+    const uint32_t n = uint32_t(comb.size());
+    std::vector<uint32_t> index(n, kNone), low(n, 0);
+    comp.assign(n, kNone);
+    order.reserve(n);
+    std::vector<uint32_t> stack;
+    struct Frame { uint32_t node, edge; };
+    std::vector<Frame> calls;
+    uint32_t counter = 0;
+    auto enter = [&](uint32_t v) {
+      index[v] = low[v] = counter++;
+      stack.push_back(v);
+      calls.push_back({ v, g.begin[v] });
+    };
+    for (uint32_t root = 0; root < n; ++root) {
+      if (!comb[root] || index[root] != kNone) continue;
+      enter(root);
+      while (!calls.empty()) {
+        Frame& f = calls.back();
+        const uint32_t u = f.node;
+        if (f.edge < g.begin[u + 1]) {
+          const uint32_t v = g.succ[f.edge++];
+          if (index[v] == kNone) enter(v);   // invalidates f
+          else if (comp[v] == kNone) low[u] = std::min(low[u], index[v]);   // still on the stack
+          continue;
+        }
+        calls.pop_back();
+        if (!calls.empty()) low[calls.back().node] = std::min(low[calls.back().node], low[u]);
+        if (low[u] != index[u]) continue;
+        const uint32_t id = uint32_t(comp_begin.size() - 1);
+        uint32_t w;
+        do {
+          w = stack.back();
+          stack.pop_back();
+          comp[w] = id;
+          order.push_back(w);
+        } while (w != u);
+        comp_begin.push_back(uint32_t(order.size()));
+      }
+    }
+  }
+};
+
+} // namespace
+
+Schedule levelize(const ModuleGraph& g, const LevelizeOptions& opts) {
+  const Module& m = g.module();
+  const uint32_t n = uint32_t(g.num_nodes());
+  Schedule s;
+  std::vector<uint8_t> comb(n, 0);
+  for (uint32_t v = 0; v < n; ++v) {
+    switch (g.node_kind(v)) {
+      case Kind::Port: continue;
+      case Kind::Assign:
+      case Kind::Gate: comb[v] = 1; continue;
+      case Kind::Instance: break;
+    }
+    const ModuleInstance& inst = m.module_instances[g.node_ref(v)];
+    bool seq = false;
+    for (const auto& pat : opts.sequential)
+      if (wildcard_match(pat, inst.module_name)) { seq = true; break; }
+    if (!seq && opts.is_sequential && opts.is_sequential(inst)) seq = true;
+    if (seq) s.sequential.push_back(v);
+    else comb[v] = 1;
+  }
+
+  const Successors succ(g, comb);
+  Components lz(succ, comb);
+
+  // Longest path over the components, taken in topological order (the
+  // reverse of Tarjan's); a component's level goes to all of its members.
+  const uint32_t comps = uint32_t(lz.comp_begin.size() - 1);
+  std::vector<uint32_t> comp_level(comps, 0);
+  uint32_t levels = 0;
+  for (uint32_t c = comps; c-- > 0;) {
+    const uint32_t lv = comp_level[c];
+    levels = std::max(levels, lv + 1);
+    for (uint32_t k = lz.comp_begin[c]; k < lz.comp_begin[c + 1]; ++k) {
+      const uint32_t u = lz.order[k];
+      for (uint32_t e = succ.begin[u]; e < succ.begin[u + 1]; ++e) {
+        const uint32_t d = lz.comp[succ.succ[e]];
+        if (d != c) comp_level[d] = std::max(comp_level[d], lv + 1);
+      }
+    }
+  }
+
+  // Loops, ordered by their lowest node.
+  std::vector<std::pair<uint32_t, uint32_t>> loops;   // (lowest node, component)
+  for (uint32_t c = 0; c < comps; ++c) {
+    const auto first = lz.order.begin() + lz.comp_begin[c], last = lz.order.begin() + lz.comp_begin[c + 1];
+    std::sort(first, last);
+    if (last - first > 1 || succ.self_loop[*first]) loops.emplace_back(*first, c);
+  }
+  std::sort(loops.begin(), loops.end());
+  for (const auto& [low, c] : loops) {
+    s.loop_nodes.insert(s.loop_nodes.end(), lz.order.begin() + lz.comp_begin[c], lz.order.begin() + lz.comp_begin[c + 1]);
+    s.loop_begin.push_back(uint32_t(s.loop_nodes.size()));
+  }
+
+  // Counting sort by level; scanning nodes in id order keeps each level ascending.
+  s.level.assign(n, Schedule::kNoLevel);
+  s.level_begin.assign(size_t(levels) + 1, 0);
+  for (uint32_t v = 0; v < n; ++v) {
+    if (!comb[v]) continue;
+    s.level[v] = comp_level[lz.comp[v]];
+    ++s.level_begin[s.level[v] + 1];
+  }
+  for (uint32_t l = 0; l < levels; ++l) s.level_begin[l + 1] += s.level_begin[l];
+  s.nodes.resize(s.level_begin[levels]);
+  std::vector<uint32_t> fill(s.level_begin.begin(), s.level_begin.end() - 1);
+  for (uint32_t v = 0; v < n; ++v)
+    if (comb[v]) s.nodes[fill[s.level[v]]++] = v;
+  return s;
+}
+
+} // namespace verilog
@@ -0,0 +1,473 @@
+#include "verilog_partition.hpp"
+#include "verilog_cone.hpp"
+#include "verilog_parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+namespace verilog {
+
+namespace {
+
+constexpr uint32_t kNone = ~uint32_t(0);
+constexpr uint32_t kCoarsest = 128;        // stop coarsening at about this many vertices
+constexpr uint32_t kMaxScoredPins = 32;    // wider nets add too little to be worth scoring in matching
+constexpr int kInitialTries = 8;
+
+// Weighted vertices and weighted nets over them, both ways as CSR arrays.
+struct Hypergraph {
+  std::vector<uint32_t> weight;
+  std::vector<uint32_t> net_begin{0}, pins;   // net -> vertices
+  std::vector<uint32_t> net_weight;
+  std::vector<uint32_t> vtx_begin, nets;      // vertex -> nets, from index()
+
+  uint32_t size() const { return uint32_t(weight.size()); }
+  uint32_t num_nets() const { return uint32_t(net_begin.size() - 1); }
+  std::span<const uint32_t> net(uint32_t e) const { return { pins.data() + net_begin[e], pins.data() + net_begin[e + 1] }; }
+  std::span<const uint32_t> nets_of(uint32_t v) const { return { nets.data() + vtx_begin[v], nets.data() + vtx_begin[v + 1] }; }
+  uint64_t total() const { return std::accumulate(weight.begin(), weight.end(), uint64_t(0)); }
+
+  // Keeps the pins pushed since `start` as a net when there are two or more.
+  void close_net(size_t start, uint32_t w = 1) {
+    if (pins.size() - start < 2) {
+      pins.resize(start);
+      return;
+    }
+    net_begin.push_back(uint32_t(pins.size()));
+    net_weight.push_back(w);
+  }
+
+  void index() {
+    const uint32_t n = size();
+    vtx_begin.assign(size_t(n) + 1, 0);
+    for (uint32_t p : pins) ++vtx_begin[p + 1];
+    for (uint32_t v = 0; v < n; ++v) vtx_begin[v + 1] += vtx_begin[v];
+    nets.resize(pins.size());
+    std::vector<uint32_t> fill(vtx_begin.begin(), vtx_begin.end() - 1);
+    for (uint32_t e = 0; e < num_nets(); ++e)
+      for (uint32_t v : net(e)) nets[fill[v]++] = e;
+  }
+};
+
+// Pairs each vertex with the unmatched neighbour it shares the most
+// connectivity with (a net of p pins counts weight / (p - 1)), visiting vertices
+// in random order and keeping clusters under `limit`. Returns the cluster of
+// every vertex and sets `count`.
+std::vector<uint32_t> match(const Hypergraph& h, uint64_t limit, std::mt19937_64& rng, uint32_t& count) {
+  const uint32_t n = h.size();
+  std::vector<uint32_t> order(n);
+  std::iota(order.begin(), order.end(), 0u);
+  std::shuffle(order.begin(), order.end(), rng);
+  std::vector<uint32_t> cluster(n, kNone);
+  std::vector<double> score(n, 0.0);
+  std::vector<uint32_t> touched;
+  count = 0;
+  for (uint32_t v : order) {
+    if (cluster[v] != kNone) continue;
+    for (uint32_t e : h.nets_of(v)) {
+      const auto pins = h.net(e);
+      if (pins.size() > kMaxScoredPins) continue;
+      const double w = double(h.net_weight[e]) / double(pins.size() - 1);
+      for (uint32_t u : pins) {
+        if (u == v || cluster[u] != kNone || uint64_t(h.weight[u]) + h.weight[v] > limit) continue;
+        if (score[u] == 0.0) touched.push_back(u);
+        score[u] += w;
+      }
+    }
+    uint32_t best = kNone;
+    for (uint32_t u : touched) {
+      if (best == kNone || score[u] > score[best] || (score[u] == score[best] && u < best)) best = u;
+      score[u] = 0.0;
+    }
+    touched.clear();
+    cluster[v] = count;
+    if (best != kNone) cluster[best] = count;
+    ++count;
+  }
+  return cluster;
+}
+
+// Merges the vertices of each cluster. Nets left with one vertex disappear,
+// and nets left on the same vertices become one net of their summed weight:
+// without that, the many parallel nets between clusters would keep the
+// coarse levels as expensive to refine as the fine ones.
+Hypergraph contract(const Hypergraph& h, const std::vector<uint32_t>& cluster, uint32_t count) {
+  Hypergraph c;
+  c.weight.assign(count, 0);
+  for (uint32_t v = 0; v < h.size(); ++v) c.weight[cluster[v]] += h.weight[v];
+  c.pins.reserve(h.pins.size());
+  std::vector<uint32_t> stamp(count, kNone);
+  // Open-addressed table of the nets kept so far, by a hash of their sorted pins.
+  size_t slots = 16;
+  while (slots < 2 * size_t(h.num_nets())) slots *= 2;
+  std::vector<uint32_t> table(slots, kNone);
+  std::vector<uint64_t> keys;
+  for (uint32_t e = 0; e < h.num_nets(); ++e) {
+    const size_t start = c.pins.size();
+    for (uint32_t v : h.net(e)) {
+      const uint32_t cv = cluster[v];
+      if (stamp[cv] != e) { stamp[cv] = e; c.pins.push_back(cv); }
+    }
+    if (c.pins.size() - start < 2) {
+      c.pins.resize(start);
+      continue;
+    }
+    const auto first = c.pins.begin() + std::ptrdiff_t(start);
+    std::sort(first, c.pins.end());
+    uint64_t key = 0xcbf29ce484222325ull;
+    for (auto it = first; it != c.pins.end(); ++it) key = (key ^ *it) * 0x100000001b3ull;
+    size_t slot = size_t(key ^ (key >> 29)) & (slots - 1);
+    uint32_t same = kNone;
+    for (; table[slot] != kNone; slot = (slot + 1) & (slots - 1)) {
+      const uint32_t f = table[slot];
+      const auto pins = c.net(f);
+      if (keys[f] == key && std::equal(pins.begin(), pins.end(), first, c.pins.end())) { same = f; break; }
+    }
+    if (same != kNone) {
+      c.net_weight[same] += h.net_weight[e];
+      c.pins.resize(start);
+      continue;
+    }
+    table[slot] = c.num_nets();
+    keys.push_back(key);
+    c.close_net(start, h.net_weight[e]);
+  }
+  c.index();
+  return c;
+}
+
+// The vertices on one side, renumbered in order, with the nets that still
+// connect two of them. `ids` maps new vertices back through `outer`.
+Hypergraph induced(const Hypergraph& h, const std::vector<uint8_t>& side, uint8_t s,
+                   const std::vector<uint32_t>& outer, std::vector<uint32_t>& ids) {
+  std::vector<uint32_t> local(h.size(), kNone);
+  Hypergraph sub;
+  ids.clear();
+  for (uint32_t v = 0; v < h.size(); ++v) {
+    if (side[v] != s) continue;
+    local[v] = sub.size();
+    sub.weight.push_back(h.weight[v]);
+    ids.push_back(outer[v]);
+  }
+  for (uint32_t e = 0; e < h.num_nets(); ++e) {
+    const size_t start = sub.pins.size();
+    for (uint32_t v : h.net(e))
+      if (local[v] != kNone) sub.pins.push_back(local[v]);
+    sub.close_net(start, h.net_weight[e]);
+  }
+  sub.index();
+  return sub;
+}
+
+using Caps = std::array<uint64_t, 2>;
+
+struct Cost {
+  uint64_t overload = 0, cut = 0;
+  bool operator<(const Cost& o) const { return overload != o.overload ? overload < o.overload : cut < o.cut; }
+};
+
+// Vertices by gain, one doubly linked list per gain value, as in
+// Fiduccia-Mattheyses: insertion, removal and a gain change are O(1), and
+// the highest non-empty bucket is found by walking `top` down.
+class GainBuckets {
+public:
+  GainBuckets(int32_t max_gain, std::vector<uint32_t>& next, std::vector<uint32_t>& prev)
+      : offset_(max_gain), head_(size_t(2 * max_gain + 1), kNone), next_(next), prev_(prev) {}
+
+  void insert(uint32_t v, int32_t gain) {
+    const int32_t b = gain + offset_;
+    next_[v] = head_[b];
+    prev_[v] = kNone;
+    if (head_[b] != kNone) prev_[head_[b]] = v;
+    head_[b] = v;
+    top_ = std::max(top_, b);
+  }
+  void remove(uint32_t v, int32_t gain) {
+    if (prev_[v] != kNone) next_[prev_[v]] = next_[v];
+    else head_[gain + offset_] = next_[v];
+    if (next_[v] != kNone) prev_[next_[v]] = prev_[v];
+  }
+  uint32_t best() {
+    while (top_ >= 0 && head_[top_] == kNone) --top_;
+    return top_ >= 0 ? head_[top_] : kNone;
+  }
+
+private:
+  int32_t offset_;
+  int32_t top_ = -1;
+  std::vector<uint32_t> head_;
+  std::vector<uint32_t>& next_;
+  std::vector<uint32_t>& prev_;
+};
+
+// Fiduccia-Mattheyses refinement of a bisection. Each pass moves every
+// vertex at most once, always the one with the highest gain whose move keeps
+// the sides within `cap` (or relieves an overloaded side), then rolls back
+// to the best state seen. A pass starts from the vertices on cut nets only;
+// an interior vertex has gain -(weighted degree) and enters the buckets once a
+// neighbour's move changes that.
+Cost refine(const Hypergraph& h, std::vector<uint8_t>& side, const Caps& cap, uint32_t passes) {
+  const uint32_t n = h.size(), m = h.num_nets();
+  std::vector<std::array<uint32_t, 2>> cnt(m);
+  Caps w{};
+  Cost cost;
+  for (uint32_t v = 0; v < n; ++v) w[side[v]] += h.weight[v];
+  for (uint32_t e = 0; e < m; ++e) {
+    for (uint32_t v : h.net(e)) ++cnt[e][side[v]];
+    if (cnt[e][0] && cnt[e][1]) cost.cut += h.net_weight[e];
+  }
+  auto overload = [&] {
+    return (w[0] > cap[0] ? w[0] - cap[0] : 0) + (w[1] > cap[1] ? w[1] - cap[1] : 0);
+  };
+  cost.overload = overload();
+  // Weighted degree: the gain of moving a vertex lies within plus or minus it.
+  std::vector<int32_t> degree(n, 0);
+  int32_t max_degree = 0;
+  for (uint32_t v = 0; v < n; ++v) {
+    for (uint32_t e : h.nets_of(v)) degree[v] += int32_t(h.net_weight[e]);
+    max_degree = std::max(max_degree, degree[v]);
+  }
+
+  std::vector<int32_t> gain(n);
+  enum : uint8_t { Free, Queued, Locked };
+  std::vector<uint8_t> state(n);
+  std::vector<uint32_t> next(n), prev(n), moves;
+  for (uint32_t pass = 0; pass < passes; ++pass) {
+    std::array<GainBuckets, 2> buckets{ GainBuckets(max_degree, next, prev), GainBuckets(max_degree, next, prev) };
+    state.assign(n, Free);
+    for (uint32_t v = 0; v < n; ++v) gain[v] = -degree[v];
+    for (uint32_t e = 0; e < m; ++e) {
+      if (!cnt[e][0] || !cnt[e][1]) continue;
+      for (uint32_t v : h.net(e)) {
+        if (state[v] == Queued) continue;
+        int32_t g = 0;
+        for (uint32_t f : h.nets_of(v)) {
+          if (cnt[f][side[v]] == 1) g += int32_t(h.net_weight[f]);
+          if (cnt[f][side[v] ^ 1] == 0) g -= int32_t(h.net_weight[f]);
+        }
+        gain[v] = g;
+        state[v] = Queued;
+        buckets[side[v]].insert(v, g);
+      }
+    }
+    auto bump = [&](uint32_t u, int32_t d) {
+      if (state[u] == Locked) return;
+      if (state[u] == Queued) buckets[side[u]].remove(u, gain[u]);
+      gain[u] += d;
+      state[u] = Queued;
+      buckets[side[u]].insert(u, gain[u]);
+    };
+
+    moves.clear();
+    Cost now = cost, best = cost;
+    size_t best_len = 0, since_best = 0;
+    const size_t patience = 100 + n / 200;
+    for (;;) {
+      uint32_t pick = kNone;
+      for (uint8_t s = 0; s < 2; ++s) {
+        const uint32_t v = buckets[s].best();
+        if (v == kNone || (w[s ^ 1] + h.weight[v] > cap[s ^ 1] && w[s] <= cap[s])) continue;
+        if (pick == kNone || gain[v] > gain[pick] || (gain[v] == gain[pick] && w[s] > w[side[pick]])) pick = v;
+      }
+      if (pick == kNone) break;
+      const uint32_t v = pick;
+      const uint8_t from = side[v], to = from ^ 1;
+      buckets[from].remove(v, gain[v]);
+      state[v] = Locked;
+      now.cut -= gain[v];
+      for (uint32_t e : h.nets_of(v)) {
+        auto& c = cnt[e];
+        const int32_t we = int32_t(h.net_weight[e]);
+        if (c[to] == 0) {
+          for (uint32_t u : h.net(e)) bump(u, we);
+        } else if (c[to] == 1) {
+          for (uint32_t u : h.net(e)) if (side[u] == to) bump(u, -we);
+        }
+        --c[from];
+        ++c[to];
+        if (c[from] == 0) {
+          for (uint32_t u : h.net(e)) bump(u, -we);
+        } else if (c[from] == 1) {
+          for (uint32_t u : h.net(e)) if (side[u] == from) bump(u, we);
+        }
+      }
+      side[v] = to;
+      w[from] -= h.weight[v];
+      w[to] += h.weight[v];
+      now.overload = overload();
+      moves.push_back(v);
+      if (now < best) {
+        best = now;
+        best_len = moves.size();
+        since_best = 0;
+      } else if (++since_best > patience) {
+        break;
+      }
+    }
+    for (size_t i = moves.size(); i > best_len; --i) {
+      const uint32_t v = moves[i - 1];
+      const uint8_t from = side[v];
+      for (uint32_t e : h.nets_of(v)) {
+        --cnt[e][from];
+        ++cnt[e][from ^ 1];
+      }
+      side[v] ^= 1;
+      w[from] -= h.weight[v];
+      w[from ^ 1] += h.weight[v];
+    }
+    cost = best;
+    if (best_len == 0) break;
+  }
+  return cost;
+}
+
+// Greedy growing: side 0 takes vertices breadth-first from a random seed
+// (and new seeds when the region runs out) until it holds its share.
+void grow(const Hypergraph& h, uint64_t target, std::mt19937_64& rng, std::vector<uint8_t>& side) {
+  const uint32_t n = h.size();
+  side.assign(n, 1);
+  std::vector<uint8_t> queued(n, 0);
+  std::deque<uint32_t> queue;
+  uint64_t w = 0;
+  uint32_t next_seed = uint32_t(rng() % n);
+  while (w < target) {
+    if (queue.empty()) {
+      while (queued[next_seed]) next_seed = (next_seed + 1) % n;
+      queue.push_back(next_seed);
+      queued[next_seed] = 1;
+    }
+    const uint32_t v = queue.front();
+    queue.pop_front();
+    side[v] = 0;
+    w += h.weight[v];
+    for (uint32_t e : h.nets_of(v)) {
+      if (h.net(e).size() > kMaxScoredPins) continue;
+      for (uint32_t u : h.net(e))
+        if (!queued[u]) { queued[u] = 1; queue.push_back(u); }
+    }
+  }
+}
+
+// Multilevel bisection with side 0 aiming at `share` of the weight.
+std::vector<uint8_t> bisect(const Hypergraph& h, double share, double imbalance, uint32_t passes, std::mt19937_64& rng) {
+  const uint64_t total = h.total();
+  const Caps cap{ uint64_t(std::floor(double(total) * share * (1 + imbalance))),
+                  uint64_t(std::floor(double(total) * (1 - share) * (1 + imbalance))) };
+  const uint64_t limit = std::max<uint64_t>(1, 3 * total / (2 * kCoarsest));
+
+  std::deque<Hypergraph> levels;
+  std::vector<std::vector<uint32_t>> clusters;
+  const Hypergraph* cur = &h;
+  while (cur->size() > kCoarsest) {
+    uint32_t count = 0;
+    std::vector<uint32_t> cluster = match(*cur, limit, rng, count);
+    if (count > cur->size() - cur->size() / 20) break;   // under 5% smaller: matching has stalled
+    levels.push_back(contract(*cur, cluster, count));
+    clusters.push_back(std::move(cluster));
+    cur = &levels.back();
+  }
+
+  std::vector<uint8_t> side, trial;
+  Cost best;
+  for (int t = 0; t < kInitialTries && cur->size(); ++t) {
+    grow(*cur, uint64_t(double(total) * share), rng, trial);
+    const Cost c = refine(*cur, trial, cap, passes);
+    if (t == 0 || c < best) { best = c; side = trial; }
+  }
+  for (size_t l = levels.size(); l-- > 0;) {
+    const Hypergraph& fine = l ? levels[l - 1] : h;
+    std::vector<uint8_t> projected(fine.size());
+    for (uint32_t v = 0; v < fine.size(); ++v) projected[v] = side[clusters[l][v]];
+    side = std::move(projected);
+    refine(fine, side, cap, passes);
+  }
+  return side;
+}
+
+void split(const Hypergraph& h, const std::vector<uint32_t>& ids, uint32_t parts, uint32_t first, double imbalance,
+           const PartitionOptions& opts, unsigned threads, std::vector<uint32_t>& part) {
+  if (parts == 1 || h.size() == 0) {
+    for (uint32_t v : ids) part[v] = first;
+    return;
+  }
+  const uint32_t left = parts / 2;
+  // Seeded per subproblem, so the result does not depend on scheduling.
+  std::mt19937_64 rng(opts.seed * 0x9e3779b97f4a7c15ull + first * 1000003ull + parts);
+  const std::vector<uint8_t> side = bisect(h, double(left) / parts, imbalance, opts.passes, rng);
+  std::array<std::vector<uint32_t>, 2> sub_ids;
+  std::array<Hypergraph, 2> sub{ induced(h, side, 0, ids, sub_ids[0]), induced(h, side, 1, ids, sub_ids[1]) };
+  const std::array<uint32_t, 2> sub_parts{ left, parts - left }, sub_first{ first, first + left };
+  parallel::parallel_for(2, [&](size_t s) {
+    split(sub[s], sub_ids[s], sub_parts[s], sub_first[s], imbalance, opts, std::max(1u, threads / 2), part);
+  }, threads > 1 ? 2 : 1);
+}
+
+} // namespace
+
+std::vector<uint32_t> Partition::nodes(uint32_t p) const {
+  std::vector<uint32_t> out;
+  out.reserve(p < sizes.size() ? sizes[p] : 0);
+  for (uint32_t n = 0; n < part.size(); ++n)
+    if (part[n] == p) out.push_back(n);
+  return out;
+}
+
+Partition partition(const ModuleGraph& g, const PartitionOptions& opts) {
+  if (opts.parts == 0) throw std::invalid_argument("partition: zero parts");
+  const uint32_t n = uint32_t(g.num_nodes());
+  std::vector<uint32_t> vertex(n, kNone), ids;
+  for (uint32_t v = 0; v < n; ++v) {
+    if (g.node_kind(v) == ModuleGraph::NodeKind::Port) continue;
+    vertex[v] = uint32_t(ids.size());
+    ids.push_back(v);
+  }
+  if (opts.parts > 1 && opts.parts > ids.size())
+    throw std::invalid_argument("partition: " + std::to_string(opts.parts) + " parts of " + std::to_string(ids.size()) + " nodes");
+
+  Hypergraph h;
+  h.weight.assign(ids.size(), 1);
+  h.pins.reserve(g.num_pins());
+  std::vector<uint32_t> stamp(ids.size(), kNone);
+  for (NetId net = 0; net < g.num_nets(); ++net) {
+    const auto pins = g.net_pins(net);
+    if (pins.size() > opts.max_net_pins) continue;
+    const size_t start = h.pins.size();
+    for (uint32_t pi : pins) {
+      const uint32_t v = vertex[g.pins()[pi].node];
+      if (v != kNone && stamp[v] != net) { stamp[v] = net; h.pins.push_back(v); }
+    }
+    h.close_net(start);
+  }
+  h.index();
+
+  // Bisections compound: k parts take ceil(log2 k) levels of them.
+  const double depth = std::ceil(std::log2(double(opts.parts)));
+  const double imbalance = depth > 0 ? std::pow(1 + opts.imbalance, 1 / depth) - 1 : opts.imbalance;
+  Partition p;
+  p.part.assign(n, Partition::kNoPart);
+  split(h, ids, opts.parts, 0, imbalance, opts, opts.threads ? opts.threads : parallel::default_threads(), p.part);
+
+  p.sizes.assign(opts.parts, 0);
+  for (uint32_t v : ids) ++p.sizes[p.part[v]];
+  for (NetId net = 0; net < g.num_nets(); ++net) {
+    uint32_t seen = Partition::kNoPart;
+    for (uint32_t pi : g.net_pins(net)) {
+      const uint32_t q = p.part[g.pins()[pi].node];
+      if (q == Partition::kNoPart) continue;
+      if (seen == Partition::kNoPart) seen = q;
+      else if (q != seen) { p.cut.push_back(net); break; }
+    }
+  }
+  return p;
+}
+
+Module part_module(const ModuleGraph& g, const Partition& p, uint32_t part, std::string name) {
+  if (part >= p.num_parts()) throw std::invalid_argument("partition: no part " + std::to_string(part));
+  return extract_module(g, p.nodes(part), std::move(name));
+}
+
+} // namespace verilog
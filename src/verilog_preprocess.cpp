@@ -0,0 +1,647 @@
+#include "verilog_preprocess.hpp"
+#include "verilog_actions.hpp"
+#include "verilog_grammar.hpp"
+#include "verilog_parallel.hpp"
+#include "verilog_scan.hpp"
+#include "verilog_source.hpp"
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+
+namespace verilog {
+
+namespace {
+
+uint64_t fnv1a(std::string_view s) {
+  uint64_t h = 14695981039346656037ull;
+  for (unsigned char c : s) { h ^= c; h *= 1099511628211ull; }
+  return h;
+}
+
+} // namespace
+
+std::shared_ptr<const SourceFile> IncludeCache::load(const std::string& path) {
+  std::promise<std::shared_ptr<const SourceFile>> promise;
+  {
+    std::unique_lock<std::mutex> lk(mu_);
+    auto it = by_path_.find(path);
+    if (it != by_path_.end()) {
+      ++hits_;
+      Entry e = it->second;
+      lk.unlock();
+      return e.get();
+    }
+    by_path_.emplace(path, promise.get_future().share());
+  }
+
+  try {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) { promise.set_value(nullptr); return nullptr; }
+    auto text = std::make_shared<std::string>((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    auto f = std::make_shared<SourceFile>();
+    f->path = path;
+    f->hash = fnv1a(*text);
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      const auto [b, e] = by_hash_.equal_range(f->hash);
+      for (auto it = b; it != e; ++it) {
+        if (*it->second->text == *text) {
+          f->text = it->second->text;
+          f->lines = it->second->lines;
+          ++shared_;
+          break;
+        }
+      }
+    }
+    if (!f->text) {
+#if VERILOGLIB_SOURCE_LOCATIONS
+      f->lines = std::make_shared<const LineTable>(*text, path);
+#endif
+      f->text = std::move(text);
+      std::lock_guard<std::mutex> lk(mu_);
+      by_hash_.emplace(f->hash, f);
+    }
+    promise.set_value(f);
+    return f;
+  } catch (...) {
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+}
+
+size_t IncludeCache::files() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return by_path_.size();
+}
+
+size_t IncludeCache::shared() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return shared_;
+}
+
+size_t IncludeCache::hits() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return hits_;
+}
+
+size_t Preprocessed::size() const {
+  size_t n = 0;
+  for (const auto& p : pieces) n += p.text.size();
+  return n;
+}
+
+namespace {
+
+using scan::is_ident_char;
+
+struct Macro {
+  std::vector<std::string> params;
+  std::string body;
+  bool function_like = false;
+};
+
+[[noreturn]] void throw_at(const std::string& file, SourceLocation loc, const std::string& message) {
+  std::string where = file;
+  if (loc.line) where += ":" + std::to_string(loc.line) + ":" + std::to_string(loc.column);
+  throw parse_error(where + ": " + message, file, loc);
+}
+
+// Errors are rare: without a line table (spans off) one is built for them.
+SourceLocation locate_in(const SourceFile& f, size_t offset) {
+  const uint32_t o = uint32_t(std::min<size_t>(offset, UINT32_MAX));
+  return f.lines ? f.lines->locate(o) : LineTable(*f.text).locate(o);
+}
+
+bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+bool is_space(char c) { return is_blank(c) || c == '\n' || c == '\f' || c == '\v'; }
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && is_space(s.front())) s.remove_prefix(1);
+  while (!s.empty() && is_space(s.back())) s.remove_suffix(1);
+  return s;
+}
+
+// Past the closing quote of a string literal whose opening quote is at p - 1.
+const char* skip_string(const char* p, const char* end) {
+  while (p < end && *p != '"' && *p != '\n') p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+  return p < end && *p == '"' ? p + 1 : p;
+}
+
+// Directives other than macro uses; a macro may not take one of these names.
+bool is_directive(std::string_view name) {
+  static const std::unordered_set<std::string_view> names = {
+    "define", "undef", "undefineall", "ifdef", "ifndef", "elsif", "else", "endif", "include",
+    "timescale", "default_nettype", "line", "pragma", "begin_keywords", "end_keywords",
+    "unconnected_drive", "nounconnected_drive", "celldefine", "endcelldefine", "resetall",
+    "default_decay_time", "default_trireg_strength", "delay_mode_distributed", "delay_mode_path",
+    "delay_mode_unit", "delay_mode_zero",
+  };
+  return names.count(name) != 0;
+}
+
+// Directives with arguments to the end of the line that we drop.
+bool takes_line(std::string_view name) {
+  return name == "timescale" || name == "default_nettype" || name == "line" || name == "pragma" ||
+         name == "begin_keywords" || name == "unconnected_drive" || name == "default_decay_time" ||
+         name == "default_trireg_strength";
+}
+
+// Reads the arguments of a macro use, p at the opening parenthesis. Commas
+// inside nested brackets or strings do not split. Null when unterminated.
+const char* read_args(const char* p, const char* end, std::vector<std::string>& args) {
+  std::string cur;
+  int depth = 0;
+  for (++p; p < end;) {
+    const char c = *p;
+    if (c == '"') {
+      const char* q = skip_string(p + 1, end);
+      cur.append(p, q);
+      p = q;
+      continue;
+    }
+    if (c == '(' || c == '[' || c == '{') ++depth;
+    else if ((c == ')' || c == ']' || c == '}') && depth > 0) --depth;
+    else if (depth == 0 && (c == ',' || c == ')')) {
+      args.emplace_back(trim(cur));
+      cur.clear();
+      ++p;
+      if (c == ')') return p;
+      continue;
+    }
+    cur += c;
+    ++p;
+  }
+  return nullptr;
+}
+
+class Preprocessor {
+public:
+  Preprocessor(const PreprocessOptions& opts, IncludeCache& cache, Preprocessed& out)
+    : opts_(opts), cache_(cache), out_(out) {
+    for (const auto& [name, value] : opts.defines) macros_[name].body = value;
+  }
+
+  void run(std::shared_ptr<const SourceFile> f, unsigned depth) {
+    const uint32_t fi = file_index(f);
+    const std::string& text = *f->text;
+    const Cursor c{ *f, fi, text.data(), text.data() + text.size(), depth };
+    const size_t open = conds_.size();
+
+    if (!std::memchr(c.begin, '`', text.size())) {   // nothing to do: one piece
+      emit(c, c.begin, c.end);
+      return;
+    }
+    static const std::array<bool, 256> stop = [] {
+      std::array<bool, 256> s{};
+      s['/'] = s['*'] = s['\\'] = s['"'] = s['`'] = true;
+      return s;
+    }();
+    const char* p = c.begin;
+    const char* run = p;
+    for (;;) {
+      while (p < c.end && !stop[uint8_t(*p)]) ++p;
+      if (p >= c.end) break;
+      if (*p == '"') { p = skip_string(p + 1, c.end); continue; }
+      const char* q = scan::skip_trivia(c.begin, p, c.end);
+      if (q != p) { p = q; continue; }
+      if (*p != '`') { ++p; continue; }
+      emit(c, run, p);
+      p = directive(c, p);
+      run = p;
+    }
+    emit(c, run, c.end);
+    if (conds_.size() > open) fail(c, conds_.back().at, "`ifdef without `endif");
+  }
+
+private:
+  struct Cursor {
+    const SourceFile& file;
+    uint32_t index;
+    const char* begin;
+    const char* end;
+    unsigned depth;   // of `include nesting
+  };
+  struct Cond {
+    bool outer;       // the enclosing region is active
+    bool active;
+    bool taken;       // some branch was (or, with !outer, can no longer be) selected
+    bool seen_else;
+    const char* at;
+  };
+
+  bool active() const { return conds_.empty() || conds_.back().active; }
+
+  uint32_t file_index(const std::shared_ptr<const SourceFile>& f) {
+    auto [it, added] = index_.emplace(f.get(), uint32_t(out_.files.size()));
+    if (added) out_.files.push_back(f);
+    return it->second;
+  }
+
+  void emit(const Cursor& c, const char* b, const char* e) {
+    if (b >= e || !active()) return;
+    if (!out_.pieces.empty()) {
+      auto& last = out_.pieces.back();
+      if (!last.expansion && last.file == c.index && last.text.data() + last.text.size() == b) {
+        last.text = std::string_view(last.text.data(), last.text.size() + size_t(e - b));
+        return;
+      }
+    }
+    out_.pieces.push_back(Preprocessed::Piece{ std::string_view(b, size_t(e - b)), c.index, uint32_t(b - c.begin), false });
+  }
+
+  [[noreturn]] void fail(const Cursor& c, const char* at, const std::string& message) const {
+    throw_at(c.file.path, locate_in(c.file, size_t(at - c.begin)), message);
+  }
+
+  static const char* skip_blanks(const char* p, const char* end) {
+    while (p < end && is_blank(*p)) ++p;
+    return p;
+  }
+
+  static const char* line_end(const char* p, const char* end) {
+    const void* nl = std::memchr(p, '\n', size_t(end - p));
+    return nl ? static_cast<const char*>(nl) : end;
+  }
+
+  // A macro name after the directive `what`, skipping blanks first.
+  std::string_view name(const Cursor& c, const char*& p, const char* at, std::string_view what) const {
+    p = skip_blanks(p, c.end);
+    const char* b = p;
+    while (p < c.end && is_ident_char(*p)) ++p;
+    if (p == b) fail(c, at, "expected a macro name after `" + std::string(what));
+    return std::string_view(b, size_t(p - b));
+  }
+
+  // The directive or macro use whose backtick is at `at`; returns where the
+  // text resumes.
+  const char* directive(const Cursor& c, const char* at) {
+    const char* p = at + 1;
+    while (p < c.end && is_ident_char(*p)) ++p;
+    const std::string_view d(at + 1, size_t(p - at - 1));
+    if (d.empty()) fail(c, at, "expected a directive or macro name after '`'");
+
+    if (d == "define") return define(c, at, p);
+    if (d == "undef") {
+      const std::string_view n = name(c, p, at, d);
+      if (active()) macros_.erase(std::string(n));
+      return p;
+    }
+    if (d == "undefineall") {
+      if (active()) macros_.clear();
+      return p;
+    }
+    if (d == "ifdef" || d == "ifndef") {
+      const bool defined = macros_.count(std::string(name(c, p, at, d))) != 0;
+      const bool cond = defined == (d == "ifdef");
+      const bool outer = active();
+      conds_.push_back(Cond{ outer, outer && cond, cond || !outer, false, at });
+      return p;
+    }
+    if (d == "elsif") {
+      const bool defined = macros_.count(std::string(name(c, p, at, d))) != 0;
+      if (conds_.empty() || conds_.back().seen_else) fail(c, at, "`elsif without `ifdef");
+      Cond& top = conds_.back();
+      top.active = top.outer && !top.taken && defined;
+      top.taken = top.taken || defined;
+      return p;
+    }
+    if (d == "else") {
+      if (conds_.empty() || conds_.back().seen_else) fail(c, at, "`else without `ifdef");
+      Cond& top = conds_.back();
+      top.active = top.outer && !top.taken;
+      top.taken = top.seen_else = true;
+      return p;
+    }
+    if (d == "endif") {
+      if (conds_.empty()) fail(c, at, "`endif without `ifdef");
+      conds_.pop_back();
+      return p;
+    }
+    if (d == "include") return include(c, at, p);
+    if (takes_line(d)) return line_end(p, c.end);
+    if (is_directive(d)) return p;
+
+    if (!active()) return p;   // macro uses in skipped text are not expanded
+    std::vector<std::string> args;
+    const Macro& m = lookup(c, at, d);
+    if (m.function_like) p = macro_args(c, at, d, p, c.end, args);
+    std::string text = expand(c, at, m, args, 0);
+    if (!text.empty()) {
+      out_.expansions.push_back(std::move(text));
+      out_.pieces.push_back(Preprocessed::Piece{ out_.expansions.back(), c.index, uint32_t(at - c.begin), true });
+    }
+    return p;
+  }
+
+  // `define NAME[(params)] body: the body runs to the end of the line;
+  // a backslash before the newline continues it.
+  const char* define(const Cursor& c, const char* at, const char* p) {
+    const std::string n(name(c, p, at, "define"));
+    if (is_directive(n)) fail(c, at, "`" + n + " is a compiler directive and cannot be redefined");
+    Macro m;
+    if (p < c.end && *p == '(') {
+      m.function_like = true;
+      for (++p;;) {
+        while (p < c.end && is_space(*p)) ++p;
+        const char* b = p;
+        while (p < c.end && is_ident_char(*p)) ++p;
+        const bool named = p > b;
+        if (named) m.params.emplace_back(b, p);
+        while (p < c.end && is_space(*p)) ++p;
+        if (p < c.end && *p == ')' && (named || m.params.empty())) { ++p; break; }
+        if (p < c.end && *p == ',' && named) { ++p; continue; }
+        fail(c, at, "malformed parameter list of macro `" + n);
+      }
+    }
+    std::string body;
+    while (p < c.end && *p != '\n') {
+      if (*p == '\\' && p + 1 < c.end && (p[1] == '\n' || (p[1] == '\r' && p + 2 < c.end && p[2] == '\n'))) {
+        body += '\n';
+        p += p[1] == '\n' ? 2 : 3;
+        continue;
+      }
+      if (*p == '/' && p + 1 < c.end && p[1] == '/') { p = line_end(p, c.end); break; }
+      if (*p == '/' && p + 1 < c.end && p[1] == '*') { p = scan::skip_block(p + 2, c.end, '/'); body += ' '; continue; }
+      if (*p == '"') {
+        const char* q = skip_string(p + 1, c.end);
+        body.append(p, q);
+        p = q;
+        continue;
+      }
+      body += *p++;
+    }
+    m.body = std::string(trim(body));
+    if (active()) macros_[n] = std::move(m);
+    return p;
+  }
+
+  const char* include(const Cursor& c, const char* at, const char* p) {
+    if (!active()) return line_end(p, c.end);
+    p = skip_blanks(p, c.end);
+    const char close = p < c.end && *p == '<' ? '>' : '"';
+    if (p >= c.end || (*p != '"' && *p != '<')) fail(c, at, "expected \"file\" or <file> after `include");
+    const char* b = ++p;
+    while (p < c.end && *p != close && *p != '\n') ++p;
+    if (p >= c.end || *p != close) fail(c, at, "unterminated file name after `include");
+    const std::string name(b, p);
+    ++p;
+    if (c.depth + 1 > opts_.max_include_depth) fail(c, at, "`include nested too deep at \"" + name + "\"");
+    auto f = resolve(c, name);
+    if (!f) fail(c, at, "cannot find include file \"" + name + "\"");
+    run(std::move(f), c.depth + 1);
+    return p;
+  }
+
+  // Relative to the including file's directory first, then each include dir.
+  std::shared_ptr<const SourceFile> resolve(const Cursor& c, const std::string& name) const {
+    namespace fs = std::filesystem;
+    const fs::path rel(name);
+    if (rel.is_absolute()) return cache_.load(rel.lexically_normal().string());
+    if (auto f = cache_.load((fs::path(c.file.path).parent_path() / rel).lexically_normal().string())) return f;
+    for (const auto& dir : opts_.include_dirs)
+      if (auto f = cache_.load((fs::path(dir) / rel).lexically_normal().string())) return f;
+    return nullptr;
+  }
+
+  const Macro& lookup(const Cursor& c, const char* at, std::string_view n) const {
+    auto it = macros_.find(std::string(n));
+    if (it == macros_.end()) fail(c, at, "undefined macro `" + std::string(n));
+    return it->second;
+  }
+
+  // Arguments of a use of function-like macro `n`, p just past its name.
+  const char* macro_args(const Cursor& c, const char* at, std::string_view n, const char* p, const char* end,
+                         std::vector<std::string>& args) const {
+    while (p < end && is_space(*p)) ++p;
+    if (p >= end || *p != '(') fail(c, at, "macro `" + std::string(n) + " needs arguments");
+    p = read_args(p, end, args);
+    if (!p) fail(c, at, "unterminated arguments of macro `" + std::string(n));
+    return p;
+  }
+
+  // The text of a use of `m`: parameters substituted, then macro uses in
+  // the result expanded in turn. Errors are reported at the outermost use.
+  std::string expand(const Cursor& c, const char* at, const Macro& m, std::vector<std::string>& args,
+                     unsigned depth) const {
+    if (depth > 64) fail(c, at, "macro expansion nested too deep (a macro that uses itself?)");
+    if (args.size() == 1 && m.params.empty() && args[0].empty()) args.clear();
+    if (args.size() > m.params.size()) fail(c, at, "too many macro arguments");
+    args.resize(m.params.size());
+
+    std::string s;
+    const char* p = m.body.data();
+    const char* const end = p + m.body.size();
+    while (p < end) {
+      if (*p == '"') {
+        const char* q = skip_string(p + 1, end);
+        s.append(p, q);
+        p = q;
+      } else if (is_ident_char(*p) && (p == m.body.data() || (!is_ident_char(p[-1]) && p[-1] != '`'))) {
+        const char* b = p;
+        while (p < end && is_ident_char(*p)) ++p;
+        const std::string_view word(b, size_t(p - b));
+        size_t k = 0;
+        while (k < m.params.size() && m.params[k] != word) ++k;
+        if (k < m.params.size()) s += args[k];
+        else s.append(b, p);
+      } else {
+        s += *p++;
+      }
+    }
+    if (s.find('`') == std::string::npos) return s;
+
+    std::string out;
+    p = s.data();
+    const char* const send = p + s.size();
+    while (p < send) {
+      if (*p == '"') {
+        const char* q = skip_string(p + 1, send);
+        out.append(p, q);
+        p = q;
+        continue;
+      }
+      if (*p != '`') { out += *p++; continue; }
+      const char* b = ++p;
+      while (p < send && is_ident_char(*p)) ++p;
+      const std::string_view n(b, size_t(p - b));
+      if (n.empty() || is_directive(n))
+        fail(c, at, "`" + std::string(n) + " inside a macro body is not supported");
+      const Macro& inner = lookup(c, at, n);
+      std::vector<std::string> inner_args;
+      if (inner.function_like) p = macro_args(c, at, n, p, send, inner_args);
+      out += expand(c, at, inner, inner_args, depth + 1);
+    }
+    return out;
+  }
+
+  const PreprocessOptions& opts_;
+  IncludeCache& cache_;
+  Preprocessed& out_;
+  std::unordered_map<std::string, Macro> macros_;
+  std::vector<Cond> conds_;
+  std::unordered_map<const SourceFile*, uint32_t> index_;
+};
+
+// Cuts the pieces of one preprocessed file into modules and parses them.
+// Stream offsets start at `base`.
+class PieceParser {
+public:
+  PieceParser(const Preprocessed& pp, uint32_t base, const SourceMap& map, const std::vector<const SourceFile*>& files)
+    : pp_(pp), base_(base), map_(map), files_(files) {}
+
+  std::vector<Module> run() {
+    static const scan::KeywordScanner find_module("module"), find_endmodule("endmodule");
+    uint64_t at = base_;   // stream offset of the current piece
+    bool inside = false;
+    std::string stitched;  // a module that straddles pieces, from its `module` on
+    uint64_t stitched_at = 0;
+    for (const auto& piece : pp_.pieces) {
+      const char* const begin = piece.text.data();
+      const char* const end = begin + piece.text.size();
+      const char* p = begin;
+      while (p < end) {
+        const char* m = p;
+        if (!inside) {
+          m = find_module.find(begin, p, end);
+          outside(p, m, at + uint64_t(p - begin));
+          if (m == end) break;
+          inside = true;
+        }
+        const char* q = find_endmodule.find(begin, m, end);
+        if (q == end) {
+          if (stitched.empty()) stitched_at = at + uint64_t(m - begin);
+          stitched.append(m, end);
+          break;
+        }
+        q += std::strlen("endmodule");
+        if (stitched.empty()) {
+          module(m, q, at + uint64_t(m - begin));
+        } else {
+          stitched.append(m, q);
+          module(stitched.data(), stitched.data() + stitched.size(), stitched_at);
+          stitched.clear();
+        }
+        inside = false;
+        p = q;
+      }
+      at += piece.text.size();
+    }
+    if (inside) fail(stitched_at, "no `endmodule`");
+    return std::move(modules_);
+  }
+
+private:
+  // Text outside modules may only hold whitespace and comments.
+  void outside(const char* b, const char* e, uint64_t at) const {
+    tao::pegtl::memory_input<> in(b, e, "");
+    tao::pegtl::parse< grammar::sep >(in);
+    if (!in.empty()) fail(at + uint64_t(in.current() - b), "expected `module`");
+  }
+
+  void module(const char* b, const char* e, uint64_t at) {
+    tao::pegtl::memory_input<> in(b, e, "");
+    actions::State st;
+    st.source_begin = b;
+    st.source_offset = uint32_t(std::min<uint64_t>(at, UINT32_MAX));
+    try {
+      if (!tao::pegtl::parse< grammar::module, actions::action >(in, st)) fail(at, "expected `module`");
+    } catch (const tao::pegtl::parse_error& x) {
+      fail(at + (x.positions().empty() ? 0 : x.positions().front().byte), std::string(x.message()));
+    }
+    modules_.push_back(std::move(st.modules_accum.front()));
+  }
+
+  [[noreturn]] void fail(uint64_t at, const std::string& message) const {
+    const SourceMap::Origin o = map_.origin(uint32_t(std::min<uint64_t>(at, UINT32_MAX)));
+    const SourceFile& f = *files_[o.file];
+    throw_at(f.path, locate_in(f, o.offset), message);
+  }
+
+  const Preprocessed& pp_;
+  uint32_t base_;
+  const SourceMap& map_;
+  const std::vector<const SourceFile*>& files_;   // by SourceMap file index
+  std::vector<Module> modules_;
+};
+
+// Adds the files and pieces of `pp` to `map` (and the files to `files`), its
+// stream starting at `base`; returns the offset just past it.
+uint64_t add_to_map(SourceMap& map, std::vector<const SourceFile*>& files, const Preprocessed& pp, uint64_t base) {
+  const uint32_t first = uint32_t(map.num_files());
+  for (const auto& f : pp.files) {
+    map.add_file(f->path, f->lines);
+    files.push_back(f.get());
+  }
+  for (const auto& piece : pp.pieces) {
+    if (base > UINT32_MAX) break;
+    map.add_segment(uint32_t(base), first + piece.file, piece.origin, piece.expansion);
+    base += piece.text.size();
+  }
+  return base;
+}
+
+} // namespace
+
+Preprocessed preprocess_file(const std::string& path, const PreprocessOptions& opts, IncludeCache& cache) {
+  auto f = cache.load(path);
+  if (!f) throw parse_error("could not open file: " + path);
+  Preprocessed out;
+  Preprocessor(opts, cache, out).run(std::move(f), 0);
+  return out;
+}
+
+Preprocessed preprocess_string(std::string_view text, const std::string& name, const PreprocessOptions& opts,
+                               IncludeCache& cache) {
+  auto f = std::make_shared<SourceFile>();
+  f->path = name;
+  f->text = std::make_shared<const std::string>(text);
+  f->hash = fnv1a(text);
+#if VERILOGLIB_SOURCE_LOCATIONS
+  f->lines = std::make_shared<const LineTable>(text, name);
+#endif
+  Preprocessed out;
+  Preprocessor(opts, cache, out).run(std::move(f), 0);
+  return out;
+}
+
+Netlist parse_preprocessed(const Preprocessed& pp) {
+  auto map = std::make_shared<SourceMap>();
+  std::vector<const SourceFile*> files;
+  add_to_map(*map, files, pp, 0);
+  Netlist nl;
+  nl.modules = PieceParser(pp, 0, *map, files).run();
+#if VERILOGLIB_SOURCE_LOCATIONS
+  nl.sources = std::move(map);
+#endif
+  return nl;
+}
+
+Netlist parse_files(const std::vector<std::string>& paths, const PreprocessOptions& opts, IncludeCache* cache) {
+  IncludeCache own;
+  if (!cache) cache = &own;
+  std::vector<Preprocessed> pp(paths.size());
+  parallel::parallel_for(paths.size(), [&](size_t i) { pp[i] = preprocess_file(paths[i], opts, *cache); }, opts.threads);
+
+  auto map = std::make_shared<SourceMap>();
+  std::vector<const SourceFile*> files;
+  std::vector<uint32_t> base(paths.size());
+  uint64_t at = 0;
+  for (size_t i = 0; i < pp.size(); ++i) {
+    base[i] = uint32_t(std::min<uint64_t>(at, UINT32_MAX));
+    at = add_to_map(*map, files, pp[i], at);
+  }
+  std::vector<std::vector<Module>> modules(paths.size());
+  parallel::parallel_for(paths.size(), [&](size_t i) { modules[i] = PieceParser(pp[i], base[i], *map, files).run(); },
+                         opts.threads);
+
+  Netlist nl;
+  parallel::ordered_append(nl.modules, modules.size(), [&](size_t i) -> std::vector<Module>& { return modules[i]; }, opts.threads);
+#if VERILOGLIB_SOURCE_LOCATIONS
+  nl.sources = std::move(map);
+#endif
+  return nl;
+}
+
+} // namespace verilog
@@ -0,0 +1,201 @@
+#include "verilog_recover.hpp"
+#include "verilog_actions.hpp"
+#include "verilog_grammar.hpp"
+#include "verilog_parallel.hpp"
+#include "verilog_scan.hpp"
+#include "verilog_source.hpp"
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace verilog {
+
+std::string ParseDiagnostic::to_string() const {
+  std::string s = source;
+  if (location.line) s += ":" + std::to_string(location.line) + ":" + std::to_string(location.column);
+  s += ": error: ";
+  if (!module.empty()) s += "module '" + module + "': ";
+  return s + message;
+}
+
+std::string RecoveredNetlist::report(size_t max_items) const {
+  std::ostringstream oss;
+  oss << "parse: " << errors.size() << " error(s), " << dropped.size() << " module(s) dropped\n";
+  for (size_t i = 0; i < errors.size() && i < max_items; ++i) oss << errors[i].to_string() << "\n";
+  if (errors.size() > max_items) oss << "... and " << errors.size() - max_items << " more\n";
+  return oss.str();
+}
+
+namespace {
+
+using grammar::Keyword;
+
+// Where to resume after an error at p: just past the next ';', at the next
+// `endmodule`, or end.
+const char* resync(const char* begin, const char* p, const char* end) {
+  while (p < end) {
+    const char* q = scan::skip_trivia(begin, p, end);
+    if (q != p) { p = q; continue; }
+    if (*p == ';') return p + 1;
+    if (*p == 'e' && scan::word_at(begin, p, end, "endmodule")) return p;
+    ++p;
+  }
+  return end;
+}
+
+// The name after the `module` keyword at p, read without the grammar, for
+// diagnostics of a header that does not parse.
+std::string name_after_module(const char* p, const char* end) {
+  p += std::strlen("module");
+  while (p < end && std::isspace(static_cast<unsigned char>(*p))) ++p;
+  const bool escaped = p < end && *p == '\\';
+  if (escaped) ++p;
+  const char* b = p;
+  while (p < end && (escaped ? !scan::ends_escaped(*p) : scan::is_ident_char(*p))) ++p;
+  return std::string(b, p);
+}
+
+struct Piece {
+  std::optional<Module> module;   // set when the module parsed without errors
+  std::string name;
+  std::vector<ParseDiagnostic> errors;
+};
+
+class Recoverer {
+public:
+  Recoverer(std::string_view text, const std::string& source, const LineTable& lines)
+    : text_(text), source_(source), lines_(lines) {}
+
+  // Text outside any module may only hold whitespace and comments.
+  void outside(const char* b, const char* e, std::vector<ParseDiagnostic>& errors, const std::string& after) const {
+    tao::pegtl::memory_input<> in(b, e, source_);
+    tao::pegtl::parse< grammar::sep >(in);
+    if (!in.empty())
+      errors.push_back(diagnostic(in.current(), "", after.empty() ? "expected `module`"
+                                                                  : "unexpected text after `endmodule` of '" + after + "'"));
+  }
+
+  // Parses the text of one module, [b, e) starting at its `module` keyword:
+  // in one go when it is clean, else item by item.
+  Piece module(const char* b, const char* e) const {
+    {
+      tao::pegtl::memory_input<> in(b, e, source_);
+      actions::State st;
+      st.source_begin = text_.data();
+      try {
+        if (tao::pegtl::parse< grammar::module, actions::action >(in, st)) {
+          Piece out;
+          out.name = st.modules_accum.front().module_name;
+          out.module = std::move(st.modules_accum.front());
+          outside(in.current(), e, out.errors, out.name);
+          return out;
+        }
+      } catch (const tao::pegtl::parse_error&) {
+      }
+    }
+    return recover_module(b, e);
+  }
+
+private:
+  Piece recover_module(const char* b, const char* e) const {
+    Piece out;
+    tao::pegtl::memory_input<> in(b, e, source_);
+    actions::State st;
+    st.source_begin = text_.data();
+
+    auto error_at = [&](const tao::pegtl::parse_error& x) {
+      return x.positions().empty() ? in.current() : b + x.positions().front().byte;
+    };
+    // Records the error, drops the half-built item and resumes after it.
+    auto recover = [&](const char* at, std::string message) {
+      out.errors.push_back(diagnostic(at, out.name, std::move(message)));
+      st.reset_item();
+      const char* to = resync(text_.data(), std::max(at, in.current()), e);
+      in.bump(size_t(to - in.current()));
+    };
+
+    try {
+      tao::pegtl::parse< grammar::module_header, actions::action >(in, st);
+      out.name = st.current_module.module_name;
+    } catch (const tao::pegtl::parse_error& x) {
+      out.name = name_after_module(b, e);
+      recover(error_at(x), std::string(x.message()));
+    }
+
+    bool ended = false;
+    for (;;) {
+      tao::pegtl::parse< grammar::sep >(in);
+      if (in.empty()) break;
+      if (grammar::peek_keyword(in) == Keyword::Endmodule) {
+        tao::pegtl::parse< grammar::kw_endmodule >(in);
+        ended = true;
+        break;
+      }
+      const char* item = in.current();
+      try {
+        if (tao::pegtl::parse< grammar::module_item, actions::action >(in, st)) continue;
+        recover(item, "expected a declaration, assign, instance or `endmodule`");
+      } catch (const tao::pegtl::parse_error& x) {
+        recover(error_at(x), std::string(x.message()));
+      }
+    }
+    if (!ended) out.errors.push_back(diagnostic(in.current(), out.name, "no `endmodule`"));
+    if (out.errors.empty()) {
+      st.current_module.span = st.span_of(b, in.current());
+      out.module = std::move(st.current_module);
+    }
+    if (ended) outside(in.current(), e, out.errors, out.name);
+    return out;
+  }
+
+  ParseDiagnostic diagnostic(const char* at, const std::string& module, std::string message) const {
+    const size_t off = size_t(at - text_.data());
+    return ParseDiagnostic{ source_, lines_.locate(uint32_t(std::min<size_t>(off, UINT32_MAX))), module, std::move(message) };
+  }
+
+  std::string_view text_;
+  const std::string& source_;
+  const LineTable& lines_;
+};
+
+} // namespace
+
+RecoveredNetlist parse_string_recovering(std::string_view text, const RecoverOptions& opts) {
+  static const scan::KeywordScanner find_module("module");
+  const char* const begin = text.data();
+  const char* const end = begin + text.size();
+  std::vector<const char*> starts;
+  for (const char* p = find_module.find(begin, begin, end); p != end; p = find_module.find(begin, p + 1, end))
+    starts.push_back(p);
+
+  auto lines = std::make_shared<const LineTable>(text, opts.source);
+  const Recoverer rec(text, opts.source, *lines);
+  std::vector<Piece> pieces(starts.size());
+  parallel::parallel_for(starts.size(), [&](size_t i) {
+    pieces[i] = rec.module(starts[i], i + 1 < starts.size() ? starts[i + 1] : end);
+  }, opts.threads);
+
+  RecoveredNetlist r;
+  rec.outside(begin, starts.empty() ? end : starts.front(), r.errors, "");
+  r.netlist.modules.reserve(pieces.size());
+  for (auto& p : pieces) {
+    if (p.module) r.netlist.modules.push_back(std::move(*p.module));
+    else r.dropped.push_back(p.name);
+    for (auto& d : p.errors) r.errors.push_back(std::move(d));
+  }
+#if VERILOGLIB_SOURCE_LOCATIONS
+  r.netlist.lines = std::move(lines);
+#endif
+  return r;
+}
+
+RecoveredNetlist parse_file_recovering(const std::string& path, RecoverOptions opts) {
+  std::ifstream ifs(path);
+  if (!ifs) throw parse_error("could not open file: " + path);
+  std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  opts.source = path;
+  return parse_string_recovering(content, opts);
+}
+
+} // namespace verilog
@@ -0,0 +1,592 @@
+#include "verilog_server.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unordered_set>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace verilog { namespace server {
+
+namespace {
+
+constexpr int kAcceptBackoffMs = 50;   // between accept() retries when out of descriptors
+
+std::runtime_error sys_error(const std::string& what) {
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+sockaddr_un unix_address(const std::string& path) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(addr.sun_path))
+    throw std::runtime_error("bad socket path '" + path + "'");
+  std::memcpy(addr.sun_path, path.data(), path.size());
+  return addr;
+}
+
+bool send_all(int fd, std::string_view data) {
+  while (!data.empty()) {
+    const ssize_t n = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (n < 0) { if (errno == EINTR) continue; return false; }
+    data.remove_prefix(size_t(n));
+  }
+  return true;
+}
+
+uint32_t load_u32(const char* p) {
+  uint32_t v = 0;
+  for (int i = 0; i < 4; ++i) v |= uint32_t(uint8_t(p[i])) << (8 * i);
+  return v;
+}
+
+void begin_frame(std::string& out, uint32_t id, uint8_t code) {
+  WireWriter w{ out };
+  w.u32(0);   // patched by end_frame
+  w.u32(id);
+  w.u8(code);
+}
+
+void end_frame(std::string& out, size_t start) {
+  const uint32_t len = uint32_t(out.size() - start - 4);
+  for (int i = 0; i < 4; ++i) out[start + i] = char(len >> (8 * i));
+}
+
+// Last module that no other module instantiates.
+std::string pick_top(const Netlist& nl) {
+  std::unordered_set<std::string_view> used;
+  for (const auto& m : nl.modules)
+    for (const auto& inst : m.module_instances) used.insert(inst.module_name);
+  for (auto it = nl.modules.rbegin(); it != nl.modules.rend(); ++it)
+    if (!used.count(it->module_name)) return it->module_name;
+  return nl.modules.empty() ? std::string() : nl.modules.back().module_name;
+}
+
+} // namespace
+
+// ---------- NetlistServer ----------
+
+struct NetlistServer::Design {
+  std::string name;
+  std::string top;
+  FrozenNetlist snap;
+  InterfaceTable ifaces;
+  uint64_t instances = 0;
+  std::unique_ptr<std::once_flag[]> graph_once;
+  mutable std::unique_ptr<std::unique_ptr<ModuleGraph>[]> graphs;
+
+  Design(std::string n, Netlist nl, std::string t)
+    : name(std::move(n)), snap(std::move(nl)), ifaces(snap.netlist()) {
+    top = t.empty() ? pick_top(snap.netlist()) : std::move(t);
+    for (const auto& m : snap.modules()) instances += m.module_instances.size();
+    graph_once.reset(new std::once_flag[snap.modules().size()]);
+    graphs.reset(new std::unique_ptr<ModuleGraph>[snap.modules().size()]);
+  }
+
+  const ModuleGraph& graph(const Module& m) const {
+    const size_t i = size_t(&m - snap.modules().data());
+    std::call_once(graph_once[i], [&] { graphs[i] = std::make_unique<ModuleGraph>(m, ifaces); });
+    return *graphs[i];
+  }
+
+  // Bits of a net, a bit select or a whole bus; empty if the name is unknown.
+  std::vector<NetId> net_bits(const ModuleGraph& g, std::string_view net) const {
+    std::vector<NetId> bits;
+    if (const NetId n = g.find_net(net); n != kNoNet) { bits.push_back(n); return bits; }
+    g.expr_bits(Identifier{ std::string(net) }, bits);
+    if (std::find(bits.begin(), bits.end(), kNoNet) != bits.end()) bits.clear();
+    return bits;
+  }
+};
+
+NetlistServer::NetlistServer(std::string socket_path) : path_(std::move(socket_path)) {}
+
+NetlistServer::~NetlistServer() { stop(); }
+
+void NetlistServer::add_design(std::string name, Netlist nl, std::string top) {
+  if (listen_fd_ >= 0) throw std::runtime_error("add_design: server already started");
+  if (design(name)) throw std::runtime_error("duplicate design '" + name + "'");
+  designs_.push_back(std::make_unique<Design>(std::move(name), std::move(nl), std::move(top)));
+}
+
+const NetlistServer::Design* NetlistServer::design(std::string_view name) const {
+  for (const auto& d : designs_) if (d->name == name) return d.get();
+  return nullptr;
+}
+
+void NetlistServer::start() {
+  if (listen_fd_ >= 0) return;
+  const sockaddr_un addr = unix_address(path_);
+
+  // Replace a stale socket from an earlier run, but never a regular file.
+  struct stat st{};
+  if (::lstat(path_.c_str(), &st) == 0) {
+    if (!S_ISSOCK(st.st_mode)) throw std::runtime_error("'" + path_ + "' exists and is not a socket");
+    ::unlink(path_.c_str());
+  }
+
+  if (::pipe(wake_) != 0) throw sys_error("pipe");
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) throw sys_error("socket");
+  if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 128) != 0) {
+    const auto err = sys_error("bind " + path_);
+    ::close(fd);
+    throw err;
+  }
+  listen_fd_ = fd;
+  acceptor_ = std::thread(&NetlistServer::accept_loop, this);
+}
+
+void NetlistServer::stop() {
+  if (listen_fd_ < 0) return;
+  const char b = 1;
+  (void)!::write(wake_[1], &b, 1);   // never drained: wakes every poll() for good
+  acceptor_.join();
+  {
+    std::lock_guard<std::mutex> lk(conns_mu_);
+    for (auto& c : conns_) ::shutdown(c.fd, SHUT_RDWR);   // unblocks a send() to a stalled client
+    for (auto& c : conns_) { c.th.join(); ::close(c.fd); }
+    conns_.clear();
+  }
+  ::close(listen_fd_);
+  ::unlink(path_.c_str());
+  ::close(wake_[0]);
+  ::close(wake_[1]);
+  listen_fd_ = wake_[0] = wake_[1] = -1;
+}
+
+// Joins and closes the connections whose threads have finished; conns_mu_ held.
+void NetlistServer::reap() {
+  for (auto it = conns_.begin(); it != conns_.end();) {
+    if (!it->done.load()) { ++it; continue; }
+    it->th.join();
+    ::close(it->fd);
+    it = conns_.erase(it);
+  }
+}
+
+void NetlistServer::accept_loop() {
+  for (;;) {
+    pollfd p[2] = { { listen_fd_, POLLIN, 0 }, { wake_[0], POLLIN, 0 } };
+    if (::poll(p, 2, -1) < 0) { if (errno == EINTR) continue; return; }
+    if (p[1].revents) return;
+    const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN || errno == EWOULDBLOCK) continue;
+      // Out of descriptors or memory (EMFILE, ENFILE, ENOBUFS, ...): the
+      // connection stays queued and poll() would report it again at once.
+      // Free what finished and wait a little, still waking on stop().
+      {
+        std::lock_guard<std::mutex> lk(conns_mu_);
+        reap();
+      }
+      pollfd w = { wake_[0], POLLIN, 0 };
+      if (::poll(&w, 1, kAcceptBackoffMs) > 0) return;
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lk(conns_mu_);
+    reap();
+    Conn& c = conns_.emplace_back();
+    c.fd = fd;
+    c.th = std::thread(&NetlistServer::serve, this, &c);
+  }
+}
+
+// Reads whatever has arrived, answers every complete frame in it and writes
+// all the answers with one send(): a pipelined batch costs one write per
+// read rather than one per request.
+void NetlistServer::serve(Conn* c) {
+  std::string in, out;
+  std::vector<char> buf(64 * 1024);
+  for (;;) {
+    pollfd p[2] = { { c->fd, POLLIN, 0 }, { wake_[0], POLLIN, 0 } };
+    if (::poll(p, 2, -1) < 0) { if (errno == EINTR) continue; break; }
+    if (p[1].revents) break;
+    const ssize_t n = ::recv(c->fd, buf.data(), buf.size(), 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    in.append(buf.data(), size_t(n));
+
+    size_t pos = 0;
+    bool bad = false;
+    while (in.size() - pos >= 4) {
+      const uint32_t len = load_u32(in.data() + pos);
+      if (len < 5 || len > kMaxFrame) { bad = true; break; }
+      if (in.size() - pos - 4 < len) break;
+      handle(std::string_view(in).substr(pos + 4, len), out);
+      pos += 4 + size_t(len);
+    }
+    in.erase(0, pos);
+    if (!out.empty() && !send_all(c->fd, out)) break;
+    out.clear();
+    if (bad) break;
+  }
+  c->done = true;
+}
+
+void NetlistServer::handle(std::string_view body, std::string& out) const {
+  WireReader rd{ body };
+  const uint32_t id = rd.u32();
+  const uint8_t op = rd.u8();
+  const size_t start = out.size();
+  begin_frame(out, id, uint8_t(Status::Ok));
+  WireWriter w{ out };
+
+  auto fail = [&](Status s, const std::string& msg) {
+    out.resize(start);
+    begin_frame(out, id, uint8_t(s));
+    w.str(msg);
+  };
+  auto need_design = [&]() -> const Design* {
+    const std::string_view name = rd.str();
+    const Design* d = design(name);
+    if (!d) fail(Status::NotFound, "no design '" + std::string(name) + "'");
+    return d;
+  };
+
+  try {
+    switch (Op(op)) {
+      case Op::Ping:
+        break;
+
+      case Op::ListDesigns:
+        w.u32(uint32_t(designs_.size()));
+        for (const auto& d : designs_) {
+          w.str(d->name); w.str(d->top); w.u64(d->snap.modules().size()); w.u64(d->instances);
+        }
+        break;
+
+      case Op::ListModules: {
+        const Design* d = need_design();
+        if (!d) break;
+        w.u32(uint32_t(d->snap.modules().size()));
+        for (const auto& m : d->snap.modules()) w.str(m.module_name);
+        break;
+      }
+
+      case Op::FindInstance: {
+        const Design* d = need_design();
+        if (!d) break;
+        const std::string_view mod = rd.str(), name = rd.str();
+        const Module* m = d->snap.find_module(mod);
+        const ModuleInstance* inst = m ? d->snap.find_instance(*m, name) : nullptr;
+        if (!inst) { fail(Status::NotFound, "no instance '" + std::string(name) + "' in '" + std::string(mod) + "'"); break; }
+        const ModuleInterface* master = d->ifaces.find(inst->module_name);
+        w.str(inst->module_name);
+        w.u32(uint32_t(inst->ports_pos.size() + inst->ports_named.size()));
+        for (size_t k = 0; k < inst->ports_pos.size(); ++k) {
+          w.str(master && k < master->ports.size() ? master->ports[k] : "#" + std::to_string(k));
+          w.str(expr_to_string(inst->ports_pos[k]));
+        }
+        for (const auto& [pin, e] : inst->ports_named) { w.str(pin); w.str(expr_to_string(e)); }
+        break;
+      }
+
+      case Op::NetFanout: {
+        const Design* d = need_design();
+        if (!d) break;
+        const std::string_view mod = rd.str(), net = rd.str();
+        const Module* m = d->snap.find_module(mod);
+        if (!m) { fail(Status::NotFound, "no module '" + std::string(mod) + "'"); break; }
+        const ModuleGraph& g = d->graph(*m);
+        const std::vector<NetId> bits = d->net_bits(g, net);
+        if (bits.empty()) { fail(Status::NotFound, "no net '" + std::string(net) + "' in '" + std::string(mod) + "'"); break; }
+        const ModuleInterface* self = d->ifaces.find(m->module_name);
+
+        size_t n = 0;
+        for (NetId b : bits) n += g.net_pins(b).size();
+        w.u32(uint32_t(n));
+        for (NetId b : bits) {
+          for (uint32_t pi : g.net_pins(b)) {
+            const ModuleGraph::Pin& p = g.pins()[pi];
+            const uint32_t ref = g.node_ref(p.node);
+            const ModuleInterface* owner = nullptr;
+            switch (g.node_kind(p.node)) {
+              case ModuleGraph::NodeKind::Port:     w.str(m->port_list[ref]); owner = self; break;
+              case ModuleGraph::NodeKind::Instance: w.str(m->module_instances[ref].instance_name); owner = g.node_master(p.node); break;
+              case ModuleGraph::NodeKind::Assign:   w.str("assign#" + std::to_string(ref)); break;
+              case ModuleGraph::NodeKind::Gate: {
+                const auto [type, row] = g.gate_ref(p.node);
+                w.str(m->gate_label(type, row));
+                break;
+              }
+            }
+            std::string pin = g.pin_name(p);
+            if (owner && p.port != ModuleInterface::npos && p.port < owner->widths.size() && owner->widths[p.port] > 1)
+              pin += "[" + std::to_string(p.bit) + "]";
+            w.str(pin);
+            w.u8(uint8_t(p.dir));
+          }
+        }
+        break;
+      }
+
+      case Op::ResolvePath: {
+        const Design* d = need_design();
+        if (!d) break;
+        const std::string_view path = rd.str();
+        std::vector<std::string_view> segs;
+        for (size_t b = 0; b <= path.size();) {
+          const size_t e = std::min(path.find('/', b), path.size());
+          if (e > b) segs.push_back(path.substr(b, e - b));
+          b = e + 1;
+        }
+
+        const Module* cur = d->snap.find_module(d->top);
+        if (!cur) { fail(Status::NotFound, "top '" + d->top + "' is not defined"); break; }
+        size_t i = 0;
+        if (!segs.empty() && segs[0] == d->top && !d->snap.find_instance(*cur, segs[0])) i = 1;
+
+        std::vector<const ModuleInstance*> hops;
+        PathEnd end = PathEnd::Instance;
+        std::string_view last;
+        bool ok = true;
+        for (; i < segs.size() && ok; ++i) {
+          if (cur) {
+            if (const ModuleInstance* inst = d->snap.find_instance(*cur, segs[i])) {
+              hops.push_back(inst);
+              cur = d->snap.find_module(inst->module_name);
+              continue;
+            }
+          }
+          ok = i + 1 == segs.size();   // only the final segment may be a pin or a net
+          if (!ok) break;
+          last = segs[i];
+          if (!hops.empty()) {
+            const ModuleInstance* inst = hops.back();
+            const ModuleInterface* mi = d->ifaces.find(inst->module_name);
+            if ((mi && mi->find(last) != ModuleInterface::npos) || inst->ports_named.count(std::string(last))) {
+              end = PathEnd::Pin;
+              break;
+            }
+          }
+          ok = cur && !d->net_bits(d->graph(*cur), last).empty();
+          end = PathEnd::Net;
+        }
+        if (!ok) { fail(Status::NotFound, "cannot resolve '" + std::string(path) + "'"); break; }
+        w.u32(uint32_t(hops.size()));
+        for (const ModuleInstance* h : hops) { w.str(h->instance_name); w.str(h->module_name); }
+        w.u8(uint8_t(end));
+        w.str(end == PathEnd::Instance ? std::string_view() : last);
+        break;
+      }
+
+      default:
+        fail(Status::BadRequest, "unknown op " + std::to_string(op));
+    }
+    if (out.size() > start && Status(uint8_t(out[start + 8])) == Status::Ok && !rd.done())
+      fail(Status::BadRequest, "trailing bytes in request");
+  } catch (const protocol_error& e) {
+    fail(Status::BadRequest, e.what());
+  } catch (const std::exception& e) {
+    fail(Status::Error, e.what());
+  }
+  end_frame(out, start);
+}
+
+// ---------- NetlistClient ----------
+
+namespace {
+
+// Ok: true. NotFound: false. Anything else throws with the server's message.
+bool check(const NetlistClient::Response& r) {
+  if (r.status == Status::Ok) return true;
+  if (r.status == Status::NotFound) return false;
+  WireReader rd{ r.payload };
+  throw std::runtime_error("vparsed: " + std::string(rd.str()));
+}
+
+InstanceInfo decode_instance(WireReader& rd) {
+  InstanceInfo info;
+  info.master = rd.str();
+  const uint32_t n = rd.u32();
+  info.connections.reserve(n);
+  for (uint32_t i = 0; i < n; ++i) {
+    std::string pin(rd.str());
+    info.connections.emplace_back(std::move(pin), std::string(rd.str()));
+  }
+  return info;
+}
+
+PathInfo decode_path(WireReader& rd) {
+  PathInfo info;
+  const uint32_t n = rd.u32();
+  info.hops.reserve(n);
+  for (uint32_t i = 0; i < n; ++i) {
+    std::string inst(rd.str());
+    info.hops.emplace_back(std::move(inst), std::string(rd.str()));
+  }
+  info.end = PathEnd(rd.u8());
+  info.name = rd.str();
+  return info;
+}
+
+} // namespace
+
+NetlistClient::NetlistClient(const std::string& socket_path) {
+  const sockaddr_un addr = unix_address(socket_path);
+  fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd_ < 0) throw sys_error("socket");
+  if (::connect(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+    const auto err = sys_error("connect " + socket_path);
+    ::close(fd_);
+    throw err;
+  }
+}
+
+NetlistClient::~NetlistClient() { if (fd_ >= 0) ::close(fd_); }
+
+uint32_t NetlistClient::post(Op op, std::string_view payload) {
+  const uint32_t id = next_id_++;
+  const size_t start = out_.size();
+  begin_frame(out_, id, uint8_t(op));
+  out_.append(payload);
+  end_frame(out_, start);
+  return id;
+}
+
+void NetlistClient::flush() {
+  if (!send_all(fd_, out_)) throw sys_error("vparsed: send");
+  out_.clear();
+}
+
+NetlistClient::Response NetlistClient::next() {
+  for (;;) {
+    const size_t avail = in_.size() - in_pos_;
+    if (avail >= 4) {
+      const uint32_t len = load_u32(in_.data() + in_pos_);
+      if (len < 5 || len > kMaxFrame) throw protocol_error("vparsed: bad frame length");
+      if (avail - 4 >= len) {
+        WireReader rd{ std::string_view(in_).substr(in_pos_ + 4, len) };
+        Response r;
+        r.id = rd.u32();
+        r.status = Status(rd.u8());
+        r.payload.assign(rd.in.substr(rd.pos));
+        in_pos_ += 4 + size_t(len);
+        return r;
+      }
+    }
+    if (in_pos_ > 0) { in_.erase(0, in_pos_); in_pos_ = 0; }
+    char buf[64 * 1024];
+    const ssize_t n = ::recv(fd_, buf, sizeof(buf), 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) throw sys_error("vparsed: recv");
+    if (n == 0) throw std::runtime_error("vparsed: connection closed");
+    in_.append(buf, size_t(n));
+  }
+}
+
+NetlistClient::Response NetlistClient::call(Op op, std::string_view payload) {
+  const uint32_t id = post(op, payload);
+  flush();
+  Response r = next();
+  if (r.id != id) throw protocol_error("vparsed: response out of order");
+  return r;
+}
+
+template<typename T, typename Encode, typename Decode>
+std::vector<std::optional<T>> NetlistClient::batch(size_t n, size_t window, Op op, Encode enc, Decode dec) {
+  std::vector<std::optional<T>> res(n);
+  window = std::max<size_t>(1, window);
+  std::string payload;
+  for (size_t b = 0; b < n; b += window) {
+    const size_t e = std::min(n, b + window);
+    uint32_t first = 0;
+    for (size_t i = b; i < e; ++i) {
+      payload.clear();
+      enc(i, payload);
+      const uint32_t id = post(op, payload);
+      if (i == b) first = id;
+    }
+    flush();
+    for (size_t i = b; i < e; ++i) {
+      Response r = next();
+      if (r.id != first + uint32_t(i - b)) throw protocol_error("vparsed: response out of order");
+      if (!check(r)) continue;
+      WireReader rd{ r.payload };
+      res[i] = dec(rd);
+    }
+  }
+  return res;
+}
+
+void NetlistClient::ping() { check(call(Op::Ping, {})); }
+
+std::vector<DesignInfo> NetlistClient::list_designs() {
+  const Response r = call(Op::ListDesigns, {});
+  check(r);
+  WireReader rd{ r.payload };
+  std::vector<DesignInfo> out(rd.u32());
+  for (auto& d : out) {
+    d.name = rd.str(); d.top = rd.str(); d.modules = rd.u64(); d.instances = rd.u64();
+  }
+  return out;
+}
+
+std::vector<std::string> NetlistClient::list_modules(std::string_view design) {
+  std::string p;
+  WireWriter{ p }.str(design);
+  const Response r = call(Op::ListModules, p);
+  if (!check(r)) throw std::runtime_error("vparsed: no design '" + std::string(design) + "'");
+  WireReader rd{ r.payload };
+  std::vector<std::string> out(rd.u32());
+  for (auto& m : out) m = rd.str();
+  return out;
+}
+
+std::optional<InstanceInfo> NetlistClient::find_instance(std::string_view design, std::string_view module, std::string_view inst) {
+  std::string p;
+  WireWriter w{ p };
+  w.str(design); w.str(module); w.str(inst);
+  const Response r = call(Op::FindInstance, p);
+  if (!check(r)) return std::nullopt;
+  WireReader rd{ r.payload };
+  return decode_instance(rd);
+}
+
+std::optional<FanoutInfo> NetlistClient::net_fanout(std::string_view design, std::string_view module, std::string_view net) {
+  std::string p;
+  WireWriter w{ p };
+  w.str(design); w.str(module); w.str(net);
+  const Response r = call(Op::NetFanout, p);
+  if (!check(r)) return std::nullopt;
+  WireReader rd{ r.payload };
+  FanoutInfo info;
+  info.pins.resize(rd.u32());
+  for (auto& pin : info.pins) {
+    pin.node = rd.str(); pin.pin = rd.str(); pin.dir = PortDir(rd.u8());
+  }
+  return info;
+}
+
+std::optional<PathInfo> NetlistClient::resolve_path(std::string_view design, std::string_view path) {
+  std::string p;
+  WireWriter w{ p };
+  w.str(design); w.str(path);
+  const Response r = call(Op::ResolvePath, p);
+  if (!check(r)) return std::nullopt;
+  WireReader rd{ r.payload };
+  return decode_path(rd);
+}
+
+std::vector<std::optional<InstanceInfo>>
+NetlistClient::find_instance_batch(std::string_view design, std::string_view module,
+                                   const std::vector<std::string>& insts, size_t window) {
+  return batch<InstanceInfo>(insts.size(), window, Op::FindInstance,
+    [&](size_t i, std::string& p) { WireWriter w{ p }; w.str(design); w.str(module); w.str(insts[i]); },
+    decode_instance);
+}
+
+std::vector<std::optional<PathInfo>>
+NetlistClient::resolve_path_batch(std::string_view design, const std::vector<std::string>& paths, size_t window) {
+  return batch<PathInfo>(paths.size(), window, Op::ResolvePath,
+    [&](size_t i, std::string& p) { WireWriter w{ p }; w.str(design); w.str(paths[i]); },
+    decode_path);
+}
+
+}} // namespace verilog::server
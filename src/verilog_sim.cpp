@@ -0,0 +1,443 @@
+#include "verilog_sim.hpp"
+#include "verilog_levelize.hpp"
+#include "verilog_parallel.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace verilog {
+
+namespace {
+
+using Kind = ModuleGraph::NodeKind;
+
+// Op kinds: the eight GateType values, then these.
+enum : uint8_t { kCopy = kNumGateTypes, kTable };
+
+constexpr size_t kLanes = 4;   // words per operation
+typedef uint64_t Word4 __attribute__((vector_size(32)));
+// Element of the value array. Without AVX enabled GCC aligns Word4 to 16
+// bytes only, which the AVX2 kernel's aligned loads would fault on.
+struct alignas(32) Slot { Word4 w; };
+
+bool drives(PortDir d) { return d != PortDir::Input; }
+bool loads(PortDir d) { return d != PortDir::Output; }
+
+struct Program {
+  const uint8_t* op;
+  const uint32_t* arg_begin;
+  const uint32_t* args;
+  const uint8_t* nout;
+  const uint32_t* table;
+  const uint64_t* tables;
+  size_t size;
+};
+
+// One pass over the program for four words of vectors. Compiled twice: for
+// the baseline target, where a Word4 operation is two SSE2 instructions, and
+// for AVX2, where it is one.
+[[gnu::always_inline]] inline void evaluate(const Program& p, Word4* v) {
+  const Word4 ones = ~Word4{};
+  for (size_t k = 0; k < p.size; ++k) {
+    const uint32_t* out = p.args + p.arg_begin[k];
+    const uint32_t nout = p.nout[k];
+    const uint32_t* in = out + nout;
+    const uint32_t nin = p.arg_begin[k + 1] - p.arg_begin[k] - nout;
+    switch (p.op[k]) {
+      case uint8_t(GateType::And):
+      case uint8_t(GateType::Nand): {
+        Word4 r = ones;
+        for (uint32_t i = 0; i < nin; ++i) r &= v[in[i]];
+        v[out[0]] = p.op[k] == uint8_t(GateType::Nand) ? ~r : r;
+        break;
+      }
+      case uint8_t(GateType::Or):
+      case uint8_t(GateType::Nor): {
+        Word4 r = {};
+        for (uint32_t i = 0; i < nin; ++i) r |= v[in[i]];
+        v[out[0]] = p.op[k] == uint8_t(GateType::Nor) ? ~r : r;
+        break;
+      }
+      case uint8_t(GateType::Xor):
+      case uint8_t(GateType::Xnor): {
+        Word4 r = {};
+        for (uint32_t i = 0; i < nin; ++i) r ^= v[in[i]];
+        v[out[0]] = p.op[k] == uint8_t(GateType::Xnor) ? ~r : r;
+        break;
+      }
+      case uint8_t(GateType::Buf):
+      case uint8_t(GateType::Not): {
+        const Word4 r = p.op[k] == uint8_t(GateType::Not) ? ~v[in[0]] : v[in[0]];
+        for (uint32_t o = 0; o < nout; ++o) v[out[o]] = r;
+        break;
+      }
+      case kCopy:
+        for (uint32_t o = 0; o < nout; ++o) v[out[o]] = v[in[o]];
+        break;
+      case kTable: {
+        // Shannon expansion from the table up: each round folds the rows
+        // that differ in one input into a mux on that input.
+        const uint64_t* tt = p.tables + p.table[k];
+        for (uint32_t o = 0; o < nout; ++o) {
+          Word4 f[size_t(1) << CellFunctions::kMaxInputs];
+          uint32_t rows = 1u << nin;
+          for (uint32_t r = 0; r < rows; ++r) f[r] = (tt[o] >> r & 1) ? ones : Word4{};
+          for (uint32_t j = 0; j < nin; ++j) {
+            const Word4 x = v[in[j]];
+            rows >>= 1;
+            for (uint32_t r = 0; r < rows; ++r) f[r] = (x & f[2 * r + 1]) | (~x & f[2 * r]);
+          }
+          v[out[o]] = f[0];
+        }
+        break;
+      }
+    }
+  }
+}
+
+void evaluate_baseline(const Program& p, Word4* v) { evaluate(p, v); }
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+__attribute__((target("avx2"))) void evaluate_avx2(const Program& p, Word4* v) { evaluate(p, v); }
+bool have_avx2() {
+  static const bool has = __builtin_cpu_supports("avx2");
+  return has;
+}
+#else
+void evaluate_avx2(const Program& p, Word4* v) { evaluate(p, v); }
+bool have_avx2() { return false; }
+#endif
+
+// Random words for one named input: a function of the seed, the name and the
+// word index only, so both sides of an equivalence check agree without
+// sharing a table.
+uint64_t mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+} // namespace
+
+void CellFunctions::add(std::string master, CellFunction f) {
+  if (f.inputs.size() > kMaxInputs)
+    throw std::invalid_argument("cell " + master + ": more than " + std::to_string(kMaxInputs) + " inputs");
+  if (f.tables.size() != f.outputs.size())
+    throw std::invalid_argument("cell " + master + ": " + std::to_string(f.outputs.size()) + " outputs but " +
+                                std::to_string(f.tables.size()) + " truth tables");
+  by_name_.insert_or_assign(std::move(master), std::move(f));
+}
+
+void CellFunctions::add(std::string master, std::vector<std::string> inputs, std::string output, uint64_t table) {
+  add(std::move(master), CellFunction{ std::move(inputs), { std::move(output) }, { table } });
+}
+
+const CellFunction* CellFunctions::find(std::string_view master) const {
+  auto it = by_name_.find(master);
+  return it == by_name_.end() ? nullptr : &it->second;
+}
+
+void CellFunctions::add_interfaces(InterfaceTable& t) const {
+  for (const auto& [name, f] : by_name_) {
+    ModuleInterface mi;
+    mi.name = name;
+    for (const auto& p : f.inputs) {
+      mi.ports.push_back(p);
+      mi.dirs.push_back(PortDir::Input);
+    }
+    for (const auto& p : f.outputs) {
+      mi.ports.push_back(p);
+      mi.dirs.push_back(PortDir::Output);
+    }
+    mi.widths.assign(mi.ports.size(), 1);
+    mi.index();
+    t.add(std::move(mi));
+  }
+}
+
+void Simulator::slots(const Expr& e, std::vector<uint32_t>& out) const {
+  if (const auto* c = std::get_if<Constant>(&e)) {
+    for (uint32_t i = c->value.width(); i-- > 0;) out.push_back(c->value.bit(i) == '1' ? const1_ : const0_);
+    return;
+  }
+  if (const auto* cat = std::get_if<std::shared_ptr<Concatenation>>(&e)) {
+    for (const auto& el : (*cat)->elements) slots(el, out);
+    return;
+  }
+  std::vector<NetId> bits;
+  g_->expr_bits(e, bits);
+  for (NetId n : bits) out.push_back(slot_of(n));
+}
+
+void Simulator::add_op(uint8_t op, std::span<const uint32_t> outs, std::span<const uint32_t> ins, uint32_t table) {
+  op_.push_back(op);
+  nout_.push_back(uint8_t(outs.size()));
+  table_.push_back(table);
+  for (uint32_t o : outs) args_.push_back(o == const0_ || o == const1_ ? sink_ : o);   // supplies keep their value
+  args_.insert(args_.end(), ins.begin(), ins.end());
+  arg_begin_.push_back(uint32_t(args_.size()));
+}
+
+Simulator::Simulator(const ModuleGraph& g, const CellFunctions& cells, SimOptions opts)
+    : g_(&g), opts_(std::move(opts)) {
+  const Module& m = g.module();
+  const uint32_t nets = uint32_t(g.num_nets());
+  const0_ = nets;
+  const1_ = nets + 1;
+  sink_ = nets + 2;
+  num_slots_ = nets + 3;
+  net_slot_.resize(nets);
+  for (NetId n = 0; n < nets; ++n) net_slot_[n] = n;
+  for (const auto& d : m.net_declarations) {
+    if (d.type != NetType::Supply0 && d.type != NetType::Supply1) continue;
+    for (const auto& name : d.names) {
+      const uint32_t b = g.find_bus(name);
+      if (b == ModuleInterface::npos) continue;
+      const auto& bus = g.bus(b);
+      const NetId width = NetId(std::abs(bus.start - bus.end) + 1);
+      for (NetId k = 0; k < width; ++k) net_slot_[bus.first + k] = d.type == NetType::Supply1 ? const1_ : const0_;
+    }
+  }
+
+  LevelizeOptions lo;
+  lo.sequential = opts_.sequential;
+  const Schedule s = levelize(g, lo);
+  if (s.num_loops()) {
+    std::string names;
+    for (uint32_t n : s.loop(0)) {
+      if (!names.empty()) names += ", ";
+      switch (g.node_kind(n)) {
+        case Kind::Instance: names += m.module_instances[g.node_ref(n)].instance_name; break;
+        case Kind::Gate: names += m.gate_label(g.gate_ref(n).first, g.gate_ref(n).second); break;
+        default: names += "assign#" + std::to_string(g.node_ref(n)); break;
+      }
+    }
+    throw std::runtime_error("module " + m.module_name + ": combinational loop through " + names);
+  }
+
+  std::vector<std::pair<uint32_t, uint32_t>> assign_of;   // flattened pair -> (statement, pair)
+  for (uint32_t st = 0; st < m.assignments.size(); ++st)
+    for (uint32_t k = 0; k < m.assignments[st].assignments.size(); ++k) assign_of.emplace_back(st, k);
+
+  std::vector<uint32_t> outs, ins, bits;
+  auto lsb = [&](const Expr* e, uint32_t missing) {
+    if (!e) return missing;
+    bits.clear();
+    slots(*e, bits);
+    return bits.empty() ? missing : bits.back();
+  };
+  std::vector<std::pair<std::string_view, const Expr*>> conns;
+  auto conn = [&](std::string_view pin) -> const Expr* {
+    for (const auto& [name, e] : conns)
+      if (name == pin) return e;
+    return nullptr;
+  };
+
+  for (size_t l = 0; l < s.num_levels(); ++l) {
+    for (uint32_t n : s.level_nodes(l)) {
+      outs.clear();
+      ins.clear();
+      switch (g.node_kind(n)) {
+        case Kind::Assign: {
+          const auto [st, k] = assign_of[g.node_ref(n)];
+          const auto& [lhs, rhs] = m.assignments[st].assignments[k];
+          slots(lhs, outs);
+          slots(rhs, ins);
+          // Aligned at the LSB: extra rhs bits are dropped, missing ones are 0.
+          if (ins.size() > outs.size()) ins.erase(ins.begin(), ins.end() - outs.size());
+          else ins.insert(ins.begin(), outs.size() - ins.size(), const0_);
+          add_op(kCopy, outs, ins);
+          break;
+        }
+        case Kind::Gate: {
+          const auto [t, row] = g.gate_ref(n);
+          const auto terms = m.gates[size_t(t)].terminals_of(row);
+          const uint32_t no = gate_outputs(t, uint32_t(terms.size()));
+          for (uint32_t i = 0; i < terms.size(); ++i) (i < no ? outs : ins).push_back(lsb(&terms[i], i < no ? sink_ : const0_));
+          if ((t == GateType::Buf || t == GateType::Not) && ins.empty()) ins.push_back(const0_);
+          add_op(uint8_t(t), outs, ins);
+          break;
+        }
+        case Kind::Instance: {
+          const ModuleInstance& inst = m.module_instances[g.node_ref(n)];
+          const CellFunction* f = cells.find(inst.module_name);
+          if (!f)
+            throw std::runtime_error("module " + m.module_name + ": no function for cell " + inst.module_name +
+                                     " (instance " + inst.instance_name + ")");
+          // Positional connections follow the master's ports, or the
+          // function's inputs then outputs when the graph has no interface.
+          const ModuleInterface* master = g.node_master(n);
+          conns.clear();
+          for (size_t k = 0; k < inst.ports_pos.size(); ++k) {
+            std::string_view name;
+            if (master) name = k < master->ports.size() ? std::string_view(master->ports[k]) : std::string_view();
+            else if (k < f->inputs.size()) name = f->inputs[k];
+            else if (k - f->inputs.size() < f->outputs.size()) name = f->outputs[k - f->inputs.size()];
+            conns.emplace_back(name, &inst.ports_pos[k]);
+          }
+          for (const auto& [key, e] : inst.ports_named) conns.emplace_back(key, &e);
+          for (const auto& o : f->outputs) outs.push_back(lsb(conn(o), sink_));
+          for (const auto& i : f->inputs) ins.push_back(lsb(conn(i), const0_));
+          add_op(kTable, outs, ins, uint32_t(tables_.size()));
+          tables_.insert(tables_.end(), f->tables.begin(), f->tables.end());
+          break;
+        }
+        case Kind::Port: break;
+      }
+    }
+    level_begin_.push_back(uint32_t(op_.size()));
+  }
+
+  // Module ports first, then the pins of state elements.
+  for (uint32_t i = 0; i < m.port_list.size(); ++i) {
+    for (const auto& p : g.node_pins(i)) {
+      if (p.dir == PortDir::Unknown) continue;
+      if (drives(p.dir)) {
+        input_slot_.push_back(slot_of(p.net) == p.net ? p.net : sink_);
+        input_name_.push_back(g.net_name(p.net));
+      }
+      if (loads(p.dir)) {
+        output_slot_.push_back(slot_of(p.net));
+        output_name_.push_back(g.net_name(p.net));
+      }
+    }
+  }
+  for (uint32_t n : s.sequential) {
+    const ModuleInstance& inst = m.module_instances[g.node_ref(n)];
+    const ModuleInterface* master = g.node_master(n);
+    for (const auto& p : g.node_pins(n)) {
+      std::string name = inst.instance_name + "." + g.pin_name(p);
+      if (master && p.port != ModuleInterface::npos && master->widths[p.port] > 1) name += "[" + std::to_string(p.bit) + "]";
+      if (drives(p.dir)) {
+        input_slot_.push_back(slot_of(p.net) == p.net ? p.net : sink_);
+        input_name_.push_back(name);
+      }
+      if (loads(p.dir)) {
+        output_slot_.push_back(slot_of(p.net));
+        output_name_.push_back(std::move(name));
+      }
+    }
+  }
+}
+
+void Simulator::run(std::span<const uint64_t> in, std::span<uint64_t> out, size_t words) const {
+  const size_t ni = num_inputs(), no = num_outputs();
+  if (in.size() < ni * words || out.size() < no * words)
+    throw std::invalid_argument("simulation: " + std::to_string(words) + " words need " + std::to_string(ni * words) +
+                                " input and " + std::to_string(no * words) + " output words");
+  const Program p{ op_.data(), arg_begin_.data(), args_.data(), nout_.data(), table_.data(), tables_.data(), op_.size() };
+  const bool wide = opts_.avx2 && have_avx2();
+  const size_t blocks = (words + kLanes - 1) / kLanes;
+  const unsigned threads = opts_.threads ? opts_.threads : parallel::default_threads();
+  const size_t chunks = std::max<size_t>(1, std::min<size_t>(threads, blocks));
+
+  // Each worker takes a contiguous run of blocks with its own value array.
+  // Nets that nothing drives stay 0, as the array starts out; every other
+  // slot is rewritten before it is read.
+  parallel::parallel_for(chunks, [&](size_t c) {
+    std::vector<Slot> slots(num_slots_, Slot{});
+    Word4* v = &slots[0].w;
+    v[const1_] = ~Word4{};
+    for (size_t b = blocks * c / chunks; b < blocks * (c + 1) / chunks; ++b) {
+      const size_t w0 = b * kLanes, lanes = std::min(kLanes, words - w0);
+      for (size_t i = 0; i < ni; ++i) {
+        Word4& x = v[input_slot_[i]];
+        for (size_t w = 0; w < kLanes; ++w) x[w] = w < lanes ? in[i * words + w0 + w] : 0;
+      }
+      if (wide) evaluate_avx2(p, v);
+      else evaluate_baseline(p, v);
+      for (size_t i = 0; i < no; ++i)
+        for (size_t w = 0; w < lanes; ++w) out[i * words + w0 + w] = v[output_slot_[i]][w];
+    }
+  }, unsigned(chunks), 1);
+}
+
+std::string EquivalenceResult::report() const {
+  std::string s;
+  if (equivalent()) return "equivalent on " + std::to_string(vectors) + " random vectors\n";
+  auto list = [&](const char* what, const std::vector<std::string>& names) {
+    if (names.empty()) return;
+    s += what;
+    for (size_t i = 0; i < names.size(); ++i) s += (i ? ", " : " ") + names[i];
+    s += "\n";
+  };
+  list("only in a:", only_in_a);
+  list("only in b:", only_in_b);
+  if (!mismatched.empty()) {
+    s += std::to_string(mismatched.size()) + " of the outputs differ on " + std::to_string(vectors) + " random vectors:";
+    for (size_t i = 0; i < mismatched.size(); ++i) s += (i ? ", " : " ") + mismatched[i];
+    s += "\n";
+  }
+  if (!counterexample.empty()) {
+    s += "counterexample:";
+    for (const auto& [name, value] : counterexample) s += " " + name + "=" + (value ? "1" : "0");
+    s += "\n";
+  }
+  return s;
+}
+
+EquivalenceResult simulate_equivalence(const ModuleGraph& a, const ModuleGraph& b, const CellFunctions& cells,
+                                       const EquivalenceOptions& opts) {
+  SimOptions so;
+  so.sequential = opts.sequential;
+  so.threads = opts.threads;
+  const Simulator sa(a, cells, so), sb(b, cells, so);
+  const size_t words = std::max<size_t>(1, (opts.vectors + 63) / 64);
+  EquivalenceResult r;
+  r.vectors = words * 64;
+
+  auto index = [](const Simulator& sim, bool inputs) {
+    std::unordered_map<std::string_view, size_t> ix;
+    const size_t n = inputs ? sim.num_inputs() : sim.num_outputs();
+    for (size_t i = 0; i < n; ++i) ix.emplace(inputs ? sim.input_name(i) : sim.output_name(i), i);
+    return ix;
+  };
+  const auto a_in = index(sa, true), b_in = index(sb, true), a_out = index(sa, false), b_out = index(sb, false);
+  for (size_t i = 0; i < sa.num_inputs(); ++i)
+    if (!b_in.count(sa.input_name(i))) r.only_in_a.push_back(sa.input_name(i));
+  for (size_t i = 0; i < sa.num_outputs(); ++i)
+    if (!b_out.count(sa.output_name(i))) r.only_in_a.push_back(sa.output_name(i));
+  for (size_t i = 0; i < sb.num_inputs(); ++i)
+    if (!a_in.count(sb.input_name(i))) r.only_in_b.push_back(sb.input_name(i));
+  for (size_t i = 0; i < sb.num_outputs(); ++i)
+    if (!a_out.count(sb.output_name(i))) r.only_in_b.push_back(sb.output_name(i));
+
+  auto stimulus = [&](const Simulator& sim) {
+    std::vector<uint64_t> in(sim.num_inputs() * words);
+    for (size_t i = 0; i < sim.num_inputs(); ++i) {
+      const uint64_t key = mix(opts.seed ^ std::hash<std::string_view>{}(sim.input_name(i)));
+      for (size_t w = 0; w < words; ++w) in[i * words + w] = mix(key + w);
+    }
+    return in;
+  };
+  const std::vector<uint64_t> in_a = stimulus(sa), in_b = stimulus(sb);
+  std::vector<uint64_t> out_a(sa.num_outputs() * words), out_b(sb.num_outputs() * words);
+  sa.run(in_a, out_a, words);
+  sb.run(in_b, out_b, words);
+
+  size_t first = r.vectors;   // first failing vector
+  for (size_t i = 0; i < sa.num_outputs(); ++i) {
+    auto it = b_out.find(sa.output_name(i));
+    if (it == b_out.end()) continue;
+    const uint64_t* x = &out_a[i * words];
+    const uint64_t* y = &out_b[it->second * words];
+    for (size_t w = 0; w < words; ++w) {
+      if (x[w] == y[w]) continue;
+      r.mismatched.push_back(sa.output_name(i));
+      first = std::min(first, w * 64 + size_t(__builtin_ctzll(x[w] ^ y[w])));
+      break;
+    }
+  }
+  if (first < r.vectors) {
+    const size_t w = first / 64, bit = first % 64;
+    for (size_t i = 0; i < sa.num_inputs(); ++i) r.counterexample.emplace_back(sa.input_name(i), in_a[i * words + w] >> bit & 1);
+    for (const auto& name : r.only_in_b) {
+      auto it = b_in.find(name);
+      if (it != b_in.end()) r.counterexample.emplace_back(name, in_b[it->second * words + w] >> bit & 1);
+    }
+  }
+  return r;
+}
+
+} // namespace verilog
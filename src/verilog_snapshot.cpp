@@ -0,0 +1,140 @@
+#include "verilog_snapshot.hpp"
+#include <algorithm>
+#include <thread>
+
+namespace verilog {
+
+static void unshare_exprs(Netlist& nl) {
+  auto unshare = [](Expr& e) { if (std::holds_alternative<std::shared_ptr<Concatenation>>(e)) e = clone_expr(e); };
+  for (auto& m : nl.modules) {
+    for (auto& inst : m.module_instances) {
+      for (auto& e : inst.ports_pos) unshare(e);
+      for (auto& [name, e] : inst.ports_named) unshare(e);
+    }
+    for (auto& ca : m.assignments) {
+      for (auto& [lhs, rhs] : ca.assignments) { unshare(lhs); unshare(rhs); }
+    }
+    for (auto& gt : m.gates)
+      for (auto& e : gt.terminals) unshare(e);
+  }
+}
+
+// ---------- FrozenNetlist ----------
+
+FrozenNetlist::FrozenNetlist(Netlist nl, uint64_t version) : nl_(std::move(nl)), version_(version) {
+  unshare_exprs(nl_);
+  auto by_name = [](const auto& a, const auto& b) { return a.first < b.first; };
+
+  module_index_.reserve(nl_.modules.size());
+  for (uint32_t i = 0; i < nl_.modules.size(); ++i) module_index_.emplace_back(nl_.modules[i].module_name, i);
+  std::stable_sort(module_index_.begin(), module_index_.end(), by_name);
+
+  instance_index_.resize(nl_.modules.size());
+  for (size_t m = 0; m < nl_.modules.size(); ++m) {
+    const auto& insts = nl_.modules[m].module_instances;
+    auto& idx = instance_index_[m];
+    idx.reserve(insts.size());
+    for (uint32_t i = 0; i < insts.size(); ++i) idx.emplace_back(insts[i].instance_name, i);
+    std::stable_sort(idx.begin(), idx.end(), by_name);
+  }
+}
+
+static const std::pair<std::string_view, uint32_t>*
+lookup(const std::vector<std::pair<std::string_view, uint32_t>>& idx, std::string_view name) {
+  auto it = std::lower_bound(idx.begin(), idx.end(), name,
+                             [](const auto& e, std::string_view n) { return e.first < n; });
+  return (it != idx.end() && it->first == name) ? &*it : nullptr;
+}
+
+const Module* FrozenNetlist::find_module(std::string_view name) const {
+  auto e = lookup(module_index_, name);
+  return e ? &nl_.modules[e->second] : nullptr;
+}
+
+const ModuleInstance* FrozenNetlist::find_instance(const Module& m, std::string_view instance) const {
+  if (&m < nl_.modules.data() || &m >= nl_.modules.data() + nl_.modules.size()) return nullptr;
+  const auto& insts = instance_index_[size_t(&m - nl_.modules.data())];
+  auto e = lookup(insts, instance);
+  return e ? &m.module_instances[e->second] : nullptr;
+}
+
+Netlist FrozenNetlist::thaw() const {
+  Netlist copy = nl_;
+  unshare_exprs(copy);
+  return copy;
+}
+
+// ---------- SnapshotPublisher ----------
+//
+// Ordering argument (all epoch/pointer accesses are seq_cst):
+//   reader: e = epoch_; slot = e; p = current_
+//   writer: old = current_.exchange(new); r = epoch_++; retire(old, r);
+//           free old once every active slot holds an epoch > r
+// A reader whose slot is <= r may hold `old` and blocks the free. A reader
+// that stamped r+1 or later read epoch_ after the increment, hence after the
+// exchange, and can only see the new pointer. A stamp the writer's scan
+// misses is ordered after the scan, and so after the exchange as well.
+
+SnapshotPublisher::SnapshotPublisher(size_t max_readers)
+  : slots_(new Slot[std::max<size_t>(1, max_readers)]), nslots_(std::max<size_t>(1, max_readers)) {}
+
+SnapshotPublisher::~SnapshotPublisher() {
+  delete current_.load();
+  for (auto& r : retired_) delete r.second;
+}
+
+SnapshotPublisher::Reader SnapshotPublisher::register_reader() {
+  for (size_t i = 0; i < nslots_; ++i) {
+    bool expected = false;
+    if (slots_[i].used.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+      return Reader(this, &slots_[i]);
+  }
+  throw std::runtime_error("SnapshotPublisher: no free reader slot");
+}
+
+SnapshotPublisher::ReadGuard SnapshotPublisher::enter(Slot* s) const {
+  s->epoch.store(epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+  return ReadGuard(s, current_.load(std::memory_order_seq_cst));
+}
+
+uint64_t SnapshotPublisher::publish(Netlist nl) {
+  std::lock_guard<std::mutex> lk(writer_mu_);
+  const uint64_t v = ++version_;
+  const FrozenNetlist* fresh = new FrozenNetlist(std::move(nl), v);
+  const FrozenNetlist* old = current_.exchange(fresh, std::memory_order_seq_cst);
+  const uint64_t r = epoch_.fetch_add(1, std::memory_order_seq_cst);
+  if (old) retired_.emplace_back(r, old);
+  reclaim_locked();
+  return v;
+}
+
+uint64_t SnapshotPublisher::version() const {
+  std::lock_guard<std::mutex> lk(writer_mu_);
+  return version_;
+}
+
+size_t SnapshotPublisher::reclaim() {
+  std::lock_guard<std::mutex> lk(writer_mu_);
+  return reclaim_locked();
+}
+
+size_t SnapshotPublisher::reclaim_locked() {
+  uint64_t oldest = UINT64_MAX;
+  for (size_t i = 0; i < nslots_; ++i) {
+    const uint64_t e = slots_[i].epoch.load(std::memory_order_seq_cst);
+    if (e) oldest = std::min(oldest, e);
+  }
+  auto keep = std::remove_if(retired_.begin(), retired_.end(), [&](const auto& r) {
+    if (r.first >= oldest) return false;
+    delete r.second;
+    return true;
+  });
+  retired_.erase(keep, retired_.end());
+  return retired_.size();
+}
+
+void SnapshotPublisher::synchronize() {
+  while (reclaim() != 0) std::this_thread::yield();
+}
+
+} // namespace verilog
@@ -0,0 +1,113 @@
+#include "verilog_source.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace verilog {
+
+LineTable::LineTable(std::string_view text, std::string name) : name_(std::move(name)) {
+  size_ = uint32_t(std::min<size_t>(text.size(), UINT32_MAX));
+  const char* const begin = text.data();
+  const char* const end = begin + size_;
+
+  uint32_t pending[kBlockLines];
+  uint32_t n = 0;
+  auto flush = [&] {
+    const uint32_t start = pending[0];
+    if (pending[n - 1] - start <= UINT16_MAX) {
+      blocks_.push_back(Block{ start, kNarrow });
+      for (uint32_t k = 0; k < n; ++k) delta_.push_back(uint16_t(pending[k] - start));
+    } else {
+      blocks_.push_back(Block{ start, uint32_t(wide_.size()) });
+      wide_.insert(wide_.end(), pending, pending + n);
+      delta_.insert(delta_.end(), n, 0);
+    }
+    num_lines_ += n;
+    n = 0;
+  };
+
+  delta_.reserve(size_ / 32 + 1);
+  pending[n++] = 0;
+  for (const char* p = begin; p < end;) {
+    const void* nl = std::memchr(p, '\n', size_t(end - p));
+    if (!nl) break;
+    p = static_cast<const char*>(nl) + 1;
+    if (n == kBlockLines) flush();
+    pending[n++] = uint32_t(p - begin);
+  }
+  flush();
+  blocks_.shrink_to_fit();
+  delta_.shrink_to_fit();
+}
+
+uint32_t LineTable::line_start(uint32_t line) const {
+  if (num_lines_ == 0) return 0;
+  const uint32_t i = std::clamp<uint32_t>(line, 1, num_lines_) - 1;
+  const Block& b = blocks_[i / kBlockLines];
+  return b.wide == kNarrow ? b.start + delta_[i] : wide_[b.wide + i % kBlockLines];
+}
+
+SourceLocation LineTable::locate(uint32_t offset) const {
+  if (num_lines_ == 0) return {};
+  offset = std::min(offset, size_);
+  const auto bit = std::upper_bound(blocks_.begin(), blocks_.end(), offset,
+                                    [](uint32_t o, const Block& b) { return o < b.start; }) - 1;
+  const Block& b = *bit;
+  const uint32_t first = uint32_t(bit - blocks_.begin()) * kBlockLines;
+  const uint32_t n = std::min(kBlockLines, num_lines_ - first);
+  uint32_t k, start;
+  if (b.wide == kNarrow) {
+    const uint16_t* d = delta_.data() + first;
+    const uint32_t rel = offset - b.start;
+    k = uint32_t(std::upper_bound(d, d + n, rel, [](uint32_t r, uint16_t x) { return r < x; }) - d) - 1;
+    start = b.start + d[k];
+  } else {
+    const uint32_t* w = wide_.data() + b.wide;
+    k = uint32_t(std::upper_bound(w, w + n, offset) - w) - 1;
+    start = w[k];
+  }
+  SourceLocation loc;
+  loc.line = first + k + 1;
+  loc.column = offset - start + 1;
+  return loc;
+}
+
+size_t LineTable::memory_bytes() const {
+  return sizeof(*this) + name_.capacity() + blocks_.capacity() * sizeof(Block) +
+         delta_.capacity() * sizeof(uint16_t) + wide_.capacity() * sizeof(uint32_t);
+}
+
+uint32_t SourceMap::add_file(std::string name, std::shared_ptr<const LineTable> lines) {
+  files_.push_back(File{ std::move(name), std::move(lines) });
+  return uint32_t(files_.size() - 1);
+}
+
+void SourceMap::add_segment(uint32_t at, uint32_t file, uint32_t origin, bool expansion) {
+  if (!segments_.empty() && segments_.back().at == at) segments_.pop_back();   // the previous one was empty
+  segments_.push_back(Segment{ at, file, origin, expansion });
+}
+
+SourceMap::Origin SourceMap::origin(uint32_t offset) const {
+  if (segments_.empty()) return {};
+  const auto it = std::upper_bound(segments_.begin(), segments_.end(), offset,
+                                   [](uint32_t o, const Segment& s) { return o < s.at; });
+  const Segment& s = it == segments_.begin() ? *it : *(it - 1);
+  return Origin{ s.file, s.expansion || offset < s.at ? s.origin : s.origin + (offset - s.at) };
+}
+
+SourceLocation SourceMap::locate(uint32_t offset) const {
+  if (segments_.empty()) return {};
+  const Origin o = origin(offset);
+  const File& f = files_[o.file];
+  SourceLocation loc = f.lines ? f.lines->locate(o.offset) : SourceLocation{};
+  loc.file = f.name;
+  return loc;
+}
+
+SourceLocation locate(const Netlist& nl, const SourceSpan& span) {
+  if (span.empty()) return {};
+  if (nl.sources) return nl.sources->locate(span.begin);
+  if (!nl.lines) return {};
+  return nl.lines->locate(span.begin);
+}
+
+} // namespace verilog
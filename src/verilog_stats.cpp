@@ -0,0 +1,238 @@
+#include "verilog_stats.hpp"
+#include "verilog_connectivity.hpp"
+#include "verilog_parallel.hpp"
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace verilog {
+
+namespace {
+
+struct LocalStats {
+  std::vector<std::pair<std::string, uint64_t>> masters;   // local instance counts, first-seen order
+  std::array<uint64_t, kNumGateTypes> gates{};
+  std::map<uint64_t, uint64_t> fanout, fanin;
+  uint64_t unresolved_nets = 0;
+  std::vector<NetIssue> floating, undriven, unused;
+  std::vector<PinIssue> unconnected;
+};
+
+LocalStats analyze_module(const Module& m, const InterfaceTable& ifaces) {
+  LocalStats ls;
+  {
+    std::unordered_map<std::string_view, size_t> slot;
+    for (const auto& inst : m.module_instances) {
+      auto [it, fresh] = slot.emplace(inst.module_name, ls.masters.size());
+      if (fresh) ls.masters.emplace_back(inst.module_name, 0);
+      ++ls.masters[it->second].second;
+    }
+  }
+
+  for (size_t t = 0; t < kNumGateTypes; ++t) ls.gates[t] = m.gates[t].size();
+  std::unordered_set<std::string_view> supplies;
+  for (const auto& d : m.net_declarations)
+    if (d.type == NetType::Supply0 || d.type == NetType::Supply1) supplies.insert(d.names.begin(), d.names.end());
+
+  const ModuleGraph g(m, ifaces);
+  for (NetId n = 0; n < g.num_nets(); ++n) {
+    const auto pins = g.net_pins(n);
+    if (pins.empty()) {
+      if (g.is_declared(n)) ls.floating.push_back({ m.module_name, g.net_name(n) });
+      continue;
+    }
+    uint64_t drivers = 0, loads = 0, unknown = 0;
+    for (uint32_t p : pins) {
+      switch (g.pins()[p].dir) {
+        case PortDir::Output:  ++drivers; break;
+        case PortDir::Input:   ++loads; break;
+        case PortDir::Inout:   ++drivers; ++loads; break;
+        case PortDir::Unknown: ++unknown; break;
+      }
+    }
+    if (unknown) { ++ls.unresolved_nets; continue; }
+    if (!supplies.empty() && supplies.count(g.bus(g.net_bus(n)).name)) ++drivers;
+    ++ls.fanout[loads];
+    ++ls.fanin[drivers];
+    if (!drivers) ls.undriven.push_back({ m.module_name, g.net_name(n) });
+    else if (!loads) ls.unused.push_back({ m.module_name, g.net_name(n) });
+  }
+
+  for (uint32_t node = 0; node < g.num_nodes(); ++node) {
+    const ModuleInterface* master = g.node_master(node);
+    if (g.node_kind(node) != ModuleGraph::NodeKind::Instance || !master) continue;
+    // Taken from the connections as written, not graph pins: a tie-off such
+    // as .D(1'b0) reaches no net but is not an open pin. .Q() is not stored.
+    const ModuleInstance& inst = m.module_instances[g.node_ref(node)];
+    std::vector<bool> seen(master->ports.size(), false);
+    for (size_t k = 0; k < inst.ports_pos.size() && k < seen.size(); ++k) seen[k] = true;
+    for (const auto& [port, expr] : inst.ports_named)
+      if (const uint32_t k = master->find(port); k != ModuleInterface::npos) seen[k] = true;
+    for (size_t k = 0; k < seen.size(); ++k)
+      if (!seen[k]) ls.unconnected.push_back({ m.module_name, inst.instance_name, master->ports[k] });
+  }
+  return ls;
+}
+
+template<typename K>
+void merge_weighted(std::map<K, uint64_t>& into, const std::map<K, uint64_t>& from, uint64_t w) {
+  for (const auto& [k, v] : from) into[k] += v * w;
+}
+
+template<typename T>
+void append(std::vector<T>& into, std::vector<T>&& from) {
+  into.insert(into.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+}
+
+} // namespace
+
+DesignStats compute_stats(const Netlist& nl, const StatsOptions& opts) {
+  const size_t n = nl.modules.size();
+  InterfaceTable ifaces(nl);
+  if (opts.cells)
+    for (const auto& cell : *opts.cells) if (!ifaces.find(cell.name)) ifaces.add(cell);
+
+  // First definition of a name wins; later duplicates are ignored.
+  std::unordered_map<std::string_view, size_t> by_name;
+  std::vector<bool> canonical(n, false);
+  for (size_t i = 0; i < n; ++i)
+    if (by_name.emplace(nl.modules[i].module_name, i).second) canonical[i] = true;
+
+  std::vector<LocalStats> local(n);
+  parallel::parallel_for(n, [&](size_t i) {
+    if (canonical[i]) local[i] = analyze_module(nl.modules[i], ifaces);
+  }, opts.threads);
+
+  // Instantiation multiplicity: Kahn order over the module DAG, then push
+  // counts from parents to children.
+  std::vector<std::vector<std::pair<size_t, uint64_t>>> children(n);
+  std::vector<size_t> indegree(n, 0);
+  for (size_t i = 0; i < n; ++i) {
+    for (const auto& [master, cnt] : local[i].masters) {
+      auto it = by_name.find(master);
+      if (it == by_name.end()) continue;
+      children[i].emplace_back(it->second, cnt);
+      ++indegree[it->second];
+    }
+  }
+  std::vector<size_t> order;
+  std::vector<size_t> pending = indegree;
+  for (size_t i = 0; i < n; ++i) if (canonical[i] && pending[i] == 0) order.push_back(i);
+  for (size_t k = 0; k < order.size(); ++k)
+    for (const auto& [c, cnt] : children[order[k]]) if (--pending[c] == 0) order.push_back(c);
+  for (size_t i = 0; i < n; ++i) {
+    if (canonical[i] && pending[i] != 0)
+      throw std::runtime_error("instantiation cycle through module " + nl.modules[i].module_name);
+  }
+
+  DesignStats ds;
+  std::vector<uint64_t> mult(n, 0);
+  if (!opts.top.empty()) {
+    auto it = by_name.find(opts.top);
+    if (it == by_name.end()) throw std::runtime_error("top module not found: " + opts.top);
+    mult[it->second] = 1;
+    ds.tops.push_back(opts.top);
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      if (canonical[i] && indegree[i] == 0) { mult[i] = 1; ds.tops.push_back(nl.modules[i].module_name); }
+    }
+  }
+  for (size_t i : order)
+    for (const auto& [c, cnt] : children[i]) mult[c] += mult[i] * cnt;
+
+  // Weighted merge of the per-module results, reduced in parallel chunks.
+  struct Acc {
+    std::map<std::string, uint64_t> instances, gates;
+    uint64_t leaf = 0, unresolved = 0;
+    std::map<uint64_t, uint64_t> fanout, fanin;
+    std::vector<NetIssue> floating, undriven, unused;
+    std::vector<PinIssue> unconnected;
+  };
+  Acc acc = parallel::parallel_reduce(n, Acc{}, [&](Acc& a, size_t i) {
+    if (!canonical[i]) return;
+    LocalStats& ls = local[i];
+    const uint64_t w = mult[i];
+    if (w) {
+      for (const auto& [master, cnt] : ls.masters) {
+        a.instances[master] += cnt * w;
+        if (!by_name.count(master)) a.leaf += cnt * w;
+      }
+      for (size_t t = 0; t < kNumGateTypes; ++t)
+        if (ls.gates[t]) a.gates[std::string(gate_type_name(GateType(t)))] += ls.gates[t] * w;
+      merge_weighted(a.fanout, ls.fanout, w);
+      merge_weighted(a.fanin, ls.fanin, w);
+      a.unresolved += ls.unresolved_nets * w;
+    }
+    append(a.floating, std::move(ls.floating));
+    append(a.undriven, std::move(ls.undriven));
+    append(a.unused, std::move(ls.unused));
+    append(a.unconnected, std::move(ls.unconnected));
+  }, [](Acc& into, Acc&& from) {
+    merge_weighted(into.instances, from.instances, 1);
+    merge_weighted(into.gates, from.gates, 1);
+    merge_weighted(into.fanout, from.fanout, 1);
+    merge_weighted(into.fanin, from.fanin, 1);
+    into.leaf += from.leaf;
+    into.unresolved += from.unresolved;
+    append(into.floating, std::move(from.floating));
+    append(into.undriven, std::move(from.undriven));
+    append(into.unused, std::move(from.unused));
+    append(into.unconnected, std::move(from.unconnected));
+  }, opts.threads, 16);
+
+  for (size_t i = 0; i < n; ++i) if (canonical[i]) ds.module_instantiations[nl.modules[i].module_name] = mult[i];
+  ds.instance_counts = std::move(acc.instances);
+  ds.leaf_instances = acc.leaf;
+  ds.gate_counts = std::move(acc.gates);
+  ds.unresolved_nets = acc.unresolved;
+  ds.fanout_histogram = std::move(acc.fanout);
+  ds.fanin_histogram = std::move(acc.fanin);
+  ds.floating_nets = std::move(acc.floating);
+  ds.undriven_nets = std::move(acc.undriven);
+  ds.unused_nets = std::move(acc.unused);
+  ds.unconnected_pins = std::move(acc.unconnected);
+  return ds;
+}
+
+std::string DesignStats::report(size_t max_items) const {
+  std::ostringstream oss;
+  oss << "design statistics\n";
+  oss << "  tops:";
+  for (const auto& t : tops) oss << " " << t;
+  oss << "\n";
+  oss << "  leaf instances (flattened): " << leaf_instances << "\n";
+
+  oss << "  instances per master (flattened):\n";
+  for (const auto& [m, c] : instance_counts) oss << "    " << m << ": " << c << "\n";
+  if (!gate_counts.empty()) {
+    oss << "  gates per type (flattened):\n";
+    for (const auto& [t, c] : gate_counts) oss << "    " << t << ": " << c << "\n";
+  }
+
+  auto histogram = [&](const char* title, const std::map<uint64_t, uint64_t>& h) {
+    oss << "  " << title << ":\n";
+    for (const auto& [k, v] : h) oss << "    " << k << ": " << v << "\n";
+  };
+  histogram("fanout histogram (loads: nets)", fanout_histogram);
+  histogram("fanin histogram (drivers: nets)", fanin_histogram);
+  if (unresolved_nets) oss << "  nets on pins of unknown cells (not in histograms): " << unresolved_nets << "\n";
+
+  auto nets = [&](const char* title, const std::vector<NetIssue>& v) {
+    oss << "  " << title << ": " << v.size() << "\n";
+    for (size_t i = 0; i < v.size() && i < max_items; ++i) oss << "    " << v[i].module << ": " << v[i].net << "\n";
+    if (v.size() > max_items) oss << "    ... " << (v.size() - max_items) << " more\n";
+  };
+  nets("floating nets", floating_nets);
+  nets("undriven nets", undriven_nets);
+  nets("unused nets", unused_nets);
+
+  oss << "  unconnected pins: " << unconnected_pins.size() << "\n";
+  for (size_t i = 0; i < unconnected_pins.size() && i < max_items; ++i) {
+    const auto& p = unconnected_pins[i];
+    oss << "    " << p.module << ": " << p.instance << "." << p.pin << "\n";
+  }
+  if (unconnected_pins.size() > max_items) oss << "    ... " << (unconnected_pins.size() - max_items) << " more\n";
+  return oss.str();
+}
+
+} // namespace verilog
@@ -0,0 +1,199 @@
+#include "verilog_writer.hpp"
+#include "verilog_grammar.hpp"
+
+namespace verilog {
+
+namespace {
+
+void put_identifier(std::string& out, std::string_view name) {
+  bool simple = !name.empty() && !(name[0] >= '0' && name[0] <= '9') && name[0] != '$';
+  for (char c : name) simple = simple && grammar::detail::is_ident_char(c);
+  if (simple && grammar::classify_keyword(name) == grammar::Keyword::None) { out += name; return; }
+  out += '\\';
+  out += name;
+  out += ' ';
+}
+
+void put_expr(std::string& out, const Expr& e) {
+  struct V {
+    std::string& out;
+    void operator()(const Identifier& x) const { put_identifier(out, x.name); }
+    void operator()(const IdentifierIndexed& x) const {
+      put_identifier(out, x.name);
+      out += '[';
+      out += x.index.to_string();
+      out += ']';
+    }
+    void operator()(const IdentifierSliced& x) const {
+      put_identifier(out, x.name);
+      out += '[';
+      out += x.range.start.to_string();
+      out += ':';
+      out += x.range.end.to_string();
+      out += ']';
+    }
+    void operator()(const std::shared_ptr<Concatenation>& x) const {
+      out += '{';
+      for (size_t i = 0; i < x->elements.size(); ++i) {
+        if (i) out += ", ";
+        put_expr(out, x->elements[i]);
+      }
+      out += '}';
+    }
+    void operator()(const Constant& x) const {
+      if (!x.sized && x.value.fits_uint64()) out += std::to_string(x.value.to_uint64());
+      else out += x.value.to_string();
+    }
+  };
+  std::visit(V{ out }, e);
+}
+
+const char* net_type_name(NetType t) {
+  switch (t) {
+    case NetType::Wire: return "wire";
+    case NetType::Tri: return "tri";
+    case NetType::Supply0: return "supply0";
+    case NetType::Supply1: return "supply1";
+  }
+  return "wire";
+}
+
+void write_decl(std::string& out, const char* kind, const NetDeclaration& d) {
+  out += "  ";
+  out += kind;
+  if (d.range_expr) out += " [" + d.range_expr->msb.to_string() + ":" + d.range_expr->lsb.to_string() + "]";
+  else if (d.range) out += " [" + d.range->start.to_string() + ":" + d.range->end.to_string() + "]";
+  for (size_t i = 0; i < d.names.size(); ++i) {
+    out += i ? ", " : " ";
+    put_identifier(out, d.names[i]);
+  }
+  out += ";\n";
+}
+
+void write_overrides(std::string& out, const ParamOverrides& p) {
+  out += " #(";
+  bool first = true;
+  for (const auto& e : p.positional) {
+    if (!first) out += ", ";
+    first = false;
+    out += e.to_string();
+  }
+  for (const auto& [name, e] : p.named) {
+    if (!first) out += ", ";
+    first = false;
+    out += '.';
+    put_identifier(out, name);
+    out += '(' + e.to_string() + ')';
+  }
+  out += ")";
+}
+
+void write_module(std::string& out, const Module& m) {
+  out += "module ";
+  put_identifier(out, m.module_name);
+  out += '(';
+  for (size_t i = 0; i < m.port_list.size(); ++i) {
+    if (i) out += ", ";
+    put_identifier(out, m.port_list[i]);
+  }
+  out += ");\n";
+
+  for (const auto& p : m.parameters) {
+    out += p.local ? "  localparam " : "  parameter ";
+    put_identifier(out, p.name);
+    out += " = " + p.expr.to_string() + ";\n";
+  }
+  for (const auto& d : m.input_declarations) write_decl(out, "input", d);
+  for (const auto& d : m.output_declarations) write_decl(out, "output", d);
+  for (const auto& d : m.inout_declarations) write_decl(out, "inout", d);
+  for (const auto& d : m.net_declarations) write_decl(out, net_type_name(d.type), d);
+
+  for (const auto& ca : m.assignments) {
+    out += "  assign ";
+    for (size_t i = 0; i < ca.assignments.size(); ++i) {
+      if (i) out += ", ";
+      put_expr(out, ca.assignments[i].first);
+      out += " = ";
+      put_expr(out, ca.assignments[i].second);
+    }
+    out += ";\n";
+  }
+
+  for (const auto& inst : m.module_instances) {
+    out += "  ";
+    put_identifier(out, inst.module_name);
+    if (inst.params) write_overrides(out, *inst.params);
+    out += ' ';
+    put_identifier(out, inst.instance_name);
+    out += " (";
+    bool first = true;
+    for (const auto& e : inst.ports_pos) {
+      if (!first) out += ", ";
+      first = false;
+      put_expr(out, e);
+    }
+    for (const auto& [pin, e] : inst.ports_named) {
+      if (!first) out += ", ";
+      first = false;
+      out += '.';
+      put_identifier(out, pin);
+      out += '(';
+      put_expr(out, e);
+      out += ')';
+    }
+    out += ");\n";
+  }
+
+  for (size_t t = 0; t < kNumGateTypes; ++t) {
+    const GateTable& gt = m.gates[t];
+    for (size_t i = 0; i < gt.size(); ++i) {
+      out += "  ";
+      out += gate_type_name(GateType(t));
+      if (!gt.names[i].empty()) {
+        out += ' ';
+        put_identifier(out, gt.names[i]);
+      }
+      out += " (";
+      const auto terms = gt.terminals_of(i);
+      for (size_t k = 0; k < terms.size(); ++k) {
+        if (k) out += ", ";
+        put_expr(out, terms[k]);
+      }
+      out += ");\n";
+    }
+  }
+  out += "endmodule\n";
+}
+
+} // namespace
+
+std::string verilog_identifier(std::string_view name) {
+  std::string s;
+  put_identifier(s, name);
+  return s;
+}
+
+std::string write_expr(const Expr& e) {
+  std::string s;
+  put_expr(s, e);
+  return s;
+}
+
+void append_expr(std::string& out, const Expr& e) { put_expr(out, e); }
+
+std::string write_verilog(const Module& m) {
+  std::string out;
+  write_module(out, m);
+  return out;
+}
+
+std::string write_verilog(const Netlist& nl) {
+  std::string out;
+  for (size_t i = 0; i < nl.modules.size(); ++i) {
+    if (i) out += "\n";
+    write_module(out, nl.modules[i]);
+  }
+  return out;
+}
+
+} // namespace verilog
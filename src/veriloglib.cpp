@@ -1,10 +1,13 @@
 #include "veriloglib.hpp"
 #include "verilog_grammar.hpp"
 #include "verilog_actions.hpp"
+#include "verilog_source.hpp"
 #include <tao/pegtl.hpp>
 #include <fstream>
 #include <cctype>
 #include <memory>
+#include <algorithm>
+#include <climits>
 
 using namespace tao::pegtl;
 
@@ -17,24 +20,250 @@ static int digit_to_val(char c) {
   return 0;
 }
 
-int64_t Number::as_integer() const {
-  int base_v = 10;
-  if (base.has_value()) {
-    switch(std::tolower(base.value())) {
-      case 'h': base_v = 16; break;
-      case 'b': base_v = 2;  break;
-      case 'd': base_v = 10; break;
-      case 'o': base_v = 8;  break;
-      default: base_v = 10;  break;
+// ---------- LogicVector ----------
+
+LogicVector::LogicVector(uint32_t width) : width_(width) {
+  if (width_ > 64) heap_.reset(new uint64_t[2 * num_words()]());
+}
+
+LogicVector::LogicVector(const LogicVector& o) : width_(o.width_) {
+  inline_[0] = o.inline_[0]; inline_[1] = o.inline_[1];
+  if (o.heap_) {
+    heap_.reset(new uint64_t[2 * num_words()]);
+    std::copy(o.heap_.get(), o.heap_.get() + 2 * num_words(), heap_.get());
+  }
+}
+
+LogicVector::LogicVector(LogicVector&& o) noexcept
+  : width_(o.width_), heap_(std::move(o.heap_)) {
+  inline_[0] = o.inline_[0]; inline_[1] = o.inline_[1];
+  o.width_ = 0; o.inline_[0] = o.inline_[1] = 0;
+}
+
+LogicVector& LogicVector::operator=(const LogicVector& o) {
+  if (this != &o) { LogicVector tmp(o); *this = std::move(tmp); }
+  return *this;
+}
+
+LogicVector& LogicVector::operator=(LogicVector&& o) noexcept {
+  if (this != &o) {
+    width_ = o.width_; heap_ = std::move(o.heap_);
+    inline_[0] = o.inline_[0]; inline_[1] = o.inline_[1];
+    o.width_ = 0; o.inline_[0] = o.inline_[1] = 0;
+  }
+  return *this;
+}
+
+char LogicVector::bit(uint32_t i) const {
+  if (i >= width_) return '0';
+  const uint64_t m = uint64_t(1) << (i % 64);
+  const bool a = aval()[i / 64] & m, b = bval()[i / 64] & m;
+  return b ? (a ? 'x' : 'z') : (a ? '1' : '0');
+}
+
+void LogicVector::set_bit(uint32_t i, char v) {
+  if (i >= width_) return;
+  const uint64_t m = uint64_t(1) << (i % 64);
+  uint64_t& a = aval_mut()[i / 64];
+  uint64_t& b = bval_mut()[i / 64];
+  const bool av = (v == '1' || v == 'x' || v == 'X');
+  const bool bv = (v == 'x' || v == 'X' || v == 'z' || v == 'Z' || v == '?');
+  a = av ? (a | m) : (a & ~m);
+  b = bv ? (b | m) : (b & ~m);
+}
+
+void LogicVector::resize(uint32_t width, char fill) {
+  LogicVector r(width);
+  const uint32_t keep = std::min(width, width_);
+  const size_t full = keep / 64;
+  std::copy(aval(), aval() + full, r.aval_mut());
+  std::copy(bval(), bval() + full, r.bval_mut());
+  for (uint32_t i = uint32_t(full * 64); i < keep; ++i) r.set_bit(i, bit(i));
+  if (fill != '0') for (uint32_t i = keep; i < width; ++i) r.set_bit(i, fill);
+  *this = std::move(r);
+}
+
+bool LogicVector::is_fully_known() const {
+  const uint64_t* b = bval();
+  for (size_t w = 0; w < num_words(); ++w) if (b[w]) return false;
+  return true;
+}
+
+bool LogicVector::fits_uint64() const {
+  if (!is_fully_known()) return false;
+  const uint64_t* a = aval();
+  for (size_t w = 1; w < num_words(); ++w) if (a[w]) return false;
+  return true;
+}
+
+uint64_t LogicVector::to_uint64() const {
+  return width_ ? (aval()[0] & ~bval()[0]) : 0;
+}
+
+void LogicVector::negate() {
+  uint64_t* a = aval_mut();
+  uint64_t carry = 1;
+  for (size_t w = 0; w < num_words(); ++w) {
+    const uint64_t v = ~a[w] + carry;
+    carry = (carry && v == 0) ? 1 : 0;
+    a[w] = v;
+  }
+  if (width_ % 64) a[num_words() - 1] &= (uint64_t(1) << (width_ % 64)) - 1;
+}
+
+std::string LogicVector::to_string() const {
+  // Hex when every nibble is uniform (all known, all x or all z), else binary.
+  bool hex_ok = width_ > 0;
+  for (uint32_t n = 0; hex_ok && n * 4 < width_; ++n) {
+    int known = 0, xs = 0, zs = 0, total = 0;
+    for (uint32_t i = n * 4; i < std::min(width_, n * 4 + 4); ++i, ++total) {
+      const char c = bit(i);
+      if (c == 'x') ++xs; else if (c == 'z') ++zs; else ++known;
     }
+    hex_ok = (known == total || xs == total || zs == total);
   }
-  int64_t v = 0; bool neg = false;
-  for (size_t i=0;i<mantissa.size();++i) {
-    char c = mantissa[i];
-    if (i==0 && (c=='+' || c=='-')) { neg = (c=='-'); continue; }
-    v = v*base_v + digit_to_val(c);
+  std::string digits;
+  if (hex_ok) {
+    for (uint32_t n = 0; n * 4 < width_; ++n) {
+      const char c = bit(n * 4);
+      if (c == 'x' || c == 'z') { digits.push_back(c); continue; }
+      int v = 0;
+      for (uint32_t i = 0; i < 4 && n * 4 + i < width_; ++i) v |= (bit(n * 4 + i) == '1') << i;
+      digits.push_back("0123456789abcdef"[v]);
+    }
+  } else {
+    for (uint32_t i = 0; i < width_; ++i) digits.push_back(bit(i));
   }
-  return neg ? -v : v;
+  while (digits.size() > 1 && digits.back() == '0') digits.pop_back();
+  std::reverse(digits.begin(), digits.end());
+  return std::to_string(width_) + (hex_ok ? "'h" : "'b") + digits;
+}
+
+bool LogicVector::operator==(const LogicVector& o) const {
+  if (width_ != o.width_) return false;
+  return std::equal(aval(), aval() + num_words(), o.aval()) &&
+         std::equal(bval(), bval() + num_words(), o.bval());
+}
+
+// ---------- Number ----------
+
+// Fills n.value / n.int_value from the digit string (underscores allowed) using
+// n.length, n.base and n.negative. Based digits take 1/3/4 bits each and may be
+// x/z/?; decimal digits are accumulated with arbitrary precision.
+static void decode_number(Number& n, std::string_view digits) {
+  int bits_per_digit = 0;
+  switch (n.base ? std::tolower(*n.base) : 'd') {
+    case 'b': bits_per_digit = 1; break;
+    case 'o': bits_per_digit = 3; break;
+    case 'h': bits_per_digit = 4; break;
+    default:  bits_per_digit = 0; break;
+  }
+  auto is_unknown = [](char c){ return c=='x' || c=='X' || c=='z' || c=='Z' || c=='?'; };
+  auto unknown_of = [](char c){ return (c=='x' || c=='X') ? 'x' : 'z'; };
+
+  char msb_fill = '0';
+  LogicVector v;
+  if (bits_per_digit) {
+    size_t ndig = 0;
+    for (char c : digits) if (c != '_') ++ndig;
+    v = LogicVector(uint32_t(std::max<size_t>(1, ndig * bits_per_digit)));
+    uint32_t pos = 0;
+    for (auto it = digits.rbegin(); it != digits.rend(); ++it) {
+      const char c = *it;
+      if (c == '_') continue;
+      if (is_unknown(c)) {
+        for (int k = 0; k < bits_per_digit; ++k) v.set_bit(pos + k, unknown_of(c));
+      } else {
+        const int d = digit_to_val(c);
+        for (int k = 0; k < bits_per_digit; ++k) if ((d >> k) & 1) v.set_bit(pos + k, '1');
+      }
+      pos += bits_per_digit;
+    }
+    for (char c : digits) if (c != '_') { if (is_unknown(c)) msb_fill = unknown_of(c); break; }
+  } else {
+    std::vector<uint64_t> words(1, 0);
+    bool unknown = false; char fill = 'x';
+    for (char c : digits) {
+      if (c == '_' || c == '+' || c == '-') continue;
+      if (is_unknown(c)) { unknown = true; fill = unknown_of(c); continue; }
+      unsigned __int128 carry = unsigned(digit_to_val(c));
+      for (auto& w : words) {
+        const unsigned __int128 t = (unsigned __int128)w * 10 + carry;
+        w = uint64_t(t); carry = t >> 64;
+      }
+      if (carry) words.push_back(uint64_t(carry));
+    }
+    uint32_t nbits = 1;
+    for (size_t w = words.size(); w-- > 0;) {
+      if (words[w]) { nbits = uint32_t(w * 64 + 64 - __builtin_clzll(words[w])); break; }
+    }
+    v = LogicVector(nbits);
+    for (uint32_t i = 0; i < nbits; ++i) if ((words[i / 64] >> (i % 64)) & 1) v.set_bit(i, '1');
+    if (unknown) { v = LogicVector(1); v.set_bit(0, fill); msb_fill = fill; }
+  }
+
+  const uint32_t width = n.length ? uint32_t(std::max(1, *n.length)) : std::max<uint32_t>(32, v.width());
+  v.resize(width, msb_fill);
+
+  // int_value carries the sign; value holds the two's complement bit pattern.
+  const uint64_t low = v.to_uint64();
+  n.int_value = n.negative ? -int64_t(low) : int64_t(low);
+  if (n.negative && v.is_fully_known()) v.negate();
+  n.value = std::move(v);
+  n.decoded = true;
+}
+
+Number Number::parse(std::string_view text) {
+  auto is_ws = [](char c){ return c==' ' || c=='\t' || c=='\r' || c=='\n'; };
+  while (!text.empty() && is_ws(text.front())) text.remove_prefix(1);
+  while (!text.empty() && is_ws(text.back()))  text.remove_suffix(1);
+
+  Number n;
+  std::string_view digits = text;
+  const size_t q = text.find('\'');
+  if (q != std::string_view::npos) {
+    int len = 0; bool any = false;
+    for (char c : text.substr(0, q)) {
+      if (c >= '0' && c <= '9') { len = len * 10 + (c - '0'); any = true; }
+    }
+    if (any) n.length = len;
+    size_t i = q + 1;
+    if (i < text.size() && (text[i] == 's' || text[i] == 'S')) ++i;
+    if (i < text.size()) { n.base = char(std::tolower(text[i])); ++i; }
+    while (i < text.size() && is_ws(text[i])) ++i;
+    digits = text.substr(i);
+    n.mantissa = std::string(digits);
+  } else {
+    n.mantissa = std::string(text);
+    n.negative = !text.empty() && text.front() == '-';
+  }
+  decode_number(n, digits);
+  return n;
+}
+
+int64_t Number::as_integer() const {
+  if (decoded) return int_value;
+  // Hand-built Number: decode from the fields without caching.
+  if (!base && mantissa.find('\'') != std::string::npos) return parse(mantissa).int_value;
+  Number tmp; tmp.length = length; tmp.base = base;
+  tmp.negative = !mantissa.empty() && mantissa.front() == '-';
+  decode_number(tmp, mantissa);
+  return tmp.int_value;
+}
+
+bool Number::fits_int64() const {
+  if (!decoded) return true;
+  if (negative) { LogicVector mag = value; mag.negate(); return mag.fits_uint64(); }
+  return value.fits_uint64() && value.to_uint64() <= uint64_t(INT64_MAX);
+}
+
+uint32_t Number::width() const {
+  return decoded ? value.width() : parse(mantissa).value.width();
+}
+
+std::string Number::to_string() const {
+  if (!decoded || fits_int64()) return std::to_string(as_integer());
+  return value.to_string();
 }
 
 std::vector<int64_t> Range::to_indices() const {
@@ -49,61 +278,320 @@ std::vector<int64_t> Range::to_indices() const {
 std::string expr_to_string(const Expr& e) {
   struct V {
     std::string operator()(const Identifier& x) const { return x.name; }
-    std::string operator()(const IdentifierIndexed& x) const { return x.name + "[" + std::to_string(x.index.as_integer()) + "]"; }
+    std::string operator()(const IdentifierIndexed& x) const { return x.name + "[" + x.index.to_string() + "]"; }
     // std::string operator()(const IdentifierSliced& x) const { return x.name + "[..]"; }
     std::string operator()(const IdentifierSliced& x) const {
       // Render explicit msb:lsb to faithfully represent the slice.
       return x.name + "[" +
-             std::to_string(x.range.start.as_integer()) + ":" +
-             std::to_string(x.range.end.as_integer()) + "]";
+             x.range.start.to_string() + ":" +
+             x.range.end.to_string() + "]";
     }
     std::string operator()(const std::shared_ptr<Concatenation>& x) const {
       std::string s = "{"; bool first=true;
       for (auto& el : x->elements) { if (!first) s += ", "; first=false; s += expr_to_string(el); }
       s += "}"; return s;
     }
+    std::string operator()(const Constant& x) const {
+      if (!x.sized && x.value.fits_uint64()) return std::to_string(x.value.to_uint64());
+      return x.value.to_string();
+    }
   };
   return std::visit(V{}, e);
 }
 
+std::string_view gate_type_name(GateType t) {
+  static constexpr std::string_view names[kNumGateTypes] = { "and", "nand", "or", "nor", "xor", "xnor", "buf", "not" };
+  return names[size_t(t)];
+}
+
+size_t Module::num_gates() const {
+  size_t n = 0;
+  for (const auto& g : gates) n += g.size();
+  return n;
+}
+
+std::string Module::gate_label(GateType t, size_t i) const {
+  const std::string& name = gates[size_t(t)].names[i];
+  return name.empty() ? std::string(gate_type_name(t)) + "#" + std::to_string(i) : name;
+}
+
+// ---------- parameter expressions ----------
+
+namespace {
+
+// Binding power of a binary operator; 0 for none.
+int precedence(ParamExpr::Op op) {
+  switch (op) {
+    case ParamExpr::Op::Mul: case ParamExpr::Op::Div: case ParamExpr::Op::Mod: return 3;
+    case ParamExpr::Op::Add: case ParamExpr::Op::Sub: return 2;
+    case ParamExpr::Op::Shl: case ParamExpr::Op::Shr: return 1;
+    default: return 0;
+  }
+}
+
+const char* op_text(ParamExpr::Op op) {
+  switch (op) {
+    case ParamExpr::Op::Add: return "+";
+    case ParamExpr::Op::Sub: return "-";
+    case ParamExpr::Op::Mul: return "*";
+    case ParamExpr::Op::Div: return "/";
+    case ParamExpr::Op::Mod: return "%";
+    case ParamExpr::Op::Shl: return "<<";
+    case ParamExpr::Op::Shr: return ">>";
+    default: return "";
+  }
+}
+
+// Precedence climbing straight into postfix terms.
+class ParamExprParser {
+public:
+  explicit ParamExprParser(std::string_view text) : s_(text) {}
+
+  ParamExpr run() {
+    ParamExpr e;
+    binary(e, 1);
+    skip();
+    if (i_ != s_.size()) fail("unexpected '" + std::string(1, s_[i_]) + "'");
+    return e;
+  }
+
+private:
+  void binary(ParamExpr& e, int min_prec) {
+    unary(e);
+    for (;;) {
+      const size_t at = i_;
+      const ParamExpr::Op op = binop();
+      const int prec = precedence(op);
+      if (prec < min_prec || prec == 0) { i_ = at; return; }
+      binary(e, prec + 1);
+      e.terms.push_back({ op, 0, {} });
+    }
+  }
+
+  void unary(ParamExpr& e) {
+    skip();
+    if (i_ < s_.size() && (s_[i_] == '-' || s_[i_] == '+')) {
+      const bool neg = s_[i_++] == '-';
+      unary(e);
+      if (neg) e.terms.push_back({ ParamExpr::Op::Neg, 0, {} });
+      return;
+    }
+    primary(e);
+  }
+
+  void primary(ParamExpr& e) {
+    skip();
+    if (i_ >= s_.size()) fail("expected a value");
+    const char c = s_[i_];
+    if (c == '(') {
+      ++i_;
+      binary(e, 1);
+      skip();
+      if (i_ >= s_.size() || s_[i_] != ')') fail("expected ')'");
+      ++i_;
+      return;
+    }
+    if (std::isdigit(static_cast<unsigned char>(c)) || c == '\'') {
+      const size_t b = i_;
+      while (i_ < s_.size() && (std::isalnum(static_cast<unsigned char>(s_[i_])) || s_[i_] == '_' || s_[i_] == '\'' ||
+                                s_[i_] == '?'))
+        ++i_;
+      e.terms.push_back({ ParamExpr::Op::Value, Number::parse(s_.substr(b, i_ - b)).as_integer(), {} });
+      return;
+    }
+    if (std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '\\') {
+      const bool escaped = c == '\\';
+      const size_t b = escaped ? ++i_ : i_;
+      while (i_ < s_.size() && (escaped ? !std::isspace(static_cast<unsigned char>(s_[i_]))
+                                        : std::isalnum(static_cast<unsigned char>(s_[i_])) || s_[i_] == '_' || s_[i_] == '$'))
+        ++i_;
+      e.terms.push_back({ ParamExpr::Op::Param, 0, std::string(s_.substr(b, i_ - b)) });
+      return;
+    }
+    fail("unexpected '" + std::string(1, c) + "'");
+  }
+
+  ParamExpr::Op binop() {
+    skip();
+    if (i_ >= s_.size()) return ParamExpr::Op::Value;
+    switch (s_[i_]) {
+      case '+': ++i_; return ParamExpr::Op::Add;
+      case '-': ++i_; return ParamExpr::Op::Sub;
+      case '*': ++i_; return ParamExpr::Op::Mul;
+      case '/': ++i_; return ParamExpr::Op::Div;
+      case '%': ++i_; return ParamExpr::Op::Mod;
+      case '<': if (s_.substr(i_, 2) == "<<") { i_ += 2; return ParamExpr::Op::Shl; } break;
+      case '>': if (s_.substr(i_, 2) == ">>") { i_ += 2; return ParamExpr::Op::Shr; } break;
+    }
+    return ParamExpr::Op::Value;
+  }
+
+  // Whitespace and comments.
+  void skip() {
+    for (;;) {
+      while (i_ < s_.size() && std::isspace(static_cast<unsigned char>(s_[i_]))) ++i_;
+      if (s_.substr(i_, 2) == "//") {
+        while (i_ < s_.size() && s_[i_] != '\n') ++i_;
+      } else if (s_.substr(i_, 2) == "/*" || s_.substr(i_, 2) == "(*") {
+        const size_t e = s_.find(s_[i_] == '/' ? "*/" : "*)", i_ + 2);
+        i_ = e == std::string_view::npos ? s_.size() : e + 2;
+      } else {
+        return;
+      }
+    }
+  }
+
+  [[noreturn]] void fail(const std::string& why) const {
+    throw parse_error("parameter expression '" + std::string(s_) + "': " + why);
+  }
+
+  std::string_view s_;
+  size_t i_ = 0;
+};
+
+} // namespace
+
+ParamExpr ParamExpr::parse(std::string_view text) { return ParamExprParser(text).run(); }
+
+ParamExpr ParamExpr::literal(int64_t v) {
+  ParamExpr e;
+  e.terms.push_back({ Op::Value, v, {} });
+  return e;
+}
+
+int64_t ParamExpr::eval(std::span<const Parameter> env) const {
+  auto lookup = [&](const std::string& name) {
+    for (size_t i = env.size(); i-- > 0;)
+      if (env[i].name == name) return env[i].value;
+    throw std::runtime_error("unknown parameter '" + name + "'");
+  };
+  if (terms.size() == 1) return terms[0].op == Op::Value ? terms[0].value : lookup(terms[0].name);
+
+  std::vector<int64_t> st;
+  st.reserve(terms.size());
+  for (const Term& t : terms) {
+    switch (t.op) {
+      case Op::Value: st.push_back(t.value); continue;
+      case Op::Param: st.push_back(lookup(t.name)); continue;
+      case Op::Neg:   st.back() = int64_t(0 - uint64_t(st.back())); continue;
+      default: break;
+    }
+    const int64_t b = st.back();
+    st.pop_back();
+    int64_t& a = st.back();
+    switch (t.op) {
+      case Op::Add: a = int64_t(uint64_t(a) + uint64_t(b)); break;
+      case Op::Sub: a = int64_t(uint64_t(a) - uint64_t(b)); break;
+      case Op::Mul: a = int64_t(uint64_t(a) * uint64_t(b)); break;
+      case Op::Div:
+      case Op::Mod:
+        if (b == 0) throw std::runtime_error("division by zero in '" + to_string() + "'");
+        if (b == -1) a = t.op == Op::Div ? int64_t(0 - uint64_t(a)) : 0;
+        else a = t.op == Op::Div ? a / b : a % b;
+        break;
+      case Op::Shl: a = (b < 0 || b > 63) ? 0 : int64_t(uint64_t(a) << b); break;
+      case Op::Shr: a = (b < 0 || b > 63) ? 0 : int64_t(uint64_t(a) >> b); break;
+      default: break;
+    }
+  }
+  return st.back();
+}
+
+std::string ParamExpr::to_string() const {
+  // Rebuild infix from postfix; an operand gets parentheses when it binds
+  // more loosely than its operator.
+  struct Part { std::string text; int prec; };
+  std::vector<Part> st;
+  for (const Term& t : terms) {
+    switch (t.op) {
+      case Op::Value: st.push_back({ std::to_string(t.value), 4 }); continue;
+      case Op::Param: st.push_back({ t.name, 4 }); continue;
+      case Op::Neg: {
+        Part& a = st.back();
+        a.text = "-" + (a.prec < 4 ? "(" + a.text + ")" : a.text);
+        a.prec = 4;
+        continue;
+      }
+      default: break;
+    }
+    Part b = std::move(st.back());
+    st.pop_back();
+    Part& a = st.back();
+    const int p = precedence(t.op);
+    if (a.prec < p) a.text = "(" + a.text + ")";
+    if (b.prec <= p) b.text = "(" + b.text + ")";
+    a.text += op_text(t.op) + b.text;
+    a.prec = p;
+  }
+  return st.empty() ? std::string() : st.back().text;
+}
+
+Expr clone_expr(const Expr& e) {
+  if (auto c = std::get_if<std::shared_ptr<Concatenation>>(&e)) {
+    auto cc = std::make_shared<Concatenation>();
+    cc->elements.reserve((*c)->elements.size());
+    for (const auto& el : (*c)->elements) cc->elements.push_back(clone_expr(el));
+    return cc;
+  }
+  return e;
+}
+
 std::string Module::summary() const {
   std::ostringstream oss;
   oss << "module " << module_name << "(";
   for (size_t i=0;i<port_list.size();++i) { if (i) oss << ", "; oss << port_list[i]; }
   oss << ");\n";
+  for (const auto& p : parameters)
+    oss << "  " << (p.local ? "localparam " : "parameter ") << p.name << " = " << p.value << "\n";
   oss << "  inputs:  " << input_declarations.size() << "\n";
   oss << "  outputs: " << output_declarations.size() << "\n";
   oss << "  inouts:  " << inout_declarations.size() << "\n";
   oss << "  wires:   " << net_declarations.size() << "\n";
   oss << "  assigns: " << assignments.size() << "\n";
   oss << "  insts:   " << module_instances.size() << "\n";
+  if (const size_t n = num_gates()) oss << "  gates:   " << n << "\n";
   oss << "endmodule\n";
   return oss.str();
 }
 
-Netlist parse_string(std::string_view text) {
+// Parses `text` under the name `source`, which PEGTL errors and the line
+// table carry.
+static Netlist parse_text(std::string_view text, const std::string& source) {
   using grammar::start;
   using verilog::actions::action;
   using verilog::actions::State;
 
-  memory_input in(text.data(), text.size(), "verilog_string");
+  memory_input in(text.data(), text.size(), source);
   State st;
+  st.source_begin = text.data();
   try {
     if (!tao::pegtl::parse< start, action >(in, st)) {
       throw parse_error("parse returned false");
     }
   } catch (const tao::pegtl::parse_error& e) {
-    throw parse_error(e.what());
+    SourceLocation where;
+    if (!e.positions().empty()) {
+      where.line = uint32_t(e.positions().front().line);
+      where.column = uint32_t(e.positions().front().column);
+    }
+    throw parse_error(e.what(), source, where);
   }
   Netlist nl; nl.modules = std::move(st.modules_accum);
+#if VERILOGLIB_SOURCE_LOCATIONS
+  nl.lines = std::make_shared<const LineTable>(text, source);
+#endif
   return nl;
 }
 
+Netlist parse_string(std::string_view text) {
+  return parse_text(text, "verilog_string");
+}
+
 Netlist parse_file(const std::string& path) {
   std::ifstream ifs(path);
   if (!ifs) throw parse_error("could not open file: " + path);
   std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
-  return parse_string(content);
+  return parse_text(content, path);
 }
 
 } // namespace verilog
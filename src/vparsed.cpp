@@ -0,0 +1,59 @@
+#include "veriloglib.hpp"
+#include "verilog_parallel.hpp"
+#include "verilog_server.hpp"
+#include <csignal>
+#include <iostream>
+#include <string>
+
+// vparsed: parse netlists once and answer queries over a Unix socket until
+// SIGINT/SIGTERM. A design is named after its file stem unless given as
+// name=path.
+int main(int argc, char** argv) {
+  std::string socket_path, top;
+  std::vector<std::pair<std::string, std::string>> inputs;   // name, path
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--socket" && i + 1 < argc) socket_path = argv[++i];
+    else if (a == "--top" && i + 1 < argc) top = argv[++i];
+    else {
+      const auto eq = a.find('=');
+      std::string path = eq == std::string::npos ? a : a.substr(eq + 1);
+      std::string name = eq == std::string::npos ? path : a.substr(0, eq);
+      if (eq == std::string::npos) {
+        name = name.substr(name.find_last_of('/') + 1);
+        name = name.substr(0, name.find('.'));
+      }
+      inputs.emplace_back(std::move(name), std::move(path));
+    }
+  }
+  if (socket_path.empty() || inputs.empty()) {
+    std::cerr << "Usage: vparsed --socket <path> [--top <module>] [name=]<file.v>...\n";
+    return 1;
+  }
+
+  // Handle the signals synchronously; the mask is inherited by every server thread.
+  sigset_t sigs;
+  sigemptyset(&sigs);
+  sigaddset(&sigs, SIGINT);
+  sigaddset(&sigs, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &sigs, nullptr);
+
+  try {
+    std::vector<verilog::Netlist> nls(inputs.size());
+    verilog::parallel::parallel_for(inputs.size(), [&](size_t i) { nls[i] = verilog::parse_file(inputs[i].second); });
+
+    verilog::server::NetlistServer srv(socket_path);
+    for (size_t i = 0; i < inputs.size(); ++i) srv.add_design(inputs[i].first, std::move(nls[i]), top);
+    srv.start();
+    std::cerr << "vparsed: serving " << inputs.size() << " design(s) on " << socket_path << "\n";
+
+    int sig = 0;
+    sigwait(&sigs, &sig);
+    srv.stop();
+  } catch (const verilog::parse_error& e) {
+    std::cerr << "Parse error: " << e.what() << "\n"; return 2;
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n"; return 3;
+  }
+  return 0;
+}
@@ -0,0 +1,78 @@
+#include "veriloglib.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Every operator new in this test binary is counted, so parses can be held
+// to a budget of heap allocations. The replacement is global, so these tests
+// build as verilog_alloc_tests, apart from verilog_tests.
+namespace {
+std::atomic<size_t> g_allocations{ 0 };
+}
+
+void* operator new(std::size_t n) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+using namespace verilog;
+
+// A module of `n` cells with named connections to nets whose names are too
+// long for the small-string buffer, so every string copy costs a malloc.
+static std::string cells(size_t n) {
+  std::string s = "module top(clock_input_signal);\n  input clock_input_signal;\n";
+  for (size_t i = 0; i < n; ++i) {
+    const std::string k = std::to_string(i);
+    s += "  SDFFRX1 register_instance_" + k + " (.D(datapath_net_in_" + k + "), .SI(scan_chain_net_" + k +
+         "), .CK(clock_input_signal), .Q(datapath_net_out_" + k + "));\n";
+  }
+  return s + "endmodule\n";
+}
+
+// Declarations and assigns, with names as long as the cells' nets.
+static std::string decls_and_assigns(size_t n) {
+  std::string s = "module top(clock_input_signal);\n  input clock_input_signal;\n";
+  for (size_t i = 0; i < n; ++i) {
+    const std::string k = std::to_string(i);
+    s += "  wire datapath_net_in_" + k + ";\n  assign datapath_net_out_" + k + " = datapath_net_in_" + k + ";\n";
+  }
+  return s + "endmodule\n";
+}
+
+// Extra allocations per item between parses of 1000 and 3000 items.
+static double allocations_per_item(std::string (*text_of)(size_t)) {
+  size_t count[2];
+  for (int k = 0; k < 2; ++k) {
+    const std::string text = text_of(k ? 3000 : 1000);
+    const size_t before = g_allocations.load();
+    const Netlist nl = parse_string(text);
+    count[k] = g_allocations.load() - before;
+  }
+  EXPECT_GT(count[1], count[0]);
+  return double(count[1] - count[0]) / 2000;
+}
+
+TEST(Alloc, NamedConnectionsAllocateOnlyTheirAst) {
+  EXPECT_EQ(parse_string(cells(10)).modules.at(0).module_instances.size(), 10u);
+  // Per instance, only what the AST keeps: the instance name, four map nodes
+  // and four net names. The port names fit the small-string buffer, and the
+  // parser's scratch strings and vectors are reused from one instance to
+  // the next.
+  const double per_instance = allocations_per_item(cells);
+  EXPECT_LE(per_instance, 9.5) << per_instance;
+}
+
+TEST(Alloc, DeclarationsAndAssignsAreMovedIntoTheModule) {
+  const Module m = parse_string(decls_and_assigns(10)).modules.at(0);
+  EXPECT_EQ(m.net_declarations.size(), 10u);
+  EXPECT_EQ(m.assignments.size(), 10u);
+  // Per wire and assign, only what the AST keeps: the declaration's first
+  // name, its names vector and the name in it, the assign's vector of pairs
+  // and its two identifiers. Moved from the parser's lists, not copied.
+  const double per_item = allocations_per_item(decls_and_assigns);
+  EXPECT_LE(per_item, 6.5) << per_item;
+}
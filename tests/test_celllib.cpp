@@ -0,0 +1,105 @@
+#include "veriloglib.hpp"
+#include "verilog_celllib.hpp"
+#include "verilog_stats.hpp"
+#include <gtest/gtest.h>
+
+using namespace verilog;
+
+static const char* kDesign = R"(
+module top(a, ck, q);
+  input a, ck; output q;
+  wire n;
+  INVX1 u0 (a, n);
+  DFFRX1 r0 (.QN(), .CK(ck), .D(n), .Q(q), .SE(a));
+  MYSTERY m0 (.A(n));
+endmodule
+)";
+
+static const char* kPins = R"(# leaf cells
+INVX1   A:in Y:out
+DFFRX1  D:input CK:in RN:in Q:out QN:output   # RN left open below
+RAM16   A[3:0]:in Q[7:0]:out
+)";
+
+TEST(CellLib, PinListLoads) {
+  InterfaceTable lib;
+  add_pin_list(lib, kPins);
+  ASSERT_EQ(lib.size(), 3u);
+  const ModuleInterface* dff = lib.find("DFFRX1");
+  ASSERT_NE(dff, nullptr);
+  EXPECT_EQ(dff->ports, (std::vector<std::string>{ "D", "CK", "RN", "Q", "QN" }));
+  EXPECT_EQ(dff->dirs[3], PortDir::Output);
+  EXPECT_EQ(dff->find("QN"), 4u);
+  EXPECT_EQ(dff->find("XX"), ModuleInterface::npos);
+  EXPECT_EQ(lib.find("RAM16")->widths, (std::vector<uint32_t>{ 4, 8 }));
+
+  EXPECT_THROW(add_pin_list(lib, "BUF A:in\nBAD Y\n"), parse_error);
+  try { add_pin_list(lib, "\nBUF A:sideways\n", "cells.txt"); FAIL(); }
+  catch (const parse_error& e) { EXPECT_EQ(std::string(e.what()).rfind("cells.txt:2:", 0), 0u) << e.what(); }
+}
+
+TEST(CellLib, StubsLoad) {
+  InterfaceTable lib;
+  add_cell_stubs(lib, parse_string("module INVX1(A, Y); input A; output Y; endmodule"));
+  ASSERT_NE(lib.find("INVX1"), nullptr);
+  EXPECT_EQ(lib.find("INVX1")->dirs, (std::vector<PortDir>{ PortDir::Input, PortDir::Output }));
+}
+
+TEST(CellLib, AnnotatesEveryPin) {
+  const Netlist nl = parse_string(kDesign);
+  InterfaceTable lib(nl);
+  add_pin_list(lib, kPins);
+  const PinAnnotation ann = annotate_pins(nl, lib, 2);
+  ASSERT_EQ(ann.modules.size(), 1u);
+  const ModulePinMap& pm = ann.modules[0];
+  ASSERT_EQ(pm.master.size(), 3u);
+  EXPECT_EQ(pm.master[0]->name, "INVX1");
+  EXPECT_EQ(pm.master[2], nullptr);
+
+  // u0 positional: A, Y
+  EXPECT_EQ(pm.pin[pm.conn_begin[0] + 1], 1u);
+  EXPECT_EQ(pm.dir[pm.conn_begin[0] + 1], PortDir::Output);
+  // r0 named, map order: CK, D, Q, SE; .QN() is unconnected and absent
+  const uint32_t c = pm.conn_begin[1];
+  ASSERT_EQ(pm.conn_begin[2] - c, 4u);
+  EXPECT_EQ(pm.pin[c + 0], 1u);   // CK
+  EXPECT_EQ(pm.pin[c + 1], 0u);   // D
+  EXPECT_EQ(pm.pin[c + 2], 3u);   // Q
+  EXPECT_EQ(pm.dir[c + 2], PortDir::Output);
+  EXPECT_EQ(pm.pin[c + 3], ModuleInterface::npos);   // SE is not a DFFRX1 pin
+
+  EXPECT_EQ(ann.unknown_cells, (std::vector<std::string>{ "MYSTERY" }));
+  ASSERT_EQ(ann.unknown_pins.size(), 1u);
+  EXPECT_EQ(ann.unknown_pins[0].instance, "r0");
+  EXPECT_EQ(ann.unknown_pins[0].pin, "SE");
+}
+
+TEST(CellLib, GraphFromPinMapMatchesLookup) {
+  const Netlist nl = parse_string(kDesign);
+  InterfaceTable lib(nl);
+  add_pin_list(lib, kPins);
+  const Module& top = nl.modules[0];
+  const ModuleGraph by_name(top, lib);
+  const ModuleGraph by_map(top, map_pins(top, lib));
+  ASSERT_EQ(by_name.num_pins(), by_map.num_pins());
+  for (size_t i = 0; i < by_name.num_pins(); ++i) {
+    EXPECT_EQ(by_name.pins()[i].port, by_map.pins()[i].port);
+    EXPECT_EQ(by_name.pins()[i].dir, by_map.pins()[i].dir);
+    EXPECT_EQ(by_name.pins()[i].net, by_map.pins()[i].net);
+  }
+}
+
+TEST(CellLib, StatsUseCellDirections) {
+  const Netlist nl = parse_string(kDesign);
+  const DesignStats plain = compute_stats(nl);
+  InterfaceTable lib;
+  add_pin_list(lib, kPins);
+  StatsOptions opts;
+  opts.cells = &lib;
+  const DesignStats with_cells = compute_stats(nl, opts);
+  EXPECT_LT(with_cells.unresolved_nets, plain.unresolved_nets);
+  // DFFRX1 now has an interface, so its open RN pin is reported.
+  bool rn = false;
+  for (const auto& p : with_cells.unconnected_pins) rn |= p.instance == "r0" && p.pin == "RN";
+  EXPECT_TRUE(rn);
+}
@@ -0,0 +1,165 @@
+#include "veriloglib.hpp"
+#include "verilog_check.hpp"
+#include "verilog_celllib.hpp"
+#include "verilog_lazy.hpp"
+#include "verilog_source.hpp"
+#include <gtest/gtest.h>
+
+using namespace verilog;
+
+static const char* kClean = R"(
+module leaf(A, Y);
+  input A; output Y;
+endmodule
+
+module top(a, y, bus);
+  input a; output y; output [3:0] bus;
+  wire n;
+  leaf u0 (.A(a), .Y(n));
+  leaf u1 (.A(n), .Y(y));
+  assign bus = {a, n, a, n};
+endmodule
+)";
+
+static const char* kDirty = R"(
+module leaf(A, Y);
+  input A; output Y;
+endmodule
+
+module bad(a, b, q);
+  input a; output q;
+  input stray;
+  wire [3:0] w;
+  wire n, n;
+  leaf u0 (.A(a), .Y(n));
+  leaf u0 (.A(w[7]), .Y(n));
+  leaf u2 (.A(w), .Z(q), .Y(implicit));
+  NOPE u3 (.A(a));
+  assign q = ghost;
+  assign w[1:2] = {a, a, a};
+  assign a[0] = n;
+endmodule
+
+module leaf(A, Y);
+  input A; output Y;
+endmodule
+)";
+
+static std::vector<std::pair<CheckId, std::string>> findings(const CheckResult& r) {
+  std::vector<std::pair<CheckId, std::string>> v;
+  for (const auto& d : r.diagnostics) v.emplace_back(d.check, d.object);
+  return v;
+}
+
+static bool has(const CheckResult& r, CheckId id, const std::string& object) {
+  for (const auto& d : r.diagnostics) if (d.check == id && d.object == object) return true;
+  return false;
+}
+
+TEST(Check, CleanDesignHasNoFindings) {
+  const CheckResult r = check_netlist(parse_string(kClean));
+  EXPECT_TRUE(r.diagnostics.empty()) << r.report();
+  EXPECT_EQ(r.errors, 0u);
+}
+
+TEST(Check, ReportsEveryKind) {
+  CheckOptions opts;
+  opts.file = "dirty.v";
+  const CheckResult r = check_netlist(parse_string(kDirty), opts);
+  EXPECT_TRUE(has(r, CheckId::DuplicateName, "n"));
+  EXPECT_TRUE(has(r, CheckId::DuplicateName, "u0"));
+  EXPECT_TRUE(has(r, CheckId::PortWithoutDirection, "b"));
+  EXPECT_TRUE(has(r, CheckId::DirectionWithoutPort, "stray"));
+  EXPECT_TRUE(has(r, CheckId::BadSelect, "w"));         // w[7] and w[1:2]
+  EXPECT_TRUE(has(r, CheckId::BadSelect, "a"));         // a[0] on a scalar
+  EXPECT_TRUE(has(r, CheckId::UndeclaredNet, "ghost"));
+  EXPECT_TRUE(has(r, CheckId::ImplicitNet, "implicit"));
+  EXPECT_TRUE(has(r, CheckId::UndefinedModule, "NOPE"));
+  EXPECT_TRUE(has(r, CheckId::UnknownPin, "u2"));
+  EXPECT_TRUE(has(r, CheckId::WidthMismatch, "u2"));    // 4-bit w on 1-bit A
+  EXPECT_TRUE(has(r, CheckId::WidthMismatch, "w[1:2]"));
+  EXPECT_TRUE(has(r, CheckId::MultipleDrivers, "n"));   // u0.Y twice
+  EXPECT_TRUE(has(r, CheckId::DuplicateModule, "leaf"));
+  EXPECT_FALSE(has(r, CheckId::UndeclaredNet, "implicit"));
+
+  size_t e = 0, w = 0;
+  for (const auto& d : r.diagnostics) (d.severity == Severity::Error ? e : w)++;
+  EXPECT_EQ(r.errors, e);
+  EXPECT_EQ(r.warnings, w);
+
+  for (const auto& d : r.diagnostics) {
+    if (d.check != CheckId::UndeclaredNet) continue;
+    EXPECT_EQ(d.module, "bad");
+    if (!VERILOGLIB_SOURCE_LOCATIONS) continue;
+    EXPECT_EQ(d.line, 15u);
+    EXPECT_EQ(d.to_string().rfind("dirty.v:15:3: error: [undeclared-net] module 'bad':", 0), 0u) << d.to_string();
+  }
+  if (VERILOGLIB_SOURCE_LOCATIONS) {
+    for (const auto& d : r.diagnostics) {
+      if (d.check == CheckId::DuplicateModule) { EXPECT_EQ(d.line, 20u); }
+      if (d.check == CheckId::DuplicateName && d.object == "n") { EXPECT_EQ(d.line, 10u); }
+      if (d.check == CheckId::DirectionWithoutPort) { EXPECT_EQ(d.line, 8u); }
+      if (d.check == CheckId::UndefinedModule) { EXPECT_EQ(d.line, 14u); }
+      if (d.check == CheckId::PortWithoutDirection) { EXPECT_EQ(d.line, 6u); }
+    }
+  }
+
+  opts.implicit_nets = false;
+  EXPECT_FALSE(has(check_netlist(parse_string(kDirty), opts), CheckId::ImplicitNet, "implicit"));
+}
+
+TEST(Check, InputPortAndAssignDriveTheSameNet) {
+  const CheckResult r = check_netlist(parse_string(
+    "module t(a, y); input a; output y; assign a = y; endmodule"));
+  ASSERT_TRUE(has(r, CheckId::MultipleDrivers, "a")) << r.report();
+  EXPECT_NE(r.report().find("input port a, assign"), std::string::npos) << r.report();
+}
+
+TEST(Check, TriAndSupplyNetsMayHaveSeveralDrivers) {
+  const CheckResult r = check_netlist(parse_string(
+    "module t(a, b, y, z); input a, b; output y, z; tri y; supply1 vdd; wire z;\n"
+    "  buf d0 (y, a);\n"
+    "  buf d1 (y, b);\n"
+    "  buf d2 (vdd, a), d5 (vdd, b);\n"
+    "  buf d3 (z, a);\n"
+    "  buf d4 (z, b);\n"
+    "endmodule\n"));
+  EXPECT_FALSE(has(r, CheckId::MultipleDrivers, "y")) << r.report();
+  EXPECT_FALSE(has(r, CheckId::MultipleDrivers, "vdd")) << r.report();
+  EXPECT_TRUE(has(r, CheckId::MultipleDrivers, "z")) << r.report();
+}
+
+TEST(Check, CellLibraryResolvesMasters) {
+  const Netlist nl = parse_string("module t(a, q); input a; output q; DFFRX1 r (.D(a), .Q(q), .XX(a)); endmodule");
+  EXPECT_TRUE(has(check_netlist(nl), CheckId::UndefinedModule, "DFFRX1"));
+  InterfaceTable lib;
+  add_pin_list(lib, "DFFRX1 D:in CK:in Q:out");
+  CheckOptions opts;
+  opts.cells = &lib;
+  const CheckResult r = check_netlist(nl, opts);
+  EXPECT_FALSE(has(r, CheckId::UndefinedModule, "DFFRX1"));
+  EXPECT_TRUE(has(r, CheckId::UnknownPin, "r"));
+}
+
+TEST(Check, ThreadCountDoesNotChangeOutput) {
+  std::string text;
+  for (int i = 0; i < 40; ++i) text += std::string(kDirty).substr(0, std::string(kDirty).rfind("module leaf")) + "\n";
+  const Netlist nl = parse_string(text);
+  CheckOptions one, many;
+  one.threads = 1;
+  many.threads = 8;
+  EXPECT_EQ(findings(check_netlist(nl, one)), findings(check_netlist(nl, many)));
+}
+
+TEST(Check, LazyAndEagerParsesLocateTheSame) {
+  if (!VERILOGLIB_SOURCE_LOCATIONS) GTEST_SKIP() << "built without source locations";
+  LazyNetlist lazy = LazyNetlist::from_string(kDirty, "dirty.v");
+  EXPECT_EQ(lazy.outlines()[1].line, 6u);
+  EXPECT_EQ(lazy.lines()->locate(lazy.module(1).span.begin).line, 6u);
+  CheckOptions opts;
+  opts.file = "dirty.v";
+  std::vector<std::string> eager, deferred;
+  for (const auto& d : check_netlist(parse_string(kDirty), opts).diagnostics) eager.push_back(d.to_string());
+  for (const auto& d : check_netlist(lazy.to_netlist(), opts).diagnostics) deferred.push_back(d.to_string());
+  EXPECT_EQ(eager, deferred);
+}
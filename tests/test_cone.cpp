@@ -0,0 +1,140 @@
+#include "veriloglib.hpp"
+#include "verilog_cone.hpp"
+#include "test_util.hpp"
+#include "verilog_writer.hpp"
+#include <gtest/gtest.h>
+
+using namespace verilog;
+
+static const char* kDesign = R"(
+module top(clk, a, b, c, y, z);
+  input clk, a, b, c; output y; output [1:0] z;
+  wire n1, n2, n3, q;
+  wire [1:0] v;
+  NAND2X1 u1 (.A(a), .B(b), .Y(n1));
+  DFFX1 r0 (.D(n1), .CK(clk), .Q(q));
+  INVX1 u2 (.A(q), .Y(n2));
+  and g0 (n3, n2, c);
+  BUFX1 u3 (.A(n3), .Y(y));
+  assign v = {n1, c};
+  assign z = v;
+endmodule
+)";
+
+static std::vector<std::string> net_names(const ModuleGraph& g, const Cone& c) {
+  std::vector<std::string> v;
+  for (NetId n : c.nets) v.push_back(g.net_name(n));
+  return v;
+}
+
+static std::vector<std::string> node_names(const ModuleGraph& g, const std::vector<uint32_t>& nodes) {
+  std::vector<std::string> v;
+  for (uint32_t n : nodes) {
+    switch (g.node_kind(n)) {
+      case ModuleGraph::NodeKind::Port: v.push_back("port " + g.module().port_list[g.node_ref(n)]); break;
+      case ModuleGraph::NodeKind::Instance: v.push_back(g.module().module_instances[g.node_ref(n)].instance_name); break;
+      case ModuleGraph::NodeKind::Assign: v.push_back("assign#" + std::to_string(g.node_ref(n))); break;
+      case ModuleGraph::NodeKind::Gate: {
+        const auto [t, row] = g.gate_ref(n);
+        v.push_back(g.module().gate_label(t, row));
+        break;
+      }
+    }
+  }
+  return v;
+}
+
+TEST(Cone, FanInStopsAtFlopsAndPorts) {
+  const Netlist nl = parse_string(kDesign);
+  const InterfaceTable lib = testutil::stub_cells();
+  const ModuleGraph g(nl.modules[0], lib);
+  ConeOptions opts;
+  opts.stop_at = { "DFF*" };
+  const ConeExtractor cones(g, opts);
+
+  const Cone c = cones.fan_in(cones.net("y"));
+  EXPECT_EQ(net_names(g, c), (std::vector<std::string>{ "c", "y", "n2", "n3", "q" }));
+  EXPECT_EQ(node_names(g, c.nodes), (std::vector<std::string>{ "port c", "r0", "u2", "u3", "g0" }));
+  EXPECT_EQ(node_names(g, c.boundary), (std::vector<std::string>{ "port c", "r0" }));
+
+  EXPECT_EQ(write_verilog(cones.to_module(c, "y_cone")),
+            "module y_cone(clk, c, y, n1);\n"
+            "  input clk;\n"
+            "  input c;\n"
+            "  input n1;\n"
+            "  output y;\n"
+            "  wire n2;\n"
+            "  wire n3;\n"
+            "  wire q;\n"
+            "  DFFX1 r0 (.CK(clk), .D(n1), .Q(q));\n"
+            "  INVX1 u2 (.A(q), .Y(n2));\n"
+            "  BUFX1 u3 (.A(n3), .Y(y));\n"
+            "  and g0 (n3, n2, c);\n"
+            "endmodule\n");
+
+  ConeOptions shallow = opts;
+  shallow.max_depth = 2;
+  const Cone s = ConeExtractor(g, shallow).fan_in(cones.pin("u3", "Y"));
+  EXPECT_EQ(node_names(g, s.nodes), (std::vector<std::string>{ "u3", "g0" }));
+  EXPECT_EQ(node_names(g, s.boundary), (std::vector<std::string>{ "g0" }));
+
+  ConeOptions by_name;
+  by_name.stop_if = [](const ModuleInstance& i) { return i.instance_name == "u2"; };
+  const Cone u = ConeExtractor(g, by_name).fan_in(cones.net("y"));
+  EXPECT_EQ(node_names(g, u.boundary), (std::vector<std::string>{ "port c", "u2" }));
+}
+
+TEST(Cone, FanOutCrossesAssignsBitForBit) {
+  const Netlist nl = parse_string(kDesign);
+  const InterfaceTable lib = testutil::stub_cells();
+  const ModuleGraph g(nl.modules[0], lib);
+  ConeOptions opts;
+  opts.stop_at = { "DFF*" };
+  const ConeExtractor cones(g, opts);
+
+  const Cone c = cones.fan_out(cones.net("a"));
+  EXPECT_EQ(net_names(g, c), (std::vector<std::string>{ "a", "z[1]", "n1", "v[1]" }));
+  EXPECT_EQ(node_names(g, c.nodes), (std::vector<std::string>{ "port z", "u1", "r0", "assign#0", "assign#1" }));
+  EXPECT_EQ(node_names(g, c.boundary), (std::vector<std::string>{ "port z", "r0" }));
+
+  const Module m = cones.to_module(c, "a_cone");
+  EXPECT_EQ(m.port_list, (std::vector<std::string>{ "clk", "a", "b", "c", "z", "q" }));
+  const Netlist back = parse_string(write_verilog(m));
+  EXPECT_EQ(back.modules[0].summary(), m.summary());
+
+  EXPECT_EQ(cones.net("z").size(), 2u);
+  EXPECT_EQ(cones.net("z[0]").size(), 1u);
+  EXPECT_THROW(cones.net("nope"), std::runtime_error);
+  EXPECT_THROW(cones.pin("u1", "Q"), std::runtime_error);
+  EXPECT_THROW(cones.pin("u9", "A"), std::runtime_error);
+}
+
+TEST(Cone, FrontierParallelMatchesSerial) {
+  // A binary tree of NAND2X1 feeding one output, with flops at every 5th leaf.
+  std::string text = "module tree(y); output y;\n";
+  const int leaves = 4096;
+  for (int i = 0; i < leaves; ++i) {
+    if (i % 5 == 0) text += "  DFFX1 r" + std::to_string(i) + " (.D(y), .CK(y), .Q(n" + std::to_string(leaves + i) + "));\n";
+    else text += "  INVX1 l" + std::to_string(i) + " (.A(y), .Y(n" + std::to_string(leaves + i) + "));\n";
+  }
+  for (int i = leaves - 1; i >= 1; --i)
+    text += "  NAND2X1 t" + std::to_string(i) + " (.A(n" + std::to_string(2 * i) + "), .B(n" + std::to_string(2 * i + 1) +
+            "), .Y(n" + std::to_string(i) + "));\n";
+  text += "  BUFX1 o (.A(n1), .Y(y));\nendmodule\n";
+  const Netlist nl = parse_string(text);
+  const InterfaceTable lib = testutil::stub_cells();
+  const ModuleGraph g(nl.modules[0], lib);
+
+  ConeOptions one, many;
+  one.stop_at = many.stop_at = { "DFF*" };
+  many.threads = 4;
+  const ConeExtractor serial(g, one), parallel(g, many);
+  const auto start = serial.net("n1");
+  const Cone a = serial.fan_in(start), b = parallel.fan_in(start);
+  EXPECT_EQ(a.nets, b.nets);
+  EXPECT_EQ(a.nodes, b.nodes);
+  EXPECT_EQ(a.boundary, b.boundary);
+  EXPECT_EQ(a.boundary.size(), size_t((leaves + 4) / 5));   // the flops
+  const Cone f = parallel.fan_out(serial.net("y"));
+  EXPECT_EQ(f.nodes, serial.fan_out(serial.net("y")).nodes);
+}
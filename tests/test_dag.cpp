@@ -0,0 +1,123 @@
+#include "veriloglib.hpp"
+#include "verilog_dag.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <map>
+
+using namespace verilog;
+
+static std::vector<std::string> names(const ModuleDag& dag, std::span<const uint32_t> ms) {
+  std::vector<std::string> v;
+  for (uint32_t m : ms) v.push_back(dag.module(m).module_name);
+  return v;
+}
+
+TEST(Dag, ChildrenParentsAndOrder) {
+  const Netlist nl = parse_string(R"(
+module top(a); input a; mid m1 (.a(a)); mid m2 (.a(a)); leaf l (.a(a)); endmodule
+module mid(a); input a; leaf l1 (.a(a)); leaf l2 (.a(a)); NAND2X1 u (.A(a)); INVX1 v (.A(a)); endmodule
+module leaf(a); input a; INVX1 u (.A(a)); endmodule
+module spare(a); input a; endmodule
+module leaf(a); input a; mid again (.a(a)); endmodule
+)");
+  const ModuleDag dag(nl);
+  ASSERT_EQ(dag.size(), 5u);
+  EXPECT_EQ(dag.find("mid"), 1u);
+  EXPECT_EQ(dag.find("leaf"), 2u);   // the first definition; the second is not a cycle
+  EXPECT_EQ(dag.find("INVX1"), ModuleDag::kNone);
+
+  EXPECT_EQ(names(dag, dag.children(0)), (std::vector<std::string>{ "mid", "leaf" }));
+  EXPECT_EQ(names(dag, dag.children(1)), (std::vector<std::string>{ "leaf" }));
+  EXPECT_TRUE(dag.children(2).empty());
+  EXPECT_EQ(names(dag, dag.parents(2)), (std::vector<std::string>{ "top", "mid" }));
+  EXPECT_EQ(names(dag, dag.parents(1)), (std::vector<std::string>{ "top", "leaf" }));
+  EXPECT_EQ(names(dag, dag.roots()), (std::vector<std::string>{ "top", "spare", "leaf" }));
+  EXPECT_EQ(dag.height(0), 2u);
+  EXPECT_EQ(dag.height(4), 2u);
+  EXPECT_EQ(dag.height(3), 0u);
+  EXPECT_EQ(std::vector<std::string_view>(dag.undefined().begin(), dag.undefined().end()),
+            (std::vector<std::string_view>{ "INVX1", "NAND2X1" }));
+
+  std::vector<size_t> at(dag.size());
+  ASSERT_EQ(dag.bottom_up().size(), dag.size());
+  for (size_t k = 0; k < dag.size(); ++k) at[dag.bottom_up()[k]] = k;
+  for (uint32_t m = 0; m < dag.size(); ++m)
+    for (uint32_t c : dag.children(m)) EXPECT_LT(at[c], at[m]);
+}
+
+TEST(Dag, CyclesAreNamed) {
+  const Netlist nl = parse_string(R"(
+module top(a); input a; x u (.a(a)); endmodule
+module x(a); input a; y u (.a(a)); endmodule
+module y(a); input a; z u (.a(a)); endmodule
+module z(a); input a; x u (.a(a)); endmodule
+)");
+  try {
+    ModuleDag dag(nl);
+    ADD_FAILURE() << "cycle not reported";
+  } catch (const std::runtime_error& e) {
+    EXPECT_STREQ(e.what(), "instantiation cycle: x -> y -> z -> x");
+  }
+  const Netlist self = parse_string("module r(a); input a; r u (.a(a)); endmodule\n");
+  EXPECT_THROW(ModuleDag{ self }, std::runtime_error);
+}
+
+// `levels` layers of `width` modules; each instantiates a few modules of the
+// layer below and one leaf cell.
+static std::string layered(int levels, int width) {
+  std::string s;
+  for (int l = 0; l < levels; ++l)
+    for (int w = 0; w < width; ++w) {
+      s += "module m" + std::to_string(l) + "_" + std::to_string(w) + "(a); input a;\n  CELL c (.A(a));\n";
+      if (l)
+        for (int k = 0; k < 3; ++k)
+          s += "  m" + std::to_string(l - 1) + "_" + std::to_string((w * 7 + k * 5) % width) + " u" + std::to_string(k) + " (.a(a));\n";
+      s += "endmodule\n";
+    }
+  return s;
+}
+
+TEST(Dag, BottomUpRollupMatchesSerial) {
+  const Netlist nl = parse_string(layered(6, 40));
+  const ModuleDag dag(nl, 3);
+  ASSERT_EQ(dag.size(), 240u);
+
+  // Cells below each module, summed over its instances of defined modules.
+  auto rollup = [&](unsigned threads) {
+    std::vector<uint64_t> cells(dag.size(), 0);
+    std::unique_ptr<std::atomic<bool>[]> visited(new std::atomic<bool>[dag.size()]);
+    for (size_t m = 0; m < dag.size(); ++m) visited[m] = false;
+    std::atomic<size_t> early{ 0 };
+    run_bottom_up(dag, [&](uint32_t m) {
+      for (uint32_t c : dag.children(m))
+        if (!visited[c]) ++early;
+      uint64_t n = 0;
+      for (const auto& inst : dag.module(m).module_instances) {
+        const uint32_t c = dag.find(inst.module_name);
+        n += c == ModuleDag::kNone ? 1 : cells[c];
+      }
+      cells[m] = n;
+      EXPECT_FALSE(visited[m].exchange(true));
+    }, threads);
+    EXPECT_EQ(early.load(), 0u);
+    return cells;
+  };
+  const std::vector<uint64_t> serial = rollup(1);
+  EXPECT_EQ(serial[dag.find("m0_0")], 1u);
+  EXPECT_EQ(serial[dag.find("m5_0")], 1u + 3 + 9 + 27 + 81 + 243);
+  EXPECT_EQ(rollup(4), serial);
+  EXPECT_EQ(rollup(0), serial);
+}
+
+TEST(Dag, FirstExceptionStopsTheRun) {
+  const Netlist nl = parse_string(layered(4, 16));
+  const ModuleDag dag(nl);
+  const uint32_t bad = dag.find("m1_3");
+  std::unique_ptr<std::atomic<bool>[]> visited(new std::atomic<bool>[dag.size()]);
+  for (size_t m = 0; m < dag.size(); ++m) visited[m] = false;
+  EXPECT_THROW(run_bottom_up(dag, [&](uint32_t m) {
+    if (m == bad) throw std::runtime_error("bad module");
+    visited[m] = true;
+  }, 4), std::runtime_error);
+  for (uint32_t p : dag.parents(bad)) EXPECT_FALSE(visited[p]) << dag.module(p).module_name;
+}
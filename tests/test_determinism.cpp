@@ -0,0 +1,176 @@
+#include "veriloglib.hpp"
+#include "verilog_celllib.hpp"
+#include "verilog_check.hpp"
+#include "verilog_cone.hpp"
+#include "verilog_dag.hpp"
+#include "verilog_diff.hpp"
+#include "verilog_elaborate.hpp"
+#include "verilog_flatten.hpp"
+#include "verilog_lazy.hpp"
+#include "verilog_parallel.hpp"
+#include "verilog_partition.hpp"
+#include "verilog_preprocess.hpp"
+#include "verilog_stats.hpp"
+#include "verilog_writer.hpp"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+using namespace verilog;
+namespace fs = std::filesystem;
+
+static uint64_t fnv1a(std::string_view s) {
+  uint64_t h = 1469598103934665603ull;
+  for (unsigned char c : s) h = (h ^ c) * 1099511628211ull;
+  return h;
+}
+
+// Four levels of parameterized blocks, each a few dozen cells, gates and
+// assigns over named and positional connections, with a top over the last
+// level; a few undeclared nets and a duplicate definition give the checker
+// something to report. Split over `files` texts.
+static std::vector<std::string> design(size_t files) {
+  std::mt19937 rng(17);
+  std::vector<std::string> text(files);
+  text[0] = "module NAND2X1(A, B, Y); input A, B; output Y; endmodule\n"
+            "module INVX1(A, Y); input A; output Y; endmodule\n"
+            "module DFFX1(D, CK, Q); input D, CK; output Q; endmodule\n";
+  auto net = [&] { return rng() % 29 == 0 ? "stray" + std::to_string(rng() % 4) : "n[" + std::to_string(rng() % 48) + "]"; };
+  for (int l = 0; l < 4; ++l)
+    for (int k = 0; k < 6; ++k) {
+      const std::string name = "b" + std::to_string(l) + "_" + std::to_string(k);
+      std::string s = "module " + name + " #(parameter N = " + std::to_string(2 + k % 3) + ") (clk, in, out);\n";
+      s += "  input clk; input [7:0] in; output [7:0] out;\n  wire [47:0] n; wire [N:0] t;\n";
+      s += "  assign n[7:0] = in;\n  assign out = {n[47:44], t[1:0], n[1], n[0]};\n";
+      for (int c = 0; c < 40; ++c) {
+        const std::string u = std::to_string(c);
+        switch (rng() % 5) {
+          case 0: s += "  NAND2X1 u" + u + " (.A(" + net() + "), .B(" + net() + "), .Y(n[" + std::to_string(8 + c) + "]));\n"; break;
+          case 1: s += "  INVX1 u" + u + " (" + net() + ", n[" + std::to_string(8 + c) + "]);\n"; break;
+          case 2: s += "  DFFX1 r" + u + " (.D(" + net() + "), .CK(clk), .Q(n[" + std::to_string(8 + c) + "]));\n"; break;
+          case 3: s += "  nand g" + u + " (n[" + std::to_string(8 + c) + "], " + net() + ", " + net() + ");\n"; break;
+          default: s += "  assign n[" + std::to_string(8 + c) + "] = " + net() + ";\n"; break;
+        }
+      }
+      s += "  assign t[1:0] = n[9:8];\n";
+      if (l)
+        for (int c = 0; c < 3; ++c)
+          s += "  b" + std::to_string(l - 1) + "_" + std::to_string(rng() % 6) + " #(.N(" + std::to_string(2 + rng() % 3) +
+               ")) s" + std::to_string(c) + " (.clk(clk), .in(n[" + std::to_string(8 * c + 7) + ":" + std::to_string(8 * c) +
+               "]), .out());\n";
+      text[size_t(l * 6 + k) % files] += s + "endmodule\n";
+    }
+  text[files - 1] += "module b0_0(clk, in, out); input clk; input [7:0] in; output [7:0] out; endmodule\n";
+  text[files - 1] += "module top(clk, in, out); input clk; input [7:0] in; output [7:0] out;\n"
+                     "  b3_0 a (.clk(clk), .in(in), .out(out));\n  b3_1 b (clk, in);\n  b3_2 c (.clk(clk), .in(in));\nendmodule\n";
+  return text;
+}
+
+// What every parallel pass returns for a thread count, hashed.
+static std::map<std::string, uint64_t> outputs(const std::vector<std::string>& paths, const std::string& all, unsigned t) {
+  std::map<std::string, uint64_t> h;
+  PreprocessOptions pp;
+  pp.threads = t;
+  const Netlist nl = parse_files(paths, pp);
+  h["parse_files"] = fnv1a(write_verilog(nl));
+  h["lazy to_netlist"] = fnv1a(write_verilog(LazyNetlist::from_string(all).to_netlist(t)));
+
+  CheckOptions co;
+  co.threads = t;
+  std::string diags;
+  for (const auto& d : check_netlist(nl, co).diagnostics) diags += d.to_string() + "\n";
+  h["check_netlist"] = fnv1a(diags);
+  StatsOptions so;
+  so.threads = t;
+  h["compute_stats"] = fnv1a(compute_stats(nl, so).report(size_t(-1)));
+  const PinAnnotation pins = annotate_pins(nl, InterfaceTable(nl), t);
+  std::string unknown;
+  for (const auto& c : pins.unknown_cells) unknown += c + "\n";
+  for (const auto& p : pins.unknown_pins) unknown += p.module + "." + p.instance + "." + p.pin + "\n";
+  h["annotate_pins"] = fnv1a(unknown);
+
+  ElaborateOptions eo;
+  eo.top = "top";
+  eo.threads = t;
+  const Netlist elab = elaborate(nl, eo).netlist;
+  h["elaborate"] = fnv1a(write_verilog(elab));
+  FlattenOptions fo;
+  fo.threads = t;
+  const Netlist flat = flatten(elab, fo);
+  h["flatten"] = fnv1a(write_verilog(flat));
+  h["uniquify"] = fnv1a(write_verilog(uniquify(elab, "top").to_netlist(t)));
+
+  DiffOptions dopt;
+  dopt.threads = t;
+  h["diff_netlists"] = fnv1a(diff_netlists(nl, elab, dopt).to_json());
+
+  const ModuleDag dag(nl, t);
+  std::vector<uint64_t> cells(dag.size());
+  run_bottom_up(dag, [&](uint32_t m) {
+    for (const auto& inst : dag.module(m).module_instances) {
+      const uint32_t c = dag.find(inst.module_name);
+      cells[m] += c == ModuleDag::kNone || dag.module(c).module_instances.empty() ? 1 : cells[c];
+    }
+  }, t);
+  h["run_bottom_up"] = fnv1a(std::string_view(reinterpret_cast<const char*>(cells.data()), cells.size() * 8));
+
+  const InterfaceTable flat_lib(flat);
+  const ModuleGraph g(flat.modules[0], flat_lib);
+  ConeOptions cone;
+  cone.threads = t;
+  const ConeExtractor x(g, cone);
+  const Cone c = x.fan_in(x.net("out"));
+  h["cone"] = fnv1a(std::string_view(reinterpret_cast<const char*>(c.nodes.data()), c.nodes.size() * 4));
+  PartitionOptions po;
+  po.parts = 3;
+  po.threads = t;
+  const Partition p = partition(g, po);
+  h["partition"] = fnv1a(std::string_view(reinterpret_cast<const char*>(p.part.data()), p.part.size() * 4));
+  return h;
+}
+
+TEST(Determinism, SameOutputsForAnyThreadCount) {
+  const fs::path dir = fs::temp_directory_path() / "verilog_determinism_test";
+  fs::create_directories(dir);
+  const std::vector<std::string> text = design(4);
+  std::vector<std::string> paths;
+  std::string all;
+  for (size_t i = 0; i < text.size(); ++i) {
+    paths.push_back((dir / ("part" + std::to_string(i) + ".v")).string());
+    std::ofstream(paths.back()) << text[i];
+    all += text[i];
+  }
+
+  const auto serial = outputs(paths, all, 1);
+  ASSERT_EQ(serial.size(), 12u);
+  for (unsigned t : { 2u, 3u, 5u, 8u }) {
+    const auto parallel = outputs(paths, all, t);
+    for (const auto& [pass, hash] : serial) EXPECT_EQ(parallel.at(pass), hash) << pass << " with " << t << " threads";
+  }
+  fs::remove_all(dir);
+}
+
+TEST(Determinism, OrderedMergesMatchASerialLoop) {
+  // Index i yields i % 7 values: chunks of very different sizes, enough in
+  // total for the parallel placement.
+  auto produce = [](size_t i, std::vector<std::string>& out) {
+    for (size_t k = 0; k < i % 7; ++k) out.push_back(std::to_string(i) + "." + std::to_string(k));
+  };
+  std::vector<std::string> serial;
+  for (size_t i = 0; i < 20000; ++i) produce(i, serial);
+  ASSERT_GT(serial.size(), 16384u);
+  for (unsigned t : { 1u, 2u, 5u, 16u })
+    for (size_t chunk : { size_t(1), size_t(64), size_t(5000) })
+      EXPECT_EQ(parallel::parallel_collect<std::string>(20000, produce, t, chunk), serial) << t << " threads, chunk " << chunk;
+
+  // Appending after what is there already, and leaving the parts empty.
+  std::vector<std::vector<std::string>> parts(3);
+  for (size_t i = 0; i < 20000; ++i) produce(i, parts[i * 3 / 20000]);
+  std::vector<std::string> out{ "head" };
+  parallel::ordered_append(out, parts.size(), [&](size_t p) -> std::vector<std::string>& { return parts[p]; }, 4);
+  ASSERT_EQ(out.size(), serial.size() + 1);
+  EXPECT_EQ(out.front(), "head");
+  EXPECT_TRUE(std::equal(serial.begin(), serial.end(), out.begin() + 1));
+  for (const auto& p : parts) EXPECT_TRUE(p.empty());
+}
@@ -0,0 +1,107 @@
+#include "veriloglib.hpp"
+#include "verilog_diff.hpp"
+#include <gtest/gtest.h>
+
+using namespace verilog;
+
+static const char* kBefore = R"(
+module top(a, b, y);
+  parameter W = 4;
+  input a, b; output y;
+  wire n1, n2;
+  INVX1 u1 (.A(a), .Y(n1));
+  NAND2X1 u2 (.A(n1), .B(b), .Y(n2));
+  BUFX1 u3 (n2, y);
+  DFFX1 r0 (.D(n2), .CK(a), .Q());
+  assign n3 = a;
+  and g0 (n4, a, b);
+endmodule
+module old(x); input x; endmodule
+)";
+
+static const char* kAfter = R"(
+module top(a, b, y, z);
+  parameter W = 8;
+  input a, b; output y; output z;
+  wire [1:0] n1;
+  wire n2;
+  INVX2 u1 (.A(a), .Y(n1[0]));
+  NAND2X1 u2 (.A(n1[0]), .B(b), .Y(n2));
+  BUFX1 u3 (n2, z);
+  BUFX1 u4 (.A(n2), .Y(y));
+  assign n3 = a;
+  assign z = b;
+  and g0 (n4, b, a);
+endmodule
+module fresh(x); input x; endmodule
+)";
+
+static std::vector<std::string> lines(const NetlistDiff& d) {
+  std::vector<std::string> v;
+  for (const auto& e : d.entries) v.push_back(e.to_string());
+  return v;
+}
+
+TEST(Diff, ReportsEveryKindOfChange) {
+  const NetlistDiff d = diff_netlists(parse_string(kBefore), parse_string(kAfter));
+  EXPECT_EQ(lines(d), (std::vector<std::string>{
+    "+ top: port z",
+    "~ top: parameter W: 4 -> 8",
+    "~ top: net n1: wire -> wire [1:0]",
+    "+ top: net z (output)",
+    "~ top: instance u1: INVX1 -> INVX2",
+    "~ top: connection u1.Y: n1 -> n1[0]",
+    "~ top: connection u2.A: n1 -> n1[0]",
+    "~ top: connection u3.#1: y -> z",
+    "- top: instance r0 (DFFX1)",
+    "+ top: instance u4 (BUFX1)",
+    "+ top: assign z = b",
+    "~ top: gate g0: and (n4, a, b) -> and (n4, b, a)",
+    "- module old",
+    "+ module fresh",
+  })) << d.report();
+  EXPECT_EQ(d.added, 5u);
+  EXPECT_EQ(d.removed, 2u);
+  EXPECT_EQ(d.changed, 7u);
+  EXPECT_NE(d.report().find("diff: 5 added, 2 removed, 7 changed"), std::string::npos);
+}
+
+TEST(Diff, IdenticalNetlistsAndJson) {
+  const Netlist a = parse_string(kBefore);
+  EXPECT_TRUE(diff_netlists(a, parse_string(kBefore)).empty());
+
+  const NetlistDiff d = diff_netlists(parse_string("module m(a); input a; X \\u\"1 (.A(a)); endmodule"),
+                                      parse_string("module m(a); input a; X \\u\"1 (.A(1'b0)); endmodule"));
+  ASSERT_EQ(d.entries.size(), 1u);
+  EXPECT_EQ(d.entries[0].to_json(),
+            R"({"kind":"changed","object":"connection","module":"m","name":"u\"1.A","before":"a","after":"1'h0"})");
+  EXPECT_TRUE(d.to_json().starts_with(R"({"added":0,"removed":0,"changed":1,"entries":[{)"));
+}
+
+TEST(Diff, LargeModulesMatchInParallelAndStream) {
+  auto big = [](int n, int skip, const char* rename) {
+    std::string s = "module top(a); input a;\n";
+    for (int i = 0; i < n; ++i) {
+      if (i == skip) continue;
+      const std::string k = std::to_string(i);
+      s += "  BUFX1 U" + k + " (.A(n" + (i == 77 ? std::string(rename) : k) + "), .Y(n" + std::to_string(i + 1) + "));\n";
+    }
+    return s + "endmodule\nmodule blk(a); input a; endmodule\n";
+  };
+  const Netlist a = parse_string(big(6000, 5000, "77"));
+  const Netlist b = parse_string(big(6000, 123, "x"));
+
+  DiffOptions one, many;
+  one.threads = 1;
+  many.threads = 4;
+  many.modules_per_batch = 1;
+  const NetlistDiff d1 = diff_netlists(a, b, one);
+  EXPECT_EQ(lines(d1), (std::vector<std::string>{
+    "~ top: connection U77.A: n77 -> nx",
+    "- top: instance U123 (BUFX1)",
+    "+ top: instance U5000 (BUFX1)",
+  }));
+  std::vector<std::string> streamed;
+  diff_netlists(a, b, many, [&](const DiffEntry& e) { streamed.push_back(e.to_string()); });
+  EXPECT_EQ(streamed, lines(d1));
+}
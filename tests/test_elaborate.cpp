@@ -0,0 +1,170 @@
+#include "veriloglib.hpp"
+#include "verilog_check.hpp"
+#include "verilog_elaborate.hpp"
+#include <gtest/gtest.h>
+
+using namespace verilog;
+
+static const char* kRam = R"(
+module ram #(parameter W = 8, parameter D = W * 2) (clk, din, dout);
+  localparam MSB = W - 1;
+  input clk;
+  input [MSB:0] din;
+  output [W-1:0] dout;
+  wire [D-1:0] store;
+  DFFX1 r (.D(din[0]), .CK(clk), .Q(dout[0]));
+endmodule
+module top(clk, a, b, y);
+  parameter N = 4;
+  input clk; input [15:0] a; input [7:0] b; output [15:0] y;
+  ram #(16) r0 (.clk(clk), .din(a), .dout(y));
+  ram #(.W(N * 4)) r1 (.clk(clk), .din(a), .dout());
+  ram r2 (.clk(clk), .din(b), .dout());
+  ram #(8) r3 (.clk(clk), .din(b), .dout());
+  ram #(.D(3)) r4 (.clk(clk), .din(b), .dout());
+  SRAM #(.W(N + 1)) s0 (.A(a));
+endmodule
+)";
+
+static const Module* find(const Netlist& nl, const std::string& name) {
+  for (const auto& m : nl.modules)
+    if (m.module_name == name) return &m;
+  return nullptr;
+}
+
+static std::string range_text(const std::optional<Range>& r) {
+  return r ? std::to_string(r->start.as_integer()) + ":" + std::to_string(r->end.as_integer()) : "-";
+}
+
+TEST(Elaborate, ParametersParse) {
+  const Netlist nl = parse_string(kRam);
+  const Module& ram = nl.modules[0];
+  ASSERT_EQ(ram.parameters.size(), 3u);
+  EXPECT_EQ(ram.parameters[0].name, "W");
+  EXPECT_EQ(ram.parameters[1].value, 16);
+  EXPECT_EQ(ram.parameters[1].expr.to_string(), "W*2");
+  EXPECT_TRUE(ram.parameters[2].local);
+  EXPECT_EQ(ram.parameters[2].value, 7);
+
+  // Before elaboration ranges hold the defaults and keep their expressions.
+  EXPECT_EQ(range_text(ram.input_declarations[1].range), "7:0");
+  ASSERT_TRUE(ram.output_declarations[0].range_expr);
+  EXPECT_EQ(ram.output_declarations[0].range_expr->msb.to_string(), "W-1");
+  EXPECT_FALSE(ram.input_declarations[0].range_expr);
+
+  const Module& top = nl.modules[1];
+  ASSERT_TRUE(top.module_instances[0].params);
+  EXPECT_EQ(top.module_instances[0].params->positional.size(), 1u);
+  ASSERT_EQ(top.module_instances[1].params->named.size(), 1u);
+  EXPECT_EQ(top.module_instances[1].params->named[0].first, "W");
+  EXPECT_FALSE(top.module_instances[2].params);
+  EXPECT_NE(top.summary().find("parameter N = 4"), std::string::npos) << top.summary();
+
+  EXPECT_EQ(ParamExpr::parse("-(1 << 3) + 10 % 4").eval({}), -6);
+  EXPECT_EQ(ParamExpr::parse("(2 + 3) * 4").to_string(), "(2+3)*4");
+  EXPECT_THROW(ParamExpr::parse("1 +"), parse_error);
+  EXPECT_THROW(ParamExpr::parse("X").eval({}), std::runtime_error);
+}
+
+TEST(Elaborate, OneSpecializationPerParameterSet) {
+  const ElaboratedNetlist e = elaborate(parse_string(kRam));
+  std::vector<std::string> names;
+  for (const auto& m : e.netlist.modules) names.push_back(m.module_name);
+  EXPECT_EQ(names, (std::vector<std::string>{ "top", "ram_W16", "ram", "ram_D3" }));
+  EXPECT_EQ(e.specializations, 4u);
+  EXPECT_EQ(e.instances, 5u);
+
+  const Module& top = *find(e.netlist, "top");
+  EXPECT_EQ(top.module_instances[0].module_name, "ram_W16");
+  EXPECT_EQ(top.module_instances[1].module_name, "ram_W16");
+  EXPECT_EQ(top.module_instances[2].module_name, "ram");
+  EXPECT_EQ(top.module_instances[3].module_name, "ram");   // restates the default
+  EXPECT_EQ(top.module_instances[4].module_name, "ram_D3");
+  EXPECT_FALSE(top.module_instances[0].params);
+
+  // Undefined masters keep their overrides, as literals.
+  const ModuleInstance& s0 = top.module_instances[5];
+  EXPECT_EQ(s0.module_name, "SRAM");
+  ASSERT_TRUE(s0.params);
+  EXPECT_TRUE(s0.params->named[0].second.is_literal());
+  EXPECT_EQ(s0.params->named[0].second.eval({}), 5);
+
+  const Module& wide = *find(e.netlist, "ram_W16");
+  EXPECT_EQ(wide.parameters[1].value, 32);
+  EXPECT_EQ(wide.parameters[2].value, 15);
+  EXPECT_EQ(range_text(wide.input_declarations[1].range), "15:0");
+  EXPECT_EQ(range_text(wide.output_declarations[0].range), "15:0");
+  EXPECT_EQ(range_text(wide.net_declarations[0].range), "31:0");
+  EXPECT_FALSE(wide.output_declarations[0].range_expr);
+  EXPECT_EQ(range_text(find(e.netlist, "ram_D3")->net_declarations[0].range), "2:0");
+  EXPECT_EQ(range_text(find(e.netlist, "ram")->net_declarations[0].range), "15:0");
+
+  const CheckResult r = check_netlist(e.netlist);
+  size_t undefined = 0;   // SRAM and DFFX1 have no definitions here
+  for (const auto& d : r.diagnostics) undefined += d.check == CheckId::UndefinedModule;
+  EXPECT_EQ(r.errors, undefined) << r.report();
+}
+
+TEST(Elaborate, ThousandsOfInstancesShareASpecialization) {
+  std::string text =
+    "module cell #(parameter W = 1) (a, y); input [W-1:0] a; output [W-1:0] y; assign y = a; endmodule\n"
+    "module blk #(parameter W = 1) (a, y); input [W-1:0] a; output [W-1:0] y;\n"
+    "  cell #(W) c (.a(a), .y(y));\nendmodule\n"
+    "module top(a, y); input [7:0] a; output [7:0] y;\n";
+  for (int i = 0; i < 4000; ++i)
+    text += "  blk #(" + std::to_string(i % 2 ? 4 : 8) + ") b" + std::to_string(i) + " (.a(a), .y());\n";
+  text += "endmodule\n";
+  const Netlist nl = parse_string(text);
+
+  ElaborateOptions one, many;
+  one.threads = 1;
+  many.threads = 4;
+  const ElaboratedNetlist a = elaborate(nl, one);
+  EXPECT_EQ(a.specializations, 5u);   // top, blk and cell at W = 8 and W = 4
+  EXPECT_EQ(a.instances, 4002u);
+  const ElaboratedNetlist b = elaborate(nl, many);
+  ASSERT_EQ(a.netlist.modules.size(), b.netlist.modules.size());
+  for (size_t i = 0; i < a.netlist.modules.size(); ++i)
+    EXPECT_EQ(a.netlist.modules[i].summary(), b.netlist.modules[i].summary());
+  EXPECT_EQ(find(a.netlist, "blk_W4")->module_instances[0].module_name, "cell_W4");
+  EXPECT_EQ(range_text(find(a.netlist, "cell_W8")->input_declarations[0].range), "7:0");
+}
+
+TEST(Elaborate, TopsAndNames) {
+  const Netlist nl = parse_string(
+    "module leaf #(parameter K = 1) (a); input [K:0] a; endmodule\n"
+    "module leaf_K2(a); input a; endmodule\n"
+    "module t1(a); input a; leaf #(2) l (.a(a)); leaf_K2 x (.a(a)); endmodule\n"
+    "module t2(a); input a; leaf #(-3) l (.a(a)); endmodule\n");
+  const ElaboratedNetlist all = elaborate(nl);
+  std::vector<std::string> names;
+  for (const auto& m : all.netlist.modules) names.push_back(m.module_name);
+  EXPECT_EQ(names, (std::vector<std::string>{ "t1", "t2", "leaf_K2_1", "leaf_K2", "leaf_Km3" }));
+
+  ElaborateOptions opts;
+  opts.top = "t2";
+  EXPECT_EQ(elaborate(nl, opts).netlist.modules.size(), 2u);
+  opts.top = "nope";
+  EXPECT_THROW(elaborate(nl, opts), std::runtime_error);
+}
+
+TEST(Elaborate, Errors) {
+  auto message = [](const std::string& text) -> std::string {
+    try {
+      elaborate(parse_string(text));
+    } catch (const std::runtime_error& e) {
+      return e.what();
+    }
+    return "";
+  };
+  const std::string leaf = "module leaf #(parameter A = 1) (x); input x; localparam L = 2; endmodule\n";
+  EXPECT_NE(message(leaf + "module t(x); input x; leaf #(.B(2)) u (.x(x)); endmodule").find("no parameter 'B'"), std::string::npos);
+  EXPECT_NE(message(leaf + "module t(x); input x; leaf #(.L(2)) u (.x(x)); endmodule").find("is local"), std::string::npos);
+  EXPECT_NE(message(leaf + "module t(x); input x; leaf #(1, 2) u (.x(x)); endmodule").find("instance 'u'"), std::string::npos);
+  EXPECT_NE(message(leaf + "module t(x); parameter Z = 0; input x; leaf #(4 / Z) u (.x(x)); endmodule").find("module 't'"),
+            std::string::npos);
+  EXPECT_NE(message("module r #(parameter N = 0) (x); input x; r #(N + 1) u (.x(x)); endmodule\n"
+                    "module t(x); input x; r u (.x(x)); endmodule").find("levels deep"), std::string::npos);
+  EXPECT_THROW(parse_string("module m(a); parameter P = ; input a; endmodule"), parse_error);
+  EXPECT_THROW(parse_string("module m(a); input [Q-1:0] a; endmodule"), parse_error);
+}
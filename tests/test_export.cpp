@@ -0,0 +1,157 @@
+#include "veriloglib.hpp"
+#include "verilog_export.hpp"
+#include "verilog_lazy.hpp"
+#include "verilog_writer.hpp"
+#include "test_util.hpp"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <sstream>
+
+using namespace verilog;
+
+static const char* kDesign = R"(
+module ram #(parameter W = 8, parameter D = 16) (clk, addr, q, ab);
+  localparam A = W*2;
+  input clk; input [W-1:0] addr; output [7:0] q; inout ab; wire \a+b ;
+  wire [3:0] n; tri t; supply0 gnd; supply1 vdd;
+  assign n[1:0] = {addr[0], 1'b1}, t = gnd;
+  assign q = {4'b10xz, n, 70'h3_0000_0000_0000_0001};
+  CELL #(.W(W+1), .D(4)) u1 (.A(addr[3]), .Y(n[2]));
+  CELL #(3) \u$2 (clk, n[3]);
+  and g0 (t, clk, vdd);
+  not (n[0], \a+b );
+endmodule
+module top(x); input x; ram #(.W(4)) r (.clk(x), .q(), .addr(0)); endmodule
+)";
+
+static std::string to_bytes(const Netlist& nl, ExportOptions opts = {}) {
+  std::ostringstream os;
+  write_binary(nl, os, opts);
+  return os.str();
+}
+
+TEST(Export, BinaryReadsBackInPlace) {
+  const Netlist nl = parse_string(kDesign);
+  const std::string bytes = to_bytes(nl);
+  const binary::NetlistView view(bytes);
+  ASSERT_EQ(view.size(), 2u);
+
+  const binary::ModuleView ram = view.module(0);
+  EXPECT_EQ(ram.name(), "ram");
+  EXPECT_GE(ram.name().data(), bytes.data());   // a view into the buffer, not a copy
+  EXPECT_LT(ram.name().data(), bytes.data() + bytes.size());
+  ASSERT_EQ(ram.num_parameters(), 3u);
+  EXPECT_EQ(ram.parameter(2).name(), "A");
+  EXPECT_EQ(ram.parameter(2).expr(), "W*2");
+  EXPECT_EQ(ram.parameter(2).value(), 16);
+  EXPECT_TRUE(ram.parameter(2).local());
+  const binary::DeclView addr = ram.declaration(1);
+  EXPECT_EQ(addr.kind(), binary::DeclKind::Input);
+  EXPECT_EQ(addr.name(0), "addr");
+  EXPECT_EQ(addr.msb(), 7);
+  EXPECT_EQ(addr.msb_expr(), "W-1");
+  const binary::InstanceView u1 = ram.instance(0);
+  EXPECT_EQ(u1.master(), "CELL");
+  ASSERT_EQ(u1.num_named(), 2u);
+  EXPECT_EQ(u1.pin(1), "Y");
+  EXPECT_EQ(u1.named(1).kind(), binary::ExprKind::Indexed);
+  EXPECT_EQ(u1.named(1).name(), "n");
+  EXPECT_EQ(u1.named(1).index(), 2);
+  EXPECT_EQ(u1.param_name(0), "W");
+  EXPECT_EQ(u1.param_expr(0), "W+1");
+  ASSERT_EQ(ram.num_gates(), 2u);
+  EXPECT_EQ(ram.gate(1).type(), GateType::Not);
+  EXPECT_EQ(ram.gate(1).name(), "");
+  EXPECT_EQ(ram.gate(1).terminal(1).name(), "a+b");
+  const binary::ExprView cat = ram.assign(1).rhs(0);
+  ASSERT_EQ(cat.kind(), binary::ExprKind::Concat);
+  EXPECT_EQ(cat.element(0).constant().to_string(), "4'b10xz");
+  EXPECT_EQ(cat.element(2).constant().to_string(), Number::parse("70'h3_0000_0000_0000_0001").value.to_string());
+
+  // Everything the writer puts out comes back.
+  EXPECT_EQ(write_verilog(view.to_netlist()), write_verilog(nl));
+  EXPECT_THROW(ram.port(ram.num_ports()), std::out_of_range);
+}
+
+TEST(Export, JsonModule) {
+  const Netlist nl = parse_string(R"(
+module m #(parameter N = 2) (a, y);
+  input [N-1:0] a; output y; wire \q"x ;
+  assign y = a[0], \q"x = 1'b0;
+  CELL #(.K(N)) u (.Z(y), .A(a[1]));
+  INV v (y, a[0]);
+  nand (y, a[0], a[1]);
+endmodule
+)");
+  EXPECT_EQ(to_json(nl.modules[0]),
+            R"({"name":"m","ports":["a","y"],"parameters":[{"name":"N","expr":"2","value":2,"local":false}],)"
+            R"("declarations":[{"kind":"input","names":["a"],"range":[1,0],"range_expr":["N-1","0"]},)"
+            R"({"kind":"output","names":["y"]},{"kind":"wire","names":["q\"x"]}],)"
+            R"("assigns":[["y","a[0]"],["\\q\"x ","1'h0"]],)"
+            R"("instances":[{"master":"CELL","name":"u","params":{"positional":[],"named":{"K":"N"}},)"
+            R"("pins":{"A":"a[1]","Z":"y"}},{"master":"INV","name":"v","ports":["y","a[0]"]}],)"
+            R"("gates":[{"type":"nand","name":"","terminals":["y","a[0]","a[1]"]}]})");
+}
+
+TEST(Export, StreamingIsTheSameForAnyBatchAndThreadCount) {
+  std::string text;
+  for (int m = 0; m < 40; ++m) {
+    text += "module b" + std::to_string(m) + "(i, o); input i; output o; wire [9:0] n;\n";
+    for (int c = 0; c < 10; ++c)
+      text += "  BUF u" + std::to_string(c) + " (.A(n[" + std::to_string(c) + "]), .Y(n[" + std::to_string((c + 1) % 10) + "]));\n";
+    text += "endmodule\n";
+  }
+  const Netlist nl = parse_string(text);
+  std::ostringstream json;
+  write_json(nl, json, { 1, 1000 });
+  const std::string bytes = to_bytes(nl, { 1, 1000 });
+  EXPECT_EQ(json.str().substr(0, 21), "{\"modules\":[\n{\"name\":");
+  EXPECT_EQ(json.str().substr(json.str().size() - 5), "}\n]}\n");
+
+  for (auto [threads, batch] : { std::pair{ 4u, size_t(3) }, std::pair{ 0u, size_t(64) }, std::pair{ 2u, size_t(0) } }) {
+    const ExportOptions opts{ threads, batch };
+    std::ostringstream j;
+    write_json(nl, j, opts);
+    EXPECT_EQ(j.str(), json.str()) << threads << " threads, batch " << batch;
+    EXPECT_EQ(to_bytes(nl, opts), bytes) << threads << " threads, batch " << batch;
+  }
+
+  // From a lazy netlist, one body touched before: the same bytes, and the
+  // bodies parsed for the export are not kept.
+  const LazyNetlist lazy = LazyNetlist::from_string(text);
+  lazy.module(7);
+  std::ostringstream j, b;
+  write_json(lazy, j, { 3, 5 });
+  write_binary(lazy, b, { 3, 5 });
+  EXPECT_EQ(j.str(), json.str());
+  EXPECT_EQ(b.str(), bytes);
+  EXPECT_TRUE(lazy.is_parsed(7));
+  EXPECT_FALSE(lazy.is_parsed(8));
+}
+
+TEST(Export, DamagedBuffersAreRefused) {
+  const std::string bytes = to_bytes(parse_string(kDesign));
+  EXPECT_THROW(binary::NetlistView(std::string_view(bytes).substr(0, bytes.size() - 1)), std::runtime_error);
+  EXPECT_THROW(binary::NetlistView(std::string_view(bytes).substr(1)), std::runtime_error);
+  EXPECT_THROW(binary::NetlistView(""), std::runtime_error);
+  EXPECT_EQ(binary::NetlistView(to_bytes(Netlist{})).size(), 0u);
+
+  // A string running past the end of its record.
+  std::string bad = bytes;
+  const uint32_t huge = 1u << 30;
+  std::memcpy(&bad[8 + 12], &huge, 4);   // the length of the first record's name
+  const binary::NetlistView view(bad);
+  EXPECT_THROW(view.module(0).name(), std::runtime_error);
+  EXPECT_EQ(view.module(1).name(), "top");
+}
+
+#ifdef VERILOG_TEST_FIFO
+TEST(Export, StreamsFromAPipe) {   // vparse --json <(cat design.v)
+  std::ostringstream eager, piped;
+  write_json(parse_string(kDesign), eager);
+  testutil::FifoFile fifo(kDesign);
+  write_json(LazyNetlist::from_file(fifo.path()), piped);
+  EXPECT_EQ(piped.str(), eager.str());
+  EXPECT_NE(piped.str().find("\"top\""), std::string::npos);
+}
+#endif
@@ -0,0 +1,187 @@
+#include "veriloglib.hpp"
+#include "verilog_flatten.hpp"
+#include "verilog_stats.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+
+using namespace verilog;
+
+static const char* kTree = R"(
+module leaf(A, Y);
+  input A; output Y;
+endmodule
+
+module inv2(a, y);
+  input a; output y;
+  wire m;
+  INVX1 i0 (.A(a), .Y(m));
+  INVX1 i1 (.A(m), .Y(y));
+endmodule
+
+module blk(in, out);
+  input [1:0] in; output [1:0] out;
+  wire [1:0] t;
+  inv2 u0 (.a(in[0]), .y(t[0]));
+  inv2 u1 (.a(in[1]), .y(t[1]));
+  assign out = t;
+  leaf l0 (.A(in[1]), .Y());
+endmodule
+
+module top(x, z);
+  input [1:0] x; output [1:0] z;
+  blk b0 (.in(x), .out(z));
+  blk b1 (.in({x[0], x[1]}), .out());
+endmodule
+)";
+
+static std::string pin(const ModuleInstance& inst, const std::string& name) {
+  auto it = inst.ports_named.find(name);
+  return it == inst.ports_named.end() ? "<open>" : expr_to_string(it->second);
+}
+
+TEST(Flatten, RenamesAndRewiresEveryLeaf) {
+  const Netlist flat = flatten(parse_string(kTree));
+  ASSERT_EQ(flat.modules.size(), 2u);   // the flat top, then the stub it uses
+  EXPECT_EQ(flat.modules[1].module_name, "leaf");
+  const Module& m = flat.modules[0];
+  EXPECT_EQ(m.module_name, "top");
+  EXPECT_EQ(m.port_list, (std::vector<std::string>{ "x", "z" }));
+
+  std::vector<std::string> names;
+  for (const auto& inst : m.module_instances) names.push_back(inst.instance_name);
+  EXPECT_EQ(names, (std::vector<std::string>{
+    "b0/l0", "b0/u0/i0", "b0/u0/i1", "b0/u1/i0", "b0/u1/i1",
+    "b1/l0", "b1/u0/i0", "b1/u0/i1", "b1/u1/i0", "b1/u1/i1" }));
+
+  const auto& is = m.module_instances;
+  EXPECT_EQ(pin(is[0], "A"), "x[1]");
+  EXPECT_EQ(pin(is[0], "Y"), "<open>");
+  EXPECT_EQ(pin(is[1], "A"), "x[0]");
+  EXPECT_EQ(pin(is[1], "Y"), "b0/u0/m");
+  EXPECT_EQ(pin(is[2], "A"), "b0/u0/m");
+  EXPECT_EQ(pin(is[2], "Y"), "b0/t[0]");
+  EXPECT_EQ(pin(is[5], "A"), "x[0]");      // b1.in = {x[0], x[1]}: in[1] is x[0]
+  EXPECT_EQ(pin(is[6], "A"), "x[1]");
+
+  ASSERT_EQ(m.assignments.size(), 2u);
+  EXPECT_EQ(expr_to_string(m.assignments[0].assignments[0].first), "z");
+  EXPECT_EQ(expr_to_string(m.assignments[0].assignments[0].second), "b0/t");
+  EXPECT_EQ(expr_to_string(m.assignments[1].assignments[0].first), "b1/out");   // open port: a fresh wire
+
+  std::vector<std::string> wires;
+  for (const auto& d : m.net_declarations) wires.push_back(d.net_name);
+  EXPECT_EQ(wires, (std::vector<std::string>{
+    "b0/t", "b0/u0/m", "b0/u1/m", "b1/out", "b1/t", "b1/u0/m", "b1/u1/m" }));
+  EXPECT_TRUE(m.net_declarations[0].range.has_value());
+  EXPECT_FALSE(m.net_declarations[1].range.has_value());
+}
+
+TEST(Flatten, LeafWalkMatchesAndThreadsAgree) {
+  const Netlist nl = parse_string(kTree);
+  FlattenOptions opts;
+  opts.separator = '.';
+  std::vector<std::string> walked;
+  for_each_leaf(nl, opts, [&](std::string_view path, const ModuleInstance& leaf) {
+    walked.emplace_back(path);
+    EXPECT_NE(leaf.module_name, "inv2");
+  });
+
+  opts.threads = 1;
+  const Netlist one = flatten(nl, opts);
+  opts.threads = 4;
+  const Netlist four = flatten(nl, opts);
+  ASSERT_EQ(walked.size(), one.modules[0].module_instances.size());
+  for (size_t i = 0; i < walked.size(); ++i) EXPECT_EQ(walked[i], one.modules[0].module_instances[i].instance_name);
+  EXPECT_EQ(walked[1], "b0.u0.i0");
+  EXPECT_EQ(one.modules[0].summary(), four.modules[0].summary());
+  ASSERT_EQ(one.modules[0].module_instances.size(), four.modules[0].module_instances.size());
+  for (size_t i = 0; i < walked.size(); ++i)
+    EXPECT_EQ(pin(one.modules[0].module_instances[i], "A"), pin(four.modules[0].module_instances[i], "A"));
+}
+
+TEST(Flatten, TopAndCycleErrors) {
+  const Netlist nl = parse_string(kTree);
+  FlattenOptions opts;
+  opts.top = "blk";
+  EXPECT_EQ(flatten(nl, opts).modules[0].module_instances.size(), 5u);
+  opts.top = "nope";
+  EXPECT_THROW(flatten(nl, opts), std::runtime_error);
+
+  const Netlist loop = parse_string(
+    "module a(x); input x; b u (.x(x)); endmodule\n"
+    "module b(x); input x; a u (.x(x)); endmodule\n"
+    "module t(x); input x; a u (.x(x)); endmodule\n");
+  EXPECT_THROW(flatten(loop), std::runtime_error);
+  EXPECT_THROW(uniquify(loop), std::runtime_error);
+}
+
+TEST(Uniquify, OneCopyPerInstantiationSharingBodies) {
+  UniqueNetlist u = uniquify(parse_string(kTree));
+  std::vector<std::string> names;
+  for (const auto& m : u.modules) names.push_back(m.name);
+  EXPECT_EQ(names, (std::vector<std::string>{ "top", "blk", "inv2", "inv2_1", "leaf", "blk_1", "inv2_2", "inv2_3" }));
+  EXPECT_EQ(u.modules[2].body, u.modules[3].body);
+  EXPECT_EQ(u.modules[1].body, u.modules[5].body);
+  EXPECT_EQ(u.modules[0].children, (std::vector<uint32_t>{ 1, 5 }));
+  EXPECT_EQ(u.modules[5].children, (std::vector<uint32_t>{ 6, 7, 4 }));
+  EXPECT_EQ(u.modules[2].children, (std::vector<uint32_t>{ UniqueModule::npos, UniqueModule::npos }));
+
+  // Copy-on-write: only the edited copy changes.
+  const Module* shared = u.modules[3].body.get();
+  Module& mine = u.edit(3);
+  EXPECT_NE(&mine, shared);
+  EXPECT_EQ(u.modules[2].body.get(), shared);
+  mine.module_instances[0].instance_name = "i0_eco";
+  EXPECT_EQ(&u.edit(3), &mine);   // already private
+
+  const Netlist nl = u.to_netlist(2);
+  ASSERT_EQ(nl.modules.size(), 8u);
+  EXPECT_EQ(nl.modules[5].module_name, "blk_1");
+  EXPECT_EQ(nl.modules[0].module_instances[1].module_name, "blk_1");
+  EXPECT_EQ(nl.modules[5].module_instances[1].module_name, "inv2_3");
+  EXPECT_EQ(nl.modules[3].module_instances[0].instance_name, "i0_eco");
+  EXPECT_EQ(nl.modules[2].module_instances[0].instance_name, "i0");
+
+  const DesignStats ds = compute_stats(nl);
+  for (const auto& [name, n] : ds.module_instantiations) EXPECT_EQ(n, name == "leaf" ? 2u : 1u) << name;
+}
+
+TEST(Uniquify, CopyNamesSkipExistingModules) {
+  UniqueNetlist u = uniquify(parse_string(
+    "module c_1(a); input a; BUF b (.A(a)); endmodule\n"
+    "module c(a); input a; BUF b (.A(a)); endmodule\n"
+    "module t(a); input a; c u0 (.a(a)); c u1 (.a(a)); c_1 u2 (.a(a)); endmodule\n"));
+  std::vector<std::string> names;
+  for (const auto& m : u.modules) names.push_back(m.name);
+  EXPECT_EQ(names, (std::vector<std::string>{ "t", "c", "c_2", "c_1" }));
+}
+
+TEST(Uniquify, SameResultForAnyThreadCount) {
+  // Repeated subtrees big enough to be split across workers.
+  std::string src = "module m0(a); input a; INVX1 i (.A(a)); endmodule\n"
+                    "module m1_2(a); input a; endmodule\n";
+  for (int l = 1; l <= 3; ++l) {
+    src += "module m" + std::to_string(l) + "(a); input a;";
+    for (int k = 0; k < 4; ++k) src += " m" + std::to_string(l - 1) + " u" + std::to_string(k) + " (.a(a));";
+    src += " m1_2 s (.a(a)); endmodule\n";
+  }
+  src += "module t(a); input a; m3 u0 (.a(a)); m3 u1 (.a(a)); m3 u2 (.a(a)); endmodule\n";
+  const UniqueNetlist one = uniquify(parse_string(src), "t", 1);
+  const UniqueNetlist many = uniquify(parse_string(src), "t", 8);
+  ASSERT_EQ(one.modules.size(), 3u * 85 + 2);
+  ASSERT_EQ(many.modules.size(), one.modules.size());
+  for (size_t i = 0; i < one.modules.size(); ++i) {
+    EXPECT_EQ(many.modules[i].name, one.modules[i].name) << i;
+    EXPECT_EQ(many.modules[i].body->module_name, one.modules[i].body->module_name) << i;
+    EXPECT_EQ(many.modules[i].children, one.modules[i].children) << i;
+  }
+  std::vector<std::string> names;
+  for (const auto& m : one.modules) names.push_back(m.name);
+  EXPECT_EQ(names[3], "m1");
+  EXPECT_EQ(names[8], "m1_2");   // the stub, after m1 and its four m0
+  EXPECT_EQ(names[9], "m1_1");
+  EXPECT_EQ(names[14], "m1_3");  // skips the stub's name
+  EXPECT_EQ(std::count(names.begin(), names.end(), "m1_2"), 1);
+  std::sort(names.begin(), names.end());
+  EXPECT_EQ(std::adjacent_find(names.begin(), names.end()), names.end());
+}
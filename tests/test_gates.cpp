@@ -0,0 +1,184 @@
+#include "veriloglib.hpp"
+#include "verilog_check.hpp"
+#include "verilog_connectivity.hpp"
+#include "verilog_flatten.hpp"
+#include "verilog_grammar.hpp"
+#include "verilog_stats.hpp"
+#include <gtest/gtest.h>
+
+using namespace verilog;
+
+static const char* kGates = R"(
+module top(a, b, y, z);
+  input a, b; output y; output [1:0] z;
+  supply0 gnd;
+  supply1 vdd;
+  tri t;
+  wire n1, n2;
+  wire [1:0] w;
+  and g0 (n1, a, b), (n2, a, vdd);
+  not (t, n1);
+  buf b0 (z[1], z[0], n2);
+  nor g1 (y, t, gnd);
+  DFFX1 r0 (.D(1'b0), .CK(a), .Q());
+  assign w = {1'b1, n1};
+endmodule
+module DFFX1(D, CK, Q); input D, CK; output Q; endmodule
+)";
+
+static size_t count(const CheckResult& r, CheckId id) {
+  size_t n = 0;
+  for (const auto& d : r.diagnostics) n += d.check == id;
+  return n;
+}
+
+static std::vector<std::string> terminal_text(const GateTable& t, size_t i) {
+  std::vector<std::string> v;
+  for (const auto& e : t.terminals_of(i)) v.push_back(expr_to_string(e));
+  return v;
+}
+
+TEST(Gates, KeywordsClassify) {
+  using grammar::classify_keyword;
+  using grammar::Keyword;
+  static_assert(classify_keyword("and") == Keyword::And);
+  static_assert(classify_keyword("or") == Keyword::Or);
+  static_assert(classify_keyword("xnor") == Keyword::Xnor);
+  static_assert(classify_keyword("not") == Keyword::Not);
+  static_assert(classify_keyword("supply0") == Keyword::Supply0);
+  static_assert(classify_keyword("tri") == Keyword::Tri);
+  static_assert(classify_keyword("supply2") == Keyword::None);
+  static_assert(classify_keyword("an") == Keyword::None);
+  static_assert(classify_keyword("AND") == Keyword::None);
+  EXPECT_EQ(classify_keyword("bufif0"), Keyword::None);
+}
+
+TEST(Gates, StoredPerTypeNotAsInstances) {
+  const Netlist nl = parse_string(kGates);
+  const Module& m = nl.modules[0];
+  EXPECT_EQ(m.module_instances.size(), 1u);
+  EXPECT_EQ(m.num_gates(), 5u);
+
+  const GateTable& ands = m.gates[size_t(GateType::And)];
+  ASSERT_EQ(ands.size(), 2u);
+  EXPECT_EQ(ands.names[0], "g0");
+  EXPECT_EQ(ands.names[1], "");
+  EXPECT_EQ(terminal_text(ands, 1), (std::vector<std::string>{ "n2", "a", "vdd" }));
+  EXPECT_EQ(m.gate_label(GateType::And, 1), "and#1");
+
+  const GateTable& bufs = m.gates[size_t(GateType::Buf)];
+  ASSERT_EQ(bufs.size(), 1u);
+  EXPECT_EQ(terminal_text(bufs, 0), (std::vector<std::string>{ "z[1]", "z[0]", "n2" }));
+  EXPECT_EQ(gate_outputs(GateType::Buf, 3), 2u);
+  EXPECT_EQ(gate_outputs(GateType::Nor, 3), 1u);
+  EXPECT_EQ(m.gates[size_t(GateType::Not)].names[0], "");
+
+  ASSERT_EQ(m.net_declarations.size(), 5u);
+  EXPECT_EQ(m.net_declarations[0].type, NetType::Supply0);
+  EXPECT_EQ(m.net_declarations[1].type, NetType::Supply1);
+  EXPECT_EQ(m.net_declarations[2].type, NetType::Tri);
+  EXPECT_EQ(m.net_declarations[3].type, NetType::Wire);
+  EXPECT_NE(m.summary().find("gates:   5"), std::string::npos) << m.summary();
+}
+
+TEST(Gates, ConstantsAreValuesNotText) {
+  const Netlist nl = parse_string(kGates);
+  const Module& m = nl.modules[0];
+  const Expr& d = m.module_instances[0].ports_named.at("D");
+  ASSERT_TRUE(std::holds_alternative<Constant>(d));
+  EXPECT_EQ(std::get<Constant>(d).value.width(), 1u);
+  EXPECT_EQ(expr_to_string(d), "1'h0");
+
+  const Expr& rhs = m.assignments[0].assignments[0].second;
+  ASSERT_TRUE(std::holds_alternative<std::shared_ptr<Concatenation>>(rhs));
+  EXPECT_TRUE(std::holds_alternative<Constant>(std::get<std::shared_ptr<Concatenation>>(rhs)->elements[0]));
+
+  const Netlist nl2 = parse_string("module m(y); output [3:0] y; assign y = 5; endmodule");
+  const Expr& five = nl2.modules[0].assignments[0].assignments[0].second;
+  ASSERT_TRUE(std::holds_alternative<Constant>(five));
+  EXPECT_FALSE(std::get<Constant>(five).sized);
+  EXPECT_EQ(expr_to_string(five), "5");
+}
+
+TEST(Gates, GraphAndChecks) {
+  const Netlist nl = parse_string(kGates);
+  const Module& m = nl.modules[0];
+  const InterfaceTable ifaces(nl);
+  const ModuleGraph g(m, ifaces);
+  uint32_t gates = 0;
+  for (uint32_t node = 0; node < g.num_nodes(); ++node) {
+    if (g.node_kind(node) != ModuleGraph::NodeKind::Gate) continue;
+    const auto [type, row] = g.gate_ref(node);
+    if (gates++ == 0) { EXPECT_EQ(type, GateType::And); }
+    if (type == GateType::Buf) {
+      const auto pins = g.node_pins(node);
+      ASSERT_EQ(pins.size(), 3u);
+      EXPECT_EQ(pins[0].dir, PortDir::Output);
+      EXPECT_EQ(pins[1].dir, PortDir::Output);
+      EXPECT_EQ(pins[2].dir, PortDir::Input);
+      EXPECT_EQ(g.pin_name(pins[2]), "#2");
+    }
+  }
+  EXPECT_EQ(gates, 5u);
+
+  const CheckResult clean = check_netlist(nl);
+  EXPECT_EQ(clean.errors, 0u) << clean.report();
+
+  const CheckResult r = check_netlist(parse_string(
+    "module m(a, y); input a; output y; wire n;\n"
+    "  not u (n, a);\n"
+    "  buf u (y, n);\n"
+    "  and (y, a, n);\n"
+    "endmodule\n"));
+  EXPECT_EQ(count(r, CheckId::DuplicateName), 1u) << r.report();
+  EXPECT_EQ(count(r, CheckId::MultipleDrivers), 1u) << r.report();
+  EXPECT_NE(r.report().find("and#0.#0"), std::string::npos) << r.report();
+
+  const DesignStats st = compute_stats(nl);
+  EXPECT_EQ(st.gate_counts.at("and"), 2u);
+  for (const auto& issue : st.undriven_nets) {
+    EXPECT_NE(issue.net, "gnd");
+    EXPECT_NE(issue.net, "vdd");
+  }
+}
+
+TEST(Gates, TieOffsAreConnectedPins) {
+  const DesignStats st = compute_stats(parse_string(
+    "module DFF(D, CK, Q); input D, CK; output Q; endmodule\n"
+    "module top(clk, q); input clk; output q;\n"
+    "  DFF r0 (.D(1'b0), .CK(clk), .Q(q));\n"
+    "  DFF r1 (.D({1'b1}), .CK(clk), .Q());\n"
+    "  DFF r2 (1'b1, clk);\n"
+    "endmodule\n"));
+  std::vector<std::string> open;
+  for (const auto& p : st.unconnected_pins) open.push_back(p.instance + "." + p.pin);
+  EXPECT_EQ(open, (std::vector<std::string>{ "r1.Q", "r2.Q" }));
+}
+
+TEST(Gates, FlattenKeepsGatesAndTies) {
+  const Netlist nl = parse_string(R"(
+    module cell(a, en, y); input a, en; output y; wire n;
+      nand g (n, a, en);
+      not (y, n);
+    endmodule
+    module top(x, y0, y1); input x; output y0, y1;
+      cell c0 (.a(x), .en(1'b1), .y(y0));
+      cell c1 (x, 1'b0, y1);
+    endmodule
+  )");
+  const Netlist flat = flatten(nl);
+  ASSERT_EQ(flat.modules.size(), 1u);
+  const Module& m = flat.modules[0];
+  const GateTable& nands = m.gates[size_t(GateType::Nand)];
+  ASSERT_EQ(nands.size(), 2u);
+  EXPECT_EQ(nands.names[0], "c0/g");
+  EXPECT_EQ(terminal_text(nands, 1), (std::vector<std::string>{ "c1/n", "x", "c1/en" }));
+  EXPECT_EQ(m.gates[size_t(GateType::Not)].names[0], "");
+  EXPECT_EQ(terminal_text(m.gates[size_t(GateType::Not)], 0), (std::vector<std::string>{ "y0", "c0/n" }));
+
+  std::vector<std::string> ties;
+  for (const auto& ca : m.assignments)
+    for (const auto& [lhs, rhs] : ca.assignments) ties.push_back(expr_to_string(lhs) + "=" + expr_to_string(rhs));
+  EXPECT_EQ(ties, (std::vector<std::string>{ "c0/en=1'h1", "c1/en=1'h0" }));
+  EXPECT_EQ(check_netlist(flat).errors, 0u) << check_netlist(flat).report();
+}
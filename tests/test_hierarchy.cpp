@@ -0,0 +1,137 @@
+#include "veriloglib.hpp"
+#include "verilog_celllib.hpp"
+#include "verilog_hierarchy.hpp"
+#include <gtest/gtest.h>
+
+using namespace verilog;
+
+static const char* kChip = R"(
+module alu(a, y); input a; output y; wire n;
+  INVX1 U1 (.A(a), .Y(n));
+  INVX1 U12 (.A(n), .Y(y));
+  BUFX1 U2 (.A(n), .Y());
+endmodule
+module cpu(a, y); input a; output y; wire m;
+  alu u_alu (.a(a), .y(m));
+  alu u_alu2 (.a(m), .y(y));
+endmodule
+module chip(a, y); input a; output y; wire w;
+  cpu u_cpu (.a(a), .y(w));
+  cpu u_dsp (.a(w), .y(y));
+endmodule
+)";
+
+static std::vector<std::string> strings(const HierarchyIndex& h, const std::vector<HierPath>& v) {
+  std::vector<std::string> s;
+  for (const auto& p : v) s.push_back(h.path_string(p));
+  return s;
+}
+
+TEST(Hierarchy, ResolvesInstancesPinsAndNets) {
+  const Netlist nl = parse_string(kChip);
+  const HierarchyIndex h(nl);
+  EXPECT_EQ(h.top().module_name, "chip");
+
+  const auto inst = h.resolve("u_cpu/u_alu/U12");
+  ASSERT_TRUE(inst);
+  EXPECT_EQ(inst->kind, PathKind::Instance);
+  ASSERT_EQ(inst->hops.size(), 3u);
+  EXPECT_EQ(inst->hops[0]->module_name, "cpu");
+  EXPECT_EQ(inst->hops[2]->instance_name, "U12");
+
+  const auto pin = h.resolve("chip/u_cpu/u_alu/U12/Y");   // leading top name is skipped
+  ASSERT_TRUE(pin);
+  EXPECT_EQ(pin->kind, PathKind::Pin);
+  EXPECT_EQ(pin->name, "Y");
+  EXPECT_EQ(h.path_string(*pin), "u_cpu/u_alu/U12/Y");
+
+  const auto port = h.resolve("u_dsp/u_alu2/a");   // a pin of a defined master
+  ASSERT_TRUE(port);
+  EXPECT_EQ(port->kind, PathKind::Pin);
+
+  const auto net = h.resolve("u_dsp/u_alu2/n");   // a net inside the last instance's master
+  ASSERT_TRUE(net);
+  EXPECT_EQ(net->kind, PathKind::Net);
+  EXPECT_EQ(net->hops.size(), 2u);
+  EXPECT_EQ(h.resolve("u_cpu/a")->kind, PathKind::Pin);   // pins shadow the port nets behind them
+}
+
+TEST(Hierarchy, NetsAndMisses) {
+  const Netlist nl = parse_string(kChip);
+  const HierarchyIndex h(nl);
+  const auto top_net = h.resolve("w");
+  ASSERT_TRUE(top_net);
+  EXPECT_EQ(top_net->kind, PathKind::Net);
+  EXPECT_TRUE(top_net->hops.empty());
+
+  EXPECT_FALSE(h.resolve("u_cpu/u_alu/U12/Q"));      // INVX1 is not defined and has no Q connection
+  EXPECT_FALSE(h.resolve("u_cpu/nope/U1"));          // only the last segment may be a pin or net
+  EXPECT_FALSE(h.resolve("u_cpu/u_alu/U2/Y"));       // .Y() is left open, so Y is not known
+  ASSERT_TRUE(h.resolve(""));
+  EXPECT_TRUE(h.resolve("chip")->hops.empty());
+
+  InterfaceTable cells;
+  add_cell_stubs(cells, parse_string("module BUFX1(A, Y); input A; output Y; endmodule"));
+  HierarchyOptions opts;
+  opts.cells = &cells;
+  opts.separator = '.';
+  const HierarchyIndex dotted(nl, opts);
+  const auto y = dotted.resolve("u_cpu.u_alu.U2.Y");
+  ASSERT_TRUE(y);
+  EXPECT_EQ(y->kind, PathKind::Pin);
+  EXPECT_EQ(dotted.path_string(*y), "u_cpu.u_alu.U2.Y");
+
+  opts.top = "cpu";
+  EXPECT_EQ(HierarchyIndex(nl, opts).resolve("u_alu.U1")->hops.size(), 2u);
+  opts.top = "missing";
+  EXPECT_THROW(HierarchyIndex(nl, opts), std::runtime_error);
+}
+
+TEST(Hierarchy, Wildcards) {
+  const Netlist nl = parse_string(kChip);
+  const HierarchyIndex h(nl);
+  EXPECT_EQ(strings(h, h.glob("u_cpu/*/U1*")),
+            (std::vector<std::string>{ "u_cpu/u_alu/U1", "u_cpu/u_alu/U12", "u_cpu/u_alu2/U1", "u_cpu/u_alu2/U12" }));
+  EXPECT_EQ(strings(h, h.glob("*/u_alu?/U2")), (std::vector<std::string>{ "u_cpu/u_alu2/U2", "u_dsp/u_alu2/U2" }));
+  EXPECT_EQ(strings(h, h.glob("u_cpu/u_alu/U1/*")), (std::vector<std::string>{ "u_cpu/u_alu/U1/A", "u_cpu/u_alu/U1/Y" }));
+  EXPECT_EQ(strings(h, h.glob("u_cpu/u_alu/?")),
+            (std::vector<std::string>{ "u_cpu/u_alu/a", "u_cpu/u_alu/y", "u_cpu/u_alu/n" }));   // pins of u_alu, then nets in alu
+  EXPECT_EQ(strings(h, h.glob("u_cpu/u_alu/U12")), (std::vector<std::string>{ "u_cpu/u_alu/U12" }));
+  EXPECT_TRUE(h.glob("u_cpu/x*/U1").empty());
+}
+
+TEST(Hierarchy, BatchMatchesSingleLookups) {
+  std::string text = "module leaf(a, y); input a; output y; endmodule\n";
+  text += "module mid(a); input a;\n";
+  for (int i = 0; i < 50; ++i) text += "  leaf L" + std::to_string(i) + " (.a(a), .y());\n";
+  text += "endmodule\nmodule top(a); input a;\n";
+  for (int i = 0; i < 40; ++i) text += "  mid M" + std::to_string(i) + " (.a(a));\n";
+  text += "endmodule\n";
+  const Netlist nl = parse_string(text);
+  HierarchyOptions opts;
+  opts.threads = 4;
+  const HierarchyIndex h(nl, opts);
+
+  std::vector<std::string> paths;
+  for (int m = 39; m >= 0; --m) {
+    for (int l = 0; l < 50; ++l) {
+      const std::string base = "M" + std::to_string(m) + "/L" + std::to_string(l);
+      paths.push_back(l % 3 == 0 ? base + "/y" : l % 3 == 1 ? "top/" + base : base + "/missing");
+    }
+  }
+  paths.push_back("M1");
+  paths.push_back("M1/L1/y/z");
+  const auto batch = h.resolve(std::span<const std::string>(paths));
+  ASSERT_EQ(batch.size(), paths.size());
+  size_t hits = 0;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    const auto one = h.resolve(paths[i]);
+    ASSERT_EQ(bool(one), bool(batch[i])) << paths[i];
+    if (!one) continue;
+    ++hits;
+    EXPECT_EQ(one->hops, batch[i]->hops) << paths[i];
+    EXPECT_EQ(one->kind, batch[i]->kind) << paths[i];
+    EXPECT_EQ(h.path_string(*batch[i]), h.path_string(*one));
+  }
+  EXPECT_EQ(hits, 40u * 34 + 1);
+}
@@ -0,0 +1,109 @@
+#include "veriloglib.hpp"
+#include "verilog_lazy.hpp"
+#include "test_util.hpp"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace verilog;
+
+static const char* kLazy = R"(// module fake(x); endmodule in a line comment
+module leaf(A, Y);
+  input A; output Y;
+  /* endmodule inside a block comment */
+endmodule
+
+(* endmodule *)
+module top(a, y);
+  input a; output y;
+  wire \endmodule ;
+  leaf u0 (.A(a), .Y(\endmodule ));
+  leaf u1 (.A(\endmodule ), .Y(y));
+endmodule
+module bad(p);
+  input p;
+  leaf u2 (.A(p) .Y());
+endmodule
+)";
+
+TEST(Lazy, OutlinesSkipCommentsAndEscapedNames) {
+  LazyNetlist lazy = LazyNetlist::from_string(kLazy);
+  ASSERT_EQ(lazy.size(), 3u);
+  EXPECT_EQ(lazy.outlines()[0].module_name, "leaf");
+  EXPECT_EQ(lazy.outlines()[0].port_list, (std::vector<std::string>{ "A", "Y" }));
+  EXPECT_EQ(lazy.outlines()[1].module_name, "top");
+  EXPECT_EQ(lazy.outlines()[2].module_name, "bad");
+  EXPECT_EQ(lazy.text(0).substr(0, 11), "module leaf");
+  EXPECT_EQ(lazy.text(1).substr(lazy.text(1).size() - 9), "endmodule");
+  EXPECT_EQ(lazy.find("top"), &lazy.outlines()[1]);
+  EXPECT_EQ(lazy.find("nope"), nullptr);
+  for (size_t i = 0; i < lazy.size(); ++i) EXPECT_FALSE(lazy.is_parsed(i));
+  EXPECT_THROW(lazy.is_parsed(lazy.size()), std::out_of_range);
+  EXPECT_THROW(lazy.module(lazy.size()), std::out_of_range);
+  EXPECT_THROW(lazy.parse_module(lazy.size()), std::out_of_range);
+}
+
+TEST(Lazy, BodiesParseOnFirstTouch) {
+  LazyNetlist lazy = LazyNetlist::from_string(kLazy);
+  const Module* top = lazy.module("top");
+  ASSERT_NE(top, nullptr);
+  EXPECT_TRUE(lazy.is_parsed(1));
+  EXPECT_FALSE(lazy.is_parsed(0));
+  ASSERT_EQ(top->module_instances.size(), 2u);
+  EXPECT_EQ(expr_to_string(top->module_instances[1].ports_named.at("A")), "endmodule");
+  EXPECT_EQ(&lazy.module(1), top);   // parsed once, then cached
+}
+
+TEST(Lazy, BodyErrorsSurfaceWhenTouched) {
+  LazyNetlist lazy = LazyNetlist::from_string(kLazy, "chip.v");
+  EXPECT_NO_THROW(lazy.module(0));
+  try {
+    lazy.module(2);
+    FAIL() << "expected a parse error";
+  } catch (const parse_error& e) {
+    EXPECT_EQ(std::string(e.what()).rfind("chip.v:16:", 0), 0u) << e.what();
+  }
+  EXPECT_THROW(lazy.module(2), parse_error);   // not cached as parsed
+  EXPECT_FALSE(lazy.is_parsed(2));
+
+  EXPECT_THROW(LazyNetlist::from_string("module m(a);\n  input a;\n"), parse_error);   // no endmodule
+}
+
+TEST(Lazy, MatchesParseString) {
+  const std::string good = std::string(kLazy).substr(0, std::string(kLazy).find("module bad"));
+  const Netlist eager = parse_string(good);
+  const Netlist lazy = LazyNetlist::from_string(good).to_netlist(2);
+  ASSERT_EQ(lazy.modules.size(), eager.modules.size());
+  for (size_t i = 0; i < eager.modules.size(); ++i) EXPECT_EQ(lazy.modules[i].summary(), eager.modules[i].summary());
+}
+
+TEST(Lazy, FromFileAndConcurrentTouch) {
+  const auto path = std::filesystem::temp_directory_path() / "verilog_lazy_test.v";
+  {
+    std::ofstream f(path);
+    for (int m = 0; m < 32; ++m)
+      f << "module m" << m << "(a);\n  input a;\n  BUF u (.A(a), .Y(n));\nendmodule\n";
+  }
+  LazyNetlist lazy = LazyNetlist::from_file(path.string());
+  ASSERT_EQ(lazy.size(), 32u);
+  std::vector<std::thread> pool;
+  std::atomic<int> ok{0};
+  for (int t = 0; t < 4; ++t)
+    pool.emplace_back([&] { for (size_t i = 0; i < lazy.size(); ++i) ok += lazy.module(i).module_instances.size() == 1; });
+  for (auto& t : pool) t.join();
+  EXPECT_EQ(ok.load(), 4 * 32);
+  std::filesystem::remove(path);
+}
+
+#ifdef VERILOG_TEST_FIFO
+TEST(Lazy, FromFileReadsPipes) {
+  const std::string good = std::string(kLazy).substr(0, std::string(kLazy).find("module bad"));
+  testutil::FifoFile fifo(good);
+  const LazyNetlist lazy = LazyNetlist::from_file(fifo.path());
+  EXPECT_EQ(lazy.size(), parse_string(good).modules.size());
+  EXPECT_NE(lazy.find("top"), nullptr);
+  EXPECT_THROW(LazyNetlist::from_file("/nonexistent/design.v"), parse_error);
+}
+#endif
@@ -0,0 +1,103 @@
+#include "veriloglib.hpp"
+#include "verilog_levelize.hpp"
+#include "test_util.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+
+using namespace verilog;
+
+static std::vector<uint32_t> nodes(std::span<const uint32_t> s) { return { s.begin(), s.end() }; }
+
+TEST(Levelize, LevelsCutAtFlopsAndFindLoops) {
+  const Netlist nl = parse_string(R"(
+module top(clk, a, b, y, z);
+  input clk, a, b; output y, z;
+  wire n1, n2, n3, q, s, r;
+  NAND2X1 u1 (.A(a), .B(q), .Y(n1));
+  INVX1 u2 (.A(n1), .Y(n2));
+  DFFX1 r0 (.D(n2), .CK(clk), .Q(q));
+  NAND2X1 l1 (.A(a), .B(r), .Y(s));
+  NAND2X1 l2 (.A(b), .B(s), .Y(r));
+  BUFX1 u3 (.A(s), .Y(z));
+  assign n3 = n2;
+  and g0 (y, n3, n1);
+endmodule
+)");
+  const InterfaceTable lib = testutil::stub_cells();
+  const ModuleGraph g(nl.modules[0], lib);
+  LevelizeOptions opts;
+  opts.sequential = { "DFF*" };
+  const Schedule s = levelize(g, opts);
+  // nodes: ports 0-4, u1 5, u2 6, r0 7, l1 8, l2 9, u3 10, assign 11, g0 12
+  ASSERT_EQ(s.num_levels(), 4u);
+  EXPECT_EQ(nodes(s.level_nodes(0)), (std::vector<uint32_t>{ 5, 8, 9 }));
+  EXPECT_EQ(nodes(s.level_nodes(1)), (std::vector<uint32_t>{ 6, 10 }));
+  EXPECT_EQ(nodes(s.level_nodes(2)), (std::vector<uint32_t>{ 11 }));
+  EXPECT_EQ(nodes(s.level_nodes(3)), (std::vector<uint32_t>{ 12 }));
+  EXPECT_EQ(s.sequential, (std::vector<uint32_t>{ 7 }));
+  EXPECT_EQ(s.level[7], Schedule::kNoLevel);
+  EXPECT_EQ(s.level[0], Schedule::kNoLevel);
+  ASSERT_EQ(s.num_loops(), 1u);
+  EXPECT_EQ(nodes(s.loop(0)), (std::vector<uint32_t>{ 8, 9 }));
+
+  // Without the flop as a cut point u1 -> u2 -> r0 -> u1 is a loop too.
+  const Schedule open = levelize(g);
+  ASSERT_EQ(open.num_loops(), 2u);
+  EXPECT_EQ(nodes(open.loop(0)), (std::vector<uint32_t>{ 5, 6, 7 }));
+  EXPECT_TRUE(open.sequential.empty());
+}
+
+TEST(Levelize, SelfLoopsAndDeepChains) {
+  const Netlist self = parse_string("module m(a, x); input a; output x; and g (x, x, a); not n (y, x); endmodule");
+  const ModuleGraph gs(self.modules[0], InterfaceTable{});
+  const Schedule ss = levelize(gs);
+  ASSERT_EQ(ss.num_loops(), 1u);
+  EXPECT_EQ(nodes(ss.loop(0)), (std::vector<uint32_t>{ 2 }));
+  EXPECT_EQ(ss.num_levels(), 2u);
+
+  // Far deeper than any recursive walk could go.
+  const int depth = 100000;
+  std::string text = "module chain(a, y); input a; output y; wire [" + std::to_string(depth) + ":0] n;\n  assign n[0] = a;\n";
+  for (int i = 0; i < depth; ++i)
+    text += "  not (n[" + std::to_string(i + 1) + "], n[" + std::to_string(i) + "]);\n";
+  text += "  assign y = n[" + std::to_string(depth) + "];\nendmodule\n";
+  const Netlist nl = parse_string(text);
+  const ModuleGraph g(nl.modules[0], InterfaceTable{});
+  const Schedule s = levelize(g);
+  EXPECT_EQ(s.num_levels(), size_t(depth) + 2);
+  EXPECT_EQ(s.num_loops(), 0u);
+  EXPECT_EQ(s.nodes.size(), size_t(depth) + 2);
+}
+
+TEST(Levelize, ParallelLevelsSeeTheirDriversDone) {
+  const size_t n = 20000;
+  testutil::RandomLogic shape;
+  shape.input_odds = 8;
+  shape.window = 300;
+  shape.flop_every = 50;
+  const std::string text = testutil::random_logic(n, 3, shape);
+  const Netlist nl = parse_string(text);
+  const InterfaceTable lib = testutil::stub_cells();
+  const ModuleGraph g(nl.modules[0], lib);
+  LevelizeOptions opts;
+  opts.sequential = { "DFF*" };
+  const Schedule s = levelize(g, opts);
+  EXPECT_EQ(s.num_loops(), 0u);
+  EXPECT_EQ(s.sequential.size(), size_t(n / 50));
+
+  std::vector<std::atomic<uint8_t>> done(g.num_nodes());
+  std::atomic<size_t> early{0}, visited{0};
+  for_each_level(s, [&](uint32_t v) {
+    for (const auto& p : g.node_pins(v)) {
+      if (p.dir != PortDir::Input) continue;
+      for (uint32_t pi : g.net_pins(p.net)) {
+        const auto& d = g.pins()[pi];
+        if (d.dir == PortDir::Output && s.level[d.node] != Schedule::kNoLevel && !done[d.node]) ++early;
+      }
+    }
+    done[v] = 1;
+    ++visited;
+  }, 4, 64);
+  EXPECT_EQ(early.load(), 0u);
+  EXPECT_EQ(visited.load(), s.nodes.size());
+}
@@ -0,0 +1,108 @@
+#include "veriloglib.hpp"
+#include "verilog_partition.hpp"
+#include "test_util.hpp"
+#include "verilog_writer.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace verilog;
+
+// Two clusters of 16 cells, each a chain with extra cross links inside,
+// joined by a single net.
+static std::string two_clusters() {
+  std::string s = "module top(in, out); input in; output out;\n";
+  for (const char* c : { "a", "b" }) {
+    for (int i = 0; i < 16; ++i) {
+      const std::string y = std::string(c) + std::to_string(i);
+      const std::string x = i ? std::string(c) + std::to_string(i - 1) : (c[0] == 'a' ? "in" : "a15");
+      const std::string z = std::string(c) + std::to_string((i * 7 + 3) % 16);
+      s += "  NAND2X1 u" + y + " (.A(" + x + "), .B(" + z + "), .Y(" + y + "));\n";
+    }
+  }
+  return s + "  BUFX1 ob (.A(b15), .Y(out));\nendmodule\n";
+}
+
+TEST(Partition, BisectionFindsTheSingleLink) {
+  const Netlist nl = parse_string(two_clusters());
+  const InterfaceTable lib = testutil::stub_cells();
+  const ModuleGraph g(nl.modules[0], lib);
+  PartitionOptions opts;
+  opts.imbalance = 0.1;
+  const Partition p = partition(g, opts);
+  ASSERT_EQ(p.num_parts(), 2u);
+  EXPECT_EQ(p.sizes[0] + p.sizes[1], 33u);
+  EXPECT_LE(std::max(p.sizes[0], p.sizes[1]), 18u);
+  ASSERT_EQ(p.cut.size(), 1u);
+  EXPECT_EQ(g.net_name(p.cut[0]), "a15");
+  EXPECT_EQ(p.part[0], Partition::kNoPart);   // port in
+
+  // Each side is a module of its own, the link net a port on both.
+  const uint32_t a_side = p.part[nl.modules[0].port_list.size()];   // node of the first instance, ua0
+  const Module a = part_module(g, p, a_side, "side_a");
+  const Module b = part_module(g, p, 1 - a_side, "side_b");
+  EXPECT_EQ(a.port_list, (std::vector<std::string>{ "in", "a15" }));
+  EXPECT_EQ(b.port_list, (std::vector<std::string>{ "out", "a15" }));
+  EXPECT_EQ(a.output_declarations.size(), 1u);
+  EXPECT_EQ(b.input_declarations.size(), 1u);
+  const Netlist back = parse_string(write_verilog(a) + write_verilog(b));
+  EXPECT_EQ(back.modules[0].module_instances.size(), 16u);
+  EXPECT_EQ(back.modules[1].module_instances.size(), 17u);
+  EXPECT_THROW(part_module(g, p, 2, "none"), std::invalid_argument);
+}
+
+TEST(Partition, NoEmptyParts) {
+  const Netlist nl = parse_string(
+    "module top(a, y); input a; output y; wire n0, n1;\n"
+    "  BUFX1 u0 (.A(a), .Y(n0));\n"
+    "  BUFX1 u1 (.A(n0), .Y(n1));\n"
+    "  NAND2X1 u2 (.A(n0), .B(n1), .Y(y));\n"
+    "  assign n2 = n1;\n"
+    "endmodule\n");
+  const InterfaceTable lib = testutil::stub_cells();
+  const ModuleGraph g(nl.modules[0], lib);
+  PartitionOptions opts;
+  opts.parts = 4;
+  const Partition p = partition(g, opts);
+  for (uint32_t s : p.sizes) EXPECT_EQ(s, 1u);
+  opts.parts = 10;
+  EXPECT_THROW(partition(g, opts), std::invalid_argument);
+}
+
+TEST(Partition, KWayIsBalancedAndBeatsRandom) {
+  const Netlist nl = parse_string(testutil::random_logic(6000, 9));
+  const InterfaceTable lib = testutil::stub_cells();
+  const ModuleGraph g(nl.modules[0], lib);
+  PartitionOptions opts;
+  opts.parts = 5;
+  const Partition p = partition(g, opts);
+  ASSERT_EQ(p.num_parts(), 5u);
+  size_t total = 0;
+  for (uint32_t s : p.sizes) {
+    total += s;
+    EXPECT_LE(s, size_t(6001 * 1.05 / 5) + 1);
+  }
+  EXPECT_EQ(total, 6001u);   // the cells and the assign
+  for (uint32_t k = 0; k < p.num_parts(); ++k) EXPECT_EQ(p.nodes(k).size(), p.sizes[k]);
+
+  // A random balanced assignment cuts far more.
+  std::mt19937 rng(1);
+  std::vector<uint32_t> random(g.num_nodes());
+  for (auto& r : random) r = rng() % 5;
+  size_t random_cut = 0;
+  for (NetId n = 0; n < g.num_nets(); ++n) {
+    uint32_t seen = Partition::kNoPart;
+    for (uint32_t pi : g.net_pins(n)) {
+      const auto& pin = g.pins()[pi];
+      if (g.node_kind(pin.node) == ModuleGraph::NodeKind::Port) continue;
+      if (seen == Partition::kNoPart) seen = random[pin.node];
+      else if (random[pin.node] != seen) { ++random_cut; break; }
+    }
+  }
+  EXPECT_LT(p.cut.size() * 4, random_cut);
+
+  // The same seed gives the same parts whatever the thread count.
+  opts.threads = 4;
+  EXPECT_EQ(partition(g, opts).part, p.part);
+  opts.parts = 0;
+  EXPECT_THROW(partition(g, opts), std::invalid_argument);
+}
@@ -0,0 +1,224 @@
+#include "veriloglib.hpp"
+#include "verilog_check.hpp"
+#include "verilog_preprocess.hpp"
+#include "verilog_source.hpp"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+
+using namespace verilog;
+
+namespace fs = std::filesystem;
+
+static Netlist pp_string(const std::string& text, const PreprocessOptions& opts = {}) {
+  IncludeCache cache;
+  return parse_preprocessed(preprocess_string(text, "top.v", opts, cache));
+}
+
+static std::vector<std::string> names(const Netlist& nl) {
+  std::vector<std::string> v;
+  for (const auto& m : nl.modules) v.push_back(m.module_name);
+  return v;
+}
+
+// A scratch directory of small files, removed with the fixture.
+class PreprocessFiles : public ::testing::Test {
+protected:
+  void SetUp() override {
+    dir_ = fs::temp_directory_path() / ("verilog_pp_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+    fs::create_directories(dir_ / "inc");
+  }
+  void TearDown() override { fs::remove_all(dir_); }
+
+  std::string write(const std::string& name, const std::string& text) {
+    const fs::path p = dir_ / name;
+    std::ofstream(p) << text;
+    return p.string();
+  }
+
+  fs::path dir_;
+};
+
+TEST(Preprocess, DirectivesAndMacrosExpand) {
+  const Netlist nl = pp_string(
+    "`timescale 1ns / 1ps\n"
+    "`define WIDTH 3\n"
+    "`define CELL(name, a, y) INVX1 name (.A(a), .Y(y))\n"
+    "`default_nettype none\n"
+    "`celldefine\n"
+    "module top(a, y);\n"
+    "  input [`WIDTH:0] a; output y;\n"
+    "`ifdef USE_BUF\n"
+    "  BUFX1 b0 (.A(a[0]), .Y(y));\n"
+    "`elsif USE_INV\n"
+    "  `CELL(i0, a[0], y);\n"
+    "`else\n"
+    "  assign y = a[0];\n"
+    "`endif\n"
+    "endmodule\n"
+    "`endcelldefine\n",
+    PreprocessOptions{ {}, { { "USE_INV", "" } } });
+  const Netlist expect = parse_string(
+    "module top(a, y);\n"
+    "  input [3:0] a; output y;\n"
+    "  INVX1 i0 (.A(a[0]), .Y(y));\n"
+    "endmodule\n");
+  ASSERT_EQ(nl.modules.size(), 1u);
+  EXPECT_EQ(nl.modules[0].summary(), expect.modules[0].summary());
+  EXPECT_EQ(nl.modules[0].module_instances[0].module_name, "INVX1");
+}
+
+TEST(Preprocess, NestedConditionalsAndUndef) {
+  const std::string text =
+    "`define A\n"
+    "`ifdef A\n"
+    "  `ifndef B\n"
+    "module ab(x); input x; endmodule\n"
+    "  `else\n"
+    "module bad1(x); input x; endmodule\n"
+    "  `endif\n"
+    "`else\n"
+    "  `ifdef A module bad2(x); input x; endmodule `endif\n"
+    "`endif\n"
+    "`undef A\n"
+    "`ifdef A module bad3(x); input x; endmodule `else module c(x); input x; endmodule `endif\n";
+  EXPECT_EQ(names(pp_string(text)), (std::vector<std::string>{ "ab", "c" }));
+}
+
+TEST(Preprocess, LocationsPointIntoTheOriginalText) {
+  if (!VERILOGLIB_SOURCE_LOCATIONS) GTEST_SKIP() << "built without source locations";
+  const Netlist nl = pp_string(
+    "`define NET n\n"                          // 1
+    "module top(a, y);\n"                      // 2
+    "  input a; output y;\n"                   // 3
+    "`ifdef NEVER\n"                           // 4
+    "  wire unused;\n"                         // 5
+    "`endif\n"                                 // 6
+    "  wire `NET;\n"                           // 7
+    "  BUFX1 b0 (.A(a), .Y(`NET));\n"          // 8
+    "  INVX1 i0 (.A(`NET), .Y(y));\n"          // 9
+    "endmodule\n"                              // 10
+    "module leaf(x); input x; endmodule\n");   // 11
+  ASSERT_TRUE(nl.sources);
+  ASSERT_EQ(nl.modules.size(), 2u);
+  const Module& top = nl.modules[0];
+  EXPECT_EQ(locate(nl, top.span).line, 2u);
+  EXPECT_EQ(locate(nl, top.span).file, "top.v");
+  EXPECT_EQ(locate(nl, top.net_declarations[0].span).line, 7u);
+  EXPECT_EQ(locate(nl, top.module_instances[0].span).line, 8u);
+  const SourceLocation inv = locate(nl, top.module_instances[1].span);
+  EXPECT_EQ(inv.line, 9u);
+  EXPECT_EQ(inv.column, 9u);
+  EXPECT_EQ(locate(nl, nl.modules[1].span).line, 11u);
+  EXPECT_EQ(locate(nl, nl.modules[1].span).column, 1u);
+}
+
+TEST(Preprocess, ErrorsReportFileAndLine) {
+  auto line_of = [](const std::string& text) -> uint32_t {
+    try {
+      pp_string(text);
+    } catch (const parse_error& e) {
+      EXPECT_EQ(e.source, "top.v") << e.what();
+      return e.location.line;
+    }
+    ADD_FAILURE() << "no error for: " << text;
+    return 0;
+  };
+  EXPECT_EQ(line_of("module m(a);\n  input `W a;\nendmodule\n"), 2u);                 // undefined macro
+  EXPECT_EQ(line_of("\n`ifdef X\nmodule m(a); input a; endmodule\n"), 2u);            // no `endif
+  EXPECT_EQ(line_of("module m(a); input a; endmodule\n`endif\n"), 2u);
+  EXPECT_EQ(line_of("`define F(x) x\nmodule m(a); input `F a; endmodule\n"), 2u);     // missing arguments
+  EXPECT_EQ(line_of("`include \"missing.vh\"\n"), 1u);
+  EXPECT_EQ(line_of("`define W\n\nmodule m(a);\n`ifdef W\n  input a\n`endif\nendmodule\n"), 7u);   // syntax, across pieces
+  EXPECT_EQ(line_of("module m(a); input a; endmodule\njunk;\n"), 2u);
+}
+
+TEST_F(PreprocessFiles, IncludesResolveRelativeThenIncludeDirs) {
+  write("inc/cells.vh",
+        "`ifndef CELLS_VH\n"
+        "`define CELLS_VH\n"
+        "module INVX1(A, Y); input A; output Y; endmodule\n"
+        "`endif\n");
+  write("defs.vh", "`define TOP top\n`include \"cells.vh\"\n");
+  const std::string top = write("top.v",
+    "`include \"defs.vh\"\n"
+    "`include \"inc/cells.vh\"\n"
+    "module `TOP (a, y);\n"
+    "  input a; output y;\n"
+    "  INVX1 i0 (.A(a), .Y(y));\n"
+    "  wire ;\n"
+    "endmodule\n");
+  PreprocessOptions opts;
+  opts.include_dirs.push_back((dir_ / "inc").string());
+  IncludeCache cache;
+  try {
+    parse_files({ top }, opts, &cache);
+    FAIL() << "expected a syntax error";
+  } catch (const parse_error& e) {
+    EXPECT_EQ(e.source, top);
+    EXPECT_EQ(e.location.line, 6u);
+  }
+
+  write("top.v",
+    "`include \"defs.vh\"\n"
+    "module `TOP (a, y);\n"
+    "  input a; output y;\n"
+    "  INVX1 i0 (.A(a), .Y(y));\n"
+    "endmodule\n");
+  IncludeCache fresh;
+  const Netlist nl = parse_files({ top }, opts, &fresh);
+  EXPECT_EQ(names(nl), (std::vector<std::string>{ "INVX1", "top" }));
+  if (VERILOGLIB_SOURCE_LOCATIONS) {
+    const SourceLocation cell = locate(nl, nl.modules[0].span);
+    EXPECT_EQ(fs::path(cell.file).filename(), "cells.vh");
+    EXPECT_EQ(cell.line, 3u);
+    EXPECT_EQ(locate(nl, nl.modules[1].span).file, top);
+  }
+}
+
+TEST_F(PreprocessFiles, IncludeCacheLoadsEachFileOnce) {
+  write("stubs.vh", "module BUFX1(A, Y); input A; output Y; endmodule\n");
+  write("stubs_copy.vh", "module BUFX1(A, Y); input A; output Y; endmodule\n");
+  std::vector<std::string> files;
+  for (int i = 0; i < 8; ++i) {
+    files.push_back(write("part" + std::to_string(i) + ".v",
+      "`ifndef ONCE\n`include \"stubs.vh\"\n`endif\n"
+      "module part" + std::to_string(i) + "(a, y);\n  input a; output y;\n  BUFX1 b (.A(a), .Y(y));\nendmodule\n"));
+  }
+  files.push_back(write("copy.v", "`include \"stubs_copy.vh\"\n"));
+
+  PreprocessOptions one, many;
+  one.threads = 1;
+  many.threads = 4;
+  IncludeCache cache;
+  const Netlist a = parse_files(files, many, &cache);
+  EXPECT_EQ(cache.files(), files.size() + 2);   // every top file, stubs.vh, stubs_copy.vh
+  EXPECT_EQ(cache.hits(), 7u);                  // stubs.vh after its first load
+  EXPECT_EQ(cache.shared(), 1u);                // stubs_copy.vh has the same contents
+  ASSERT_EQ(a.modules.size(), 8u * 2 + 1);
+  for (int i = 0; i < 8; ++i) EXPECT_EQ(a.modules[size_t(2 * i + 1)].module_name, "part" + std::to_string(i));
+
+  const Netlist b = parse_files(files, one);
+  ASSERT_EQ(b.modules.size(), a.modules.size());
+  for (size_t i = 0; i < a.modules.size(); ++i) {
+    EXPECT_EQ(a.modules[i].summary(), b.modules[i].summary());
+    EXPECT_EQ(a.modules[i].span.begin, b.modules[i].span.begin);
+  }
+
+  // Predefining ONCE skips the include: macros start from opts.defines in every file.
+  PreprocessOptions once = many;
+  once.defines["ONCE"] = "";
+  EXPECT_EQ(parse_files(files, once).modules.size(), 8u + 1);
+}
+
+TEST_F(PreprocessFiles, CheckReportsTheIncludedFile) {
+  if (!VERILOGLIB_SOURCE_LOCATIONS) GTEST_SKIP() << "built without source locations";
+  write("leaf.vh", "module leaf(a, y);\n  input a; output y;\n  input a;\nendmodule\n");
+  const std::string top = write("top.v", "`include \"leaf.vh\"\nmodule top(a); input a; leaf l (.a(a)); endmodule\n");
+  CheckOptions opts;
+  opts.file = top;
+  const CheckResult r = check_netlist(parse_files({ top }), opts);
+  ASSERT_GE(r.errors, 1u) << r.report();
+  EXPECT_EQ(fs::path(r.diagnostics[0].file).filename(), "leaf.vh");
+  EXPECT_EQ(r.diagnostics[0].line, 3u);
+}
@@ -0,0 +1,129 @@
+"""Tests of the veriloglib Python extension; run by ctest with the module on PYTHONPATH."""
+import os
+import tempfile
+import threading
+import unittest
+
+import veriloglib
+
+DESIGN = """
+module INVX1(A, Y); input A; output Y; endmodule
+module NAND2X1(A, B, Y); input A, B; output Y; endmodule
+module top(a, b, y);
+  input a, b; output y; wire [1:0] n;
+  NAND2X1 u1 (.A(a), .B(b), .Y(n[0]));
+  INVX1 u2 (.A(n[0]), .Y(n[1]));
+  INVX1 u3 (n[1], y);
+  BUFX1 u4 (.A(n[0]), .Y());
+endmodule
+"""
+
+
+class ViewsTest(unittest.TestCase):
+    def setUp(self):
+        self.nl = veriloglib.parse_string(DESIGN)
+
+    def test_modules_and_instances(self):
+        nl = self.nl
+        self.assertEqual(len(nl), 3)
+        self.assertEqual([m.name for m in nl], ["INVX1", "NAND2X1", "top"])
+        top = nl["top"]
+        self.assertEqual(nl[-1].name, "top")
+        self.assertEqual(nl.find("top").ports, ["a", "b", "y"])
+        self.assertIsNone(nl.find("missing"))
+        with self.assertRaises(KeyError):
+            nl["missing"]
+        with self.assertRaises(IndexError):
+            nl[3]
+
+        insts = top.instances
+        self.assertEqual(len(insts), 4)
+        self.assertEqual([i.name for i in insts], ["u1", "u2", "u3", "u4"])
+        self.assertEqual(insts[0].master, "NAND2X1")
+        self.assertEqual(insts[0].pins, {"A": "a", "B": "b", "Y": "n[0]"})
+        self.assertEqual(insts[2].ports, ["n[1]", "y"])
+        self.assertEqual(insts[-1].name, "u4")
+        self.assertIn("INVX1 u2 (.A(n[0]), .Y(n[1]));", top.to_verilog())
+
+    def test_views_keep_the_netlist_alive(self):
+        inst = veriloglib.parse_string(DESIGN)["top"].instances[1]
+        self.assertEqual(inst.master, "INVX1")
+
+    def test_instance_masters(self):
+        codes, names = self.nl["top"].instance_masters()
+        self.assertEqual(names, ["NAND2X1", "INVX1", "BUFX1"])
+        self.assertEqual(list(codes), [0, 1, 1, 2])
+        view = memoryview(codes)
+        self.assertEqual((view.format, view.itemsize, view.shape, view.readonly), ("I", 4, (4,), True))
+        self.assertEqual(view.tolist(), [0, 1, 1, 2])
+
+    def test_net_fanouts(self):
+        top = self.nl["top"]
+        loads = dict(zip(top.net_names(), top.net_fanouts()))
+        # n[0] feeds u2 and the undefined BUFX1, whose pin counts as a load.
+        self.assertEqual(loads, {"a": 1, "b": 1, "y": 1, "n[1]": 1, "n[0]": 2})
+        cells = veriloglib.parse_string("module BUFX1(A, Y); input A; output Y; endmodule\n")
+        self.assertEqual(list(top.net_fanouts(cells=cells)), list(top.net_fanouts()))
+        with self.assertRaises(TypeError):
+            top.net_fanouts(cells=1)
+
+    def test_numpy_wraps_columns_without_copying(self):
+        try:
+            import numpy
+        except ImportError:
+            self.skipTest("numpy not installed")
+        codes, _ = self.nl["top"].instance_masters()
+        a = numpy.asarray(codes)
+        self.assertEqual(a.dtype, numpy.uint32)
+        self.assertEqual(a.tolist(), [0, 1, 1, 2])
+        self.assertFalse(a.flags.writeable)
+        self.assertEqual(numpy.asarray(codes).ctypes.data, a.ctypes.data)   # both wrap the column's memory
+
+
+class ParseTest(unittest.TestCase):
+    def test_parse_file_and_bytes(self):
+        with tempfile.TemporaryDirectory() as d:
+            path = os.path.join(d, "design.v")
+            with open(path, "w") as f:
+                f.write(DESIGN)
+            self.assertEqual(len(veriloglib.parse_file(path)), 3)
+        self.assertEqual(len(veriloglib.parse_string(DESIGN.encode())), 3)
+
+    def test_syntax_errors(self):
+        with self.assertRaises(veriloglib.ParseError) as cm:
+            veriloglib.parse_string("module m(a);\n  input a\n  wire b;\nendmodule\n")
+        self.assertGreater(cm.exception.line, 0)
+        self.assertIsInstance(cm.exception, ValueError)
+        with self.assertRaises(veriloglib.ParseError):
+            veriloglib.parse_file("/nonexistent/design.v")
+
+    def test_gil_is_released_while_parsing(self):
+        text = "".join(
+            "module m%d(a, y); input a; output y; wire [63:0] n;\n%s endmodule\n"
+            % (k, "".join("  INVX1 u%d (.A(n[%d]), .Y(n[%d]));\n" % (c, c, c + 1) for c in range(63)))
+            for k in range(400))
+        ticks = 0
+        running = True
+
+        def count():
+            nonlocal ticks
+            while running:
+                ticks += 1
+
+        t = threading.Thread(target=count)
+        t.start()
+        try:
+            while ticks == 0:
+                pass
+            before = ticks
+            nl = veriloglib.parse_string(text)
+            during = ticks - before
+        finally:
+            running = False
+            t.join()
+        self.assertEqual(len(nl), 400)
+        self.assertGreater(during, 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
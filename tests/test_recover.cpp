@@ -0,0 +1,113 @@
+#include "veriloglib.hpp"
+#include "verilog_recover.hpp"
+#include <gtest/gtest.h>
+
+using namespace verilog;
+
+static const char* kBroken = R"(
+module good1(a, y);
+  input a; output y;
+  BUFX1 b0 (.A(a), .Y(y));
+endmodule
+
+module bad(clk, d, q);
+  input clk, d; output q;
+  always @(posedge clk) q <= d;
+  BUFX1 b1 (.A(d), .Y(q));
+  wire ;
+endmodule
+
+module good2(a, y);
+  input a; output y;
+  assign y = a;
+endmodule
+)";
+
+static std::vector<std::string> names(const Netlist& nl) {
+  std::vector<std::string> v;
+  for (const auto& m : nl.modules) v.push_back(m.module_name);
+  return v;
+}
+
+TEST(Recover, CleanTextMatchesParseString) {
+  const std::string text = R"(
+// leading comment
+module inv(A, Y); input A; output Y; endmodule
+module top(a, y);
+  input a; output y; wire n;
+  inv u0 (.A(a), .Y(n)), u1 (.A(n), .Y(y));
+  assign y = n;
+endmodule /* trailing */
+)";
+  const RecoveredNetlist r = parse_string_recovering(text);
+  EXPECT_TRUE(r.ok()) << r.report();
+  EXPECT_TRUE(r.dropped.empty());
+  const Netlist strict = parse_string(text);
+  ASSERT_EQ(r.netlist.modules.size(), strict.modules.size());
+  for (size_t i = 0; i < strict.modules.size(); ++i) {
+    EXPECT_EQ(r.netlist.modules[i].summary(), strict.modules[i].summary());
+    EXPECT_EQ(r.netlist.modules[i].span.begin, strict.modules[i].span.begin);
+    EXPECT_EQ(r.netlist.modules[i].span.end, strict.modules[i].span.end);
+  }
+  EXPECT_EQ(r.netlist.modules[1].module_instances[1].span.begin, strict.modules[1].module_instances[1].span.begin);
+}
+
+TEST(Recover, ReportsEveryErrorAndKeepsGoodModules) {
+  EXPECT_THROW(parse_string(kBroken), parse_error);
+
+  RecoverOptions opts;
+  opts.source = "broken.v";
+  const RecoveredNetlist r = parse_string_recovering(kBroken, opts);
+  EXPECT_EQ(names(r.netlist), (std::vector<std::string>{ "good1", "good2" }));
+  EXPECT_EQ(r.dropped, (std::vector<std::string>{ "bad" }));
+  ASSERT_EQ(r.errors.size(), 2u) << r.report();
+  EXPECT_EQ(r.errors[0].module, "bad");
+  EXPECT_EQ(r.errors[0].location.line, 9u);
+  EXPECT_EQ(r.errors[1].location.line, 11u);
+  EXPECT_EQ(r.errors[1].to_string().rfind("broken.v:11:", 0), 0u) << r.errors[1].to_string();
+  EXPECT_NE(r.report().find("2 error(s), 1 module(s) dropped"), std::string::npos) << r.report();
+  EXPECT_EQ(r.netlist.modules[1].assignments.size(), 1u);
+}
+
+TEST(Recover, MissingEndmoduleAndBadHeaderStayLocal) {
+  const RecoveredNetlist r = parse_string_recovering(
+    "module open(a);\n"
+    "  input a;\n"
+    "module hdr(a b);\n"
+    "  input a;\n"
+    "endmodule\n"
+    "module ok(a); input a; endmodule\n");
+  EXPECT_EQ(names(r.netlist), (std::vector<std::string>{ "ok" }));
+  EXPECT_EQ(r.dropped, (std::vector<std::string>{ "open", "hdr" }));
+  ASSERT_EQ(r.errors.size(), 2u) << r.report();
+  EXPECT_NE(r.errors[0].message.find("endmodule"), std::string::npos);
+  EXPECT_EQ(r.errors[1].module, "hdr");
+  EXPECT_EQ(r.errors[1].location.line, 3u);
+}
+
+TEST(Recover, TextOutsideModulesIsReported) {
+  const RecoveredNetlist r = parse_string_recovering(
+    "`timescale 1ns/1ps\n"
+    "module a(x); input x; endmodule\n"
+    "junk;\n"
+    "module b(x); input x; endmodule\n");
+  EXPECT_EQ(names(r.netlist), (std::vector<std::string>{ "a", "b" }));
+  EXPECT_TRUE(r.dropped.empty());
+  ASSERT_EQ(r.errors.size(), 2u) << r.report();
+  EXPECT_EQ(r.errors[0].location.line, 1u);
+  EXPECT_TRUE(r.errors[0].module.empty());
+  EXPECT_EQ(r.errors[1].location.line, 3u);
+}
+
+TEST(Recover, ThreadCountDoesNotChangeResult) {
+  std::string text;
+  for (int i = 0; i < 50; ++i) text += kBroken;
+  RecoverOptions one, many;
+  one.threads = 1;
+  many.threads = 8;
+  const RecoveredNetlist a = parse_string_recovering(text, one), b = parse_string_recovering(text, many);
+  EXPECT_EQ(a.report(1000), b.report(1000));
+  EXPECT_EQ(a.errors.size(), 100u);
+  EXPECT_EQ(names(a.netlist), names(b.netlist));
+  EXPECT_EQ(a.netlist.modules.size(), 100u);
+}
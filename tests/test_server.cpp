@@ -0,0 +1,191 @@
+#include "veriloglib.hpp"
+#include "verilog_server.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace verilog;
+using namespace verilog::server;
+
+static const char* kChip = R"(
+module INV(A, Y);
+  input A; output Y;
+endmodule
+module core(a, y);
+  input a; output y;
+  wire [1:0] n;
+  INV u0 (.A(a), .Y(n[0]));
+  INV u1 (.A(n[0]), .Y(n[1]));
+  DFF r0 (.D(n[1]), .Q(y));
+endmodule
+module chip(in, out);
+  input in; output out;
+  core u_core (.a(in), .y(out));
+endmodule
+)";
+
+static std::string socket_name(const char* tag) {
+  return (std::filesystem::temp_directory_path() / ("vparsed_" + std::string(tag) + "_" + std::to_string(::getpid()) + ".sock")).string();
+}
+
+struct ServerTest : ::testing::Test {
+  NetlistServer srv{ socket_name("test") };
+  void SetUp() override {
+    srv.add_design("chip", parse_string(kChip));
+    srv.start();
+  }
+};
+
+TEST_F(ServerTest, ListsDesignsAndModules) {
+  NetlistClient c(srv.socket_path());
+  c.ping();
+  const auto designs = c.list_designs();
+  ASSERT_EQ(designs.size(), 1u);
+  EXPECT_EQ(designs[0].name, "chip");
+  EXPECT_EQ(designs[0].top, "chip");
+  EXPECT_EQ(designs[0].modules, 3u);
+  EXPECT_EQ(designs[0].instances, 4u);
+  EXPECT_EQ(c.list_modules("chip"), (std::vector<std::string>{ "INV", "core", "chip" }));
+  EXPECT_THROW(c.list_modules("nope"), std::runtime_error);
+}
+
+TEST_F(ServerTest, FindInstance) {
+  NetlistClient c(srv.socket_path());
+  auto u1 = c.find_instance("chip", "core", "u1");
+  ASSERT_TRUE(u1);
+  EXPECT_EQ(u1->master, "INV");
+  ASSERT_EQ(u1->connections.size(), 2u);
+  EXPECT_EQ(u1->connections[0], (std::pair<std::string, std::string>{ "A", "n[0]" }));
+  EXPECT_FALSE(c.find_instance("chip", "core", "u9"));
+  EXPECT_FALSE(c.find_instance("chip", "nope", "u1"));
+}
+
+TEST_F(ServerTest, NetFanout) {
+  NetlistClient c(srv.socket_path());
+  auto f = c.net_fanout("chip", "core", "n[0]");
+  ASSERT_TRUE(f);
+  ASSERT_EQ(f->pins.size(), 2u);
+  EXPECT_EQ(f->pins[0].node, "u0");
+  EXPECT_EQ(f->pins[0].pin, "Y");
+  EXPECT_EQ(f->pins[0].dir, PortDir::Output);
+  EXPECT_EQ(f->pins[1].node, "u1");
+  EXPECT_EQ(f->pins[1].dir, PortDir::Input);
+
+  auto bus = c.net_fanout("chip", "core", "n");   // whole bus, MSB first: n[1] then n[0]
+  ASSERT_TRUE(bus);
+  EXPECT_EQ(bus->pins.size(), 4u);
+  EXPECT_EQ(bus->pins[1].node, "r0");   // DFF has no definition: named pin, unknown direction
+  EXPECT_EQ(bus->pins[1].pin, "D");
+  EXPECT_EQ(bus->pins[1].dir, PortDir::Unknown);
+  EXPECT_FALSE(c.net_fanout("chip", "core", "zz"));
+}
+
+TEST_F(ServerTest, ResolvePath) {
+  NetlistClient c(srv.socket_path());
+  auto p = c.resolve_path("chip", "chip/u_core/u1/Y");
+  ASSERT_TRUE(p);
+  ASSERT_EQ(p->hops.size(), 2u);
+  EXPECT_EQ(p->hops[0], (std::pair<std::string, std::string>{ "u_core", "core" }));
+  EXPECT_EQ(p->hops[1], (std::pair<std::string, std::string>{ "u1", "INV" }));
+  EXPECT_EQ(p->end, PathEnd::Pin);
+  EXPECT_EQ(p->name, "Y");
+
+  auto net = c.resolve_path("chip", "u_core/n[1]");   // top name is optional
+  ASSERT_TRUE(net);
+  EXPECT_EQ(net->end, PathEnd::Net);
+  EXPECT_EQ(net->hops.size(), 1u);
+
+  auto inst = c.resolve_path("chip", "u_core/r0");
+  ASSERT_TRUE(inst);
+  EXPECT_EQ(inst->end, PathEnd::Instance);
+  EXPECT_EQ(inst->hops.back().second, "DFF");
+
+  EXPECT_FALSE(c.resolve_path("chip", "u_core/u7/A"));
+  EXPECT_FALSE(c.resolve_path("chip", "u_core/r0/Q/x"));
+}
+
+TEST_F(ServerTest, PipelinedBatches) {
+  NetlistClient c(srv.socket_path());
+  std::vector<std::string> names;
+  for (int i = 0; i < 1000; ++i) names.push_back(i % 4 == 3 ? "bogus" : "u" + std::to_string(i % 2));
+  auto res = c.find_instance_batch("chip", "core", names, 64);
+  ASSERT_EQ(res.size(), names.size());
+  for (size_t i = 0; i < names.size(); ++i) {
+    EXPECT_EQ(res[i].has_value(), i % 4 != 3) << i;
+    if (res[i]) { EXPECT_EQ(res[i]->master, "INV"); }
+  }
+
+  // Raw pipelining: a bad op answers BadRequest and the stream stays in sync.
+  const uint32_t a = c.post(Op::Ping, {});
+  const uint32_t b = c.post(Op(99), {});
+  const uint32_t d = c.post(Op::Ping, {});
+  c.flush();
+  EXPECT_EQ(c.next().id, a);
+  auto bad = c.next();
+  EXPECT_EQ(bad.id, b);
+  EXPECT_EQ(bad.status, Status::BadRequest);
+  EXPECT_EQ(c.next().id, d);
+}
+
+TEST_F(ServerTest, AcceptBacksOffWhenOutOfDescriptors) {
+  const int s = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_GE(s, 0);
+  const int lowest_free = ::dup(s);
+  ASSERT_GE(lowest_free, 0);
+  ::close(lowest_free);
+  rlimit saved{};
+  ASSERT_EQ(::getrlimit(RLIMIT_NOFILE, &saved), 0);
+  rlimit low = saved;
+  low.rlim_cur = rlim_t(lowest_free);   // every new descriptor now fails with EMFILE
+  ASSERT_EQ(::setrlimit(RLIMIT_NOFILE, &low), 0);
+
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, srv.socket_path().data(), srv.socket_path().size());
+  const int connected = ::connect(s, reinterpret_cast<const sockaddr*>(&addr), sizeof addr);
+  const std::clock_t cpu = std::clock();
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  const double busy = double(std::clock() - cpu) / CLOCKS_PER_SEC;
+  ::setrlimit(RLIMIT_NOFILE, &saved);
+  ASSERT_EQ(connected, 0);
+  EXPECT_LT(busy, 0.1) << "accept loop spins while out of descriptors";
+
+  // Once descriptors are back, the queued connection is served.
+  std::string ping;
+  WireWriter w{ ping };
+  w.u32(5);
+  w.u32(1);
+  w.u8(uint8_t(Op::Ping));
+  timeval tv{ 5, 0 };
+  ::setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+  ASSERT_EQ(::send(s, ping.data(), ping.size(), MSG_NOSIGNAL), ssize_t(ping.size()));
+  char b[16];
+  EXPECT_GT(::recv(s, b, sizeof b, 0), 0);
+  ::close(s);
+}
+
+TEST_F(ServerTest, ConcurrentClientsAndStop) {
+  std::vector<std::thread> clients;
+  std::atomic<int> ok{0};
+  for (int t = 0; t < 4; ++t) {
+    clients.emplace_back([&] {
+      NetlistClient c(srv.socket_path());
+      auto r = c.resolve_path_batch("chip", std::vector<std::string>(200, "u_core/u0/A"));
+      if (std::all_of(r.begin(), r.end(), [](const auto& p) { return p && p->end == PathEnd::Pin; })) ++ok;
+    });
+  }
+  for (auto& t : clients) t.join();
+  EXPECT_EQ(ok.load(), 4);
+
+  NetlistClient idle(srv.socket_path());   // stop() must not wait for idle connections
+  idle.ping();
+  srv.stop();
+  EXPECT_FALSE(std::filesystem::exists(srv.socket_path()));
+  EXPECT_THROW(idle.ping(), std::runtime_error);
+}
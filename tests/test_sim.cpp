@@ -0,0 +1,237 @@
+#include "veriloglib.hpp"
+#include "verilog_celllib.hpp"
+#include "verilog_sim.hpp"
+#include "test_util.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace verilog;
+
+static CellFunctions functions() {
+  CellFunctions f;
+  f.add("NAND2", { "A", "B" }, "Y", 0b0111);
+  f.add("INV", { "A" }, "Y", 0b01);
+  f.add("MUX2", { "A", "B", "S" }, "Y", 0b11001010);
+  f.add("HA", CellFunction{ { "A", "B" }, { "S", "CO" }, { 0b0110, 0b1000 } });
+  return f;
+}
+
+static InterfaceTable interfaces(const CellFunctions& f) {
+  InterfaceTable t;
+  f.add_interfaces(t);
+  add_cell_stubs(t, parse_string("module DFF(D, CK, Q); input D, CK; output Q; endmodule\n"));
+  return t;
+}
+
+static size_t input_index(const Simulator& s, std::string_view name) {
+  for (size_t i = 0; i < s.num_inputs(); ++i)
+    if (s.input_name(i) == name) return i;
+  ADD_FAILURE() << "no input " << name;
+  return 0;
+}
+
+static size_t output_index(const Simulator& s, std::string_view name) {
+  for (size_t i = 0; i < s.num_outputs(); ++i)
+    if (s.output_name(i) == name) return i;
+  ADD_FAILURE() << "no output " << name;
+  return 0;
+}
+
+TEST(Sim, CellsGatesAssignsAndState) {
+  const Netlist nl = parse_string(R"(
+module top(clk, a, b, c, y, z, s, co);
+  input clk, a, b, c; output y, s, co; output [1:0] z;
+  wire n1, n2, q;
+  NAND2 u1 (.A(a), .B(b), .Y(n1));
+  DFF r0 (.D(n1), .CK(clk), .Q(q));
+  xor g0 (n2, q, c);
+  MUX2 u2 (n2, a, b, y);
+  HA u3 (.A(a), .B(c), .S(s), .CO(co));
+  assign z = {n1, 1'b1};
+endmodule
+)");
+  const CellFunctions f = functions();
+  const InterfaceTable lib = interfaces(f);
+  const ModuleGraph g(nl.modules[0], lib);
+  SimOptions opts;
+  opts.sequential = { "DFF" };
+  const Simulator sim(g, f, opts);
+  EXPECT_EQ(sim.num_inputs(), 5u);    // clk a b c r0.Q
+  EXPECT_EQ(sim.num_outputs(), 7u);   // y s co z[1] z[0] r0.D r0.CK
+  EXPECT_EQ(sim.num_levels(), 2u);
+
+  // Every combination of the five inputs, one per vector.
+  const char* in_names[] = { "clk", "a", "b", "c", "r0.Q" };
+  std::vector<uint64_t> in(sim.num_inputs()), out(sim.num_outputs());
+  for (size_t i = 0; i < 5; ++i)
+    for (uint64_t k = 0; k < 64; ++k) in[input_index(sim, in_names[i])] |= (k >> i & 1) << k;
+  sim.run(in, out);
+  for (uint64_t k = 0; k < 64; ++k) {
+    const bool clk = k & 1, a = k >> 1 & 1, b = k >> 2 & 1, c = k >> 3 & 1, q = k >> 4 & 1;
+    const bool n1 = !(a && b), n2 = q != c;
+    auto bit = [&](std::string_view name) { return bool(out[output_index(sim, name)] >> k & 1); };
+    EXPECT_EQ(bit("y"), b ? a : n2) << k;
+    EXPECT_EQ(bit("s"), a != c) << k;
+    EXPECT_EQ(bit("co"), a && c) << k;
+    EXPECT_EQ(bit("z[1]"), n1) << k;
+    EXPECT_TRUE(bit("z[0]")) << k;
+    EXPECT_EQ(bit("r0.D"), n1) << k;
+    EXPECT_EQ(bit("r0.CK"), clk) << k;
+  }
+}
+
+TEST(Sim, SuppliesAreConstants) {
+  const Netlist nl = parse_string(R"(
+module top(a, y, z, w, v);
+  input a; output y, z, w, v;
+  supply1 vdd;
+  supply0 [1:0] gnd;
+  and g0 (y, a, vdd);
+  or g1 (z, a, gnd[1]);
+  NAND2 u1 (.A(vdd), .B(a), .Y(w));
+  not (vdd, a);                      // a driver cannot pull a supply
+  xor g2 (v, vdd, gnd[0]);
+endmodule
+)");
+  const CellFunctions f = functions();
+  const InterfaceTable lib = interfaces(f);
+  const ModuleGraph g(nl.modules[0], lib);
+  const Simulator sim(g, f);
+  ASSERT_EQ(sim.num_inputs(), 1u);
+  std::vector<uint64_t> in{ 0xf0f0 }, out(sim.num_outputs());
+  sim.run(in, out);
+  EXPECT_EQ(out[output_index(sim, "y")], 0xf0f0u);
+  EXPECT_EQ(out[output_index(sim, "z")], 0xf0f0u);
+  EXPECT_EQ(out[output_index(sim, "w")], ~uint64_t(0xf0f0));
+  EXPECT_EQ(out[output_index(sim, "v")], ~uint64_t(0));
+}
+
+TEST(Sim, RejectsUnknownCellsLoopsAndBadFunctions) {
+  const CellFunctions f = functions();
+  const InterfaceTable lib = interfaces(f);
+  const Netlist unknown = parse_string("module t(a, y); input a; output y; BUFX1 u (.A(a), .Y(y)); endmodule\n");
+  EXPECT_THROW(Simulator(ModuleGraph(unknown.modules[0], lib), f), std::runtime_error);
+  const Netlist loop = parse_string(R"(
+module t(a, y); input a; output y; wire s, r;
+  NAND2 l1 (.A(a), .B(r), .Y(s));
+  NAND2 l2 (.A(a), .B(s), .Y(r));
+  assign y = s;
+endmodule
+)");
+  try {
+    Simulator(ModuleGraph(loop.modules[0], lib), f);
+    ADD_FAILURE() << "loop not reported";
+  } catch (const std::runtime_error& e) {
+    EXPECT_NE(std::string(e.what()).find("l1, l2"), std::string::npos) << e.what();
+  }
+
+  CellFunctions bad;
+  EXPECT_THROW(bad.add("AND7", { "A", "B", "C", "D", "E", "F", "G" }, "Y", 0), std::invalid_argument);
+  EXPECT_THROW(bad.add("HA", CellFunction{ { "A", "B" }, { "S", "CO" }, { 0b0110 } }), std::invalid_argument);
+}
+
+TEST(Sim, WideAndThreadedRunsMatchScalar) {
+  testutil::RandomLogic shape;   // NAND2/INV/MUX2 logic with gates and assigns mixed in
+  shape.inputs = 32;
+  shape.outputs = 8;
+  shape.input_odds = 8;
+  shape.window = 0;
+  shape.mixed = true;
+  const Netlist nl = parse_string(testutil::random_logic(2000, 3, shape));
+  const CellFunctions f = functions();
+  const InterfaceTable lib = interfaces(f);
+  const ModuleGraph g(nl.modules[0], lib);
+  SimOptions scalar, wide;
+  scalar.avx2 = false;
+  wide.threads = 3;
+  const Simulator a(g, f, scalar), b(g, f, wide);
+  ASSERT_EQ(a.num_inputs(), 32u);
+  ASSERT_EQ(a.num_outputs(), 8u);
+
+  const size_t words = 11;   // two full blocks of four words and a partial one
+  std::mt19937_64 rng(5);
+  std::vector<uint64_t> in(a.num_inputs() * words);
+  for (auto& w : in) w = rng();
+  std::vector<uint64_t> out_a(a.num_outputs() * words), out_b(out_a.size());
+  a.run(in, out_a, words);
+  b.run(in, out_b, words);
+  EXPECT_EQ(out_a, out_b);
+
+  // Word w of a run is the same as simulating that word alone.
+  std::vector<uint64_t> one_in(a.num_inputs()), one_out(a.num_outputs());
+  for (size_t i = 0; i < a.num_inputs(); ++i) one_in[i] = in[i * words + 9];
+  a.run(one_in, one_out);
+  for (size_t o = 0; o < a.num_outputs(); ++o) EXPECT_EQ(one_out[o], out_a[o * words + 9]);
+
+  EXPECT_THROW(a.run(one_in, one_out, 2), std::invalid_argument);
+}
+
+TEST(Sim, RandomPatternEquivalence) {
+  const CellFunctions f = functions();
+  const InterfaceTable lib = interfaces(f);
+  const Netlist before = parse_string(R"(
+module m(clk, a, b, c, y);
+  input clk, a, b, c; output y; wire n1, n2, q;
+  NAND2 u1 (.A(a), .B(b), .Y(n1));
+  NAND2 u2 (.A(n1), .B(c), .Y(n2));
+  DFF r0 (.D(n2), .CK(clk), .Q(q));
+  MUX2 u3 (.A(n2), .B(a), .S(q), .Y(y));
+endmodule
+)");
+  // The same function, restructured: u2 becomes an and gate and an inverter.
+  const Netlist restructured = parse_string(R"(
+module m(clk, a, b, c, y);
+  input clk, a, b, c; output y; wire n1, n2, n3, q;
+  NAND2 u1 (.A(a), .B(b), .Y(n1));
+  and (n3, n1, c);
+  INV u2 (.A(n3), .Y(n2));
+  DFF r0 (.D(n2), .CK(clk), .Q(q));
+  MUX2 u3 (.A(n2), .B(a), .S(q), .Y(y));
+endmodule
+)");
+  // An ECO that changes the function: u1 now reads c instead of b.
+  const Netlist eco = parse_string(R"(
+module m(clk, a, b, c, y);
+  input clk, a, b, c; output y; wire n1, n2, q;
+  NAND2 u1 (.A(a), .B(c), .Y(n1));
+  NAND2 u2 (.A(n1), .B(c), .Y(n2));
+  DFF r0 (.D(n2), .CK(clk), .Q(q));
+  MUX2 u3 (.A(n2), .B(a), .S(q), .Y(y));
+endmodule
+)");
+  const ModuleGraph ga(before.modules[0], lib), gb(restructured.modules[0], lib), gc(eco.modules[0], lib);
+  EquivalenceOptions opts;
+  opts.sequential = { "DFF" };
+  opts.vectors = 1000;
+
+  const EquivalenceResult same = simulate_equivalence(ga, gb, f, opts);
+  EXPECT_TRUE(same.equivalent()) << same.report();
+  EXPECT_EQ(same.vectors, 1024u);
+  EXPECT_EQ(same.report(), "equivalent on 1024 random vectors\n");
+
+  const EquivalenceResult diff = simulate_equivalence(ga, gc, f, opts);
+  EXPECT_FALSE(diff.equivalent());
+  EXPECT_EQ(diff.mismatched, (std::vector<std::string>{ "y", "r0.D" }));
+  // The counterexample tells b and c apart where the ECO matters.
+  std::map<std::string, bool> cex(diff.counterexample.begin(), diff.counterexample.end());
+  ASSERT_EQ(cex.size(), 5u);
+  EXPECT_TRUE(cex["a"]);
+  EXPECT_TRUE(cex["c"]);
+  EXPECT_NE(cex["b"], cex["c"]);
+  EXPECT_NE(diff.report().find("counterexample:"), std::string::npos);
+
+  const Netlist renamed = parse_string(R"(
+module m(clk, a, b, c, out);
+  input clk, a, b, c; output out; wire n1, n2, q;
+  NAND2 u1 (.A(a), .B(b), .Y(n1));
+  NAND2 u2 (.A(n1), .B(c), .Y(n2));
+  DFF r0 (.D(n2), .CK(clk), .Q(q));
+  MUX2 u3 (.A(n2), .B(a), .S(q), .Y(out));
+endmodule
+)");
+  const ModuleGraph gd(renamed.modules[0], lib);
+  const EquivalenceResult ports = simulate_equivalence(ga, gd, f, opts);
+  EXPECT_TRUE(ports.mismatched.empty());
+  EXPECT_EQ(ports.only_in_a, (std::vector<std::string>{ "y" }));
+  EXPECT_EQ(ports.only_in_b, (std::vector<std::string>{ "out" }));
+}
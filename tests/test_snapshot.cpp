@@ -0,0 +1,105 @@
+#include "veriloglib.hpp"
+#include "verilog_snapshot.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace verilog;
+
+static const char* kSnap = R"(
+module leaf(A, Y);
+  input A; output Y;
+endmodule
+module top(a, y);
+  input a; output y;
+  wire [1:0] n;
+  leaf u1 (.A(a), .Y(n[0]));
+  leaf u0 (.A(n[0]), .Y({n[1], y}));
+endmodule
+)";
+
+TEST(Snapshot, FrozenLookups) {
+  FrozenNetlist snap(parse_string(kSnap), 7);
+  EXPECT_EQ(snap.version(), 7u);
+  ASSERT_EQ(snap.modules().size(), 2u);
+  const Module* top = snap.find_module("top");
+  ASSERT_NE(top, nullptr);
+  EXPECT_EQ(snap.find_module("nope"), nullptr);
+  const ModuleInstance* u0 = snap.find_instance(*top, "u0");
+  ASSERT_NE(u0, nullptr);
+  EXPECT_EQ(u0->instance_name, "u0");
+  EXPECT_EQ(snap.find_instance(*top, "u2"), nullptr);
+}
+
+TEST(Snapshot, ThawIsADeepCopy) {
+  Netlist src = parse_string(kSnap);
+  const auto& yconn = src.modules[1].module_instances[1].ports_named.at("Y");
+  auto shared = std::get<std::shared_ptr<Concatenation>>(yconn);
+
+  FrozenNetlist snap(std::move(src));
+  shared->elements.clear();   // a copy the caller kept must not reach the snapshot
+  const auto& frozen = snap.find_instance(*snap.find_module("top"), "u0")->ports_named.at("Y");
+  EXPECT_EQ(expr_to_string(frozen), "{n[1], y}");
+
+  Netlist eco = snap.thaw();
+  std::get<std::shared_ptr<Concatenation>>(eco.modules[1].module_instances[1].ports_named.at("Y"))->elements.pop_back();
+  EXPECT_EQ(expr_to_string(frozen), "{n[1], y}");
+}
+
+TEST(Snapshot, PublishAndRead) {
+  SnapshotPublisher pub(4);
+  auto r = pub.register_reader();
+  EXPECT_FALSE(r.read());
+
+  EXPECT_EQ(pub.publish(parse_string(kSnap)), 1u);
+  {
+    auto g = r.read();
+    ASSERT_TRUE(g);
+    EXPECT_EQ(g->version(), 1u);
+
+    // An ECO publishes v2 while the guard still pins v1.
+    Netlist eco = g->thaw();
+    eco.modules[1].module_instances.pop_back();
+    EXPECT_EQ(pub.publish(std::move(eco)), 2u);
+    EXPECT_EQ(g->version(), 1u);
+    EXPECT_EQ(g->find_module("top")->module_instances.size(), 2u);
+    EXPECT_EQ(pub.reclaim(), 1u);   // v1 is still pinned
+  }
+  EXPECT_EQ(pub.reclaim(), 0u);
+  EXPECT_EQ(r.read()->find_module("top")->module_instances.size(), 1u);
+}
+
+TEST(Snapshot, ReaderSlotsAreBounded) {
+  SnapshotPublisher pub(2);
+  auto a = pub.register_reader();
+  {
+    auto b = pub.register_reader();
+    EXPECT_THROW(pub.register_reader(), std::runtime_error);
+  }
+  auto c = pub.register_reader();   // b's slot was released
+  SUCCEED();
+}
+
+TEST(Snapshot, ConcurrentReadersWhilePublishing) {
+  SnapshotPublisher pub(16);
+  pub.publish(parse_string(kSnap));
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> reads{0}, bad{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([&] {
+      auto r = pub.register_reader();
+      while (!stop.load()) {
+        auto g = r.read();
+        const Module* top = g->find_module("top");
+        if (!top || !g->find_instance(*top, "u1")) ++bad;
+        ++reads;
+      }
+    });
+  }
+  for (int v = 0; v < 200; ++v) pub.publish(parse_string(kSnap));
+  stop = true;
+  for (auto& t : readers) t.join();
+  pub.synchronize();
+  EXPECT_EQ(bad.load(), 0u);
+  EXPECT_EQ(pub.version(), 201u);
+}
@@ -0,0 +1,134 @@
+#include "veriloglib.hpp"
+#include "verilog_source.hpp"
+#include "verilog_lazy.hpp"
+#include "verilog_flatten.hpp"
+#include <gtest/gtest.h>
+
+using namespace verilog;
+
+static const char* kText =
+  "// header\n"
+  "module inv(A, Y);\n"
+  "  input A;\n"
+  "  output Y;\n"
+  "endmodule\n"
+  "\n"
+  "module top(a, y);\n"
+  "  input a; output y;\n"
+  "  wire [1:0] n;\n"
+  "  inv u0 (.A(a), .Y(n[0])),\n"
+  "      u1 (.A(n[0]),\n"
+  "          .Y(n[1]));\n"
+  "  assign y = n[1];\n"
+  "endmodule\n";
+
+static std::string_view text_of(std::string_view text, const SourceSpan& s) {
+  return text.substr(s.begin, s.end - s.begin);
+}
+
+// Brute-force line and column of every offset.
+static std::vector<SourceLocation> walk(std::string_view text) {
+  std::vector<SourceLocation> v(text.size() + 1);
+  uint32_t line = 1, col = 1;
+  for (size_t i = 0; i <= text.size(); ++i) {
+    v[i].line = line;
+    v[i].column = col;
+    if (i < text.size() && text[i] == '\n') { ++line; col = 1; } else { ++col; }
+  }
+  return v;
+}
+
+static void expect_matches_walk(std::string_view text) {
+  const LineTable t(text);
+  const auto want = walk(text);
+  ASSERT_EQ(t.num_lines(), want.back().line);
+  for (uint32_t i = 0; i < want.size(); ++i) {
+    const SourceLocation got = t.locate(i);
+    ASSERT_EQ(got.line, want[i].line) << "offset " << i;
+    ASSERT_EQ(got.column, want[i].column) << "offset " << i;
+    if (want[i].column == 1) { ASSERT_EQ(t.line_start(got.line), i); }
+  }
+}
+
+TEST(LineTable, LocatesEveryOffset) {
+  expect_matches_walk("");
+  expect_matches_walk("no newline");
+  expect_matches_walk("\n\n\n");
+  expect_matches_walk(kText);
+
+  std::string many;   // several blocks of short lines
+  for (int i = 0; i < 1000; ++i) many += std::string(size_t(i % 7), 'x') + "\n";
+  expect_matches_walk(many);
+}
+
+TEST(LineTable, WideBlocksKeepFullOffsets) {
+  // Lines of 2 KiB: a block of 64 spans more than 64 KiB, so it falls back to
+  // 32-bit offsets; the short lines after it are narrow again.
+  std::string text;
+  for (int i = 0; i < 100; ++i) text += std::string(2048, 'w') + "\n";
+  for (int i = 0; i < 200; ++i) text += "short\n";
+  expect_matches_walk(text);
+
+  std::string narrow;
+  for (int i = 0; i < 300; ++i) narrow += "line\n";
+  EXPECT_LT(LineTable(narrow).memory_bytes(), sizeof(LineTable) + 300 * sizeof(uint32_t));
+}
+
+TEST(SourceSpans, CoverModulesDeclarationsAssignsAndInstances) {
+  if (!VERILOGLIB_SOURCE_LOCATIONS) GTEST_SKIP() << "built without source locations";
+  const std::string_view text = kText;
+  const Netlist nl = parse_string(text);
+  ASSERT_TRUE(nl.lines);
+  ASSERT_EQ(nl.modules.size(), 2u);
+
+  const Module& inv = nl.modules[0];
+  EXPECT_EQ(text_of(text, inv.span).substr(0, 10), "module inv");
+  EXPECT_TRUE(text_of(text, inv.span).ends_with("endmodule"));
+  EXPECT_EQ(locate(nl, inv.span).line, 2u);
+  EXPECT_EQ(text_of(text, inv.output_declarations[0].span), "output Y;");
+
+  const Module& top = nl.modules[1];
+  EXPECT_EQ(locate(nl, top.span).line, 7u);
+  EXPECT_EQ(text_of(text, top.input_declarations[0].span), "input a;");
+  EXPECT_EQ(text_of(text, top.net_declarations[0].span), "wire [1:0] n;");
+  EXPECT_EQ(text_of(text, top.assignments[0].span), "assign y = n[1];");
+  ASSERT_EQ(top.module_instances.size(), 2u);
+  EXPECT_EQ(text_of(text, top.module_instances[0].span), "u0 (.A(a), .Y(n[0]))");
+  const SourceLocation u1 = locate(nl, top.module_instances[1].span);
+  EXPECT_EQ(u1.line, 11u);
+  EXPECT_EQ(u1.column, 7u);
+  EXPECT_EQ(nl.lines->locate(top.module_instances[1].span.end).line, 12u);
+}
+
+TEST(SourceSpans, LazyBodiesUseWholeFileOffsets) {
+  if (!VERILOGLIB_SOURCE_LOCATIONS) GTEST_SKIP() << "built without source locations";
+  const Netlist eager = parse_string(kText);
+  LazyNetlist lazy = LazyNetlist::from_string(kText);
+  const Module& top = lazy.module(1);
+  EXPECT_EQ(top.span.begin, eager.modules[1].span.begin);
+  EXPECT_EQ(top.module_instances[1].span.begin, eager.modules[1].module_instances[1].span.begin);
+  EXPECT_EQ(lazy.lines()->locate(top.assignments[0].span.begin).line, 13u);
+
+  // Flattening keeps the leaf's span into the original text.
+  const Netlist flat = flatten(eager);
+  ASSERT_EQ(flat.modules[0].module_instances.size(), 2u);
+  EXPECT_EQ(locate(flat, flat.modules[0].module_instances[1].span).line, 11u);
+}
+
+TEST(SourceSpans, ParseErrorsCarryTheirLocation) {
+  try {
+    parse_string("module m(a);\n  input a;\n  wire ;\nendmodule\n");
+    FAIL() << "expected a parse error";
+  } catch (const parse_error& e) {
+    EXPECT_EQ(e.source, "verilog_string");
+    EXPECT_EQ(e.location.line, 3u);
+    EXPECT_GT(e.location.column, 1u);
+  }
+  try {
+    LazyNetlist::from_string("module a(x); input x; endmodule\nmodule b(y);\n  input y;\n  ? ;\nendmodule\n", "two.v").module(1);
+    FAIL() << "expected a parse error";
+  } catch (const parse_error& e) {
+    EXPECT_EQ(e.source, "two.v");
+    EXPECT_EQ(e.location.line, 4u);
+  }
+}
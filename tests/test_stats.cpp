@@ -0,0 +1,110 @@
+#include "veriloglib.hpp"
+#include "verilog_connectivity.hpp"
+#include "verilog_stats.hpp"
+#include <gtest/gtest.h>
+
+using namespace verilog;
+
+static const char* kHier = R"(
+module leaf(A, Y);
+  input A; output Y;
+endmodule
+
+module mid(i, o);
+  input i; output o;
+  wire n1, spare;
+  leaf u0 (.A(i), .Y(n1));
+  leaf u1 (.A(n1), .Y(o));
+  DFFRX1 r0 (.D(n1), .CK(i), .Q());
+endmodule
+
+module top(a, z, bus);
+  input a; output z; output [1:0] bus;
+  wire m1, dangling, orphan;
+  mid x0 (.i(a), .o(m1));
+  mid x1 (.i(m1), .o(z));
+  mid x2 (.i(a), .o(dangling));
+  leaf l0 (.A(orphan));
+endmodule
+)";
+
+TEST(Stats, DeclarationsKeepEveryName) {
+  auto nl = parse_string("module t(a,b); input a, b; output [3:0] q, r; endmodule");
+  const auto& m = nl.modules[0];
+  ASSERT_EQ(m.input_declarations.size(), 1u);
+  EXPECT_EQ(m.input_declarations[0].names, (std::vector<std::string>{ "a", "b" }));
+  ASSERT_EQ(m.output_declarations.size(), 1u);
+  EXPECT_EQ(m.output_declarations[0].net_name, "q");
+  EXPECT_EQ(m.output_declarations[0].names, (std::vector<std::string>{ "q", "r" }));
+}
+
+TEST(Stats, ModuleGraphBits) {
+  auto nl = parse_string(R"(
+    module t(a, q);
+      input [1:0] a; output [3:0] q;
+      assign q[3:2] = a;
+      BUF b0 (.A(a[0]), .Y(q[0]));
+    endmodule
+  )");
+  InterfaceTable ifaces(nl);
+  ModuleGraph g(nl.modules[0], ifaces);
+  EXPECT_EQ(g.num_nets(), 6u);
+  const NetId q3 = g.find_net("q[3]");
+  ASSERT_NE(q3, kNoNet);
+  EXPECT_EQ(g.net_name(q3), "q[3]");
+  EXPECT_EQ(g.find_net("q"), kNoNet);          // vectors are looked up per bit
+  // q[3]: output port load + assign driver
+  EXPECT_EQ(g.net_pins(q3).size(), 2u);
+  // a[0]: input port driver, BUF pin (unknown cell), assign rhs
+  EXPECT_EQ(g.net_pins(g.find_net("a[0]")).size(), 3u);
+}
+
+TEST(Stats, HierarchyCountsAndIssues) {
+  auto nl = parse_string(kHier);
+  DesignStats ds = compute_stats(nl);
+
+  ASSERT_EQ(ds.tops, std::vector<std::string>{ "top" });
+  EXPECT_EQ(ds.module_instantiations.at("mid"), 3u);
+  EXPECT_EQ(ds.instance_counts.at("mid"), 3u);
+  EXPECT_EQ(ds.instance_counts.at("leaf"), 7u);     // 3 * 2 + 1
+  EXPECT_EQ(ds.instance_counts.at("DFFRX1"), 3u);
+  EXPECT_EQ(ds.leaf_instances, 3u);
+
+  auto has_net = [](const std::vector<NetIssue>& v, const std::string& mod, const std::string& net) {
+    for (const auto& x : v) if (x.module == mod && x.net == net) return true;
+    return false;
+  };
+  EXPECT_TRUE(has_net(ds.floating_nets, "mid", "spare"));
+  EXPECT_TRUE(has_net(ds.undriven_nets, "top", "bus[1]"));   // output port, nothing drives it
+  EXPECT_TRUE(has_net(ds.undriven_nets, "top", "orphan"));
+  EXPECT_TRUE(has_net(ds.unused_nets, "top", "dangling"));
+
+  // .Q() on the flop is an unknown cell (no interface), l0 leaves Y open.
+  ASSERT_EQ(ds.unconnected_pins.size(), 1u);
+  EXPECT_EQ(ds.unconnected_pins[0].instance, "l0");
+  EXPECT_EQ(ds.unconnected_pins[0].pin, "Y");
+
+  // mid: n1 has loads on u1.A and the flop's D (unknown), so it is unresolved.
+  EXPECT_GT(ds.unresolved_nets, 0u);
+  EXPECT_FALSE(ds.report().empty());
+}
+
+TEST(Stats, ThreadCountDoesNotChangeResult) {
+  auto nl = parse_string(kHier);
+  DesignStats one = compute_stats(nl, StatsOptions{ "", 1 });
+  for (unsigned t : { 2u, 4u, 8u }) {
+    DesignStats many = compute_stats(nl, StatsOptions{ "", t });
+    EXPECT_EQ(one.report(1000), many.report(1000)) << t << " threads";
+  }
+}
+
+TEST(Stats, ExplicitTopAndCycles) {
+  auto nl = parse_string(kHier);
+  DesignStats ds = compute_stats(nl, StatsOptions{ "mid", 0 });
+  EXPECT_EQ(ds.instance_counts.at("leaf"), 2u);
+  EXPECT_EQ(ds.module_instantiations.at("top"), 0u);
+  EXPECT_THROW(compute_stats(nl, StatsOptions{ "nope", 0 }), std::runtime_error);
+
+  auto cyc = parse_string("module a(); b u(); endmodule module b(); a u(); endmodule");
+  EXPECT_THROW(compute_stats(cyc), std::runtime_error);
+}
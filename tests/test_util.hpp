@@ -0,0 +1,110 @@
+#pragma once
+#include "veriloglib.hpp"
+#include "verilog_celllib.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VERILOG_TEST_FIFO 1
+#endif
+
+namespace testutil {
+
+// Interfaces of the library cells the graph tests instantiate.
+inline verilog::InterfaceTable stub_cells() {
+  verilog::InterfaceTable t;
+  verilog::add_cell_stubs(t, verilog::parse_string(R"(
+    module NAND2X1(A, B, Y); input A, B; output Y; endmodule
+    module DFFX1(D, CK, Q); input D, CK; output Q; endmodule
+    module INVX1(A, Y); input A; output Y; endmodule
+    module BUFX1(A, Y); input A; output Y; endmodule
+  )"));
+  return t;
+}
+
+// Shape of random_logic(). Sources come only from module inputs and earlier
+// cells, so the logic has no loops except through flops.
+struct RandomLogic {
+  size_t inputs = 16;         // in[inputs-1:0]
+  size_t outputs = 1;         // out[outputs-1:0], assigned from the last cells
+  unsigned input_odds = 16;   // one source in this many is a module input
+  size_t window = 64;         // other sources are among the last `window` cells; 0: any earlier cell
+  size_t flop_every = 0;      // every flop_every-th cell is a DFFX1 clocked by in[0]; 0: none
+  bool mixed = false;         // NAND2/INV/MUX2 cells, xnor gates and assigns instead of NAND2X1 only
+};
+
+// Module r of `cells` random cells driving n[cells-1:0].
+inline std::string random_logic(size_t cells, unsigned seed, const RandomLogic& shape = {}) {
+  std::mt19937 rng(seed);
+  std::string s = "module r(in, out);\n  input [" + std::to_string(shape.inputs - 1) + ":0] in;\n";
+  s += "  output [" + std::to_string(shape.outputs - 1) + ":0] out;\n  wire [" + std::to_string(cells - 1) + ":0] n;\n";
+  auto src = [&](size_t c) {
+    if (c == 0 || rng() % shape.input_odds == 0) return "in[" + std::to_string(rng() % shape.inputs) + "]";
+    return "n[" + std::to_string(c - 1 - rng() % (shape.window ? std::min(c, shape.window) : c)) + "]";
+  };
+  for (size_t c = 0; c < cells; ++c) {
+    const std::string u = std::to_string(c), y = "n[" + u + "]";
+    if (shape.flop_every && c % shape.flop_every == shape.flop_every - 1) {
+      s += "  DFFX1 r" + u + " (.D(" + src(c) + "), .CK(in[0]), .Q(" + y + "));\n";
+      continue;
+    }
+    switch (shape.mixed ? rng() % 5 : 0) {
+      case 0: s += (shape.mixed ? "  NAND2 u" : "  NAND2X1 u") + u + " (.A(" + src(c) + "), .B(" + src(c) + "), .Y(" + y + "));\n"; break;
+      case 1: s += "  INV u" + u + " (.A(" + src(c) + "), .Y(" + y + "));\n"; break;
+      case 2: s += "  MUX2 u" + u + " (.A(" + src(c) + "), .B(" + src(c) + "), .S(" + src(c) + "), .Y(" + y + "));\n"; break;
+      case 3: s += "  xnor (" + y + ", " + src(c) + ", " + src(c) + ", " + src(c) + ");\n"; break;
+      default: s += "  assign " + y + " = " + src(c) + ";\n"; break;
+    }
+  }
+  for (size_t o = 0; o < shape.outputs; ++o)
+    s += "  assign out[" + std::to_string(o) + "] = n[" + std::to_string(cells - 1 - o) + "];\n";
+  return s + "endmodule\n";
+}
+
+#ifdef VERILOG_TEST_FIFO
+// A named pipe that serves `text` once, like `<(cat design.v)`: stat()
+// reports no size and the file cannot be mapped. A missing reader does not
+// hang the destructor as long as `text` fits in the pipe buffer.
+class FifoFile {
+public:
+  explicit FifoFile(std::string text) : text_(std::move(text)) {
+    static int serial = 0;
+    path_ = (std::filesystem::temp_directory_path() /
+             ("verilog_fifo_" + std::to_string(::getpid()) + "_" + std::to_string(serial++))).string();
+    if (::mkfifo(path_.c_str(), 0600) != 0) throw std::runtime_error("mkfifo " + path_);
+    writer_ = std::thread([this] {
+      const int fd = ::open(path_.c_str(), O_WRONLY);   // blocks until the reader opens
+      if (fd < 0) return;
+      for (size_t done = 0; done < text_.size();) {
+        const ssize_t n = ::write(fd, text_.data() + done, text_.size() - done);
+        if (n <= 0) break;
+        done += size_t(n);
+      }
+      ::close(fd);
+    });
+  }
+  ~FifoFile() {
+    const int fd = ::open(path_.c_str(), O_RDONLY | O_NONBLOCK);   // releases a writer nobody read from
+    writer_.join();
+    if (fd >= 0) ::close(fd);
+    ::unlink(path_.c_str());
+  }
+  FifoFile(const FifoFile&) = delete;
+  FifoFile& operator=(const FifoFile&) = delete;
+
+  const std::string& path() const { return path_; }
+
+private:
+  std::string text_, path_;
+  std::thread writer_;
+};
+#endif
+
+} // namespace testutil
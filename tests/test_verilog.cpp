@@ -1,4 +1,5 @@
 #include "veriloglib.hpp"
+#include "verilog_grammar.hpp"
 #include <gtest/gtest.h>
 
 using namespace verilog;
@@ -348,3 +349,93 @@ EXPECT_TRUE(is_slice_structural(u1.ports_pos[1], "bus", 7, 0));
     EXPECT_TRUE(is_slice(u1.ports_pos[1], "bus", 7, 0));
   }
 }
+
+TEST(Number, DecodedOnceAtParse) {
+  Number n = Number::parse("8'hF_F");
+  EXPECT_TRUE(n.decoded);
+  ASSERT_TRUE(n.length.has_value());
+  EXPECT_EQ(*n.length, 8);
+  EXPECT_EQ(n.base, 'h');
+  EXPECT_EQ(n.width(), 8u);
+  EXPECT_EQ(n.as_integer(), 255);
+
+  EXPECT_EQ(Number::parse("'d1_000").as_integer(), 1000);
+  EXPECT_EQ(Number::parse("-3").as_integer(), -3);
+  EXPECT_EQ(Number::parse("12").width(), 32u);
+
+  // Hand-built Numbers still decode on demand.
+  Number h; h.mantissa = "42";
+  EXPECT_EQ(h.as_integer(), 42);
+}
+
+TEST(Number, WideAndFourState) {
+  Number w = Number::parse("128'hFFFF_FFFF_FFFF_FFFF_FFFF_FFFF_FFFF_FFFF");
+  EXPECT_EQ(w.width(), 128u);
+  EXPECT_FALSE(w.fits_int64());
+  EXPECT_EQ(w.value.bit(127), '1');
+  EXPECT_EQ(w.to_string(), "128'hffffffffffffffffffffffffffffffff");
+
+  Number d = Number::parse("80'd1208925819614629174706176"); // 2^80
+  EXPECT_EQ(d.width(), 80u);
+  EXPECT_EQ(d.value.bit(79), '0');  // truncated to 80 bits
+
+  Number xz = Number::parse("4'b1x_z0");
+  EXPECT_FALSE(xz.value.is_fully_known());
+  EXPECT_EQ(xz.value.bit(0), '0');
+  EXPECT_EQ(xz.value.bit(1), 'z');
+  EXPECT_EQ(xz.value.bit(2), 'x');
+  EXPECT_EQ(xz.value.bit(3), '1');
+  EXPECT_EQ(Number::parse("8'bx").value.to_string(), "8'hxx");
+}
+
+TEST(Parse, SizedNumbersInSelects) {
+  const char* data = R"(
+    module top(a);
+      output [4'd7:0] bus;
+      BUF u0 (.A(bus[8'h3]), .Y(bus[3'b1_10:'d0]));
+    endmodule
+  )";
+  auto nl = parse_string(data);
+  const auto& m = nl.modules[0];
+  ASSERT_EQ(m.output_declarations.size(), 1u);
+  ASSERT_TRUE(m.output_declarations[0].range.has_value());
+  EXPECT_EQ(m.output_declarations[0].range->to_indices().size(), 8u);
+  const auto& u0 = m.module_instances[0];
+  EXPECT_EQ(expr_to_string(u0.ports_named.at("A")), "bus[3]");
+  EXPECT_TRUE(is_slice_structural(u0.ports_named.at("Y"), "bus", 6, 0));
+}
+
+TEST(Grammar, KeywordClassifier) {
+  using verilog::grammar::classify_keyword;
+  using verilog::grammar::Keyword;
+  static_assert(classify_keyword("inout") == Keyword::Inout);
+  static_assert(classify_keyword("input") == Keyword::Input);
+  static_assert(classify_keyword("endmodule") == Keyword::Endmodule);
+  static_assert(classify_keyword("wires") == Keyword::None);
+  static_assert(classify_keyword("inpu") == Keyword::None);
+  static_assert(classify_keyword("BUF") == Keyword::None);
+  EXPECT_EQ(classify_keyword("assign"), Keyword::Assign);
+  EXPECT_EQ(classify_keyword("assig_"), Keyword::None);
+}
+
+TEST(Parse, KeywordPrefixedNames) {
+  // Masters and instances that merely start with a keyword are instantiations.
+  const char* data = R"(
+    module top(a, y);
+      input a; output y;
+      wire_buf u0 (.A(a), .Y(n1));
+      inputs module_x (.A(n1), .Y(n2));
+      assign_cell endmodule_u (.A(n2), .Y(y));
+    endmodule
+  )";
+  auto nl = parse_string(data);
+  ASSERT_EQ(nl.modules.size(), 1u);
+  const auto& m = nl.modules[0];
+  ASSERT_EQ(m.module_instances.size(), 3u);
+  EXPECT_EQ(m.module_instances[0].module_name, "wire_buf");
+  EXPECT_EQ(m.module_instances[1].module_name, "inputs");
+  EXPECT_EQ(m.module_instances[1].instance_name, "module_x");
+  EXPECT_EQ(m.module_instances[2].module_name, "assign_cell");
+  EXPECT_EQ(m.module_instances[2].instance_name, "endmodule_u");
+  EXPECT_EQ(m.input_declarations.size(), 1u);
+}
@@ -0,0 +1,40 @@
+#include "veriloglib.hpp"
+#include "verilog_writer.hpp"
+#include <gtest/gtest.h>
+
+using namespace verilog;
+
+TEST(Writer, RoundTripsEveryConstruct) {
+  const char* text = R"(
+module ram #(parameter W = 8, parameter D = 16) (clk, addr, q, ab);
+  localparam A = W*2;
+  input clk; input [W-1:0] addr; output [7:0] q; inout ab; wire \a+b ;
+  wire [3:0] n; tri t; supply0 gnd; supply1 vdd;
+  assign n[1:0] = {addr[0], 1'b1}, t = gnd;
+  assign q = {4'b10xz, n};
+  CELL #(.W(W+1), .D(4)) u1 (.A(addr[3]), .Y(n[2]));
+  CELL #(3) \u$2 (clk, n[3]);
+  and g0 (t, clk, vdd);
+  not (n[0], \a+b );
+endmodule
+module top(x); input x; ram #(.W(4)) r (.clk(x)); endmodule
+)";
+  const Netlist a = parse_string(text);
+  const std::string written = write_verilog(a);
+  const Netlist b = parse_string(written);
+  ASSERT_EQ(b.modules.size(), 2u);
+  for (size_t i = 0; i < 2; ++i) EXPECT_EQ(a.modules[i].summary(), b.modules[i].summary()) << written;
+  EXPECT_EQ(write_verilog(b), written);
+  EXPECT_NE(written.find("  CELL #(.W(W+1), .D(4)) u1 (.A(addr[3]), .Y(n[2]));\n"), std::string::npos) << written;
+  EXPECT_NE(written.find("  not (n[0], \\a+b );\n"), std::string::npos) << written;
+  EXPECT_NE(written.find("  input [W-1:0] addr;\n"), std::string::npos) << written;
+}
+
+TEST(Writer, EscapesOnlyWhatNeedsIt) {
+  EXPECT_EQ(verilog_identifier("n_1$x"), "n_1$x");
+  EXPECT_EQ(verilog_identifier("wire"), "\\wire ");
+  EXPECT_EQ(verilog_identifier("1abc"), "\\1abc ");
+  EXPECT_EQ(verilog_identifier("a/b[3]"), "\\a/b[3] ");
+  EXPECT_EQ(write_expr(IdentifierIndexed{ "bus.x", Number::parse("3") }), "\\bus.x [3]");
+  EXPECT_EQ(write_expr(Constant{ LogicVector(4), false }), "0");
+}